@@ -275,3 +275,23 @@ bool OPCODE_Model::Build(const OPCODECREATE& create)
 #endif // __MESHMERIZER_H__
     return true;
 }
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *  Discards the model and creates an empty non quantized no-leaf tree.
+ *  \param      nb_nodes    [in] number of nodes
+ *  \return     zeroed nodes to be filled by the caller
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+AABBNoLeafNode* OPCODE_Model::Restore(udword nb_nodes)
+{
+    xr_delete(mSource);
+    xr_delete(mTree);
+
+    mNoLeaf = true;
+    mQuantized = false;
+
+    AABBNoLeafTree* tree = new AABBNoLeafTree();
+    mTree = tree;
+    return tree->Reset(nb_nodes);
+}
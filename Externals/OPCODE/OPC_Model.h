@@ -55,6 +55,16 @@ public:
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     bool Build(const OPCODECREATE& create);
 
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    /**
+     *	Discards the model and creates an empty non quantized no-leaf tree.
+     *	Used to restore a saved tree instead of building it.
+     *	\param		nb_nodes	[in] number of nodes
+     *	\return		zeroed nodes to be filled by the caller
+     */
+    ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+    AABBNoLeafNode* Restore(udword nb_nodes);
+
     ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
     /**
      *	A method to access the tree.
@@ -298,6 +298,23 @@ bool AABBNoLeafTree::Build(AABBTree* tree)
     return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+/**
+ *	Discards the tree and allocates zeroed nodes to be filled by the caller.
+ *	\param		nb_nodes		[in] number of nodes
+ *	\return		the nodes
+ */
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+AABBNoLeafNode* AABBNoLeafTree::Reset(udword nb_nodes)
+{
+    xr_free(mNodes);
+    mNbNodes = nb_nodes;
+    mNodes = xr_alloc<AABBNoLeafNode>(mNbNodes);
+    if (mNodes)
+        ZeroMemory(mNodes, mNbNodes * sizeof(AABBNoLeafNode));
+    return mNodes;
+}
+
 // Quantization notes:
 // - We could use the highest bits of mData to store some more quantized bits. Dequantization code
 //   would be slightly more complex, but number of overlap tests would be reduced (and anyhow those
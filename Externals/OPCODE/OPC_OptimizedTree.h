@@ -150,6 +150,10 @@ class OPCODE_API AABBCollisionTree : public AABBOptimizedTree
 class OPCODE_API AABBNoLeafTree : public AABBOptimizedTree
 {
     IMPLEMENT_COLLISION_TREE(AABBNoLeafTree, AABBNoLeafNode)
+
+public:
+    // Allocates zeroed nodes to be filled by the caller, used to restore a saved tree
+    AABBNoLeafNode* Reset(udword nb_nodes);
 };
 
 class OPCODE_API AABBQuantizedTree : public AABBOptimizedTree
@@ -390,6 +390,10 @@ static void SOR_LCP (int m, int nb, dRealMutablePtr J, int *jb, dxBody * const *
 	dIASSERT (j==m);
 #endif
 
+#ifdef RANDOMLY_REORDER_CONSTRAINTS
+	unsigned long shuffle_seed = (unsigned long) m;
+#endif
+
 	for (int iteration=0; iteration < num_iterations; iteration++) {
 
 #ifdef REORDER_CONSTRAINTS
@@ -425,15 +429,15 @@ static void SOR_LCP (int m, int nb, dRealMutablePtr J, int *jb, dxBody * const *
 #endif
 #ifdef RANDOMLY_REORDER_CONSTRAINTS
 		if ((iteration & 3) == 0) {
-			std::random_shuffle	(order,order+m);
-			/*
+			// the generator is local: islands are solved in parallel and the result
+			// must not depend on what was solved before or at the same time
 			for (i=1; i<m; ++i) {
+				shuffle_seed = (1664525L*shuffle_seed + 1013904223L) & 0xffffffff;
+				int swapi = (int) (double(shuffle_seed) * (double(i+1) / 4294967296.0));
 				IndexError tmp = order[i];
-				int swapi = dRandInt(i+1);
 				order[i] = order[swapi];
 				order[swapi] = tmp;
 			}
-			*/
 		}
 #endif
 
@@ -0,0 +1,56 @@
+# - Find LZ4 library
+# Find the native LZ4 includes and library
+# This module defines
+#  LZ4_INCLUDE_DIRS, where to find lz4.h, Set when
+#                        LZ4_INCLUDE_DIR is found.
+#  LZ4_LIBRARIES, libraries to link against to use LZ4.
+#  LZ4_ROOT_DIR, The base directory to search for LZ4.
+#                    This can also be an environment variable.
+#  LZ4_FOUND, If false, do not try to use LZ4.
+#
+# also defined, but not for general use are
+#  LZ4_LIBRARY, where to find the LZ4 library.
+
+# If LZ4_ROOT_DIR was defined in the environment, use it.
+IF(NOT LZ4_ROOT_DIR AND NOT $ENV{LZ4_ROOT_DIR} STREQUAL "")
+  SET(LZ4_ROOT_DIR $ENV{LZ4_ROOT_DIR})
+ENDIF()
+
+SET(_lz4_SEARCH_DIRS
+  ${LZ4_ROOT_DIR}
+  /usr/local
+  /sw # Fink
+  /opt/local # DarwinPorts
+)
+
+FIND_PATH(LZ4_INCLUDE_DIR lz4.h
+  HINTS
+    ${_lz4_SEARCH_DIRS}
+  PATH_SUFFIXES
+    include
+)
+
+FIND_LIBRARY(LZ4_LIBRARY
+  NAMES
+    lz4
+  HINTS
+    ${_lz4_SEARCH_DIRS}
+  PATH_SUFFIXES
+    lib64 lib
+  )
+
+# handle the QUIETLY and REQUIRED arguments and set LZ4_FOUND to TRUE if 
+# all listed variables are TRUE
+INCLUDE(FindPackageHandleStandardArgs)
+FIND_PACKAGE_HANDLE_STANDARD_ARGS(LZ4 DEFAULT_MSG
+  LZ4_LIBRARY LZ4_INCLUDE_DIR)
+
+IF(LZ4_FOUND)
+  SET(LZ4_LIBRARIES ${LZ4_LIBRARY})
+  SET(LZ4_INCLUDE_DIRS ${LZ4_INCLUDE_DIR})
+ENDIF(LZ4_FOUND)
+
+MARK_AS_ADVANCED(
+  LZ4_INCLUDE_DIR
+  LZ4_LIBRARY
+)
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 
 #include "D3DXRenderBase.h"
+#include "SkeletonCustom.h"
 #include "xrEngine/GameFont.h"
 #include "xrEngine/PerformanceAlert.hpp"
 
@@ -311,6 +312,12 @@ u32 D3DXRenderBase::GetCacheStatPolys()
 {
     return RCache.stat.polys;
 }
+void D3DXRenderBase::BeforeRender()
+{
+    // The game is done with the frame, the skeletons drawn by the previous one are calculated at once
+    CKinematics::CalculateBones_Batch();
+}
+
 void D3DXRenderBase::Begin()
 {
 #ifdef USE_DX9
@@ -397,6 +404,8 @@ void D3DXRenderBase::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
     font.OutNext("*** RENDER:   %2.2fms", renderTotal);
     font.OutNext("Calc:         %2.2fms, %2.1f%%", BasicStats.Culling.result, PPP(BasicStats.Culling.result));
     font.OutNext("Skeletons:    %2.2fms, %d", BasicStats.Animation.result, BasicStats.Animation.count);
+    font.OutNext("- batch:      %2.2fms, %u skeletons, %u bones", BasicStats.AnimationBatch.result,
+        BasicStats.AnimationSkeletons, BasicStats.AnimationBones);
     font.OutNext("Primitives:   %2.2fms, %2.1f%%", BasicStats.Primitives.result, PPP(BasicStats.Primitives.result));
     font.OutNext("Wait-L:       %2.2fms", BasicStats.Wait.result);
     font.OutNext("Wait-S:       %2.2fms", BasicStats.WaitS.result);
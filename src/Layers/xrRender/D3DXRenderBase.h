@@ -210,6 +210,7 @@ public:
     virtual u32 GetCacheStatPolys() override;
     virtual void Begin() override;
     void BeforeFrame() override {}
+    void BeforeRender() override;
     virtual void Clear() override;
     virtual void End() override;
     virtual void ClearTarget() override;
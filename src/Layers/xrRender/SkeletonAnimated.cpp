@@ -12,6 +12,7 @@
 #include "xrCore/dump_string.h"
 #endif
 extern int psSkeletonUpdate;
+extern int psSkeletonStreams;
 using namespace animation;
 
 //////////////////////////////////////////////////////////////////////////
@@ -830,10 +831,12 @@ void CKinematicsAnimated::Load(const char* N, IReader* data, u32 dwFlags)
     {
         SMotionsSlot& MS = m_it;
         MS.bone_motions.resize(bones->size());
+        MS.bone_tracks.resize(bones->size());
         for (u32 i = 0; i < bones->size(); i++)
         {
             CBoneData* BD = (*bones)[i];
             MS.bone_motions[i] = MS.motions.bone_motions(BD->name);
+            MS.bone_tracks[i] = MS.motions.track(BD->name);
         }
     }
 
@@ -844,15 +847,182 @@ void CKinematicsAnimated::Load(const char* N, IReader* data, u32 dwFlags)
     //.		Msg("* WARNING: model '%s' has only one motion. Candidate for SkeletonRigid???",N);
 }
 
+void CKinematicsAnimated::LL_DecodeKeys()
+{
+    const u16 count = LL_BoneCount();
+    m_decoded_first.resize(count + 1);
+    u32 total = 0;
+    for (u16 bone = 0; bone < count; ++bone)
+    {
+        m_decoded_first[bone] = total;
+        total += blend_instances[bone].blend_vector().size();
+    }
+    m_decoded_first[count] = total;
+    m_decoded.resize(total);
+    for (auto& it : m_decoded)
+        it.blend = nullptr;
+
+    // Every blend is dequantized by four bones, they are usually neighbours in the streams
+    const auto decode = [&](const CBlend* B)
+    {
+        SMotionsSlot& slot = m_Motions[B->motionID.slot];
+        const CMotionStreams* streams = slot.motions.streams(B->motionID.idx);
+        CKey lanes[4];
+        u32 decoded = u32(-1);
+        for (u16 bone = 0; bone < count; ++bone)
+        {
+            const u16 track = slot.bone_tracks[bone];
+            CBlendInstance::BlendSVec& blends = blend_instances[bone].blend_vector();
+            const auto it = std::find(blends.begin(), blends.end(), B);
+            if (track == BI_NONE || it == blends.end())
+                continue;
+
+            const u32 group = track / 4;
+            if (group != decoded)
+            {
+                streams->Dequantize(lanes, group, B->timeCurrent);
+                decoded = group;
+            }
+            SDecodedKey& D = m_decoded[m_decoded_first[bone] + u32(it - blends.begin())];
+            D.blend = B;
+            D.motion = B->motionID;
+            D.time = B->timeCurrent;
+            D.key = lanes[track % 4];
+        }
+    };
+    for (const auto& part : blend_cycles)
+    {
+        for (const CBlend* B : part)
+            decode(B);
+    }
+    for (const CBlend* B : blend_fx)
+        decode(B);
+}
+
+const CKey* CKinematicsAnimated::LL_DecodedKey(u16 bone, u32 blend_idx, const CBlend& B) const
+{
+    if (u32(bone) + 1 >= m_decoded_first.size())
+        return nullptr;
+    const u32 idx = m_decoded_first[bone] + blend_idx;
+    if (idx >= m_decoded_first[bone + 1])
+        return nullptr;
+    const SDecodedKey& D = m_decoded[idx];
+    if (D.blend != &B || D.motion != B.motionID || D.time != B.timeCurrent)
+        return nullptr;
+    return &D.key;
+}
+
+// Dequantization speed of all the loaded motions, bone by bone against the motion streams
+void motion_streams_benchmark(u32 samples)
+{
+    xr_vector<motions_value*> values;
+    g_pMotionsContainer->for_each([&](motions_value& value) { values.push_back(&value); });
+
+    CTimer timer;
+    timer.Start();
+    u32 motions = 0, memory = 0;
+    for (motions_value* value : values)
+    {
+        for (u16 idx = 0; idx < value->m_streams.size(); ++idx, ++motions)
+            memory += value->streams(idx)->mem_usage();
+    }
+    Msg("* [motion streams] %u motions converted in %2.3f ms, %u Kb", motions, timer.GetElapsed_sec() * 1000.f,
+        memory / 1024);
+
+    CBlend B;
+    CKey key, lanes[4];
+    float max_angle = 0.f, max_distance = 0.f;
+    for (motions_value* value : values)
+    {
+        for (u16 idx = 0; idx < value->m_streams.size(); ++idx)
+        {
+            const CMotionStreams* streams = value->streams(idx);
+            const float length = value->m_tracks[0]->at(idx).GetLength();
+            for (u32 s = 0; s < samples; ++s)
+            {
+                B.timeCurrent = length * (float(s) + 0.5f) / float(samples);
+                for (u32 t = 0; t < value->m_tracks.size(); ++t)
+                {
+                    if (t % 4 == 0)
+                        streams->Dequantize(lanes, t / 4, B.timeCurrent);
+                    Dequantize(key, B, value->m_tracks[t]->at(idx));
+                    const CKey& lane = lanes[t % 4];
+                    const float cosom = _abs(key.Q.x * lane.Q.x + key.Q.y * lane.Q.y + key.Q.z * lane.Q.z +
+                        key.Q.w * lane.Q.w) / _sqrt(key.Q.magnitude());
+                    max_angle = std::max(max_angle, 2.f * acosf(std::min(cosom, 1.f)));
+                    max_distance = std::max(max_distance, key.T.distance_to(lane.T));
+                }
+            }
+        }
+    }
+
+    const auto run = [&](pcstr mode, bool packed)
+    {
+        u32 bones = 0;
+        float checksum = 0.f;
+        timer.Start();
+        for (motions_value* value : values)
+        {
+            const u32 tracks = u32(value->m_tracks.size());
+            for (u16 idx = 0; idx < value->m_streams.size(); ++idx)
+            {
+                const CMotionStreams* streams = value->streams(idx);
+                const float length = value->m_tracks[0]->at(idx).GetLength();
+                for (u32 s = 0; s < samples; ++s)
+                {
+                    B.timeCurrent = length * (float(s) + 0.5f) / float(samples);
+                    if (packed)
+                    {
+                        for (u32 group = 0; group < streams->groups(); ++group)
+                        {
+                            streams->Dequantize(lanes, group, B.timeCurrent);
+                            checksum += lanes[0].Q.w;
+                        }
+                    }
+                    else
+                    {
+                        for (u32 t = 0; t < tracks; ++t)
+                        {
+                            Dequantize(key, B, value->m_tracks[t]->at(idx));
+                            checksum += key.Q.w;
+                        }
+                    }
+                    bones += tracks;
+                }
+            }
+        }
+        const float us = std::max(timer.GetElapsed_sec() * 1000000.f, 1.f);
+        static volatile float sink;
+        sink = checksum;
+        Msg("* [%s] %u bones in %2.3f ms: %2.2f bones/us", mode, bones, us / 1000.f, float(bones) / us);
+    };
+    run("bone by bone", false);
+    run("motion streams", true);
+    Msg("* [motion streams] max difference: rotation %2.4f deg, translation %2.5f m", rad2deg(max_angle),
+        max_distance);
+}
+
+void CKinematicsAnimated::OnCalculateBonesExact()
+{
+    if (psSkeletonStreams)
+        LL_DecodeKeys();
+    else if (!m_decoded.empty())
+    {
+        m_decoded.clear();
+        m_decoded_first.clear();
+    }
+}
+
 void CKinematicsAnimated::LL_BuldBoneMatrixDequatize(const CBoneData* bd, u8 channel_mask, SKeyTable& keys)
 {
     u16 SelfID = bd->GetSelfID();
     CBlendInstance& BLEND_INST = LL_GetBlendInstance(SelfID);
     CKey BK[MAX_CHANNELS][MAX_BLENDED]; // base keys
 
-    for (auto &it : BLEND_INST.blend_vector())
+    CBlendInstance::BlendSVec& blends = BLEND_INST.blend_vector();
+    for (u32 blend_idx = 0; blend_idx < blends.size(); ++blend_idx)
     {
-        CBlend* B = it;
+        CBlend* B = blends[blend_idx];
         int& b_count = keys.chanel_blend_conts[B->channel];
         CKey* D = &keys.keys[B->channel][b_count];
         if (!(channel_mask & (1 << B->channel)))
@@ -861,7 +1031,10 @@ void CKinematicsAnimated::LL_BuldBoneMatrixDequatize(const CBoneData* bd, u8 cha
         // keys.blend_factors[channel][b_count]	=  B->blendAmount;
         keys.blends[channel][b_count] = B;
         CMotion& M = *LL_GetMotion(B->motionID, SelfID);
-        Dequantize(*D, *B, M);
+        if (const CKey* decoded = LL_DecodedKey(SelfID, blend_idx, *B))
+            *D = *decoded;
+        else
+            Dequantize(*D, *B, M);
         QR2Quat(M._keysR[0], BK[channel][b_count].Q);
         if (M.test_flag(flTKeyPresent))
         {
@@ -58,6 +58,8 @@ private:
 public:
     // Calculation
 private:
+    void LL_DecodeKeys();
+    const CKey* LL_DecodedKey(u16 bone, u32 blend_idx, const CBlend& B) const;
     void LL_BuldBoneMatrixDequatize(const CBoneData* bd, u8 channel_mask, SKeyTable& keys);
     void LL_BoneMatrixBuild(CBoneInstance& bi, const Fmatrix* parent, const SKeyTable& keys);
     virtual void BuildBoneMatrix(
@@ -68,6 +70,7 @@ public:
     virtual void LL_ClearAdditionalTransform(u16 bone_id = BI_NONE); //--#SM+#--
 
     virtual void OnCalculateBones();
+    void OnCalculateBonesExact() override;
 
 public:
 #ifdef _EDITOR
@@ -83,10 +86,23 @@ private:
     {
         shared_motions motions;
         BoneMotionsVec bone_motions;
+        xr_vector<u16> bone_tracks; // lanes of the motion streams
     };
     using MotionsSlotVec = xr_vector<SMotionsSlot>;
     MotionsSlotVec m_Motions;
 
+    // Keys of the blends decoded by the motion streams for the whole skeleton,
+    // the bones calculation falls back to Dequantize when the blend has changed since
+    struct SDecodedKey
+    {
+        const CBlend* blend;
+        MotionID motion;
+        float time;
+        CKey key;
+    };
+    xr_vector<SDecodedKey> m_decoded; // the blends of every bone, one bone after another
+    xr_vector<u32> m_decoded_first; // by bone, and the total
+
     CPartition* m_Partition;
 
     IBlendDestroyCallback* m_blend_destroy_callback;
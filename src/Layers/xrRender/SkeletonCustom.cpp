@@ -9,6 +9,8 @@
 #include "xrEngine/Render.h"
 #endif
 int psSkeletonUpdate = 32;
+int psSkeletonParallel = 1;
+int psSkeletonStreams = 1;
 Lock UCalc_Mutex
 #ifdef CONFIG_PROFILE_LOCKS
     (MUTEX_PROFILE_ID(UCalc_Mutex))
@@ -107,10 +109,12 @@ CKinematics::CKinematics()
 #endif
 
     m_is_original_lod = false;
+    UCalc_Batched = false;
 }
 
 CKinematics::~CKinematics()
 {
+    CalculateBones_Unschedule();
     IBoneInstances_Destroy();
     // wallmarks
     ClearWallmarks();
@@ -447,6 +451,7 @@ void CKinematics::Spawn()
 void CKinematics::Depart()
 {
     inherited::Depart();
+    CalculateBones_Unschedule();
     // wallmarks
     ClearWallmarks();
 
@@ -123,6 +123,7 @@ public:
     virtual void BuildBoneMatrix(
         const CBoneData* bd, CBoneInstance& bi, const Fmatrix* parent, u8 mask_channel = (1 << 0));
     virtual void OnCalculateBones() {}
+    virtual void OnCalculateBonesExact() {} // right before the bones of the whole skeleton are calculated
 
     virtual void CalculateBonesAdditionalTransforms(
         const CBoneData* bd, CBoneInstance& bi, const Fmatrix* parent, u8 mask_channel = (1 << 0)); //--#SM+#--
@@ -150,6 +151,7 @@ protected:
     BOOL Update_Visibility;
     u32 UCalc_Time;
     s32 UCalc_Visibox;
+    bool UCalc_Batched; // drawn and waiting for CalculateBones_Batch()
 
     Flags64 visimask;
 
@@ -161,6 +163,9 @@ protected:
     virtual void IBoneInstances_Destroy();
     void Visibility_Invalidate() { Update_Visibility = TRUE; }
     void Visibility_Update();
+    void CalculateBones_Exact(); // the caller holds UCalc_Mutex
+    bool CalculateBones_Callbacks(); // game code is called from the bones calculation
+    void CalculateBones_Unschedule();
 
     void LL_Validate();
 
@@ -269,6 +274,11 @@ public:
     // Main functionality
     void CalculateBones(BOOL bForceExact = FALSE) override; // Recalculate skeleton
     void CalculateBones_Invalidate() override;
+    void CalculateBones_Visible(); // called by the renderer for the drawn skeletons
+
+    // Batch animation stage (rs_skeleton_parallel): the skeletons drawn by the previous frame
+    // are calculated in parallel before the next one is rendered
+    static void CalculateBones_Batch();
     void Callback(UpdateCallback C, void* Param) override
     {
         Update_Callback = C;
@@ -3,8 +3,20 @@
 #pragma hdrstop
 
 #include "SkeletonCustom.h"
+#include "xrCore/Threading/ScopeLock.hpp"
+#include "xrCore/Threading/TaskManager.hpp"
 
 extern int psSkeletonUpdate;
+extern int psSkeletonParallel;
+
+namespace
+{
+Lock batch_lock; // guards batch_visible
+xr_vector<CKinematics*> batch_visible; // drawn by the current frame
+xr_vector<CKinematics*> batch_parallel;
+xr_vector<CKinematics*> batch_serial;
+std::atomic_bool batch_running; // the batch holds UCalc_Mutex, all the calculations are its own
+} // namespace
 
 #ifdef DEBUG
 void check_kinematics(CKinematics* _k, LPCSTR s);
@@ -21,6 +33,11 @@ void CKinematics::CalculateBones(BOOL bForceExact)
     OnCalculateBones();
     if (!bForceExact && (RDEVICE.dwTimeGlobal < (UCalc_Time + UCalc_Interval)))
         return; // early out for "slow" update
+    CalculateBones_Exact();
+}
+
+void CKinematics::CalculateBones_Exact()
+{
     if (Update_Visibility)
         Visibility_Update();
 
@@ -33,21 +50,28 @@ void CKinematics::CalculateBones(BOOL bForceExact)
 // exact computation
 // Calculate bones
 #ifdef DEBUG
-    RImplementation.BasicStats.Animation.Begin();
+    // The batch stage times itself, the timer isn't shared between the threads
+    const bool timed = !batch_running;
+    if (timed)
+        RImplementation.BasicStats.Animation.Begin();
 #endif
 
+    OnCalculateBonesExact();
     Bone_Calculate(bones->at(iRoot), &Fidentity);
 #ifdef DEBUG
     check_kinematics(this, dbg_name.c_str());
-    RImplementation.BasicStats.Animation.End();
+    if (timed)
+        RImplementation.BasicStats.Animation.End();
 #endif
     VERIFY(LL_GetBonesVisible() != 0);
     // Calculate BOXes/Spheres if needed
     UCalc_Visibox++;
     if (UCalc_Visibox >= psSkeletonUpdate)
     {
-        // mark
-        UCalc_Visibox = -(::Random.randI(psSkeletonUpdate - 1));
+        // mark, the jitter spreads the updates of the skeletons over the frames.
+        // It's not taken from the global random, this may run on a worker thread
+        const u32 jitter = (u32(uintptr_t(this) >> 4) ^ UCalc_Time) * 2654435761u;
+        UCalc_Visibox = -s32(jitter % u32(psSkeletonUpdate - 1));
 
         // the update itself
         Fbox Box;
@@ -120,6 +144,97 @@ void CKinematics::CalculateBones(BOOL bForceExact)
         Update_Callback(this);
 }
 
+bool CKinematics::CalculateBones_Callbacks()
+{
+    if (Update_Callback)
+        return true;
+    for (u16 i = 0; i < LL_BoneCount(); ++i)
+    {
+        if (bone_instances[i].callback())
+            return true;
+    }
+    return false;
+}
+
+void CKinematics::CalculateBones_Visible()
+{
+    if (!UCalc_Batched)
+    {
+        ScopeLock lock(&batch_lock);
+        UCalc_Batched = true;
+        batch_visible.push_back(this);
+    }
+    CalculateBones(TRUE);
+}
+
+void CKinematics::CalculateBones_Unschedule()
+{
+    if (!UCalc_Batched)
+        return;
+    ScopeLock lock(&batch_lock);
+    UCalc_Batched = false;
+    const auto it = std::find(batch_visible.begin(), batch_visible.end(), this);
+    if (it != batch_visible.end())
+        batch_visible.erase(it);
+}
+
+void CKinematics::CalculateBones_Batch()
+{
+    ScopeLock lock(&batch_lock);
+    if (batch_visible.empty())
+        return;
+
+    // The renderer fills it again for the next frame
+    for (CKinematics* K : batch_visible)
+        K->UCalc_Batched = false;
+    if (!psSkeletonParallel || !TaskScheduler->GetWorkersCount())
+    {
+        batch_visible.clear();
+        return;
+    }
+
+    // Nobody else calculates the bones meanwhile
+    UCalc_mtlock calc_lock;
+    RImplementation.BasicStats.AnimationBatch.Begin();
+
+    // Tracks are updated here, their callbacks go into the game code.
+    // Skeletons with the game callbacks on the bones are calculated here as well.
+    batch_parallel.clear();
+    batch_serial.clear();
+    u32 bones_count = 0;
+    for (CKinematics* K : batch_visible)
+    {
+        if (RDEVICE.dwTimeGlobal == K->UCalc_Time)
+            continue;
+        K->OnCalculateBones();
+        if (K->CalculateBones_Callbacks())
+            batch_serial.push_back(K);
+        else
+        {
+            // Calculated already for anybody who asks while it's still in progress
+            K->UCalc_Time = RDEVICE.dwTimeGlobal;
+            batch_parallel.push_back(K);
+        }
+        bones_count += K->LL_BoneCount();
+    }
+    batch_visible.clear();
+
+    batch_running = true;
+    TaskScheduler->ParallelFor(0, batch_parallel.size(), 1, [](size_t from, size_t to)
+    {
+        for (size_t i = from; i < to; ++i)
+            batch_parallel[i]->CalculateBones_Exact();
+    });
+    batch_running = false;
+
+    for (CKinematics* K : batch_serial)
+        K->CalculateBones_Exact();
+
+    RImplementation.BasicStats.AnimationSkeletons += u32(batch_parallel.size() + batch_serial.size());
+    RImplementation.BasicStats.AnimationBones += bones_count;
+    RImplementation.BasicStats.AnimationBatch.End();
+}
+
 #ifdef DEBUG
 void check_kinematics(CKinematics* _k, LPCSTR s)
 {
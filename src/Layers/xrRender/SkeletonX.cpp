@@ -22,10 +22,35 @@
 #include "xrCore/FMesh.hpp"
 #include "xrCore/Math/MathUtil.hpp"
 
+#include "xrCore/Threading/TaskManager.hpp"
+
 using namespace XRay::Math;
 
+extern int psSkeletonParallel;
+
 shared_str s_bones_array_const;
 
+namespace
+{
+constexpr u32 SKINNING_GRAIN = 4096; // vertices skinned by one task
+
+// Big meshes are split between the worker threads, the dynamic buffer is locked already
+template <typename Vertex>
+void Skin(void (*skin)(vertRender*, Vertex*, u32, CBoneInstance*), vertRender* dest, Vertex* src, u32 vCount,
+    CBoneInstance* bones)
+{
+    if (!psSkeletonParallel || vCount < 2 * SKINNING_GRAIN)
+    {
+        skin(dest, src, vCount, bones);
+        return;
+    }
+    TaskScheduler->ParallelFor(0, vCount, SKINNING_GRAIN, [=](size_t from, size_t to)
+    {
+        skin(dest + from, src + from, u32(to - from), bones);
+    });
+}
+} // namespace
+
 //////////////////////////////////////////////////////////////////////
 // Body Part
 //////////////////////////////////////////////////////////////////////
@@ -123,7 +148,7 @@ void CSkeletonX::_Render_soft(ref_geom& hGeom, u32 vCount, u32 iOffset, u32 pCou
         RImplementation.BasicStats.Skinning.Begin();
         if (*Vertices1W)
         {
-            Skin1W(Dest, // dest
+            Skin(Skin1W, Dest, // dest
                 *Vertices1W, // source
                 vCount, // count
                 Parent->bone_instances // bones
@@ -131,7 +156,7 @@ void CSkeletonX::_Render_soft(ref_geom& hGeom, u32 vCount, u32 iOffset, u32 pCou
         }
         else if (*Vertices2W)
         {
-            Skin2W(Dest, // dest
+            Skin(Skin2W, Dest, // dest
                 *Vertices2W, // source
                 vCount, // count
                 Parent->bone_instances // bones
@@ -139,7 +164,7 @@ void CSkeletonX::_Render_soft(ref_geom& hGeom, u32 vCount, u32 iOffset, u32 pCou
         }
         else if (*Vertices3W)
         {
-            Skin3W(Dest, // dest
+            Skin(Skin3W, Dest, // dest
                 *Vertices3W, // source
                 vCount, // count
                 Parent->bone_instances // bones
@@ -147,7 +172,7 @@ void CSkeletonX::_Render_soft(ref_geom& hGeom, u32 vCount, u32 iOffset, u32 pCou
         }
         else if (*Vertices4W)
         {
-            Skin4W(Dest, // dest
+            Skin(Skin4W, Dest, // dest
                 *Vertices4W, // source
                 vCount, // count
                 Parent->bone_instances // bones
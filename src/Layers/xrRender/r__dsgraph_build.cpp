@@ -401,7 +401,7 @@ void CRender::add_leafs_Dynamic(dxRender_Visual* pVisual)
         }
         else
         {
-            pV->CalculateBones(TRUE);
+            pV->CalculateBones_Visible();
             pV->CalculateWallmarks(); //. bug?
             for (auto& i : pV->children)
             {
@@ -465,7 +465,7 @@ void CRender::add_leafs_Static(dxRender_Visual* pVisual)
     {
         // Add all children, doesn't perform any tests
         CKinematics* pV = (CKinematics*)pVisual;
-        pV->CalculateBones(TRUE);
+        pV->CalculateBones_Visible();
         for (auto& i : pV->children)
         {
             i->vis.obj_data = pV->getVisData().obj_data; // Наследники используют шейдерные данные от родительского визуала
@@ -600,7 +600,7 @@ BOOL CRender::add_Dynamic(dxRender_Visual* pVisual, u32 planes)
         }
         else
         {
-            pV->CalculateBones(TRUE);
+            pV->CalculateBones_Visible();
             pV->CalculateWallmarks(); //. bug?
             for (auto& i : pV->children)
                 add_leafs_Dynamic(i);
@@ -681,7 +681,7 @@ void CRender::add_Static(dxRender_Visual* pVisual, u32 planes)
     {
         // Add all children, doesn't perform any tests
         CKinematics* pV = (CKinematics*)pVisual;
-        pV->CalculateBones(TRUE);
+        pV->CalculateBones_Visible();
         if (fcvPartial == VIS)
         {
             for (auto& i : pV->children)
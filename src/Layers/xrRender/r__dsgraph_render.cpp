@@ -636,7 +636,7 @@ void D3DXRenderBase::r_dsgraph_render_R1_box(IRender_Sector* S, Fbox& BB, int sh
         {
             // Add all children	(s)
             CKinematics* pV = (CKinematics*)V;
-            pV->CalculateBones(TRUE);
+            pV->CalculateBones_Visible();
             for (auto& i : pV->children)
             {
                 dxRender_Visual* T = i;
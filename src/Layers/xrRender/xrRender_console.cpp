@@ -80,6 +80,9 @@ int ps_r2_fxaa = 0;
 
 // Common
 extern int psSkeletonUpdate;
+extern int psSkeletonParallel;
+extern int psSkeletonStreams;
+void motion_streams_benchmark(u32 samples);
 extern float r__dtex_range;
 
 //int ps_r__Supersample = 1;
@@ -391,6 +394,21 @@ public:
     virtual void Execute(LPCSTR /*args*/) { RImplementation.Models->dump(); }
 };
 
+// Motion keys dequantization speed, bone by bone vs the motion streams
+class CCC_MotionStreamsBench : public IConsole_Command
+{
+public:
+    CCC_MotionStreamsBench(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+    virtual void Execute(LPCSTR args)
+    {
+        u32 samples = 30;
+        if (args && args[0])
+            sscanf(args, "%u", &samples);
+        clamp(samples, u32(1), u32(1000));
+        motion_streams_benchmark(samples);
+    }
+};
+
 class CCC_SSAO_Mode : public CCC_Token
 {
 public:
@@ -697,6 +715,9 @@ void xrRender_initconsole()
     CMD3(CCC_Preset, "_preset", &ps_Preset, qpreset_token);
 
     CMD4(CCC_Integer, "rs_skeleton_update", &psSkeletonUpdate, 2, 128);
+    CMD4(CCC_Integer, "rs_skeleton_parallel", &psSkeletonParallel, 0, 1);
+    CMD4(CCC_Integer, "rs_skeleton_streams", &psSkeletonStreams, 0, 1);
+    CMD1(CCC_MotionStreamsBench, "dbg_motion_streams_bench");
 #ifdef DEBUG
     CMD1(CCC_DumpResources, "dump_resources");
 #endif // DEBUG
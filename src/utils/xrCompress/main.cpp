@@ -1,23 +1,45 @@
 #include "stdafx.h"
 #include "xrCompress.h"
 
+#include "xrCore/Threading/TaskManager.hpp"
+
 #ifndef MOD_COMPRESS
-extern int ProcessDifference();
+extern int ProcessDifference(LPCSTR params);
 #endif
 
+// Compression workers
+class CompressTaskManager : public TaskManagerBase
+{
+public:
+    void DumpStatistics(class IGameFont& font, class IPerformanceAlert* alert) override {}
+};
+
 int __cdecl main(int argc, char* argv[])
 {
+#if defined(WINDOWS)
     LPCSTR params = GetCommandLine();
+#else
+    xr_string command_line;
+    for (int i = 0; i < argc; ++i)
+    {
+        command_line += argv[i];
+        command_line += " ";
+    }
+    LPCSTR params = command_line.c_str();
+#endif
 
     xrDebug::Initialize(params);
-    Core.Initialize("xrCompress", 0, FALSE);
+    Core.Initialize("xrCompress");
     printf("\n\n");
 
+    TaskScheduler = xr_make_unique<CompressTaskManager>();
+    TaskScheduler->Initialize();
+
 
 #ifndef MOD_COMPRESS
     if (strstr(params, "-diff"))
     {
-        ProcessDifference();
+        ProcessDifference(params);
     }
     else
 #endif
@@ -29,22 +51,30 @@ int __cdecl main(int argc, char* argv[])
             printf("-diff /? option to get information about creating difference.\n");
             printf("-fast	- fast compression.\n");
             printf("-store	- store files. No compression.\n");
+            printf("-codec <lzo|lz4|zstd|zstd_dict> - default codec, lzo if omitted.\n");
             printf("-ltx <file_name.ltx> - pathes to compress.\n");
             printf("\n");
             printf("LTX format:\n");
             printf("	[config]\n");
             printf("	;<path>     = <recurse>\n");
-            printf("	.\\         = false\n");
+            printf("	." DELIMITER "         = false\n");
             printf("	textures    = true\n");
+            printf("	[codecs]\n");
+            printf("	;<extension> = <codec>\n");
+            printf("	.ltx        = zstd_dict\n");
+            printf("	[options]\n");
+            printf("	;files compressed in blocks to be streamed (none by default)\n");
+            printf("	;stream_files = level.geom, level.geomx, *.ogm\n");
 
+            TaskScheduler.reset();
             Core._destroy();
             return 3;
         }
 #endif
 
         string_path folder;
-        strconcat(sizeof(folder), folder, argv[1], "\\");
-        _strlwr_s(folder, sizeof(folder));
+        strconcat(sizeof(folder), folder, argv[1], DELIMITER);
+        xr_strlwr(folder);
         printf("\nCompressing files (%s)...\n\n", folder);
 
         FS._initialize(CLocatorAPI::flTargetFolderOnly, folder);
@@ -54,6 +84,17 @@ int __cdecl main(int argc, char* argv[])
 
         C.SetStoreFiles(NULL != strstr(params, "-store"));
         C.SetFastMode(NULL != strstr(params, "-fast"));
+
+        if (LPCSTR c = strstr(params, "-codec "))
+        {
+            string64 codec_name;
+            sscanf(c + 7, "%63[^ ] ", codec_name);
+            const ArchiveCodec codec = archive_codec_by_name(codec_name, ArchiveCodec::Count);
+            if (codec != ArchiveCodec::Count && archive_codec_supported(codec))
+                C.SetCodec(codec);
+            else
+                printf("Codec [%s] isn't supported, LZO will be used.\n", codec_name);
+        }
         C.SetTargetName(argv[1]);
 
         LPCSTR p = strstr(params, "-ltx");
@@ -76,6 +117,7 @@ int __cdecl main(int argc, char* argv[])
         }
     }
 
+    TaskScheduler.reset();
     Core._destroy();
     return 0;
 }
@@ -5,8 +5,8 @@
 #include "Common/Common.hpp"
 #include "xrCore/xrCore.h"
 
-#include "lzo/lzo1x.h"
-
+#if defined(WINDOWS)
 #include <mmsystem.h>
 
 #pragma comment(lib, "winmm")
+#endif
@@ -1,9 +1,21 @@
 #include "stdafx.h"
 #include "xrCompress.h"
 
+#include "xrCore/Threading/ScopeLock.hpp"
+#include "xrCore/Threading/TaskManager.hpp"
+
+#include <thread>
+
+namespace
+{
+constexpr size_t PIPELINE_FILES_PER_THREAD = 4; // files read ahead of the writer
+constexpr size_t PIPELINE_MAX_BYTES = 256 * 1024 * 1024; // source data read ahead of the writer
+constexpr u32 PROGRESS_INTERVAL = 2000; // ms
+} // namespace
+
 xrCompressor::xrCompressor()
     : fs_pack_writer(NULL), bFast(false), files_list(NULL), folders_list(NULL), bStoreFiles(false), pPackHeader(NULL),
-      config_ltx(NULL)
+      config_ltx(NULL), default_codec(ArchiveCodec::LZO), dictionary(NULL), next_file(0), pending_bytes(0)
 {
     bytesSRC = 0;
     bytesDST = 0;
@@ -11,8 +23,12 @@ xrCompressor::xrCompressor()
     filesSKIP = 0;
     filesVFS = 0;
     filesALIAS = 0;
-    c_heap = NULL;
+    compress_time = 0;
     dwTimeStart = 0;
+    bytes_read_total = 0;
+    bytes_written_total = 0;
+    files_written_total = 0;
+    ZeroMemory(codec_stats, sizeof(codec_stats));
 
     XRP_MAX_SIZE = 1024 * 1024 * 640; // bytes (640Mb)
 }
@@ -21,6 +37,7 @@ xrCompressor::~xrCompressor()
 {
     if (pPackHeader)
         FS.r_close(pPackHeader);
+    xr_delete(dictionary);
 }
 
 bool is_tail(LPCSTR name, LPCSTR tail, const u32 tlen)
@@ -39,15 +56,16 @@ bool xrCompressor::testSKIP(LPCSTR path)
     string256 p_ext;
     _splitpath(path, 0, 0, p_name, p_ext);
 
-    if (strstr(path, "textures\\lod\\"))
+    if (strstr(path, "textures" DELIMITER "lod" DELIMITER))
         return true;
-    if (strstr(path, "textures\\det\\"))
+    if (strstr(path, "textures" DELIMITER "det" DELIMITER))
         return true;
 
-    if (xr_stricmp(p_ext, ".thm") && strstr(path, "textures\\terrain\\terrain_") && !is_tail(p_name, "_mask", 5))
+    if (xr_stricmp(p_ext, ".thm") && strstr(path, "textures" DELIMITER "terrain" DELIMITER "terrain_") &&
+        !is_tail(p_name, "_mask", 5))
         return true;
 
-    if (strstr(path, "textures\\") && is_tail(p_name, "_nmap", 5) && !strstr(p_name, "water_flowing_nmap"))
+    if (strstr(path, "textures" DELIMITER) && is_tail(p_name, "_nmap", 5) && !strstr(p_name, "water_flowing_nmap"))
         return true;
 
     if (0 == xr_stricmp(p_name, "build"))
@@ -95,11 +113,28 @@ bool xrCompressor::testSKIP(LPCSTR path)
     return false;
 }
 
+bool xrCompressor::testSTREAM(LPCSTR path)
+{
+    string256 p_name;
+    string256 p_ext;
+    _splitpath(path, 0, 0, p_name, p_ext);
+    xr_strcat(p_name, p_ext);
+
+    for (const auto& it : stream_files)
+        if (PatternMatch(p_name, it.c_str()))
+            return true;
+
+    return false;
+}
+
 bool xrCompressor::testVFS(LPCSTR path)
 {
     if (bStoreFiles)
         return (true);
 
+    if (testSTREAM(path))
+        return (false);
+
     string256 p_ext;
     _splitpath(path, 0, 0, 0, p_ext);
 
@@ -148,16 +183,91 @@ xrCompressor::ALIAS* xrCompressor::testALIAS(IReader* base, u32 crc, u32& a_test
     return NULL;
 }
 
-void xrCompressor::write_file_header(
-    LPCSTR file_name, const u32& crc, const u32& ptr, const u32& size_real, const u32& size_compressed)
+ArchiveCodec xrCompressor::SelectCodec(LPCSTR path)
+{
+    string256 p_ext;
+    _splitpath(path, 0, 0, 0, p_ext);
+    xr_strlwr(p_ext);
+
+    const auto it = ext_codecs.find(p_ext);
+    return it != ext_codecs.end() ? it->second : default_codec;
+}
+
+void xrCompressor::TrainDictionary()
+{
+    constexpr size_t DICTIONARY_SIZE = 112 * 1024;
+    constexpr size_t SAMPLES_MAX_SIZE = 64 * 1024 * 1024;
+
+    xr_delete(dictionary);
+
+    CMemoryWriter samples;
+    xr_vector<size_t> sample_sizes;
+    for (LPCSTR path : *files_list)
+    {
+        if (SelectCodec(path) != ArchiveCodec::ZstdDict || testSKIP(path))
+            continue;
+
+        string_path fn;
+        strconcat(sizeof(fn), fn, target_name.c_str(), DELIMITER, path);
+        IReader* src = FS.r_open(fn);
+        if (!src)
+            continue;
+
+        if (src->length() && samples.size() + src->length() <= SAMPLES_MAX_SIZE)
+        {
+            samples.w(src->pointer(), src->length());
+            sample_sizes.push_back(src->length());
+        }
+        FS.r_close(src);
+    }
+
+    if (sample_sizes.empty())
+        return;
+
+    printf("...Training dictionary on %u files\n", u32(sample_sizes.size()));
+    xr_vector<u8> dict(DICTIONARY_SIZE);
+    const size_t size = archive_train_dictionary(
+        dict.data(), dict.size(), samples.pointer(), sample_sizes.data(), u32(sample_sizes.size()));
+
+    if (size)
+    {
+        dictionary = new ArchiveDictionary(dict.data(), size);
+        Msg("Dictionary size: %uK, trained on %u files", u32(size / 1024), u32(sample_sizes.size()));
+    }
+    else
+        Msg("! Files for [%s] codec will be compressed without dictionary", archive_codec_name(ArchiveCodec::ZstdDict));
+}
+
+void xrCompressor::DumpCodecStats()
+{
+    for (size_t i = 0; i < size_t(ArchiveCodec::Count); ++i)
+    {
+        const CODEC_STATS& stats = codec_stats[i];
+        if (!stats.files)
+            continue;
+
+        const float megabytes = float(stats.bytes_src) / float(1024 * 1024);
+        const float compress_sec = float(stats.compress_time) / 1000000000.f;
+        const float decompress_sec = float(stats.decompress_time) / 1000000000.f;
+        Msg("%-10s files: %6d, %dK/%dK, %3.1f%%, compression: %3.1f Mb/s, decompression: %3.1f Mb/s",
+            archive_codec_name(ArchiveCodec(i)), stats.files, u32(stats.bytes_dst / 1024), u32(stats.bytes_src / 1024),
+            100.f * float(stats.bytes_dst) / float(stats.bytes_src), compress_sec > 0.f ? megabytes / compress_sec : 0.f,
+            decompress_sec > 0.f ? megabytes / decompress_sec : 0.f);
+    }
+}
+
+void xrCompressor::write_file_header(LPCSTR file_name, const u32& crc, const u32& ptr, const u32& size_real,
+    const u32& size_compressed, ArchiveCodec codec /*= ArchiveCodec::LZO*/, bool blocks /*= false*/)
 {
+    // LZO entries keep the original format
+    const bool write_codec = codec != ArchiveCodec::LZO || blocks;
     size_t file_name_size = (xr_strlen(file_name) + 0) * sizeof(char);
-    size_t buffer_size = file_name_size + 4 * sizeof(u32);
-    VERIFY(buffer_size <= 65535);
+    size_t buffer_size = file_name_size + 4 * sizeof(u32) + (write_codec ? sizeof(u8) : 0);
+    VERIFY(buffer_size < ARCHIVE_ENTRY_CODEC_MARK);
     size_t full_buffer_size = buffer_size + sizeof(u16);
     u8* buffer = (u8*)xr_alloca(full_buffer_size);
     u8* buffer_start = buffer;
-    *(u16*)buffer = (u16)buffer_size;
+    *(u16*)buffer = (u16)buffer_size | (write_codec ? ARCHIVE_ENTRY_CODEC_MARK : 0);
     buffer += sizeof(u16);
 
     *(u32*)buffer = size_real;
@@ -173,34 +283,153 @@ void xrCompressor::write_file_header(
     buffer += file_name_size;
 
     *(u32*)buffer = ptr;
+    buffer += sizeof(u32);
+
+    if (write_codec)
+        *buffer = u8(codec) | (blocks ? ARCHIVE_CODEC_BLOCKS : 0);
 
     fs_desc.w(buffer_start, full_buffer_size);
 }
 
-void xrCompressor::CompressOne(LPCSTR path)
+bool xrCompressor::ClaimContent(u32 index, u32 size, u32 crc)
 {
-    filesTOTAL++;
+    const u64 key = (u64(size) << 32) | crc;
 
-    if (testSKIP(path))
+    ScopeLock scope(&claims_lock);
+    const auto it = claims.emplace(key, index).first;
+    if (it->second < index)
+        return false;
+    it->second = index;
+    return true;
+}
+
+bool xrCompressor::ReadNext()
+{
+    if (next_file >= files_list->size())
+        return false;
+
+    // Don't run too far ahead of the writer
+    if (pending.size() >= (TaskScheduler->GetWorkersCount() + 1) * PIPELINE_FILES_PER_THREAD)
+        return false;
+    if (!pending.empty() && pending_bytes >= PIPELINE_MAX_BYTES)
+        return false;
+
+    pending.emplace_back();
+    PackItem& item = pending.back();
+    ZeroMemory(&item, sizeof(item));
+    item.index = u32(next_file);
+    item.path = (*files_list)[next_file++];
+
+    item.skip = testSKIP(item.path);
+    if (item.skip)
+        return true;
+
+    string_path fn;
+    strconcat(sizeof(fn), fn, target_name.c_str(), DELIMITER, item.path);
+    item.src = FS.r_open(fn);
+    if (!item.src)
+        return true;
+
+    pending_bytes += item.src->length();
+    bytes_read_total += item.src->length();
+
+    item.task = TaskScheduler->CreateTask("xrCompressor::CompressItem", Task::Type::Core, [this, &item]()
     {
-        filesSKIP++;
-        printf(" - a SKIP");
-        Msg("%-80s   - SKIP", path);
+        CompressItem(item);
+    });
+    TaskScheduler->Hold(*item.task);
+    TaskScheduler->PushTask(item.task);
+    return true;
+}
+
+// Called from worker threads
+void xrCompressor::CompressItem(PackItem& item)
+{
+    const u32 size = item.src->length();
+    item.crc = crc32(item.src->pointer(), size);
+
+    if (!ClaimContent(item.index, size, item.crc))
+    {
+        item.duplicate = true;
         return;
     }
 
-    string_path fn;
-    strconcat(sizeof(fn), fn, target_name.c_str(), "\\", path);
+    if (0 != size && !testVFS(item.path))
+        CompressData(item);
+}
+
+void xrCompressor::CompressData(PackItem& item)
+{
+    const u32 c_size_real = item.src->length();
+
+    ArchiveCodec codec = SelectCodec(item.path);
+    if (codec == ArchiveCodec::ZstdDict && !dictionary)
+        codec = ArchiveCodec::Zstd;
+    if (!archive_codec_supported(codec))
+        codec = ArchiveCodec::LZO;
+
+    // Streamed files are split into blocks, so CStreamReader doesn't need to decompress them at once
+    const bool blocks = testSTREAM(item.path);
+
+    u8* c_data;
+    u32 c_size_compressed;
+    CTimer timer;
+    timer.Start();
+    if (blocks)
+    {
+        xr_vector<u8> c_blocks;
+        c_size_compressed = u32(archive_compress_blocks(
+            codec, !bFast, c_blocks, item.src->pointer(), c_size_real, ARCHIVE_BLOCK_SIZE, dictionary));
+        c_data = xr_alloc<u8>(c_blocks.size());
+        CopyMemory(c_data, c_blocks.data(), c_blocks.size());
+    }
+    else
+    {
+        const size_t c_size_max = archive_compress_bound(codec, c_size_real);
+        c_data = xr_alloc<u8>(c_size_max);
+        c_size_compressed =
+            u32(archive_compress(codec, !bFast, c_data, c_size_max, item.src->pointer(), c_size_real, dictionary));
+    }
+    item.compress_time = timer.GetElapsed_ns();
 
-    if (::GetFileAttributes(fn) == u32(-1))
+    if (0 == c_size_compressed || (c_size_compressed + 16) >= c_size_real)
+    {
+        // Failed to compress - the writer will store it
+        xr_free(c_data);
+        return;
+    }
+
+    // Compressed OK - verify and measure decompression speed
+    u8* c_out = xr_alloc<u8>(c_size_real);
+    timer.Start();
+    const size_t c_orig = blocks ?
+        archive_decompress_blocks(codec, c_out, c_size_real, c_data, c_size_compressed, dictionary) :
+        archive_decompress(codec, c_out, c_size_real, c_data, c_size_compressed, dictionary);
+    item.decompress_time = timer.GetElapsed_ns();
+    R_ASSERT2(c_orig == c_size_real && 0 == memcmp(c_out, item.src->pointer(), c_size_real), item.path);
+    xr_free(c_out);
+
+    item.c_codec = codec;
+    item.c_blocks = blocks;
+    item.c_data = c_data;
+    item.c_size_compressed = c_size_compressed;
+}
+
+void xrCompressor::WriteOne(PackItem& item)
+{
+    filesTOTAL++;
+    files_written_total++;
+
+    LPCSTR path = item.path;
+    if (item.skip)
     {
         filesSKIP++;
-        printf(" - CAN'T OPEN");
-        Msg("%-80s   - CAN'T OPEN", path);
+        printf(" - a SKIP");
+        Msg("%-80s   - SKIP", path);
         return;
     }
 
-    IReader* src = FS.r_open(fn);
+    IReader* src = item.src;
     if (0 == src)
     {
         filesSKIP++;
@@ -210,10 +439,12 @@ void xrCompressor::CompressOne(LPCSTR path)
     }
 
     bytesSRC += src->length();
-    u32 c_crc32 = crc32(src->pointer(), src->length());
+    u32 c_crc32 = item.crc;
     u32 c_ptr = 0;
     u32 c_size_real = 0;
     u32 c_size_compressed = 0;
+    ArchiveCodec c_codec = ArchiveCodec::LZO;
+    bool c_blocks = false;
     u32 a_tests = 0;
 
     ALIAS* A = testALIAS(src, c_crc32, a_tests);
@@ -228,6 +459,8 @@ void xrCompressor::CompressOne(LPCSTR path)
         c_ptr = A->c_ptr;
         c_size_real = A->c_size_real;
         c_size_compressed = A->c_size_compressed;
+        c_codec = A->c_codec;
+        c_blocks = A->c_blocks;
     }
     else
     {
@@ -250,26 +483,11 @@ void xrCompressor::CompressOne(LPCSTR path)
             c_size_real = src->length();
             if (0 != c_size_real)
             {
-                u32 c_size_max = rtc_csize(src->length());
-                u8* c_data = xr_alloc<u8>(c_size_max);
-
-                t_compress.Begin();
+                // The claimed original is in the other volume or just has the same crc
+                if (item.duplicate)
+                    CompressData(item);
 
-                c_size_compressed = c_size_max;
-                if (bFast)
-                {
-                    R_ASSERT(LZO_E_OK ==
-                        lzo1x_1_compress((u8*)src->pointer(), c_size_real, c_data, (lzo_uintp)&c_size_compressed, c_heap));
-                }
-                else
-                {
-                    R_ASSERT(LZO_E_OK ==
-                        lzo1x_999_compress((u8*)src->pointer(), c_size_real, c_data, (lzo_uintp)&c_size_compressed, c_heap));
-                }
-
-                t_compress.End();
-
-                if ((c_size_compressed + 16) >= c_size_real)
+                if (!item.c_data)
                 {
                     // Failed to compress - revert to VFS
                     filesVFS++;
@@ -280,22 +498,23 @@ void xrCompressor::CompressOne(LPCSTR path)
                 }
                 else
                 {
-                    // Compressed OK - optimize
-                    if (!bFast)
-                    {
-                        u8* c_out = xr_alloc<u8>(c_size_real);
-                        u32 c_orig = c_size_real;
-                        R_ASSERT(LZO_E_OK == lzo1x_optimize(c_data, c_size_compressed, c_out, (lzo_uintp)&c_orig, NULL));
-                        R_ASSERT(c_orig == c_size_real);
-                        xr_free(c_out);
-                    } // bFast
-                    fs_pack_writer->w(c_data, c_size_compressed);
-                    printf("%3.1f%%", 100.f * float(c_size_compressed) / float(src->length()));
-                    Msg("%-80s   - OK (%3.1f%%)", path, 100.f * float(c_size_compressed) / float(src->length()));
+                    c_codec = item.c_codec;
+                    c_blocks = item.c_blocks;
+                    c_size_compressed = item.c_size_compressed;
+
+                    CODEC_STATS& stats = codec_stats[size_t(c_codec)];
+                    stats.files++;
+                    stats.bytes_src += c_size_real;
+                    stats.bytes_dst += c_size_compressed;
+                    stats.compress_time += item.compress_time;
+                    stats.decompress_time += item.decompress_time;
+
+                    fs_pack_writer->w(item.c_data, c_size_compressed);
+                    printf("%3.1f%% %s%s", 100.f * float(c_size_compressed) / float(c_size_real),
+                        archive_codec_name(c_codec), c_blocks ? " blocks" : "");
+                    Msg("%-80s   - OK (%3.1f%%, %s%s)", path, 100.f * float(c_size_compressed) / float(c_size_real),
+                        archive_codec_name(c_codec), c_blocks ? " blocks" : "");
                 }
-
-                // cleanup
-                xr_free(c_data);
             }
             else
             { // 0!=c_size_real
@@ -306,23 +525,47 @@ void xrCompressor::CompressOne(LPCSTR path)
             }
         } // test VFS
     } //(A)
+    compress_time += item.compress_time;
 
     // Write description
-    write_file_header(path, c_crc32, c_ptr, c_size_real, c_size_compressed);
+    write_file_header(path, c_crc32, c_ptr, c_size_real, c_size_compressed, c_codec, c_blocks);
 
     if (0 == A)
     {
         // Register for future aliasing
+        string_path fn;
+        strconcat(sizeof(fn), fn, target_name.c_str(), DELIMITER, path);
+
         ALIAS R;
         R.path = xr_strdup(fn);
         R.crc = c_crc32;
         R.c_ptr = c_ptr;
         R.c_size_real = c_size_real;
         R.c_size_compressed = c_size_compressed;
+        R.c_codec = c_codec;
+        R.c_blocks = c_blocks;
         aliases.insert(std::make_pair(R.c_size_real, R));
     }
+}
 
-    FS.r_close(src);
+void xrCompressor::ReportProgress(bool force)
+{
+    if (!force && t_progress.GetElapsed_ms() < PROGRESS_INTERVAL)
+        return;
+    t_progress.Start();
+
+    const float elapsed = std::max(t_total.GetElapsed_sec(), 0.001f);
+    const u64 written = bytes_written_total + (fs_pack_writer ? fs_pack_writer->tell() : 0);
+    const u32 total = u32(files_list->size());
+
+    string256 caption;
+    xr_sprintf(caption, "Compress files: %u/%u - %u%%, read: %3.1f Mb/s, written: %3.1f Mb/s", files_written_total,
+        total, total ? files_written_total * 100 / total : 100, float(bytes_read_total) / (1024 * 1024) / elapsed,
+        float(written) / (1024 * 1024) / elapsed);
+#if defined(WINDOWS)
+    SetWindowText(GetConsoleWindow(), caption);
+#endif
+    printf("\n[%s, in flight: %u]", caption, u32(pending.size()));
 }
 
 void xrCompressor::OpenPack(LPCSTR tgt_folder, int num)
@@ -346,6 +589,8 @@ void xrCompressor::OpenPack(LPCSTR tgt_folder, int num)
     filesSKIP = 0;
     filesVFS = 0;
     filesALIAS = 0;
+    compress_time = 0;
+    ZeroMemory(codec_stats, sizeof(codec_stats));
 
     dwTimeStart = timeGetTime();
     if (config_ltx && config_ltx->section_exist("header"))
@@ -378,6 +623,12 @@ void xrCompressor::OpenPack(LPCSTR tgt_folder, int num)
     else
         printf("...Pack header not found\n");
 
+    if (dictionary)
+    {
+        printf("...Writing dictionary\n");
+        fs_pack_writer->w_chunk(CFS_DictionaryChunkID, (void*)dictionary->pointer(), dictionary->size());
+    }
+
     //	g_dummy_stuff	= _dummy_stuff_subst;
 
     fs_pack_writer->open_chunk(0);
@@ -400,21 +651,25 @@ void xrCompressor::ClosePack()
 
     Msg("Data size: %d. Desc size: %d.", bytesDST, fs_desc.size());
     FS.w_close(fs_pack_writer);
+    bytes_written_total += bytesDST;
     Msg("Pack saved.");
     u32 dwTimeEnd = timeGetTime();
+    const float elapsed_sec = std::max(float(dwTimeEnd - dwTimeStart) / 1000.f, 0.001f);
+    const float compress_sec = float(compress_time) / 1000000000.f;
     printf(
         "\n\nFiles total/skipped/VFS/aliased: %d/%d/%d/%d\nOveral: %dK/%dK, %3.1f%%\nElapsed time: %d:%d\nCompression "
-        "speed: %3.1f Mb/s",
+        "speed: %3.1f Mb/s, compression time: %3.1f s on %u threads",
         filesTOTAL, filesSKIP, filesVFS, filesALIAS, bytesDST / 1024, bytesSRC / 1024,
         100.f * float(bytesDST) / float(bytesSRC), ((dwTimeEnd - dwTimeStart) / 1000) / 60,
-        ((dwTimeEnd - dwTimeStart) / 1000) % 60,
-        float((float(bytesDST) / float(1024 * 1024)) / (t_compress.GetElapsed_sec())));
+        ((dwTimeEnd - dwTimeStart) / 1000) % 60, float(bytesSRC) / float(1024 * 1024) / elapsed_sec, compress_sec,
+        TaskScheduler->GetWorkersCount() + 1);
     Msg("\n\nFiles total/skipped/VFS/aliased: %d/%d/%d/%d\nOveral: %dK/%dK, %3.1f%%\nElapsed time: %d:%d\nCompression "
-        "speed: %3.1f Mb/s\n\n",
+        "speed: %3.1f Mb/s, compression time: %3.1f s on %u threads\n\n",
         filesTOTAL, filesSKIP, filesVFS, filesALIAS, bytesDST / 1024, bytesSRC / 1024,
         100.f * float(bytesDST) / float(bytesSRC), ((dwTimeEnd - dwTimeStart) / 1000) / 60,
-        ((dwTimeEnd - dwTimeStart) / 1000) % 60,
-        float((float(bytesDST) / float(1024 * 1024)) / (t_compress.GetElapsed_sec())));
+        ((dwTimeEnd - dwTimeStart) / 1000) % 60, float(bytesSRC) / float(1024 * 1024) / elapsed_sec, compress_sec,
+        TaskScheduler->GetWorkersCount() + 1);
+    DumpCodecStats();
 
     for (auto &it : aliases)
         xr_free(it.second.path);
@@ -425,7 +680,16 @@ void xrCompressor::PerformWork()
 {
     if (!files_list->empty() && target_name.size())
     {
-        string256 caption;
+        if (!bStoreFiles)
+            TrainDictionary();
+
+        printf("...Compressing on %u threads\n", TaskScheduler->GetWorkersCount() + 1);
+
+        bytes_read_total = 0;
+        bytes_written_total = 0;
+        files_written_total = 0;
+        t_total.Start();
+        t_progress.Start();
 
         int pack_num = 0;
         OpenPack(target_name.c_str(), pack_num++);
@@ -433,26 +697,44 @@ void xrCompressor::PerformWork()
         for (const auto &it : *folders_list)
             write_file_header(it, 0, 0, 0, 0);
 
-        if (!bStoreFiles)
-            c_heap = xr_alloc<u8>(LZO1X_999_MEM_COMPRESS);
-
-        for (size_t it = 0; it < files_list->size(); it++)
+        // Reader and writer stages share the main thread: CLocatorAPI isn't thread-safe,
+        // workers only CRC and compress the data already in memory
+        next_file = 0;
+        pending_bytes = 0;
+        while (ReadNext() || !pending.empty())
         {
-            xr_sprintf(caption, "Compress files: %d/%d - %d%%", it, files_list->size(), (it * 100) / files_list->size());
-            SetWindowText(GetConsoleWindow(), caption);
-            printf("\n%-80s   ", (*files_list)[it]);
+            PackItem& item = pending.front();
+            while (item.task && !item.task->IsFinished())
+            {
+                if (!ReadNext() && !TaskScheduler->ExecuteOneTask())
+                    std::this_thread::yield();
+            }
+            if (item.task)
+                TaskScheduler->Release(*item.task);
+
+            printf("\n%-80s   ", item.path);
 
             if (fs_pack_writer->tell() > XRP_MAX_SIZE)
             {
                 ClosePack();
                 OpenPack(target_name.c_str(), pack_num++);
             }
-            CompressOne((*files_list)[it]);
+            WriteOne(item);
+
+            if (item.src)
+            {
+                pending_bytes -= item.src->length();
+                FS.r_close(item.src);
+            }
+            xr_free(item.c_data);
+            pending.pop_front();
+
+            ReportProgress(false);
         }
+        ReportProgress(true);
         ClosePack();
 
-        if (!bStoreFiles)
-            xr_free(c_heap);
+        claims.clear();
     }
     else
     {
@@ -529,6 +811,38 @@ void xrCompressor::ProcessLTX(CInifile& ltx)
     if (ltx.line_exist("options", "exclude_exts"))
         _SequenceToList(exclude_exts, ltx.r_string("options", "exclude_exts"));
 
+    // Block compressed entries can't be read by the older builds, so streaming is opt-in
+    if (ltx.line_exist("options", "stream_files"))
+        _SequenceToList(stream_files, ltx.r_string("options", "stream_files"));
+
+    if (ltx.line_exist("options", "codec"))
+    {
+        LPCSTR codec_name = ltx.r_string("options", "codec");
+        const ArchiveCodec codec = archive_codec_by_name(codec_name, ArchiveCodec::Count);
+        if (codec != ArchiveCodec::Count && archive_codec_supported(codec))
+            default_codec = codec;
+        else
+            Msg("! Codec [%s] isn't supported, LZO will be used", codec_name);
+    }
+
+    // extension = codec
+    if (ltx.section_exist("codecs"))
+    {
+        CInifile::Sect& codecs_sect = ltx.r_section("codecs");
+        for (const auto& it : codecs_sect.Data)
+        {
+            const ArchiveCodec codec = archive_codec_by_name(it.second.c_str(), ArchiveCodec::Count);
+            if (codec == ArchiveCodec::Count || !archive_codec_supported(codec))
+            {
+                Msg("! Codec [%s] for [%s] isn't supported, LZO will be used", it.second.c_str(), it.first.c_str());
+                continue;
+            }
+            string256 ext;
+            xr_strcpy(ext, it.first.c_str());
+            ext_codecs[xr_strlwr(ext)] = codec;
+        }
+    }
+
     files_list = new xr_vector<char*>();
     folders_list = new xr_vector<char*>();
 
@@ -541,11 +855,11 @@ void xrCompressor::ProcessLTX(CInifile& ltx)
             u32 folder_mask = FS_ListFolders | (ifRecurse ? 0 : FS_RootOnly);
 
             string_path path;
-            LPCSTR _path = 0 == xr_strcmp(it.first.c_str(), ".\\") ? "" : it.first.c_str();
+            LPCSTR _path = 0 == xr_strcmp(it.first.c_str(), "." DELIMITER) ? "" : it.first.c_str();
             xr_strcpy(path, _path);
             size_t path_len = xr_strlen(path);
-            if ((0 != path_len) && (path[path_len - 1] != '\\'))
-                xr_strcat(path, "\\");
+            if ((0 != path_len) && (path[path_len - 1] != _DELIMITER))
+                xr_strcat(path, DELIMITER);
 
             Msg("");
             Msg("Processing folder: '%s'", path);
@@ -2,6 +2,13 @@
 #ifndef XR_COMPRESS_H_INCLUDED
 #define XR_COMPRESS_H_INCLUDED
 
+#include "xrCore/Compression/archive_codec.h"
+#include "xrCore/Threading/Lock.hpp"
+#include "xrCommon/xr_deque.h"
+#include "xrCommon/xr_unordered_map.h"
+
+class Task;
+
 class xrCompressor
 {
     bool bFast;
@@ -21,26 +28,81 @@ class xrCompressor
         u32 c_ptr;
         u32 c_size_real;
         u32 c_size_compressed;
+        ArchiveCodec c_codec;
+        bool c_blocks;
     };
     xr_multimap<u32, ALIAS> aliases;
 
+    struct CODEC_STATS
+    {
+        u32 files;
+        u64 bytes_src;
+        u64 bytes_dst;
+        u64 compress_time; // ns
+        u64 decompress_time; // ns
+    };
+    CODEC_STATS codec_stats[size_t(ArchiveCodec::Count)];
+
+    ArchiveCodec default_codec;
+    xr_map<shared_str, ArchiveCodec> ext_codecs; // extension -> codec
+    ArchiveDictionary* dictionary;
+    ArchiveCodec SelectCodec(LPCSTR path);
+    void TrainDictionary();
+    void DumpCodecStats();
+
     xr_vector<shared_str> exclude_exts;
+    xr_vector<shared_str> stream_files; // opened by FS.rs_open(), compressed in blocks
     bool testSKIP(LPCSTR path);
+    bool testSTREAM(LPCSTR path);
     ALIAS* testALIAS(IReader* base, u32 crc, u32& a_tests);
     bool testEqual(LPCSTR path, IReader* base);
     bool testVFS(LPCSTR path);
     bool IsFolderAccepted(CInifile& ltx, LPCSTR path, BOOL& recurse);
 
+    // File passing through the pipeline: it's read on the main thread,
+    // CRC'ed and compressed by a worker and written on the main thread
+    // in the original order, so the archive layout doesn't depend on timings
+    struct PackItem
+    {
+        LPCSTR path;
+        u32 index;
+        bool skip;
+        IReader* src; // null if the file can't be opened
+        Task* task; // null if there is nothing to do for workers
+        u32 crc;
+        bool duplicate; // content was claimed by the earlier file, compression skipped
+        ArchiveCodec c_codec;
+        bool c_blocks;
+        u8* c_data; // null if not compressed
+        u32 c_size_compressed;
+        u64 compress_time; // ns
+        u64 decompress_time; // ns
+    };
+    xr_deque<PackItem> pending;
+    size_t next_file;
+    size_t pending_bytes;
+
+    // (size, crc) -> index of the first file with such content.
+    // Only a hint for workers, aliases are resolved by the writer.
+    Lock claims_lock;
+    xr_unordered_map<u64, u32> claims;
+    bool ClaimContent(u32 index, u32 size, u32 crc);
+
+    bool ReadNext();
+    void CompressItem(PackItem& item);
+    void CompressData(PackItem& item);
+    void ReportProgress(bool force);
+
     void GatherFiles(LPCSTR folder);
 
-    void write_file_header(
-        LPCSTR file_name, const u32& crc, const u32& ptr, const u32& size_real, const u32& size_compressed);
+    void write_file_header(LPCSTR file_name, const u32& crc, const u32& ptr, const u32& size_real,
+        const u32& size_compressed, ArchiveCodec codec = ArchiveCodec::LZO, bool blocks = false);
     void ClosePack();
     void OpenPack(LPCSTR tgt_folder, int num);
 
     void PerformWork();
 
-    void CompressOne(LPCSTR path);
+    void WriteOne(PackItem& item);
 
     u32 bytesSRC;
     u32 bytesDST;
@@ -48,16 +110,23 @@ class xrCompressor
     u32 filesSKIP;
     u32 filesVFS;
     u32 filesALIAS;
-    CStatTimer t_compress;
-    u8* c_heap;
+    u64 compress_time; // ns, summed over all threads
     u32 dwTimeStart;
 
+    // For the whole run, all volumes
+    u64 bytes_read_total;
+    u64 bytes_written_total;
+    u32 files_written_total;
+    CTimer t_total;
+    CTimer t_progress;
+
     u32 XRP_MAX_SIZE;
 
 public:
     xrCompressor();
     ~xrCompressor();
     void SetFastMode(bool b) { bFast = b; }
+    void SetCodec(ArchiveCodec c) { default_codec = c; }
     void SetStoreFiles(bool b) { bStoreFiles = b; }
     void SetMaxVolumeSize(u32 sz) { XRP_MAX_SIZE = sz; }
     void SetTargetName(LPCSTR n) { target_name = n; }
@@ -91,9 +91,8 @@ struct file_comparer
     }
 };
 
-int ProcessDifference()
+int ProcessDifference(LPCSTR params)
 {
-    LPCSTR params = GetCommandLine();
     Flags32 _flags;
     _flags.zero();
     if (strstr(params, "-diff /?"))
@@ -171,9 +170,11 @@ int ProcessDifference()
     {
         LPCSTR fn = target_file_list[i];
         xr_sprintf(stats, "%d of %d (%3.1f%%)", i, total, 100.0f * ((float)i / (float)total));
+#if defined(WINDOWS)
         SetConsoleTitle(stats);
+#endif
 
-        strconcat(sizeof(out_path), out_path, target_folder, "\\", fn);
+        strconcat(sizeof(out_path), out_path, target_folder, DELIMITER, fn);
         VerifyPath(out_path);
         IReader* r = FS_new->r_open("$target_folder$", fn);
         IWriter* w = FS_old->w_open(out_path);
@@ -10,6 +10,7 @@
 #include "xrEngine/GameFont.h"
 #include "xrEngine/PerformanceAlert.hpp"
 #include "xrCore/Threading/Lock.hpp"
+#include "xrCore/Threading/SharedLock.hpp"
 
 ISpatial_DB* g_SpatialSpace = NULL;
 ISpatial_DB* g_SpatialSpacePhysic = NULL;
@@ -24,7 +25,8 @@ SpatialBase::SpatialBase(ISpatial_DB* space)
     spatial.sphere.R = 0;
     spatial.node_center.set(0, 0, 0);
     spatial.node_radius = 0;
-    spatial.node_ptr = NULL;
+    spatial.node_id = SPATIAL_NO_NODE;
+    spatial.node_slot = 0;
     spatial.sector = NULL;
     spatial.space = space;
 }
@@ -68,7 +70,7 @@ BOOL verify_sp(ISpatial* sp, Fvector& node_center, float node_radius)
 void SpatialBase::spatial_register()
 {
     spatial.type |= STYPEFLAG_INVALIDSECTOR;
-    if (spatial.node_ptr)
+    if (spatial.registered())
     {
         // already registered - nothing to do
     }
@@ -83,11 +85,10 @@ void SpatialBase::spatial_register()
 
 void SpatialBase::spatial_unregister()
 {
-    if (spatial.node_ptr)
+    if (spatial.registered())
     {
         // remove
         spatial.space->remove(this);
-        spatial.node_ptr = NULL;
         spatial.sector = NULL;
     }
     else
@@ -98,16 +99,13 @@ void SpatialBase::spatial_unregister()
 
 void SpatialBase::spatial_move()
 {
-    if (spatial.node_ptr)
+    if (spatial.registered())
     {
         //*** somehow it was determined that object has been moved
         spatial.type |= STYPEFLAG_INVALIDSECTOR;
 
-        //*** check if we are supposed to correct it's spatial location
-        if (spatial_inside())
-            return; // ???
-        spatial.space->remove(this);
-        spatial.space->insert(this);
+        //*** node keeps a copy of the sphere, so it has to be updated even if we are still inside
+        spatial.space->move(this);
     }
     else
     {
@@ -125,63 +123,95 @@ void SpatialBase::spatial_updatesector_internal()
 }
 
 //////////////////////////////////////////////////////////////////////////
-void ISpatial_NODE::_init(ISpatial_NODE* _parent)
+void ISpatial_NODE::_init(u32 _parent)
 {
     parent = _parent;
     children[0] = children[1] = children[2] = children[3] = children[4] = children[5] = children[6] = children[7] =
-        NULL;
-    items.clear();
+        SPATIAL_NO_NODE;
+    count = 0;
+    packs.clear();
 }
 
-void ISpatial_NODE::_insert(ISpatial* S)
+void ISpatial_NODE::_insert(ISpatial* S, u32 _id)
 {
-    S->GetSpatialData().node_ptr = this;
-    items.push_back(S);
-    S->GetSpatialData().space->Stats.ObjectCount++;
+    SpatialData& D = S->GetSpatialData();
+    const u32 slot = count++;
+    if (slot / 4 >= packs.size())
+        packs.emplace_back();
+
+    SpatialPack& P = packs[slot / 4];
+    const u32 lane = slot % 4;
+    P.data[lane] = &D;
+    P.items[lane] = S;
+
+    D.node_id = _id;
+    D.node_slot = slot;
+    _update(D);
+    D.space->Stats.ObjectCount++;
 }
 
 void ISpatial_NODE::_remove(ISpatial* S)
 {
-    S->GetSpatialData().node_ptr = NULL;
-    xr_vector<ISpatial*>::iterator it = std::find(items.begin(), items.end(), S);
-    VERIFY(it != items.end());
-    items.erase(it);
-    S->GetSpatialData().space->Stats.ObjectCount--;
+    SpatialData& D = S->GetSpatialData();
+    const u32 slot = D.node_slot;
+    VERIFY(slot < count && packs[slot / 4].items[slot % 4] == S);
+
+    // Fill the hole with the last item
+    const u32 last = --count;
+    if (slot != last)
+    {
+        const SpatialPack& L = packs[last / 4];
+        SpatialPack& P = packs[slot / 4];
+        const u32 from = last % 4, to = slot % 4;
+        P.x[to] = L.x[from];
+        P.y[to] = L.y[from];
+        P.z[to] = L.z[from];
+        P.r[to] = L.r[from];
+        P.data[to] = L.data[from];
+        P.items[to] = L.items[from];
+        P.data[to]->node_slot = slot;
+    }
+    if (0 == count % 4)
+        packs.pop_back();
+
+    D.node_id = SPATIAL_NO_NODE;
+    D.space->Stats.ObjectCount--;
+}
+
+void ISpatial_NODE::_update(const SpatialData& D)
+{
+    SpatialPack& P = packs[D.node_slot / 4];
+    const u32 lane = D.node_slot % 4;
+    P.x[lane] = D.sphere.P.x;
+    P.y[lane] = D.sphere.P.y;
+    P.z[lane] = D.sphere.P.z;
+    P.r[lane] = D.sphere.R;
 }
 
 //////////////////////////////////////////////////////////////////////////
 
 ISpatial_DB::ISpatial_DB(const char* name) :
+    pcs(new SharedLock),
 #ifdef CONFIG_PROFILE_LOCKS
-    pcs(new Lock(MUTEX_PROFILE_ID(ISpatial_DB))),
+    stats_lock(new Lock(MUTEX_PROFILE_ID(ISpatial_DB))),
 #else
-    pcs(new Lock),
+    stats_lock(new Lock),
 #endif // CONFIG_PROFILE_LOCKS
-    rt_insert_object(nullptr), m_root(nullptr),
-    m_bounds(0), q_result(nullptr)
+    rt_insert_object(nullptr), m_deferred_moves(true), m_root(SPATIAL_NO_NODE),
+    m_bounds(0)
 {
     xr_strcpy(Name, name);
 }
 
 ISpatial_DB::~ISpatial_DB()
 {
-    if (m_root)
-    {
-        _node_destroy(m_root);
-    }
-
-    while (!allocator_pool.empty())
-    {
-        allocator.destroy(allocator_pool.back());
-        allocator_pool.pop_back();
-    }
-
+    delete stats_lock;
     delete pcs;
 }
 
 void ISpatial_DB::initialize(Fbox& BB)
 {
-    if (0 == m_root)
+    if (SPATIAL_NO_NODE == m_root)
     {
         // initialize
         Fvector bbc, bbd;
@@ -190,47 +220,56 @@ void ISpatial_DB::initialize(Fbox& BB)
         bbc.set(0, 0, 0); // generic
         bbd.set(1024, 1024, 1024); // generic
 
-        allocator_pool.reserve(128);
+        m_nodes.reserve(1024);
         m_center.set(bbc);
         m_bounds = _max(_max(bbd.x, bbd.y), bbd.z);
         rt_insert_object = NULL;
-        if (0 == m_root)
-            m_root = _node_create();
-        m_root->_init(NULL);
+
+        // Pending objects aren't counted as a node
+        m_nodes.emplace_back();
+        m_nodes[PENDING_NODE]._init(SPATIAL_NO_NODE);
+        m_root = _node_create(SPATIAL_NO_NODE);
     }
 }
-ISpatial_NODE* ISpatial_DB::_node_create()
+
+u32 ISpatial_DB::_node_create(u32 parent)
 {
     Stats.NodeCount++;
-    if (allocator_pool.empty())
-        return allocator.create();
+    u32 id;
+    if (m_free_nodes.empty())
+    {
+        id = u32(m_nodes.size());
+        m_nodes.emplace_back();
+    }
     else
     {
-        ISpatial_NODE* N = allocator_pool.back();
-        allocator_pool.pop_back();
-        return N;
+        id = m_free_nodes.back();
+        m_free_nodes.pop_back();
     }
+    m_nodes[id]._init(parent);
+    return id;
 }
-void ISpatial_DB::_node_destroy(ISpatial_NODE*& P)
+
+void ISpatial_DB::_node_destroy(u32 id)
 {
-    VERIFY(P->_empty());
+    VERIFY(m_nodes[id]._empty());
     Stats.NodeCount--;
-    allocator_pool.push_back(P);
-    P = NULL;
+    m_free_nodes.push_back(id);
 }
 
-void ISpatial_DB::_insert(ISpatial_NODE* N, Fvector& n_C, float n_R)
+void ISpatial_DB::_insert(u32 N, Fvector& n_C, float n_R)
 {
     //*** we are assured that object lives inside our node
+    //*** m_nodes may grow here, so don't keep references to the nodes
     float n_vR = 2 * n_R;
-    VERIFY(N);
+    VERIFY(N != SPATIAL_NO_NODE);
     VERIFY(verify_sp(rt_insert_object, n_C, n_vR));
 
     // we have to make sure we aren't the leaf node
     if (n_R <= c_spatial_min)
     {
         // this is leaf node
-        N->_insert(rt_insert_object);
+        m_nodes[N]._insert(rt_insert_object, N);
         rt_insert_object->GetSpatialData().node_center.set(n_C);
         rt_insert_object->GetSpatialData().node_radius = n_vR; // vR
         return;
@@ -247,28 +286,43 @@ void ISpatial_DB::_insert(ISpatial_NODE* N, Fvector& n_C, float n_R)
         Fvector c_C;
         c_C.mad(n_C, c_spatial_offset[octant], c_R);
         VERIFY(octant == _octant(n_C, c_C)); // check table assosiations
-        ISpatial_NODE*& chield = N->children[octant];
 
-        if (0 == chield)
+        u32 chield = m_nodes[N].children[octant];
+        if (SPATIAL_NO_NODE == chield)
         {
-            chield = _node_create();
-            VERIFY(chield);
-            chield->_init(N);
-            VERIFY(chield);
+            chield = _node_create(N);
+            m_nodes[N].children[octant] = chield;
         }
-        VERIFY(chield);
         _insert(chield, c_C, c_R);
-        VERIFY(chield);
     }
     else
     {
         // we have to "own" this object (potentially it can be putted down sometimes...)
-        N->_insert(rt_insert_object);
+        m_nodes[N]._insert(rt_insert_object, N);
         rt_insert_object->GetSpatialData().node_center.set(n_C);
         rt_insert_object->GetSpatialData().node_radius = n_vR;
     }
 }
 
+void ISpatial_DB::_insert_object(ISpatial* S)
+{
+    if (verify_sp(S, m_center, m_bounds))
+    {
+        // Object inside our DB
+        rt_insert_object = S;
+        _insert(m_root, m_center, m_bounds);
+        VERIFY(S->spatial_inside());
+    }
+    else
+    {
+        // Object outside our DB, put it into root node and hack bounds
+        // Object will reinsert itself until fits into "real", "controlled" space
+        m_nodes[m_root]._insert(S, m_root);
+        S->GetSpatialData().node_center.set(m_center);
+        S->GetSpatialData().node_radius = m_bounds;
+    }
+}
+
 void ISpatial_DB::insert(ISpatial* S)
 {
     pcs->Enter();
@@ -302,57 +356,42 @@ void ISpatial_DB::insert(ISpatial* S)
     }
 #endif
 
-    if (verify_sp(S, m_center, m_bounds))
-    {
-        // Object inside our DB
-        rt_insert_object = S;
-        _insert(m_root, m_center, m_bounds);
-        VERIFY(S->spatial_inside());
-    }
-    else
-    {
-        // Object outside our DB, put it into root node and hack bounds
-        // Object will reinsert itself until fits into "real", "controlled" space
-        m_root->_insert(S);
-        S->GetSpatialData().node_center.set(m_center);
-        S->GetSpatialData().node_radius = m_bounds;
-    }
+    _insert_object(S);
+
 #ifdef DEBUG
     Stats.Insert.End();
 #endif
     pcs->Leave();
 }
 
-void ISpatial_DB::_remove(ISpatial_NODE* N, ISpatial_NODE* N_sub)
+void ISpatial_DB::_remove(u32 N, u32 N_sub)
 {
-    if (0 == N)
+    if (SPATIAL_NO_NODE == N)
         return;
 
     //*** we are assured that node contains N_sub and this subnode is empty
-    u32 octant = u32(-1);
-    if (N_sub == N->children[0])
-        octant = 0;
-    else if (N_sub == N->children[1])
-        octant = 1;
-    else if (N_sub == N->children[2])
-        octant = 2;
-    else if (N_sub == N->children[3])
-        octant = 3;
-    else if (N_sub == N->children[4])
-        octant = 4;
-    else if (N_sub == N->children[5])
-        octant = 5;
-    else if (N_sub == N->children[6])
-        octant = 6;
-    else if (N_sub == N->children[7])
-        octant = 7;
+    ISpatial_NODE& node = m_nodes[N];
+    u32 octant = 0;
+    while (octant < 8 && node.children[octant] != N_sub)
+        octant++;
     VERIFY(octant < 8);
-    VERIFY(N_sub->_empty());
-    _node_destroy(N->children[octant]);
+    node.children[octant] = SPATIAL_NO_NODE;
+    _node_destroy(N_sub);
 
     // Recurse
-    if (N->_empty())
-        _remove(N->parent, N);
+    if (node._empty())
+        _remove(node.parent, N);
+}
+
+void ISpatial_DB::_remove_object(ISpatial* S)
+{
+    const u32 N = S->GetSpatialData().node_id;
+    ISpatial_NODE& node = m_nodes[N];
+    node._remove(S);
+
+    // Recurse
+    if (N != PENDING_NODE && node._empty())
+        _remove(node.parent, N);
 }
 
 void ISpatial_DB::remove(ISpatial* S)
@@ -361,26 +400,93 @@ void ISpatial_DB::remove(ISpatial* S)
 #ifdef DEBUG
     Stats.Remove.Begin();
 #endif
-    ISpatial_NODE* N = S->GetSpatialData().node_ptr;
-    N->_remove(S);
-
-    // Recurse
-    if (N->_empty())
-        _remove(N->parent, N);
-
+    _remove_object(S);
 #ifdef DEBUG
     Stats.Remove.End();
 #endif
     pcs->Leave();
 }
 
+void ISpatial_DB::move(ISpatial* S)
+{
+    SpatialData& D = S->GetSpatialData();
+
+    // Most of the moves don't leave the node,
+    // update the copy of the sphere without blocking queries
+    pcs->EnterShared();
+    const bool inside = PENDING_NODE == D.node_id || S->spatial_inside();
+    if (inside)
+        m_nodes[D.node_id]._update(D);
+    pcs->LeaveShared();
+    if (inside)
+        return;
+
+    pcs->Enter();
+    if (D.registered())
+    {
+        _remove_object(S);
+        if (m_deferred_moves)
+        {
+            // Will be put into the tree by update()
+            m_nodes[PENDING_NODE]._insert(S, PENDING_NODE);
+            D.node_center.set(m_center);
+            D.node_radius = m_bounds;
+            if (m_nodes[PENDING_NODE].count > PENDING_MAX)
+                _apply_moves();
+        }
+        else
+            _insert_object(S);
+    }
+    pcs->Leave();
+}
+
+void ISpatial_DB::_apply_moves()
+{
+    while (m_nodes[PENDING_NODE].count)
+    {
+        const u32 last = m_nodes[PENDING_NODE].count - 1;
+        ISpatial* S = m_nodes[PENDING_NODE].packs[last / 4].items[last % 4];
+        m_nodes[PENDING_NODE]._remove(S);
+        _insert_object(S);
+    }
+}
+
+void ISpatial_DB::set_deferred_moves(bool value)
+{
+    pcs->Enter();
+    m_deferred_moves = value;
+    if (!m_deferred_moves && SPATIAL_NO_NODE != m_root)
+        _apply_moves();
+    pcs->Leave();
+}
+
 void ISpatial_DB::update(u32 /*nodes = 8 */)
 {
-#ifdef DEBUG
-    if (0 == m_root)
+    if (SPATIAL_NO_NODE == m_root)
         return;
     pcs->Enter();
+    _apply_moves();
     VERIFY(verify());
     pcs->Leave();
-#endif
+}
+
+void ISpatial_DB::_query_begin(CTimer& T)
+{
+    pcs->EnterShared();
+    if (g_bEnableStatGather)
+        T.Start();
+}
+
+void ISpatial_DB::_query_end(CTimer& T)
+{
+    // Queries run concurrently, so CStatTimer can't be used directly
+    if (g_bEnableStatGather)
+    {
+        const auto elapsed = T.getElapsedTime();
+        stats_lock->Enter();
+        Stats.Query.accum += elapsed;
+        Stats.Query.count++;
+        stats_lock->Leave();
+    }
+    pcs->LeaveShared();
 }
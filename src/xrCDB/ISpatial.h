@@ -80,6 +80,9 @@ class Sound;
 class IRenderable;
 class IRender_Light;
 class Lock;
+class SharedLock;
+
+constexpr u32 SPATIAL_NO_NODE = u32(-1);
 
 class SpatialData
 {
@@ -88,9 +91,12 @@ public:
     Fsphere sphere;
     Fvector node_center; // Cached node center for TBV optimization
     float node_radius; // Cached node bounds for TBV optimization
-    ISpatial_NODE* node_ptr; // Cached parent node for "empty-members" optimization
+    u32 node_id; // Cached parent node for "empty-members" optimization
+    u32 node_slot; // Index of the object inside the node
     IRender_Sector* sector;
     ISpatial_DB* space; // allow different spaces
+
+    bool registered() const { return node_id != SPATIAL_NO_NODE; }
 };
 
 class XRCDB_API ISpatial
@@ -143,24 +149,41 @@ public:
 };
 
 //////////////////////////////////////////////////////////////////////////
-// class ISpatial_NODE;
+// Four objects of a node stored by components,
+// so queries cull them at once with SSE instead of calling GetSpatialData()
+struct SpatialPack
+{
+    float x[4];
+    float y[4];
+    float z[4];
+    float r[4];
+    SpatialData* data[4]; // for the type, which can change without move
+    ISpatial* items[4];
+};
+
 class ISpatial_NODE
 {
 public:
-    ISpatial_NODE* parent; // parent node for "empty-members" optimization
-    ISpatial_NODE* children[8]; // children nodes
-    xr_vector<ISpatial*> items; // own items
+    u32 parent; // parent node for "empty-members" optimization
+    u32 children[8]; // children nodes
+    u32 count; // own items
+    xr_vector<SpatialPack> packs; // own items, count rounded up to 4
 
-    void _init(ISpatial_NODE* _parent);
+    void _init(u32 _parent);
     void _remove(ISpatial* _S);
-    void _insert(ISpatial* _S);
-    bool _empty()
+    void _insert(ISpatial* _S, u32 _id);
+    void _update(const SpatialData& _D);
+    bool _empty() const
+    {
+        return 0 == count &&
+            SPATIAL_NO_NODE == (children[0] & children[1] & children[2] & children[3] &
+                                children[4] & children[5] & children[6] & children[7]);
+    }
+    // Mask of the used lanes of the pack
+    u32 _lanes(size_t pack) const
     {
-        return items.empty() &&
-            0 == (uintptr_t(children[0]) | uintptr_t(children[1]) |
-                  uintptr_t(children[2]) | uintptr_t(children[3]) |
-                  uintptr_t(children[4]) | uintptr_t(children[5]) |
-                  uintptr_t(children[6]) | uintptr_t(children[7]));
+        const u32 used = count - u32(pack) * 4;
+        return used >= 4 ? 0xf : (1u << used) - 1;
     }
 };
 
@@ -203,19 +226,28 @@ public:
     };
 
 private:
-    Lock* pcs;
-
-    poolSS<ISpatial_NODE, 128> allocator;
+    // Queries and moves inside the node take it shared,
+    // everything that changes the tree takes it exclusively
+    SharedLock* pcs;
+    Lock* stats_lock;
 
-    xr_vector<ISpatial_NODE*> allocator_pool;
+    xr_vector<u32> m_free_nodes;
     ISpatial* rt_insert_object;
+    bool m_deferred_moves;
+
+    static constexpr u32 PENDING_MAX = 1024; // applied at once if there are more pending moves
 
 public:
+    // Nodes are referenced by index, freed ones are reused.
+    // [PENDING_NODE] isn't a part of the tree: it keeps objects moved
+    // out of their nodes until update(), queries test all of them.
+    static constexpr u32 PENDING_NODE = 0;
+    xr_vector<ISpatial_NODE> m_nodes;
+
     char Name[64];
-    ISpatial_NODE* m_root;
+    u32 m_root;
     Fvector m_center;
     float m_bounds;
-    xr_vector<ISpatial*>* q_result;
     SpatialDBStatistics Stats;
 
 private:
@@ -234,11 +266,17 @@ private:
         return o;
     }
 
-    ISpatial_NODE* _node_create();
-    void _node_destroy(ISpatial_NODE*& P);
+    u32 _node_create(u32 parent);
+    void _node_destroy(u32 id);
+
+    void _insert(u32 N, Fvector& n_center, float n_radius);
+    void _remove(u32 N, u32 N_sub);
+    void _insert_object(ISpatial* S);
+    void _remove_object(ISpatial* S);
+    void _apply_moves();
 
-    void _insert(ISpatial_NODE* N, Fvector& n_center, float n_radius);
-    void _remove(ISpatial_NODE* N, ISpatial_NODE* N_sub);
+    void _query_begin(CTimer& T);
+    void _query_end(CTimer& T);
 
 public:
     ISpatial_DB(const char* name);
@@ -249,9 +287,15 @@ public:
     // void							destroy			();
     void insert(ISpatial* S);
     void remove(ISpatial* S);
+    // Object has changed its sphere
+    void move(ISpatial* S);
+    // Applies deferred moves, call it once per frame
     void update(u32 nodes = 8);
     BOOL verify();
 
+    // Objects that left their nodes are reinserted by update(), not immediately
+    void set_deferred_moves(bool value);
+
     enum
     {
         O_ONLYFIRST = (1 << 0),
@@ -2,30 +2,79 @@
 #include "ISpatial.h"
 #include "xrCore/_fbox.h"
 #include "xrCore/Threading/Lock.hpp"
+#pragma warning(push)
+#pragma warning(disable : 4995)
+#include <xmmintrin.h>
+#pragma warning(pop)
 
 extern Fvector c_spatial_offset[8];
 
 template <bool b_first>
-class walker
+class alignas(16) walker
 {
 public:
+    __m128 min_x, min_y, min_z;
+    __m128 max_x, max_y, max_z;
     u32 mask;
     Fvector center;
     Fvector size;
     Fbox box;
-    ISpatial_DB* space;
+    const ISpatial_NODE* nodes;
+    xr_vector<ISpatial*>* result;
 
 public:
-    walker(ISpatial_DB* _space, u32 _mask, const Fvector& _center, const Fvector& _size)
+    walker(const ISpatial_NODE* _nodes, xr_vector<ISpatial*>* _result, u32 _mask, const Fvector& _center,
+        const Fvector& _size)
     {
         mask = _mask;
         center = _center;
         size = _size;
         box.setb(center, size);
-        space = _space;
+        nodes = _nodes;
+        result = _result;
+
+        min_x = _mm_set1_ps(box.vMin.x);
+        min_y = _mm_set1_ps(box.vMin.y);
+        min_z = _mm_set1_ps(box.vMin.z);
+        max_x = _mm_set1_ps(box.vMax.x);
+        max_y = _mm_set1_ps(box.vMax.y);
+        max_z = _mm_set1_ps(box.vMax.z);
     }
 
-    void walk(ISpatial_NODE* N, Fvector& n_C, float n_R)
+    // Returns true if the query is done
+    bool test(const ISpatial_NODE& N)
+    {
+        for (size_t p = 0; p < N.packs.size(); ++p)
+        {
+            // bounding boxes of four spheres against the query box
+            const SpatialPack& P = N.packs[p];
+            const __m128 r = _mm_loadu_ps(P.r);
+            const __m128 x = _mm_loadu_ps(P.x);
+            const __m128 y = _mm_loadu_ps(P.y);
+            const __m128 z = _mm_loadu_ps(P.z);
+            __m128 in = _mm_and_ps(_mm_cmple_ps(_mm_sub_ps(x, r), max_x), _mm_cmpge_ps(_mm_add_ps(x, r), min_x));
+            in = _mm_and_ps(in, _mm_cmple_ps(_mm_sub_ps(y, r), max_y));
+            in = _mm_and_ps(in, _mm_cmpge_ps(_mm_add_ps(y, r), min_y));
+            in = _mm_and_ps(in, _mm_cmple_ps(_mm_sub_ps(z, r), max_z));
+            in = _mm_and_ps(in, _mm_cmpge_ps(_mm_add_ps(z, r), min_z));
+
+            u32 hits = u32(_mm_movemask_ps(in)) & N._lanes(p);
+            for (u32 lane = 0; hits; ++lane, hits >>= 1)
+            {
+                if (0 == (hits & 1))
+                    continue;
+                if (0 == (P.data[lane]->type & mask))
+                    continue;
+
+                result->push_back(P.items[lane]);
+                if (b_first)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    void walk(u32 id, Fvector& n_C, float n_R)
     {
         // box
         float n_vR = 2 * n_R;
@@ -35,34 +84,20 @@ public:
             return;
 
         // test items
-        for (auto& it : N->items)
-        {
-            ISpatial* S = it;
-            if (0 == (S->GetSpatialData().type & mask))
-                continue;
-
-            Fvector& sC = S->GetSpatialData().sphere.P;
-            float sR = S->GetSpatialData().sphere.R;
-            Fbox sB;
-            sB.set(sC.x - sR, sC.y - sR, sC.z - sR, sC.x + sR, sC.y + sR, sC.z + sR);
-            if (!sB.intersect(box))
-                continue;
-
-            space->q_result->push_back(S);
-            if (b_first)
-                return;
-        }
+        const ISpatial_NODE& N = nodes[id];
+        if (test(N))
+            return;
 
         // recurse
         float c_R = n_R / 2;
         for (u32 octant = 0; octant < 8; octant++)
         {
-            if (0 == N->children[octant])
+            if (SPATIAL_NO_NODE == N.children[octant])
                 continue;
             Fvector c_C;
             c_C.mad(n_C, c_spatial_offset[octant], c_R);
-            walk(N->children[octant], c_C, c_R);
-            if (b_first && !space->q_result->empty())
+            walk(N.children[octant], c_C, c_R);
+            if (b_first && !result->empty())
                 return;
         }
     }
@@ -70,22 +105,26 @@ public:
 
 void ISpatial_DB::q_box(xr_vector<ISpatial*>& R, u32 _o, u32 _mask, const Fvector& _center, const Fvector& _size)
 {
-    pcs->Enter();
-    Stats.Query.Begin();
-    q_result = &R;
-    q_result->clear();
-    if (_o & O_ONLYFIRST)
+    CTimer T;
+    _query_begin(T);
+    R.clear();
+    if (SPATIAL_NO_NODE != m_root)
     {
-        walker<true> W(this, _mask, _center, _size);
-        W.walk(m_root, m_center, m_bounds);
-    }
-    else
-    {
-        walker<false> W(this, _mask, _center, _size);
-        W.walk(m_root, m_center, m_bounds);
+        if (_o & O_ONLYFIRST)
+        {
+            walker<true> W(m_nodes.data(), &R, _mask, _center, _size);
+            W.walk(m_root, m_center, m_bounds);
+            if (R.empty())
+                W.test(m_nodes[PENDING_NODE]);
+        }
+        else
+        {
+            walker<false> W(m_nodes.data(), &R, _mask, _center, _size);
+            W.walk(m_root, m_center, m_bounds);
+            W.test(m_nodes[PENDING_NODE]);
+        }
     }
-    Stats.Query.End();
-    pcs->Leave();
+    _query_end(T);
 }
 
 void ISpatial_DB::q_sphere(xr_vector<ISpatial*>& R, u32 _o, u32 _mask, const Fvector& _center, const float _radius)
@@ -3,24 +3,80 @@
 #include "Frustum.h"
 #include "xrCore/_fbox.h"
 #include "xrCore/Threading/Lock.hpp"
+#pragma warning(push)
+#pragma warning(disable : 4995)
+#include <xmmintrin.h>
+#pragma warning(pop)
 
 extern Fvector c_spatial_offset[8];
 
-class walker
+class alignas(16) walker
 {
 public:
+    // planes splatted by components
+    __m128 p_x[FRUSTUM_MAXPLANES];
+    __m128 p_y[FRUSTUM_MAXPLANES];
+    __m128 p_z[FRUSTUM_MAXPLANES];
+    __m128 p_d[FRUSTUM_MAXPLANES];
     u32 mask;
     CFrustum* F;
-    ISpatial_DB* space;
+    const ISpatial_NODE* nodes;
+    xr_vector<ISpatial*>* result;
 
 public:
-    walker(ISpatial_DB* _space, u32 _mask, const CFrustum* _F)
+    walker(const ISpatial_NODE* _nodes, xr_vector<ISpatial*>* _result, u32 _mask, const CFrustum* _F)
     {
         mask = _mask;
         F = (CFrustum*)_F;
-        space = _space;
+        nodes = _nodes;
+        result = _result;
+
+        for (size_t i = 0; i < F->p_count; ++i)
+        {
+            const Fplane& P = F->planes[i];
+            p_x[i] = _mm_set1_ps(P.n.x);
+            p_y[i] = _mm_set1_ps(P.n.y);
+            p_z[i] = _mm_set1_ps(P.n.z);
+            p_d[i] = _mm_set1_ps(P.d);
+        }
     }
-    void walk(ISpatial_NODE* N, Fvector& n_C, float n_R, u32 fmask)
+
+    // Same as CFrustum::testSphere() != fcvNone, for four spheres at once
+    void test(const ISpatial_NODE& N, u32 fmask)
+    {
+        for (size_t p = 0; p < N.packs.size(); ++p)
+        {
+            const SpatialPack& P = N.packs[p];
+            const __m128 x = _mm_loadu_ps(P.x);
+            const __m128 y = _mm_loadu_ps(P.y);
+            const __m128 z = _mm_loadu_ps(P.z);
+            const __m128 r = _mm_loadu_ps(P.r);
+
+            __m128 out = _mm_setzero_ps();
+            u32 bit = 1;
+            for (size_t i = 0; i < F->p_count; i++, bit <<= 1)
+            {
+                if (0 == (fmask & bit))
+                    continue;
+                __m128 cls = _mm_add_ps(_mm_mul_ps(p_x[i], x), p_d[i]);
+                cls = _mm_add_ps(cls, _mm_mul_ps(p_y[i], y));
+                cls = _mm_add_ps(cls, _mm_mul_ps(p_z[i], z));
+                out = _mm_or_ps(out, _mm_cmpgt_ps(cls, r));
+            }
+
+            u32 hits = ~u32(_mm_movemask_ps(out)) & N._lanes(p);
+            for (u32 lane = 0; hits; ++lane, hits >>= 1)
+            {
+                if (0 == (hits & 1))
+                    continue;
+                if (0 == (P.data[lane]->type & mask))
+                    continue;
+                result->push_back(P.items[lane]);
+            }
+        }
+    }
+
+    void walk(u32 id, Fvector& n_C, float n_R, u32 fmask)
     {
         // box
         float n_vR = 2 * n_R;
@@ -30,42 +86,32 @@ public:
             return;
 
         // test items
-        for (auto& it : N->items)
-        {
-            ISpatial* S = it;
-            if (0 == (S->GetSpatialData().type & mask))
-                continue;
-
-            Fvector& sC = S->GetSpatialData().sphere.P;
-            float sR = S->GetSpatialData().sphere.R;
-            u32 tmask = fmask;
-            if (fcvNone == F->testSphere(sC, sR, tmask))
-                continue;
-
-            space->q_result->push_back(S);
-        }
+        const ISpatial_NODE& N = nodes[id];
+        test(N, fmask);
 
         // recurse
         float c_R = n_R / 2;
         for (u32 octant = 0; octant < 8; octant++)
         {
-            if (0 == N->children[octant])
+            if (SPATIAL_NO_NODE == N.children[octant])
                 continue;
             Fvector c_C;
             c_C.mad(n_C, c_spatial_offset[octant], c_R);
-            walk(N->children[octant], c_C, c_R, fmask);
+            walk(N.children[octant], c_C, c_R, fmask);
         }
     }
 };
 
 void ISpatial_DB::q_frustum(xr_vector<ISpatial*>& R, u32 _o, u32 _mask, const CFrustum& _frustum)
 {
-    pcs->Enter();
-    Stats.Query.Begin();
-    q_result = &R;
-    q_result->clear();
-    walker W(this, _mask, &_frustum);
-    W.walk(m_root, m_center, m_bounds, _frustum.getMask());
-    Stats.Query.End();
-    pcs->Leave();
+    CTimer T;
+    _query_begin(T);
+    R.clear();
+    if (SPATIAL_NO_NODE != m_root)
+    {
+        walker W(m_nodes.data(), &R, _mask, &_frustum);
+        W.walk(m_root, m_center, m_bounds, _frustum.getMask());
+        W.test(m_nodes[PENDING_NODE], _frustum.getMask());
+    }
+    _query_end(T);
 }
@@ -203,10 +203,12 @@ public:
     u32 mask;
     float range;
     float range2;
-    ISpatial_DB* space;
+    const ISpatial_NODE* nodes;
+    xr_vector<ISpatial*>* result;
 
 public:
-    walker(ISpatial_DB* _space, u32 _mask, const Fvector& _start, const Fvector& _dir, float _range)
+    walker(const ISpatial_NODE* _nodes, xr_vector<ISpatial*>* _result, u32 _mask, const Fvector& _start,
+        const Fvector& _dir, float _range)
     {
         mask = _mask;
         ray.pos.set(_start);
@@ -233,7 +235,8 @@ public:
         }
         range = _range;
         range2 = _range * _range;
-        space = _space;
+        nodes = _nodes;
+        result = _result;
     }
     // fpu
     ICF BOOL _box_fpu(const Fvector& n_C, const float n_R, Fvector& coord)
@@ -264,7 +267,42 @@ public:
 
         return isect_sse(box, ray, dist);
     }
-    void walk(ISpatial_NODE* N, Fvector& n_C, float n_R)
+    // Returns true if the query is done
+    bool test(const ISpatial_NODE& N)
+    {
+        for (u32 i = 0; i < N.count; ++i)
+        {
+            const SpatialPack& P = N.packs[i / 4];
+            const u32 lane = i % 4;
+            if (mask != (P.data[lane]->type & mask))
+                continue;
+            Fsphere sS;
+            sS.P.set(P.x[lane], P.y[lane], P.z[lane]);
+            sS.R = P.r[lane];
+            int quantity;
+            float afT[2];
+            Fsphere::ERP_Result isect = sS.intersect(ray.pos, ray.fwd_dir, range, quantity, afT);
+
+            if (isect == Fsphere::rpOriginInside || ((isect == Fsphere::rpOriginOutside) && (afT[0] < range)))
+            {
+                if (b_nearest)
+                {
+                    switch (isect)
+                    {
+                    case Fsphere::rpOriginInside: range = afT[0] < range ? afT[0] : range; break;
+                    case Fsphere::rpOriginOutside: range = afT[0]; break;
+                    }
+                    range2 = range * range;
+                }
+                result->push_back(P.items[lane]);
+                if (b_first)
+                    return true;
+            }
+        }
+        return false;
+    }
+
+    void walk(u32 id, Fvector& n_C, float n_R)
     {
         // Actual ray/aabb test
         if (b_use_sse)
@@ -287,43 +325,20 @@ public:
         }
 
         // test items
-        for (auto& it : N->items)
-        {
-            ISpatial* S = it;
-            if (mask != (S->GetSpatialData().type & mask))
-                continue;
-            Fsphere& sS = S->GetSpatialData().sphere;
-            int quantity;
-            float afT[2];
-            Fsphere::ERP_Result result = sS.intersect(ray.pos, ray.fwd_dir, range, quantity, afT);
-
-            if (result == Fsphere::rpOriginInside || ((result == Fsphere::rpOriginOutside) && (afT[0] < range)))
-            {
-                if (b_nearest)
-                {
-                    switch (result)
-                    {
-                    case Fsphere::rpOriginInside: range = afT[0] < range ? afT[0] : range; break;
-                    case Fsphere::rpOriginOutside: range = afT[0]; break;
-                    }
-                    range2 = range * range;
-                }
-                space->q_result->push_back(S);
-                if (b_first)
-                    return;
-            }
-        }
+        const ISpatial_NODE& N = nodes[id];
+        if (test(N))
+            return;
 
         // recurse
         float c_R = n_R / 2;
         for (u32 octant = 0; octant < 8; octant++)
         {
-            if (0 == N->children[octant])
+            if (SPATIAL_NO_NODE == N.children[octant])
                 continue;
             Fvector c_C;
             c_C.mad(n_C, c_spatial_offset[octant], c_R);
-            walk(N->children[octant], c_C, c_R);
-            if (b_first && !space->q_result->empty())
+            walk(N.children[octant], c_C, c_R);
+            if (b_first && !result->empty())
                 return;
         }
     }
@@ -332,36 +347,46 @@ public:
 void ISpatial_DB::q_ray(
     xr_vector<ISpatial*>& R, u32 _o, u32 _mask_and, const Fvector& _start, const Fvector& _dir, float _range)
 {
-    pcs->Enter();
-    Stats.Query.Begin();
-    q_result = &R;
-    q_result->clear();
+    CTimer T;
+    _query_begin(T);
+    R.clear();
+    if (SPATIAL_NO_NODE == m_root)
+    {
+        _query_end(T);
+        return;
+    }
     if (SDL_HasSSE())
     {
         if (_o & O_ONLYFIRST)
         {
             if (_o & O_ONLYNEAREST)
             {
-                walker<true, true, true> W(this, _mask_and, _start, _dir, _range);
+                walker<true, true, true> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                if (R.empty())
+                    W.test(m_nodes[PENDING_NODE]);
             }
             else
             {
-                walker<true, true, false> W(this, _mask_and, _start, _dir, _range);
+                walker<true, true, false> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                if (R.empty())
+                    W.test(m_nodes[PENDING_NODE]);
             }
         }
         else
         {
             if (_o & O_ONLYNEAREST)
             {
-                walker<true, false, true> W(this, _mask_and, _start, _dir, _range);
+                walker<true, false, true> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                W.test(m_nodes[PENDING_NODE]);
             }
             else
             {
-                walker<true, false, false> W(this, _mask_and, _start, _dir, _range);
+                walker<true, false, false> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                W.test(m_nodes[PENDING_NODE]);
             }
         }
     }
@@ -371,29 +396,34 @@ void ISpatial_DB::q_ray(
         {
             if (_o & O_ONLYNEAREST)
             {
-                walker<false, true, true> W(this, _mask_and, _start, _dir, _range);
+                walker<false, true, true> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                if (R.empty())
+                    W.test(m_nodes[PENDING_NODE]);
             }
             else
             {
-                walker<false, true, false> W(this, _mask_and, _start, _dir, _range);
+                walker<false, true, false> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                if (R.empty())
+                    W.test(m_nodes[PENDING_NODE]);
             }
         }
         else
         {
             if (_o & O_ONLYNEAREST)
             {
-                walker<false, false, true> W(this, _mask_and, _start, _dir, _range);
+                walker<false, false, true> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                W.test(m_nodes[PENDING_NODE]);
             }
             else
             {
-                walker<false, false, false> W(this, _mask_and, _start, _dir, _range);
+                walker<false, false, false> W(m_nodes.data(), &R, _mask_and, _start, _dir, _range);
                 W.walk(m_root, m_center, m_bounds);
+                W.test(m_nodes[PENDING_NODE]);
             }
         }
     }
-    Stats.Query.End();
-    pcs->Leave();
+    _query_end(T);
 }
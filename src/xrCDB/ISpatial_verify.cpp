@@ -8,24 +8,29 @@ class walker
 public:
     u32 o_count;
     u32 n_count;
+    const ISpatial_NODE* nodes;
 
 public:
-    walker()
+    walker(const ISpatial_NODE* _nodes)
     {
         o_count = 0;
         n_count = 0;
+        nodes = _nodes;
     }
-    void walk(ISpatial_NODE* N, Fvector& n_C, float n_R)
+    void walk(u32 id, Fvector& n_C, float n_R)
     {
+        const ISpatial_NODE* N = nodes + id;
+
         // test items
         n_count += 1;
-        o_count += N->items.size();
+        o_count += N->count;
+        VERIFY(N->packs.size() == (N->count + 3) / 4);
 
         // recurse
         float c_R = n_R / 2;
         for (u32 octant = 0; octant < 8; octant++)
         {
-            if (0 == N->children[octant])
+            if (SPATIAL_NO_NODE == N->children[octant])
                 continue;
             Fvector c_C;
             c_C.mad(n_C, c_spatial_offset[octant], c_R);
@@ -36,9 +41,10 @@ public:
 
 BOOL ISpatial_DB::verify()
 {
-    walker W;
+    walker W(m_nodes.data());
     W.walk(m_root, m_center, m_bounds);
-    BOOL bResult = (W.o_count == Stats.ObjectCount) && (W.n_count == Stats.NodeCount);
+    const u32 pending = m_nodes[PENDING_NODE].count;
+    BOOL bResult = (W.o_count + pending == Stats.ObjectCount) && (W.n_count == Stats.NodeCount);
     VERIFY(bResult);
     return bResult;
 }
@@ -4,7 +4,9 @@
 #include "stdafx.h"
 
 #include "xrCDB.h"
+#include "xrCDB_compact.h"
 #include "xrCore/Threading/Lock.hpp"
+#include "SDL.h"
 
 namespace Opcode
 {
@@ -37,6 +39,8 @@ MODEL::MODEL() :
 #endif // CONFIG_PROFILE_LOCKS
 {
     tree = 0;
+    compact = 0;
+    layout = strstr(Core.Params, "-cdb_compact") ? TreeLayout::Compact : TreeLayout::OPCODE;
     tris = 0;
     tris_count = 0;
     verts = 0;
@@ -48,6 +52,7 @@ MODEL::~MODEL()
     syncronize(); // maybe model still in building
     status = S_INIT;
     xr_delete(tree);
+    xr_delete(compact);
     xr_free(tris);
     tris_count = 0;
     xr_free(verts);
@@ -55,6 +60,12 @@ MODEL::~MODEL()
     delete pcs;
 }
 
+void MODEL::set_layout(TreeLayout value)
+{
+    R_ASSERT(S_INIT == status);
+    layout = value;
+}
+
 void MODEL::syncronize_impl() const
 {
     Log("! WARNING: syncronized CDB::query");
@@ -114,7 +125,28 @@ void MODEL::build(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, vo
 #endif
 }
 
-void MODEL::build_internal(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
+void MODEL::build_cached(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
+{
+    R_ASSERT(S_INIT == status);
+    R_ASSERT((Vcnt >= 4) && (Tcnt >= 2));
+
+    _initialize_cpu_thread();
+
+    // Only the geometry affects the tree, but the callback may change tris, so the key is taken before it
+    const u32 crc = crc32(T, Tcnt * sizeof(TRI), crc32(V, Vcnt * sizeof(Fvector)));
+
+    copy_source(V, Vcnt, T, Tcnt, bc, bcp);
+    if (!cache_load(crc))
+    {
+        build_tree();
+        if (tree)
+            cache_save(crc);
+    }
+    build_compact();
+    status = S_READY;
+}
+
+void MODEL::copy_source(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
 {
     // verts
     verts_count = Vcnt;
@@ -129,10 +161,20 @@ void MODEL::build_internal(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callbac
     // callback
     if (bc)
         bc(verts, Vcnt, tris, Tcnt, bcp);
+}
+
+void MODEL::build_internal(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp)
+{
+    copy_source(V, Vcnt, T, Tcnt, bc, bcp);
 
     // Release data pointers
     status = S_BUILD;
+    build_tree();
+    build_compact();
+}
 
+void MODEL::build_tree()
+{
     // Allocate temporary "OPCODE" tris + convert tris to 'pointer' form
     u32* temp_tris = xr_alloc<u32>(tris_count * 3);
     if (0 == temp_tris)
@@ -173,6 +215,166 @@ void MODEL::build_internal(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callbac
     return;
 }
 
+void MODEL::build_compact()
+{
+    if (TreeLayout::Compact != layout || !tree)
+        return;
+
+    if (!SDL_HasSSE2())
+    {
+        Msg("! xrCDB: compact tree requires SSE2, using OPCODE one");
+        layout = TreeLayout::OPCODE;
+        return;
+    }
+
+    compact = new CompactTree();
+    if (!compact->build(*(const AABBNoLeafTree*)tree->GetTree(), verts, tris))
+    {
+        Msg("! xrCDB: tree is too deep for the compact layout, using OPCODE one");
+        xr_delete(compact);
+        layout = TreeLayout::OPCODE;
+        return;
+    }
+    xr_delete(tree);
+}
+
+// Tree cache layout, little-endian and independent of the pointer size:
+//   TreeCacheHeader
+//   TreeCacheNode nodes[nodes_count]
+namespace
+{
+constexpr u32 TREE_CACHE_MAGIC = 0x54424443; // "CDBT"
+constexpr u32 TREE_CACHE_VERSION = 1;
+
+struct TreeCacheHeader
+{
+    u32 magic;
+    u32 version;
+    u32 crc; // of the source verts and tris
+    u32 verts_count;
+    u32 tris_count;
+    u32 nodes_count;
+};
+
+struct TreeCacheNode
+{
+    Fvector center;
+    Fvector extents;
+    u32 pos; // node index << 1 or primitive << 1 | 1
+    u32 neg;
+};
+static_assert(sizeof(TreeCacheNode) == 32, "Tree cache layout must not depend on the platform");
+} // namespace
+
+bool MODEL::cache_name(u32 crc, string_path& name)
+{
+    if (strstr(Core.Params, "-no_cdb_cache"))
+        return false;
+
+    FS_Path* root = nullptr;
+    if (!FS.get_path("$app_data_root$", &root))
+        return false;
+
+    xr_sprintf(name, "%scdb_cache" DELIMITER "%08x.cdb", root->m_Path, crc);
+    return true;
+}
+
+bool MODEL::cache_load(u32 crc)
+{
+    string_path name;
+    if (!cache_name(crc, name) || !FS.exist(name, FSType::External))
+        return false;
+
+    // The nodes are converted into the OPCODE ones in a single pass: those keep pointer-sized links
+    // holding absolute node addresses, so the file can't be used as the tree in place
+    IReader* F = FS.r_open(name);
+    if (!F)
+        return false;
+
+    bool valid = false;
+    const TreeCacheHeader* H = (const TreeCacheHeader*)F->pointer();
+    if (F->length() >= sizeof(TreeCacheHeader) && H->magic == TREE_CACHE_MAGIC &&
+        H->version == TREE_CACHE_VERSION && H->crc == crc && H->verts_count == u32(verts_count) &&
+        H->tris_count == u32(tris_count) && H->nodes_count == u32(tris_count - 1) &&
+        F->length() == sizeof(TreeCacheHeader) + H->nodes_count * sizeof(TreeCacheNode))
+    {
+        const TreeCacheNode* src = (const TreeCacheNode*)(H + 1);
+        const u32 count = H->nodes_count;
+
+        // Children follow their parent, so the links can't form a cycle
+        const auto link = [&](AABBNoLeafNode* nodes, u32 parent, u32 data, uintptr_t& dest)
+        {
+            const u32 index = data >> 1;
+            if (data & 1)
+            {
+                dest = data;
+                return index < u32(tris_count);
+            }
+            dest = uintptr_t(nodes + index);
+            return index > parent && index < count;
+        };
+
+        tree = new OPCODE_Model();
+        AABBNoLeafNode* nodes = tree->Restore(count);
+        valid = nullptr != nodes;
+        for (u32 i = 0; valid && i < count; ++i)
+        {
+            AABBNoLeafNode& N = nodes[i];
+            N.mAABB.mCenter.Set(src[i].center.x, src[i].center.y, src[i].center.z);
+            N.mAABB.mExtents.Set(src[i].extents.x, src[i].extents.y, src[i].extents.z);
+            valid = link(nodes, i, src[i].pos, N.mData) && link(nodes, i, src[i].neg, N.mData2);
+        }
+
+        if (!valid)
+            xr_delete(tree);
+    }
+    FS.r_close(F);
+
+    if (!valid)
+        Msg("! xrCDB: tree cache [%s] is invalid, rebuilding", name);
+    return valid;
+}
+
+void MODEL::cache_save(u32 crc) const
+{
+    string_path name;
+    if (!cache_name(crc, name))
+        return;
+
+    const AABBNoLeafTree* T = static_cast<const AABBNoLeafTree*>(tree->GetTree());
+    const AABBNoLeafNode* nodes = T->GetNodes();
+    const u32 count = T->GetNbNodes();
+
+    const auto link = [nodes](uintptr_t data) -> u32
+    {
+        if (data & 1)
+            return u32(data);
+        return u32((const AABBNoLeafNode*)data - nodes) << 1;
+    };
+
+    xr_vector<TreeCacheNode> dest(count);
+    for (u32 i = 0; i < count; ++i)
+    {
+        const AABBNoLeafNode& N = nodes[i];
+        dest[i].center.set(N.mAABB.mCenter.x, N.mAABB.mCenter.y, N.mAABB.mCenter.z);
+        dest[i].extents.set(N.mAABB.mExtents.x, N.mAABB.mExtents.y, N.mAABB.mExtents.z);
+        dest[i].pos = link(N.mData);
+        dest[i].neg = link(N.mData2);
+    }
+
+    const TreeCacheHeader H = { TREE_CACHE_MAGIC, TREE_CACHE_VERSION, crc, u32(verts_count), u32(tris_count), count };
+
+    IWriter* W = FS.w_open(name);
+    if (!W)
+        return;
+    if (W->valid())
+    {
+        W->w(&H, sizeof(H));
+        W->w(dest.data(), u32(dest.size() * sizeof(TreeCacheNode)));
+    }
+    FS.w_close(W);
+}
+
 u32 MODEL::memory()
 {
     if (S_BUILD == status)
@@ -182,6 +384,8 @@ u32 MODEL::memory()
     }
     u32 V = verts_count * sizeof(Fvector);
     u32 T = tris_count * sizeof(TRI);
+    if (compact)
+        return u32(compact->memory()) + V + T + sizeof(*this);
     return tree->GetUsedBytes() + V + T + sizeof(*this) + sizeof(*tree);
 }
 
@@ -42,6 +42,15 @@ public:
     IC u32 IDvert(u32 ID) { return verts[ID]; }
 };
 
+// Collision tree of the model
+enum class TreeLayout : u8
+{
+    OPCODE, // binary tree with float bounds
+    Compact, // 4-wide tree with 16-bit child bounds, see xrCDB_compact.h
+};
+
+class CompactTree;
+
 // Build callback
 typedef void __stdcall build_callback(Fvector* V, int Vcnt, TRI* T, int Tcnt, void* params);
 
@@ -60,6 +69,8 @@ class XRCDB_API MODEL : Noncopyable
 private:
     Lock* pcs;
     Opcode::OPCODE_Model* tree;
+    CompactTree* compact; // replaces the tree when built with TreeLayout::Compact
+    TreeLayout layout;
     volatile u32 status; // 0=ready, 1=init, 2=building
 
     // tris
@@ -78,6 +89,9 @@ public:
     IC const TRI* get_tris() const { return tris; }
     IC TRI* get_tris() { return tris; }
     IC int get_tris_count() const { return tris_count; }
+    // Should be called before build(), the default is Compact with -cdb_compact
+    void set_layout(TreeLayout value);
+    IC TreeLayout get_layout() const { return layout; }
     IC void syncronize() const
     {
         if (S_READY != status)
@@ -87,10 +101,20 @@ public:
     static void build_thread(void*);
     void build_internal(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc = NULL, void* bcp = NULL);
     void build(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc = NULL, void* bcp = NULL);
+    // Same as build(), but restores the tree from $app_data_root$ if it was already built
+    // for the same source, and saves it there otherwise. Never uses the construction thread.
+    void build_cached(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc = NULL, void* bcp = NULL);
     u32 memory();
 
 private:
     void syncronize_impl() const;
+
+    void copy_source(Fvector* V, int Vcnt, TRI* T, int Tcnt, build_callback* bc, void* bcp);
+    void build_tree();
+    void build_compact();
+    static bool cache_name(u32 crc, string_path& name);
+    bool cache_load(u32 crc);
+    void cache_save(u32 crc) const;
 };
 
 // Collider result
@@ -113,6 +137,14 @@ struct XRCDB_API RESULT
     float u, v;
 };
 
+// Ray of a batch query
+struct XRCDB_API RAY
+{
+    Fvector start;
+    Fvector dir;
+    float range;
+};
+
 // Collider Options
 enum
 {
@@ -132,6 +164,10 @@ class XRCDB_API COLLIDER
 
     // Result management
     xr_vector<RESULT> rd;
+    xr_vector<u32> rd_rays; // first result of every ray of the batch query, and the end
+
+    template <bool bCull, bool bFirst, bool bNearest>
+    void ray_packets(const MODEL* m_def, const RAY* rays, size_t count);
 
 public:
     COLLIDER();
@@ -139,6 +175,9 @@ public:
 
     ICF void ray_options(u32 f) { ray_mode = f; }
     void ray_query(const MODEL* m_def, const Fvector& r_start, const Fvector& r_dir, float r_range = 10000.f);
+    // Traces the rays by four at once, the results are grouped by rays.
+    // Gives the same results as ray_query() for every ray.
+    void ray_query(const MODEL* m_def, const RAY* rays, size_t count);
 
     ICF void box_options(u32 f) { box_mode = f; }
     void box_query(const MODEL* m_def, const Fvector& b_center, const Fvector& b_dim);
@@ -154,6 +193,10 @@ public:
     ICF size_t r_count() { return rd.size(); };
     ICF void r_clear() { rd.clear(); };
     ICF void r_clear_compact() { rd.clear(); };
+
+    // Results of the ray of the last batch query
+    ICF RESULT* r_ray_begin(size_t ray) { return rd.data() + rd_rays[ray]; }
+    ICF size_t r_ray_count(size_t ray) const { return rd_rays[ray + 1] - rd_rays[ray]; }
 };
 
 //
@@ -2,6 +2,7 @@
 #pragma hdrstop
 
 #include "xrCDB.h"
+#include "xrCDB_compact.h"
 
 using namespace CDB;
 using namespace Opcode;
@@ -290,46 +291,107 @@ public:
         else
             _stab(node->GetNeg());
     }
+    void _stab(const CompactTree& T)
+    {
+        struct entry
+        {
+            u32 node;
+            CompactBounds bounds;
+        };
+        entry stack[CompactTree::STACK_SIZE];
+        u32 count = 0;
+        stack[count++] = { 0, T.root };
+
+        const __m128 min_x = _mm_set1_ps(b_min.x), min_y = _mm_set1_ps(b_min.y), min_z = _mm_set1_ps(b_min.z);
+        const __m128 max_x = _mm_set1_ps(b_max.x), max_y = _mm_set1_ps(b_max.y), max_z = _mm_set1_ps(b_max.z);
+
+        CompactChildren C;
+        while (count)
+        {
+            const entry E = stack[--count];
+            C.decode(T.nodes[E.node], E.bounds);
+
+            // Actual box-box tests, four at once
+            __m128 in = _mm_cmple_ps(_mm_load_ps(C.min[0]), max_x);
+            in = _mm_and_ps(in, _mm_cmpge_ps(_mm_load_ps(C.max[0]), min_x));
+            in = _mm_and_ps(in, _mm_cmple_ps(_mm_load_ps(C.min[1]), max_y));
+            in = _mm_and_ps(in, _mm_cmpge_ps(_mm_load_ps(C.max[1]), min_y));
+            in = _mm_and_ps(in, _mm_cmple_ps(_mm_load_ps(C.min[2]), max_z));
+            in = _mm_and_ps(in, _mm_cmpge_ps(_mm_load_ps(C.max[2]), min_z));
+            const u32 mask = C.valid & u32(_mm_movemask_ps(in));
+
+            // Pushed in reverse, so the children are visited in order
+            const CompactNode& N = T.nodes[E.node];
+            for (int i = 3; i >= 0; --i)
+            {
+                if (0 == (mask & (1 << i)) || CompactNode::is_leaf(N.child[i]))
+                    continue;
+                stack[count++] = { CompactNode::index(N.child[i]), C.bounds(i) };
+            }
+            for (u32 i = 0; i < 4; ++i)
+            {
+                if (0 == (mask & (1 << i)) || !CompactNode::is_leaf(N.child[i]))
+                    continue;
+                _prim(CompactNode::index(N.child[i]));
+
+                // Early exit for "only first"
+                if (bFirst && dest->r_count())
+                    return;
+            }
+        }
+    }
 };
 
+template <bool bClass3, bool bFirst, typename Tree>
+void box_stab(COLLIDER* CL, Fvector* V, TRI* tris, const Tree& T, const Fvector& b_center, const Fvector& b_dim)
+{
+    box_collider<bClass3, bFirst> BC;
+    BC._init(CL, V, tris, b_center, b_dim);
+    BC._stab(T);
+}
+
 void COLLIDER::box_query(const MODEL* m_def, const Fvector& b_center, const Fvector& b_dim)
 {
     m_def->syncronize();
-
-    // Get nodes
-    const AABBNoLeafTree* T = (const AABBNoLeafTree*)m_def->tree->GetTree();
-    const AABBNoLeafNode* N = T->GetNodes();
     r_clear();
 
     // Binary dispatcher
-    if (box_mode & OPT_FULL_TEST)
+    if (m_def->compact)
     {
-        if (box_mode & OPT_ONLYFIRST)
+        const CompactTree& T = *m_def->compact;
+        if (box_mode & OPT_FULL_TEST)
         {
-            box_collider<true, true> BC;
-            BC._init(this, m_def->verts, m_def->tris, b_center, b_dim);
-            BC._stab(N);
+            if (box_mode & OPT_ONLYFIRST)
+                box_stab<true, true>(this, m_def->verts, m_def->tris, T, b_center, b_dim);
+            else
+                box_stab<true, false>(this, m_def->verts, m_def->tris, T, b_center, b_dim);
         }
         else
         {
-            box_collider<true, false> BC;
-            BC._init(this, m_def->verts, m_def->tris, b_center, b_dim);
-            BC._stab(N);
+            if (box_mode & OPT_ONLYFIRST)
+                box_stab<false, true>(this, m_def->verts, m_def->tris, T, b_center, b_dim);
+            else
+                box_stab<false, false>(this, m_def->verts, m_def->tris, T, b_center, b_dim);
         }
+        return;
+    }
+
+    // Get nodes
+    const AABBNoLeafTree* T = (const AABBNoLeafTree*)m_def->tree->GetTree();
+    const AABBNoLeafNode* N = T->GetNodes();
+
+    if (box_mode & OPT_FULL_TEST)
+    {
+        if (box_mode & OPT_ONLYFIRST)
+            box_stab<true, true>(this, m_def->verts, m_def->tris, N, b_center, b_dim);
+        else
+            box_stab<true, false>(this, m_def->verts, m_def->tris, N, b_center, b_dim);
     }
     else
     {
         if (box_mode & OPT_ONLYFIRST)
-        {
-            box_collider<false, true> BC;
-            BC._init(this, m_def->verts, m_def->tris, b_center, b_dim);
-            BC._stab(N);
-        }
+            box_stab<false, true>(this, m_def->verts, m_def->tris, N, b_center, b_dim);
         else
-        {
-            box_collider<false, false> BC;
-            BC._init(this, m_def->verts, m_def->tris, b_center, b_dim);
-            BC._stab(N);
-        }
+            box_stab<false, false>(this, m_def->verts, m_def->tris, N, b_center, b_dim);
     }
 }
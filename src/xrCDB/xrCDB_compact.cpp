@@ -0,0 +1,189 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "xrCDB_compact.h"
+
+using namespace CDB;
+using namespace Opcode;
+
+namespace
+{
+// Child of the OPCODE node: primitive << 1 | 1 or node pointer
+struct SourceChild
+{
+    uintptr_t data;
+    Fvector min, max;
+
+    bool is_leaf() const { return data & 1; }
+    const AABBNoLeafNode* node() const { return (const AABBNoLeafNode*)data; }
+    float area() const
+    {
+        Fvector size;
+        size.sub(max, min);
+        return size.x * size.y + size.y * size.z + size.z * size.x;
+    }
+};
+
+class CompactBuilder
+{
+public:
+    CompactTree& dest;
+    const Fvector* verts;
+    const TRI* tris;
+    u32 depth;
+
+    CompactBuilder(CompactTree& T, const Fvector* V, const TRI* tris) : dest(T), verts(V), tris(tris), depth(0) {}
+
+    SourceChild child(uintptr_t data) const
+    {
+        SourceChild result;
+        result.data = data;
+        if (data & 1)
+        {
+            const TRI& T = tris[data >> 1];
+            result.min.set(verts[T.verts[0]]);
+            result.max.set(verts[T.verts[0]]);
+            for (u32 i = 1; i < 3; ++i)
+            {
+                result.min.min(verts[T.verts[i]]);
+                result.max.max(verts[T.verts[i]]);
+            }
+        }
+        else
+        {
+            const CollisionAABB& box = ((const AABBNoLeafNode*)data)->mAABB;
+            const Fvector& C = (const Fvector&)box.mCenter;
+            const Fvector& E = (const Fvector&)box.mExtents;
+            result.min.sub(C, E);
+            result.max.add(C, E);
+        }
+        return result;
+    }
+
+    // Pulls the grandchildren up, opening the biggest nodes first
+    u32 collect(const AABBNoLeafNode* node, SourceChild (&children)[4]) const
+    {
+        children[0] = child(node->mData);
+        children[1] = child(node->mData2);
+        u32 count = 2;
+        while (count < 4)
+        {
+            int best = -1;
+            float best_area = -1.f;
+            for (u32 i = 0; i < count; ++i)
+            {
+                if (!children[i].is_leaf() && children[i].area() > best_area)
+                {
+                    best = int(i);
+                    best_area = children[i].area();
+                }
+            }
+            if (best < 0)
+                break;
+
+            const AABBNoLeafNode* opened = children[best].node();
+            children[best] = child(opened->mData);
+            children[count++] = child(opened->mData2);
+        }
+        return count;
+    }
+
+    static u16 quantize(float value, float b_min, float step, bool round_up)
+    {
+        if (step <= 0.f)
+            return 0;
+        const float q = (value - b_min) / step;
+        const float rounded = round_up ? std::ceil(q) : std::floor(q);
+        return u16(std::clamp(rounded, 0.f, 65535.f));
+    }
+
+    u32 emit(const AABBNoLeafNode* node, const CompactBounds& bounds, u32 level)
+    {
+        depth = std::max(depth, level);
+
+        const u32 index = u32(dest.nodes.size());
+        dest.nodes.emplace_back();
+
+        SourceChild children[4];
+        const u32 count = collect(node, children);
+
+        CompactNode N;
+        for (u32 i = 0; i < 4; ++i)
+        {
+            N.child[i] = CompactNode::EMPTY;
+            for (u32 k = 0; k < 3; ++k)
+            {
+                N.lo[k][i] = 0;
+                N.hi[k][i] = 0;
+                if (i < count)
+                {
+                    N.lo[k][i] = quantize(children[i].min[k], bounds.min[k], bounds.step[k], false);
+                    N.hi[k][i] = quantize(children[i].max[k], bounds.min[k], bounds.step[k], true);
+                }
+            }
+            if (i < count)
+                N.child[i] = u32(children[i].data);
+        }
+
+        // Rounding is checked with the same code the traversal uses, the bounds must never shrink
+        CompactChildren decoded;
+        for (u32 pass = 0; pass < 4; ++pass)
+        {
+            decoded.decode(N, bounds);
+            bool changed = false;
+            for (u32 i = 0; i < count; ++i)
+            {
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    if (decoded.min[k][i] > children[i].min[k] && N.lo[k][i] > 0)
+                    {
+                        --N.lo[k][i];
+                        changed = true;
+                    }
+                    if (decoded.max[k][i] < children[i].max[k] && N.hi[k][i] < 65535)
+                    {
+                        ++N.hi[k][i];
+                        changed = true;
+                    }
+                }
+            }
+            if (!changed)
+                break;
+        }
+        decoded.decode(N, bounds);
+
+        for (u32 i = 0; i < count; ++i)
+        {
+            if (!children[i].is_leaf())
+                N.child[i] = emit(children[i].node(), decoded.bounds(i), level + 1) << 1;
+        }
+
+        dest.nodes[index] = N;
+        return index;
+    }
+};
+} // namespace
+
+bool CompactTree::build(const AABBNoLeafTree& source, const Fvector* verts, const TRI* tris)
+{
+    const AABBNoLeafNode* N = source.GetNodes();
+    const Fvector& C = (const Fvector&)N->mAABB.mCenter;
+    const Fvector& E = (const Fvector&)N->mAABB.mExtents;
+    root.min.sub(C, E);
+    root.step.mul(E, 2.f * CompactChildren::STEP_SCALE);
+
+    nodes.clear();
+    nodes.reserve(source.GetNbNodes() / 2 + 1);
+
+    CompactBuilder builder(*this, verts, tris);
+    builder.emit(N, root, 1);
+    nodes.shrink_to_fit();
+
+    // Every level pushes at most three more nodes than it pops
+    if (builder.depth * 3 + 1 > STACK_SIZE)
+    {
+        nodes.clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#pragma warning(push)
+#pragma warning(disable : 4995)
+#include <emmintrin.h>
+#pragma warning(pop)
+
+#include "xrCDB.h"
+
+namespace CDB
+{
+/*
+ * Compact collision tree, an alternative to the OPCODE one (see TreeLayout).
+ * Every node has up to four children and takes one cache line: the child bounds
+ * are quantized to 16 bits inside the bounds of the node itself, which aren't stored,
+ * the traversal gets them from the parent. Nodes are stored in depth-first order,
+ * so the first child is usually the next node in memory.
+ */
+struct CompactNode
+{
+    static constexpr u32 EMPTY = u32(-1);
+
+    u16 lo[3][4]; // child bounds min by axis
+    u16 hi[3][4]; // child bounds max by axis
+    u32 child[4]; // node index << 1, primitive << 1 | 1 or EMPTY
+
+    static ICF bool is_leaf(u32 child) { return child & 1; }
+    static ICF u32 index(u32 child) { return child >> 1; }
+};
+static_assert(sizeof(CompactNode) == 64, "Compact node should fit a cache line");
+
+// Bounds of a node as the traversal sees them
+struct CompactBounds
+{
+    Fvector min;
+    Fvector step; // quantization step, a bit more than size / 65535 to cover the max
+};
+
+// Decoded bounds of the node children, by axis
+struct alignas(16) CompactChildren
+{
+    float min[3][4];
+    float max[3][4];
+    float step[3][4];
+    u32 valid; // mask of non-empty children
+
+    ICF void decode(const CompactNode& node, const CompactBounds& bounds)
+    {
+        const __m128 scale = _mm_set1_ps(STEP_SCALE);
+        for (u32 k = 0; k < 3; ++k)
+        {
+            const __m128 b_min = _mm_set1_ps(bounds.min[k]);
+            const __m128 b_step = _mm_set1_ps(bounds.step[k]);
+            const __m128 c_min = dequantize(node.lo[k], b_min, b_step);
+            const __m128 c_max = dequantize(node.hi[k], b_min, b_step);
+            _mm_store_ps(min[k], c_min);
+            _mm_store_ps(max[k], c_max);
+            _mm_store_ps(step[k], _mm_mul_ps(_mm_sub_ps(c_max, c_min), scale));
+        }
+
+        valid = 0;
+        for (u32 i = 0; i < 4; ++i)
+        {
+            if (node.child[i] != CompactNode::EMPTY)
+                valid |= 1 << i;
+        }
+    }
+
+    ICF CompactBounds bounds(u32 i) const
+    {
+        CompactBounds result;
+        result.min.set(min[0][i], min[1][i], min[2][i]);
+        result.step.set(step[0][i], step[1][i], step[2][i]);
+        return result;
+    }
+
+    static constexpr float STEP_SCALE = 1.0001f / 65535.f;
+
+private:
+    static ICF __m128 dequantize(const u16* q, __m128 b_min, __m128 b_step)
+    {
+        const __m128i packed = _mm_loadl_epi64((const __m128i*)q);
+        const __m128 value = _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128()));
+        return _mm_add_ps(b_min, _mm_mul_ps(value, b_step));
+    }
+};
+
+class CompactTree : Noncopyable
+{
+public:
+    // Traversal stack, enough for any tree that was built
+    static constexpr u32 STACK_SIZE = 256;
+
+    xr_vector<CompactNode> nodes;
+    CompactBounds root;
+
+    // Converts the built OPCODE tree, fails if it's too deep for the traversal stack
+    bool build(const Opcode::AABBNoLeafTree& source, const Fvector* verts, const TRI* tris);
+    size_t memory() const { return sizeof(*this) + nodes.size() * sizeof(CompactNode); }
+};
+} // namespace CDB
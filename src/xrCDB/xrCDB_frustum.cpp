@@ -2,6 +2,7 @@
 #pragma hdrstop
 
 #include "xrCDB.h"
+#include "xrCDB_compact.h"
 #include "Frustum.h"
 
 using namespace CDB;
@@ -84,47 +85,114 @@ public:
         else
             _stab(node->GetNeg(), mask);
     }
+    void _stab(const CompactTree& T, u32 mask)
+    {
+        struct entry
+        {
+            u32 node;
+            u32 mask;
+            CompactBounds bounds;
+        };
+        entry stack[CompactTree::STACK_SIZE];
+        u32 count = 0;
+        stack[count++] = { 0, mask, T.root };
+
+        CompactChildren C;
+        while (count)
+        {
+            const entry E = stack[--count];
+            const CompactNode& N = T.nodes[E.node];
+            C.decode(N, E.bounds);
+
+            u32 visible = 0;
+            u32 masks[4];
+            for (u32 i = 0; i < 4; ++i)
+            {
+                if (0 == (C.valid & (1 << i)))
+                    continue;
+
+                // Actual frustum/aabb test
+                Fvector mM[2];
+                mM[0].set(C.min[0][i], C.min[1][i], C.min[2][i]);
+                mM[1].set(C.max[0][i], C.max[1][i], C.max[2][i]);
+                masks[i] = E.mask;
+                if (fcvNone != F->testAABB(&mM[0].x, masks[i]))
+                    visible |= 1 << i;
+            }
+
+            // Pushed in reverse, so the children are visited in order
+            for (int i = 3; i >= 0; --i)
+            {
+                if (0 == (visible & (1 << i)) || CompactNode::is_leaf(N.child[i]))
+                    continue;
+                stack[count++] = { CompactNode::index(N.child[i]), masks[i], C.bounds(i) };
+            }
+            for (u32 i = 0; i < 4; ++i)
+            {
+                if (0 == (visible & (1 << i)) || !CompactNode::is_leaf(N.child[i]))
+                    continue;
+                _prim(CompactNode::index(N.child[i]));
+
+                // Early exit for "only first"
+                if (bFirst && dest->r_count())
+                    return;
+            }
+        }
+    }
 };
 
+template <bool bClass3, bool bFirst, typename Tree>
+void frustum_stab(COLLIDER* CL, Fvector* V, TRI* tris, const Tree& T, const CFrustum& F, u32 mask)
+{
+    frustum_collider<bClass3, bFirst> BC;
+    BC._init(CL, V, tris, &F);
+    BC._stab(T, mask);
+}
+
 void COLLIDER::frustum_query(const MODEL* m_def, const CFrustum& F)
 {
     m_def->syncronize();
 
-    // Get nodes
-    const AABBNoLeafTree* T = (const AABBNoLeafTree*)m_def->tree->GetTree();
-    const AABBNoLeafNode* N = T->GetNodes();
     const DWORD mask = F.getMask();
     r_clear();
 
     // Binary dispatcher
-    if (frustum_mode & OPT_FULL_TEST)
+    if (m_def->compact)
     {
-        if (frustum_mode & OPT_ONLYFIRST)
+        const CompactTree& T = *m_def->compact;
+        if (frustum_mode & OPT_FULL_TEST)
         {
-            frustum_collider<true, true> BC;
-            BC._init(this, m_def->verts, m_def->tris, &F);
-            BC._stab(N, mask);
+            if (frustum_mode & OPT_ONLYFIRST)
+                frustum_stab<true, true>(this, m_def->verts, m_def->tris, T, F, mask);
+            else
+                frustum_stab<true, false>(this, m_def->verts, m_def->tris, T, F, mask);
         }
         else
         {
-            frustum_collider<true, false> BC;
-            BC._init(this, m_def->verts, m_def->tris, &F);
-            BC._stab(N, mask);
+            if (frustum_mode & OPT_ONLYFIRST)
+                frustum_stab<false, true>(this, m_def->verts, m_def->tris, T, F, mask);
+            else
+                frustum_stab<false, false>(this, m_def->verts, m_def->tris, T, F, mask);
         }
+        return;
+    }
+
+    // Get nodes
+    const AABBNoLeafTree* T = (const AABBNoLeafTree*)m_def->tree->GetTree();
+    const AABBNoLeafNode* N = T->GetNodes();
+
+    if (frustum_mode & OPT_FULL_TEST)
+    {
+        if (frustum_mode & OPT_ONLYFIRST)
+            frustum_stab<true, true>(this, m_def->verts, m_def->tris, N, F, mask);
+        else
+            frustum_stab<true, false>(this, m_def->verts, m_def->tris, N, F, mask);
     }
     else
     {
         if (frustum_mode & OPT_ONLYFIRST)
-        {
-            frustum_collider<false, true> BC;
-            BC._init(this, m_def->verts, m_def->tris, &F);
-            BC._stab(N, mask);
-        }
+            frustum_stab<false, true>(this, m_def->verts, m_def->tris, N, F, mask);
         else
-        {
-            frustum_collider<false, false> BC;
-            BC._init(this, m_def->verts, m_def->tris, &F);
-            BC._stab(N, mask);
-        }
+            frustum_stab<false, false>(this, m_def->verts, m_def->tris, N, F, mask);
     }
 }
@@ -7,6 +7,7 @@
 #pragma warning(pop)
 
 #include "xrCDB.h"
+#include "xrCDB_compact.h"
 #include "SDL.h"
 
 using namespace CDB;
@@ -414,15 +415,115 @@ public:
         else
             _stab(node->GetNeg());
     }
+    void _stab(const CompactTree& T)
+    {
+        struct entry
+        {
+            u32 node;
+            float dist;
+            CompactBounds bounds;
+        };
+        entry stack[CompactTree::STACK_SIZE];
+        u32 count = 0;
+        stack[count++] = { 0, 0.f, T.root };
+
+        const __m128 plus_inf = loadps(ps_cst_plus_inf), minus_inf = loadps(ps_cst_minus_inf);
+        const __m128 pos[3] = { _mm_set1_ps(ray.pos.x), _mm_set1_ps(ray.pos.y), _mm_set1_ps(ray.pos.z) };
+        const __m128 inv_dir[3] = {
+            _mm_set1_ps(ray.inv_dir.x), _mm_set1_ps(ray.inv_dir.y), _mm_set1_ps(ray.inv_dir.z) };
+
+        CompactChildren C;
+        alignas(16) float dist[4];
+        while (count)
+        {
+            const entry E = stack[--count];
+
+            // The nearest hit may be found after the node was pushed
+            if (bNearest && E.dist > rRange)
+                continue;
+
+            const CompactNode& N = T.nodes[E.node];
+            C.decode(N, E.bounds);
+
+            // Actual ray/aabb tests, four at once, same as isect_sse()
+            __m128 lmin = minus_inf, lmax = plus_inf;
+            for (u32 k = 0; k < 3; ++k)
+            {
+                const __m128 l1 = mulps(subps(loadps(C.min[k]), pos[k]), inv_dir[k]);
+                const __m128 l2 = mulps(subps(loadps(C.max[k]), pos[k]), inv_dir[k]);
+                lmax = minps(lmax, maxps(minps(l1, plus_inf), minps(l2, plus_inf)));
+                lmin = maxps(lmin, minps(maxps(l1, minus_inf), maxps(l2, minus_inf)));
+            }
+            __m128 hit = _mm_cmpge_ps(lmax, _mm_setzero_ps());
+            hit = _mm_and_ps(hit, _mm_cmpge_ps(lmax, lmin));
+            hit = _mm_and_ps(hit, _mm_cmple_ps(lmin, _mm_set1_ps(rRange)));
+            const u32 mask = C.valid & u32(_mm_movemask_ps(hit));
+            if (0 == mask)
+                continue;
+            _mm_store_ps(dist, lmin);
+
+            u32 order[4];
+            u32 nodes = 0;
+            for (u32 i = 0; i < 4; ++i)
+            {
+                if (0 == (mask & (1 << i)))
+                    continue;
+                if (!CompactNode::is_leaf(N.child[i]))
+                {
+                    order[nodes++] = i;
+                    continue;
+                }
+                _prim(CompactNode::index(N.child[i]));
+
+                // Early exit for "only first"
+                if (bFirst && dest->r_count())
+                    return;
+            }
+
+            // The nearest child is pushed last to be visited first
+            if (bNearest)
+            {
+                for (u32 i = 1; i < nodes; ++i)
+                {
+                    for (u32 j = i; j > 0 && dist[order[j - 1]] < dist[order[j]]; --j)
+                        std::swap(order[j - 1], order[j]);
+                }
+            }
+            else
+            {
+                std::reverse(order, order + nodes);
+            }
+
+            for (u32 i = 0; i < nodes; ++i)
+            {
+                const u32 child = order[i];
+                if (dist[child] > rRange)
+                    continue;
+                stack[count++] = { CompactNode::index(N.child[child]), dist[child], C.bounds(child) };
+            }
+        }
+    }
 };
 
+template <bool bUseSSE, bool bCull, bool bFirst, bool bNearest>
+void ray_stab(COLLIDER* CL, Fvector* V, TRI* tris, const CompactTree* compact, const AABBNoLeafNode* N,
+    const Fvector& r_start, const Fvector& r_dir, float r_range)
+{
+    ray_collider<bUseSSE, bCull, bFirst, bNearest> RC;
+    RC._init(CL, V, tris, r_start, r_dir, r_range);
+    if (compact)
+        RC._stab(*compact);
+    else
+        RC._stab(N);
+}
+
 void COLLIDER::ray_query(const MODEL* m_def, const Fvector& r_start, const Fvector& r_dir, float r_range)
 {
     m_def->syncronize();
 
     // Get nodes
-    const AABBNoLeafTree* T = (const AABBNoLeafTree*)m_def->tree->GetTree();
-    const AABBNoLeafNode* N = T->GetNodes();
+    const CompactTree* compact = m_def->compact;
+    const AABBNoLeafNode* N = compact ? nullptr : ((const AABBNoLeafTree*)m_def->tree->GetTree())->GetNodes();
     r_clear();
 
     if (SDL_HasSSE())
@@ -435,30 +536,26 @@ void COLLIDER::ray_query(const MODEL* m_def, const Fvector& r_start, const Fvect
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<true, true, true, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, true, true, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<true, true, true, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, true, true, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
             else
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<true, true, false, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, true, false, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<true, true, false, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, true, false, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
         }
@@ -468,30 +565,26 @@ void COLLIDER::ray_query(const MODEL* m_def, const Fvector& r_start, const Fvect
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<true, false, true, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, false, true, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<true, false, true, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, false, true, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
             else
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<true, false, false, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, false, false, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<true, false, false, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<true, false, false, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
         }
@@ -506,30 +599,26 @@ void COLLIDER::ray_query(const MODEL* m_def, const Fvector& r_start, const Fvect
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<false, true, true, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, true, true, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<false, true, true, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, true, true, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
             else
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<false, true, false, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, true, false, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<false, true, false, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, true, false, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
         }
@@ -539,32 +628,320 @@ void COLLIDER::ray_query(const MODEL* m_def, const Fvector& r_start, const Fvect
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<false, false, true, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, false, true, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<false, false, true, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, false, true, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
             else
             {
                 if (ray_mode & OPT_ONLYNEAREST)
                 {
-                    ray_collider<false, false, false, true> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, false, false, true>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
                 else
                 {
-                    ray_collider<false, false, false, false> RC;
-                    RC._init(this, m_def->verts, m_def->tris, r_start, r_dir, r_range);
-                    RC._stab(N);
+                    ray_stab<false, false, false, false>(
+                        this, m_def->verts, m_def->tris, compact, N, r_start, r_dir, r_range);
                 }
             }
         }
     }
 }
+
+namespace
+{
+// Results of the packet rays, reused between queries
+thread_local COLLIDER packet_lanes[4];
+
+// Rays with different signs of direction go through the tree in different order,
+// tracing them together only adds box tests
+bool is_coherent(const RAY* rays, size_t count)
+{
+    const auto octant = [](const Fvector& dir)
+    {
+        return u32(dir.x < 0) | u32(dir.y < 0) << 1 | u32(dir.z < 0) << 2;
+    };
+    const u32 first = octant(rays[0].dir);
+    for (size_t i = 1; i < count; ++i)
+    {
+        if (octant(rays[i].dir) != first)
+            return false;
+    }
+    return true;
+}
+} // namespace
+
+// Four rays at once: node boxes are tested for all of them with one SSE slab test,
+// triangles - by the ray_collider of each ray
+template <bool bCull, bool bFirst, bool bNearest>
+class alignas(16) ray_packet
+{
+public:
+    using lane_collider = ray_collider<true, bCull, bFirst, bNearest>;
+
+    __m128 pos_x, pos_y, pos_z;
+    __m128 inv_x, inv_y, inv_z;
+    alignas(16) float range[4];
+    lane_collider lanes[4];
+    u32 active; // rays that still need the traversal
+
+    IC void _init(COLLIDER* results, Fvector* V, TRI* T, const RAY* rays, size_t count)
+    {
+        alignas(16) float px[4], py[4], pz[4], ix[4], iy[4], iz[4];
+        active = 0;
+        for (u32 i = 0; i < 4; i++)
+        {
+            // unused lanes repeat the first ray and stay inactive
+            const RAY& R = rays[i < count ? i : 0];
+            lanes[i]._init(results + i, V, T, R.start, R.dir, R.range);
+            px[i] = lanes[i].ray.pos.x;
+            py[i] = lanes[i].ray.pos.y;
+            pz[i] = lanes[i].ray.pos.z;
+            ix[i] = lanes[i].ray.inv_dir.x;
+            iy[i] = lanes[i].ray.inv_dir.y;
+            iz[i] = lanes[i].ray.inv_dir.z;
+            range[i] = R.range;
+            if (i < count)
+                active |= 1 << i;
+        }
+        pos_x = loadps(px);
+        pos_y = loadps(py);
+        pos_z = loadps(pz);
+        inv_x = loadps(ix);
+        inv_y = loadps(iy);
+        inv_z = loadps(iz);
+    }
+
+    // Mask of the rays hitting the box, same test as isect_sse()
+    ICF u32 _box(const Fvector& bCenter, const Fvector& bExtents)
+    {
+        Fvector bMin, bMax;
+        bMin.sub(bCenter, bExtents);
+        bMax.add(bCenter, bExtents);
+        return _box_bounds(bMin, bMax);
+    }
+    ICF u32 _box_bounds(const Fvector& bMin, const Fvector& bMax)
+    {
+        const __m128 plus_inf = loadps(ps_cst_plus_inf), minus_inf = loadps(ps_cst_minus_inf);
+
+        const auto slab = [&](float b_min, float b_max, __m128 pos, __m128 inv_dir, __m128& lmin, __m128& lmax)
+        {
+            const __m128 l1 = mulps(subps(_mm_set1_ps(b_min), pos), inv_dir);
+            const __m128 l2 = mulps(subps(_mm_set1_ps(b_max), pos), inv_dir);
+            lmax = maxps(minps(l1, plus_inf), minps(l2, plus_inf));
+            lmin = minps(maxps(l1, minus_inf), maxps(l2, minus_inf));
+        };
+
+        __m128 lmin_x, lmax_x, lmin_y, lmax_y, lmin_z, lmax_z;
+        slab(bMin.x, bMax.x, pos_x, inv_x, lmin_x, lmax_x);
+        slab(bMin.y, bMax.y, pos_y, inv_y, lmin_y, lmax_y);
+        slab(bMin.z, bMax.z, pos_z, inv_z, lmin_z, lmax_z);
+
+        const __m128 lmin = maxps(maxps(lmin_x, lmin_y), lmin_z);
+        const __m128 lmax = minps(minps(lmax_x, lmax_y), lmax_z);
+
+        __m128 hit = _mm_cmpge_ps(lmax, _mm_setzero_ps());
+        hit = _mm_and_ps(hit, _mm_cmpge_ps(lmax, lmin));
+        hit = _mm_and_ps(hit, _mm_cmple_ps(lmin, loadps(range)));
+        return u32(_mm_movemask_ps(hit));
+    }
+
+    void _prim(DWORD prim, u32 mask)
+    {
+        for (u32 i = 0; i < 4; i++)
+        {
+            if (0 == (mask & (1 << i)))
+                continue;
+            lanes[i]._prim(prim);
+            if (bNearest)
+                range[i] = lanes[i].rRange;
+            if (bFirst && lanes[i].dest->r_count())
+                active &= ~(1 << i);
+        }
+    }
+
+    void _stab(const AABBNoLeafNode* node, u32 mask)
+    {
+        // Should help
+        _mm_prefetch((char*)node->GetNeg(), _MM_HINT_NTA);
+
+        mask &= active & _box((Fvector&)node->mAABB.mCenter, (Fvector&)node->mAABB.mExtents);
+        if (0 == mask)
+            return;
+
+        // 1st chield
+        if (node->HasLeaf())
+            _prim(node->GetPrimitive(), mask);
+        else
+            _stab(node->GetPos(), mask);
+
+        // Early exit for "only first"
+        if (bFirst)
+        {
+            mask &= active;
+            if (0 == mask)
+                return;
+        }
+
+        // 2nd chield
+        if (node->HasLeaf2())
+            _prim(node->GetPrimitive2(), mask);
+        else
+            _stab(node->GetNeg(), mask);
+    }
+
+    void _stab(const CompactTree& T, u32 mask)
+    {
+        struct entry
+        {
+            u32 node;
+            u32 mask;
+            CompactBounds bounds;
+        };
+        entry stack[CompactTree::STACK_SIZE];
+        u32 count = 0;
+        stack[count++] = { 0, mask, T.root };
+
+        CompactChildren C;
+        while (count)
+        {
+            const entry E = stack[--count];
+            const CompactNode& N = T.nodes[E.node];
+            C.decode(N, E.bounds);
+
+            u32 masks[4];
+            for (u32 i = 0; i < 4; ++i)
+            {
+                masks[i] = 0;
+                if (0 == (C.valid & (1 << i)))
+                    continue;
+                Fvector bMin, bMax;
+                bMin.set(C.min[0][i], C.min[1][i], C.min[2][i]);
+                bMax.set(C.max[0][i], C.max[1][i], C.max[2][i]);
+                masks[i] = E.mask & active & _box_bounds(bMin, bMax);
+            }
+
+            // Pushed in reverse, so the children are visited in order
+            for (int i = 3; i >= 0; --i)
+            {
+                if (masks[i] && !CompactNode::is_leaf(N.child[i]))
+                    stack[count++] = { CompactNode::index(N.child[i]), masks[i], C.bounds(i) };
+            }
+            for (u32 i = 0; i < 4; ++i)
+            {
+                if (masks[i] && CompactNode::is_leaf(N.child[i]))
+                    _prim(CompactNode::index(N.child[i]), masks[i] & active);
+            }
+
+            // Early exit for "only first"
+            if (bFirst && 0 == active)
+                return;
+        }
+    }
+};
+
+template <bool bCull, bool bFirst, bool bNearest>
+void COLLIDER::ray_packets(const MODEL* m_def, const RAY* rays, size_t count)
+{
+    const CompactTree* compact = m_def->compact;
+    const AABBNoLeafNode* N = compact ? nullptr : ((const AABBNoLeafTree*)m_def->tree->GetTree())->GetNodes();
+
+    for (size_t first = 0; first < count; first += 4)
+    {
+        const size_t size = std::min<size_t>(4, count - first);
+        for (size_t i = 0; i < size; ++i)
+            packet_lanes[i].r_clear();
+
+        if (is_coherent(rays + first, size))
+        {
+            ray_packet<bCull, bFirst, bNearest> RP;
+            RP._init(packet_lanes, m_def->verts, m_def->tris, rays + first, size);
+            if (compact)
+                RP._stab(*compact, RP.active);
+            else
+                RP._stab(N, RP.active);
+        }
+        else
+        {
+            // Fall back to one by one
+            for (size_t i = 0; i < size; ++i)
+            {
+                const RAY& R = rays[first + i];
+                ray_stab<true, bCull, bFirst, bNearest>(
+                    packet_lanes + i, m_def->verts, m_def->tris, compact, N, R.start, R.dir, R.range);
+            }
+        }
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            rd_rays.push_back(u32(rd.size()));
+            rd.insert(rd.end(), packet_lanes[i].rd.begin(), packet_lanes[i].rd.end());
+        }
+    }
+}
+
+void COLLIDER::ray_query(const MODEL* m_def, const RAY* rays, size_t count)
+{
+    m_def->syncronize();
+    r_clear();
+    rd_rays.clear();
+    rd_rays.reserve(count + 1);
+
+    if (!SDL_HasSSE())
+    {
+        // FPU
+        COLLIDER& single = packet_lanes[0];
+        single.ray_options(ray_mode);
+        for (size_t i = 0; i < count; ++i)
+        {
+            single.ray_query(m_def, rays[i].start, rays[i].dir, rays[i].range);
+            rd_rays.push_back(u32(rd.size()));
+            rd.insert(rd.end(), single.rd.begin(), single.rd.end());
+        }
+        rd_rays.push_back(u32(rd.size()));
+        return;
+    }
+
+    // Binary dispatcher
+    if (ray_mode & OPT_CULL)
+    {
+        if (ray_mode & OPT_ONLYFIRST)
+        {
+            if (ray_mode & OPT_ONLYNEAREST)
+                ray_packets<true, true, true>(m_def, rays, count);
+            else
+                ray_packets<true, true, false>(m_def, rays, count);
+        }
+        else
+        {
+            if (ray_mode & OPT_ONLYNEAREST)
+                ray_packets<true, false, true>(m_def, rays, count);
+            else
+                ray_packets<true, false, false>(m_def, rays, count);
+        }
+    }
+    else
+    {
+        if (ray_mode & OPT_ONLYFIRST)
+        {
+            if (ray_mode & OPT_ONLYNEAREST)
+                ray_packets<false, true, true>(m_def, rays, count);
+            else
+                ray_packets<false, true, false>(m_def, rays, count);
+        }
+        else
+        {
+            if (ray_mode & OPT_ONLYNEAREST)
+                ray_packets<false, false, true>(m_def, rays, count);
+            else
+                ray_packets<false, false, false>(m_def, rays, count);
+        }
+    }
+    rd_rays.push_back(u32(rd.size()));
+}
@@ -9,12 +9,14 @@
 
 XRCDB_API xrXRC XRC("global");
 
-void xrXRC::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
+void xrXRC::ColliderStatistics::Dump(IGameFont& font, IPerformanceAlert* alert, const char* name)
 {
-    Stats.FrameEnd();
+    FrameEnd();
     font.OutNext("XRC (%s):", name);
-    font.OutNext("- ray:        %2.2fms, %d, %2.0fK", Stats.RayQuery.result, Stats.RayQuery.count, Stats.RayPs);
-    font.OutNext("- box:        %2.2fms, %d, %2.0fK", Stats.BoxQuery.result, Stats.BoxQuery.count, Stats.BoxPs);
-    font.OutNext("- frustum:    %2.2fms, %d", Stats.FrustumQuery.result, Stats.FrustumQuery.count);
-    Stats.FrameStart();
+    font.OutNext("- ray:        %2.2fms, %d, %2.0fK", RayQuery.result, RayQuery.count, RayPs);
+    font.OutNext("- box:        %2.2fms, %d, %2.0fK", BoxQuery.result, BoxQuery.count, BoxPs);
+    font.OutNext("- frustum:    %2.2fms, %d", FrustumQuery.result, FrustumQuery.count);
+    FrameStart();
 }
+
+void xrXRC::DumpStatistics(IGameFont& font, IPerformanceAlert* alert) { Stats.Dump(font, alert, name); }
@@ -44,6 +44,20 @@ public:
                 newBoxPs = 0;
             BoxPs = 0.99f * BoxPs + 0.01f * newBoxPs;
         }
+
+        // Moves the counters of the other statistics into these
+        void Merge(ColliderStatistics& from)
+        {
+            RayQuery.accum += from.RayQuery.accum;
+            RayQuery.count += from.RayQuery.count;
+            BoxQuery.accum += from.BoxQuery.accum;
+            BoxQuery.count += from.BoxQuery.count;
+            FrustumQuery.accum += from.FrustumQuery.accum;
+            FrustumQuery.count += from.FrustumQuery.count;
+            from.FrameStart();
+        }
+
+        void Dump(IGameFont& font, IPerformanceAlert* alert, const char* name);
     };
     ColliderStatistics Stats;
 
@@ -54,6 +68,14 @@ public:
         CL.ray_query(m_def, r_start, r_dir, r_range);
         Stats.RayQuery.End();
     }
+    IC void ray_query(const CDB::MODEL* m_def, const CDB::RAY* rays, size_t count)
+    {
+        Stats.RayQuery.Begin();
+        CL.ray_query(m_def, rays, count);
+        Stats.RayQuery.End();
+        if (g_bEnableStatGather && count)
+            Stats.RayQuery.count += u32(count) - 1; // count rays, not calls
+    }
 
     IC void box_options(u32 f) { CL.box_options(f); }
     IC void box_query(const CDB::MODEL* m_def, const Fvector& b_center, const Fvector& b_dim)
@@ -74,6 +96,8 @@ public:
     IC CDB::RESULT* r_begin() { return CL.r_begin(); };
     //IC CDB::RESULT* r_end() { return CL.r_end(); };
     IC xr_vector<CDB::RESULT>* r_get() { return CL.r_get(); };
+    IC CDB::RESULT* r_ray_begin(size_t ray) { return CL.r_ray_begin(ray); }
+    IC size_t r_ray_count(size_t ray) const { return CL.r_ray_count(ray); }
     IC void r_free() { CL.r_free(); }
     IC int r_count() { return CL.r_count(); };
     IC void r_clear() { CL.r_clear(); };
@@ -12,11 +12,10 @@ using namespace collide;
 // Purpose	: stores space slots
 //----------------------------------------------------------------------
 CObjectSpace::CObjectSpace()
-    : xrc("object space")
 #ifdef CONFIG_PROFILE_LOCKS
-      , lock(new Lock(MUTEX_PROFILE_ID(CObjectSpace::Lock)))
+    : lock(new Lock(MUTEX_PROFILE_ID(CObjectSpace::Lock)))
 #else
-      , lock(new Lock)
+    : lock(new Lock)
 #endif // CONFIG_PROFILE_LOCKS
 #ifdef DEBUG
       , m_pRender(0)
@@ -41,9 +40,39 @@ CObjectSpace::~CObjectSpace()
     // sh_debug.destroy			();
     xr_delete(m_pRender);
 #endif
+    VERIFY2(m_free_contexts.size() == m_contexts.size(), "Object space is destroyed during a query");
+    for (QueryContext*& ctx : m_contexts)
+        xr_delete(ctx);
     delete lock;
 }
 //----------------------------------------------------------------------
+CObjectSpace::QueryContext* CObjectSpace::AcquireContext()
+{
+    lock->Enter();
+    QueryContext* ctx;
+    if (m_free_contexts.empty())
+    {
+        ctx = new QueryContext();
+        m_contexts.push_back(ctx);
+    }
+    else
+    {
+        ctx = m_free_contexts.back();
+        m_free_contexts.pop_back();
+    }
+    lock->Leave();
+    return ctx;
+}
+
+void CObjectSpace::ReleaseContext(QueryContext* ctx)
+{
+    VERIFY(ctx);
+    ctx->r_spatial.clear();
+    lock->Enter();
+    m_free_contexts.push_back(ctx);
+    lock->Leave();
+}
+//----------------------------------------------------------------------
 
 //----------------------------------------------------------------------
 int CObjectSpace::GetNearest(xr_vector<ISpatial*>& q_spatial, xr_vector<IGameObject*>& q_nearest, const Fvector& point,
@@ -78,7 +107,14 @@ int CObjectSpace::GetNearest(xr_vector<ISpatial*>& q_spatial, xr_vector<IGameObj
 int CObjectSpace::GetNearest(
     xr_vector<IGameObject*>& q_nearest, const Fvector& point, float range, IGameObject* ignore_object)
 {
-    return (GetNearest(r_spatial, q_nearest, point, range, ignore_object));
+    ContextScope scope(*this);
+    return GetNearest(scope.ctx, q_nearest, point, range, ignore_object);
+}
+
+int CObjectSpace::GetNearest(QueryContext& ctx, xr_vector<IGameObject*>& q_nearest, const Fvector& point, float range,
+    IGameObject* ignore_object)
+{
+    return GetNearest(ctx.r_spatial, q_nearest, point, range, ignore_object);
 }
 
 //----------------------------------------------------------------------
@@ -111,7 +147,7 @@ void CObjectSpace::Load(IReader* F, CDB::build_callback build_callback)
 void CObjectSpace::Create(Fvector* verts, CDB::TRI* tris, const hdrCFORM& H, CDB::build_callback build_callback)
 {
     R_ASSERT(CFORM_CURRENT_VERSION == H.version);
-    Static.build(verts, H.vertcount, tris, H.facecount, build_callback);
+    Static.build_cached(verts, H.vertcount, tris, H.facecount, build_callback);
     m_BoundingVolume.set(H.aabb);
     g_SpatialSpace->initialize(m_BoundingVolume);
     g_SpatialSpacePhysic->initialize(m_BoundingVolume);
@@ -154,4 +190,12 @@ void CObjectSpace::dbgRender()
 */
 #endif
 // XXX stats: add to statistics
-void CObjectSpace::DumpStatistics(IGameFont& font, IPerformanceAlert* alert) { xrc.DumpStatistics(font, alert); }
+void CObjectSpace::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
+{
+    // Contexts that are busy now will be counted next frame
+    lock->Enter();
+    for (QueryContext* ctx : m_free_contexts)
+        m_stats.Merge(ctx->xrc.Stats);
+    lock->Leave();
+    m_stats.Dump(font, alert, "object space");
+}
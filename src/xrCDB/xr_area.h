@@ -19,14 +19,38 @@ class Lock;
 struct hdrCFORM;
 class XRCDB_API CObjectSpace : Noncopyable
 {
+public:
+    // Scratch state of a query. Every running query owns its context,
+    // so queries from different threads don't wait for each other.
+    struct QueryContext
+    {
+        xrXRC xrc;
+        collide::rq_results r_temp;
+        xr_vector<ISpatial*> r_spatial;
+
+        QueryContext() : xrc("object space") {}
+    };
+
+    // Holds a context from the pool while in scope
+    class ContextScope : Noncopyable
+    {
+        CObjectSpace& space;
+
+    public:
+        QueryContext& ctx;
+
+        ContextScope(CObjectSpace& _space) : space(_space), ctx(*_space.AcquireContext()) {}
+        ~ContextScope() { space.ReleaseContext(&ctx); }
+    };
+
 private:
-    // Debug
-    Lock* lock;
+    Lock* lock; // contexts pool
+    xr_vector<QueryContext*> m_contexts;
+    xr_vector<QueryContext*> m_free_contexts;
+    xrXRC::ColliderStatistics m_stats; // merged from the contexts
     CDB::MODEL Static;
     Fbox m_BoundingVolume;
-    xrXRC xrc; // MT: dangerous
-    collide::rq_results r_temp; // MT: dangerous
-    xr_vector<ISpatial*> r_spatial; // MT: dangerous
+
 public:
 #ifdef DEBUG
     FactoryPtr<IObjectSpaceRender>* m_pRender;
@@ -36,16 +60,16 @@ public:
 #endif
 
 private:
-    BOOL _RayTest(const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
+    BOOL _RayTest(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
         collide::ray_cache* cache, IGameObject* ignore_object);
-    BOOL _RayPick(const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt, collide::rq_result& R,
-        IGameObject* ignore_object);
-    BOOL _RayQuery(collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb, LPVOID user_data,
-        collide::test_callback* tb, IGameObject* ignore_object);
-    BOOL _RayQuery2(collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb, LPVOID user_data,
-        collide::test_callback* tb, IGameObject* ignore_object);
-    BOOL _RayQuery3(collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb, LPVOID user_data,
-        collide::test_callback* tb, IGameObject* ignore_object);
+    BOOL _RayPick(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
+        collide::rq_result& R, IGameObject* ignore_object);
+    BOOL _RayQuery(QueryContext& ctx, collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb,
+        LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object);
+    BOOL _RayQuery2(QueryContext& ctx, collide::rq_results& dest, const collide::ray_defs& rq,
+        collide::rq_callback* cb, LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object);
+    BOOL _RayQuery3(QueryContext& ctx, collide::rq_results& dest, const collide::ray_defs& rq,
+        collide::rq_callback* cb, LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object);
 
 public:
     CObjectSpace();
@@ -55,26 +79,42 @@ public:
     void Load(LPCSTR path, LPCSTR fname, CDB::build_callback build_callback);
     void Load(IReader* R, CDB::build_callback build_callback);
     void Create(Fvector* verts, CDB::TRI* tris, const hdrCFORM& H, CDB::build_callback build_callback);
+
+    // Queries below take a context from the pool for their duration.
+    // Code doing many queries in a row can hold its own one.
+    QueryContext* AcquireContext();
+    void ReleaseContext(QueryContext* ctx);
+
     // Occluded/No
     BOOL RayTest(const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
         collide::ray_cache* cache, IGameObject* ignore_object);
+    BOOL RayTest(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
+        collide::ray_cache* cache, IGameObject* ignore_object);
 
     // Game raypick (nearest) - returns object and addititional params
     BOOL RayPick(const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt, collide::rq_result& R,
         IGameObject* ignore_object);
+    BOOL RayPick(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
+        collide::rq_result& R, IGameObject* ignore_object);
 
     // General collision query
     BOOL RayQuery(collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb, LPVOID user_data,
         collide::test_callback* tb, IGameObject* ignore_object);
+    BOOL RayQuery(QueryContext& ctx, collide::rq_results& dest, const collide::ray_defs& rq, collide::rq_callback* cb,
+        LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object);
     BOOL RayQuery(collide::rq_results& dest, ICollisionForm* target, const collide::ray_defs& rq);
 
     bool BoxQuery(Fvector const& box_center, Fvector const& box_z_axis, Fvector const& box_y_axis,
         Fvector const& box_sizes, xr_vector<Fvector>* out_tris);
+    bool BoxQuery(QueryContext& ctx, Fvector const& box_center, Fvector const& box_z_axis, Fvector const& box_y_axis,
+        Fvector const& box_sizes, xr_vector<Fvector>* out_tris);
 
     int GetNearest(xr_vector<IGameObject*>& q_nearest, ICollisionForm* obj, float range);
     int GetNearest(xr_vector<IGameObject*>& q_nearest, const Fvector& point, float range, IGameObject* ignore_object);
     int GetNearest(xr_vector<ISpatial*>& q_spatial, xr_vector<IGameObject*>& q_nearest, const Fvector& point,
         float range, IGameObject* ignore_object);
+    int GetNearest(QueryContext& ctx, xr_vector<IGameObject*>& q_nearest, const Fvector& point, float range,
+        IGameObject* ignore_object);
 
     CDB::TRI* GetStaticTris() { return Static.get_tris(); }
     Fvector* GetStaticVerts() { return Static.get_verts(); }
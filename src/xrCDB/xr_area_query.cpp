@@ -8,6 +8,13 @@ using namespace collide;
 
 bool CObjectSpace::BoxQuery(Fvector const& box_center, Fvector const& box_z_axis, Fvector const& box_y_axis,
     Fvector const& box_sizes, xr_vector<Fvector>* out_tris)
+{
+    ContextScope scope(*this);
+    return BoxQuery(scope.ctx, box_center, box_z_axis, box_y_axis, box_sizes, out_tris);
+}
+
+bool CObjectSpace::BoxQuery(QueryContext& ctx, Fvector const& box_center, Fvector const& box_z_axis,
+    Fvector const& box_y_axis, Fvector const& box_sizes, xr_vector<Fvector>* out_tris)
 {
     Fvector z_axis = box_z_axis;
     z_axis.normalize();
@@ -37,12 +44,12 @@ bool CObjectSpace::BoxQuery(Fvector const& box_center, Fvector const& box_z_axis
     CFrustum frustum;
     frustum.CreateFromPlanes(planes, sizeof(planes) / sizeof(planes[0]));
 
-    xrc.frustum_options(CDB::OPT_FULL_TEST);
-    xrc.frustum_query(&Static, frustum);
+    ctx.xrc.frustum_options(CDB::OPT_FULL_TEST);
+    ctx.xrc.frustum_query(&Static, frustum);
 
     if (out_tris)
     {
-        for (auto &result : *xrc.r_get())
+        for (auto &result : *ctx.xrc.r_get())
         {
             out_tris->push_back(result.verts[0]);
             out_tris->push_back(result.verts[1]);
@@ -50,7 +57,7 @@ bool CObjectSpace::BoxQuery(Fvector const& box_center, Fvector const& box_z_axis
         }
     }
 
-    return !!xrc.r_count();
+    return !!ctx.xrc.r_count();
 }
 
 /*
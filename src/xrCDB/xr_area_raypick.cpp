@@ -21,19 +21,23 @@ using namespace collide;
 BOOL CObjectSpace::RayTest(const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
     collide::ray_cache* cache, IGameObject* ignore_object)
 {
-    lock->Enter();
-    BOOL _ret = _RayTest(start, dir, range, tgt, cache, ignore_object);
-    r_spatial.clear();
-    lock->Leave();
+    ContextScope scope(*this);
+    return _RayTest(scope.ctx, start, dir, range, tgt, cache, ignore_object);
+}
+BOOL CObjectSpace::RayTest(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range,
+    collide::rq_target tgt, collide::ray_cache* cache, IGameObject* ignore_object)
+{
+    BOOL _ret = _RayTest(ctx, start, dir, range, tgt, cache, ignore_object);
+    ctx.r_spatial.clear();
     return _ret;
 }
-BOOL CObjectSpace::_RayTest(const Fvector& start, const Fvector& dir, float range, collide::rq_target tgt,
-    collide::ray_cache* cache, IGameObject* ignore_object)
+BOOL CObjectSpace::_RayTest(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range,
+    collide::rq_target tgt, collide::ray_cache* cache, IGameObject* ignore_object)
 {
     VERIFY(_abs(dir.magnitude() - 1) < EPS);
-    r_temp.r_clear();
+    ctx.r_temp.r_clear();
 
-    xrc.ray_options(CDB::OPT_ONLYFIRST);
+    ctx.xrc.ray_options(CDB::OPT_ONLYFIRST);
     collide::ray_defs Q(start, dir, range, CDB::OPT_ONLYFIRST, tgt);
 
     // dynamic test
@@ -42,19 +46,19 @@ BOOL CObjectSpace::_RayTest(const Fvector& start, const Fvector& dir, float rang
         u32 d_flags =
             STYPE_COLLIDEABLE | ((tgt & rqtObstacle) ? STYPE_OBSTACLE : 0) | ((tgt & rqtShape) ? STYPE_SHAPE : 0);
         // traverse object database
-        g_SpatialSpace->q_ray(r_spatial, 0, d_flags, start, dir, range);
+        g_SpatialSpace->q_ray(ctx.r_spatial, 0, d_flags, start, dir, range);
         // Determine visibility for dynamic part of scene
-        for (u32 o_it = 0; o_it < r_spatial.size(); o_it++)
+        for (u32 o_it = 0; o_it < ctx.r_spatial.size(); o_it++)
         {
-            ISpatial* spatial = r_spatial[o_it];
+            ISpatial* spatial = ctx.r_spatial[o_it];
             IGameObject* collidable = spatial->dcast_GameObject();
             if (collidable && (collidable != ignore_object))
             {
                 ECollisionFormType tp = collidable->GetCForm()->Type();
                 if ((tgt & (rqtObject | rqtObstacle)) && (tp == cftObject) &&
-                    collidable->GetCForm()->_RayQuery(Q, r_temp))
+                    collidable->GetCForm()->_RayQuery(Q, ctx.r_temp))
                     return TRUE;
-                if ((tgt & rqtShape) && (tp == cftShape) && collidable->GetCForm()->_RayQuery(Q, r_temp))
+                if ((tgt & rqtShape) && (tp == cftShape) && collidable->GetCForm()->_RayQuery(Q, ctx.r_temp))
                     return TRUE;
             }
         }
@@ -80,8 +84,8 @@ BOOL CObjectSpace::_RayTest(const Fvector& start, const Fvector& dir, float rang
             }
 
             // 2. Polygon doesn't pick - real database query
-            xrc.ray_query(&Static, start, dir, range);
-            if (0 == xrc.r_count())
+            ctx.xrc.ray_query(&Static, start, dir, range);
+            if (0 == ctx.xrc.r_count())
             {
                 cache->set(start, dir, range, FALSE);
                 return FALSE;
@@ -90,7 +94,7 @@ BOOL CObjectSpace::_RayTest(const Fvector& start, const Fvector& dir, float rang
             {
                 // cache polygon
                 cache->set(start, dir, range, TRUE);
-                CDB::RESULT* R = xrc.r_begin();
+                CDB::RESULT* R = ctx.xrc.r_begin();
                 CDB::TRI& T = Static.get_tris()[R->id];
                 Fvector* V = Static.get_verts();
                 cache->verts[0].set(V[T.verts[0]]);
@@ -101,8 +105,8 @@ BOOL CObjectSpace::_RayTest(const Fvector& start, const Fvector& dir, float rang
         }
         else
         {
-            xrc.ray_query(&Static, start, dir, range);
-            return xrc.r_count();
+            ctx.xrc.ray_query(&Static, start, dir, range);
+            return ctx.xrc.r_count();
         }
     }
     return FALSE;
@@ -114,26 +118,30 @@ BOOL CObjectSpace::_RayTest(const Fvector& start, const Fvector& dir, float rang
 BOOL CObjectSpace::RayPick(
     const Fvector& start, const Fvector& dir, float range, rq_target tgt, rq_result& R, IGameObject* ignore_object)
 {
-    lock->Enter();
-    BOOL _res = _RayPick(start, dir, range, tgt, R, ignore_object);
-    r_spatial.clear();
-    lock->Leave();
+    ContextScope scope(*this);
+    return _RayPick(scope.ctx, start, dir, range, tgt, R, ignore_object);
+}
+BOOL CObjectSpace::RayPick(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range, rq_target tgt,
+    rq_result& R, IGameObject* ignore_object)
+{
+    BOOL _res = _RayPick(ctx, start, dir, range, tgt, R, ignore_object);
+    ctx.r_spatial.clear();
     return _res;
 }
-BOOL CObjectSpace::_RayPick(
-    const Fvector& start, const Fvector& dir, float range, rq_target tgt, rq_result& R, IGameObject* ignore_object)
+BOOL CObjectSpace::_RayPick(QueryContext& ctx, const Fvector& start, const Fvector& dir, float range, rq_target tgt,
+    rq_result& R, IGameObject* ignore_object)
 {
-    r_temp.r_clear();
+    ctx.r_temp.r_clear();
     R.O = 0;
     R.range = range;
     R.element = -1;
     // static test
     if (tgt & rqtStatic)
     {
-        xrc.ray_options(CDB::OPT_ONLYNEAREST | CDB::OPT_CULL);
-        xrc.ray_query(&Static, start, dir, range);
-        if (xrc.r_count())
-            R.set_if_less(xrc.r_begin());
+        ctx.xrc.ray_options(CDB::OPT_ONLYNEAREST | CDB::OPT_CULL);
+        ctx.xrc.ray_query(&Static, start, dir, range);
+        if (ctx.xrc.r_count())
+            R.set_if_less(ctx.xrc.r_begin());
     }
     // dynamic test
     if (tgt & rqtDyn)
@@ -142,11 +150,11 @@ BOOL CObjectSpace::_RayPick(
         // traverse object database
         u32 d_flags =
             STYPE_COLLIDEABLE | ((tgt & rqtObstacle) ? STYPE_OBSTACLE : 0) | ((tgt & rqtShape) ? STYPE_SHAPE : 0);
-        g_SpatialSpace->q_ray(r_spatial, 0, d_flags, start, dir, range);
+        g_SpatialSpace->q_ray(ctx.r_spatial, 0, d_flags, start, dir, range);
         // Determine visibility for dynamic part of scene
-        for (u32 o_it = 0; o_it < r_spatial.size(); o_it++)
+        for (u32 o_it = 0; o_it < ctx.r_spatial.size(); o_it++)
         {
-            ISpatial* spatial = r_spatial[o_it];
+            ISpatial* spatial = ctx.r_spatial[o_it];
             IGameObject* collidable = spatial->dcast_GameObject();
             if (0 == collidable)
                 continue;
@@ -157,10 +165,10 @@ BOOL CObjectSpace::_RayPick(
             {
                 u32 C = color_xrgb(64, 64, 64);
                 Q.range = R.range;
-                if (collidable->GetCForm()->_RayQuery(Q, r_temp))
+                if (collidable->GetCForm()->_RayQuery(Q, ctx.r_temp))
                 {
                     C = color_xrgb(128, 128, 196);
-                    R.set_if_less(r_temp.r_begin());
+                    R.set_if_less(ctx.r_temp.r_begin());
                 }
 #ifdef DEBUG
                 if (bDebug())
@@ -184,18 +192,22 @@ BOOL CObjectSpace::_RayPick(
 BOOL CObjectSpace::RayQuery(collide::rq_results& dest, const collide::ray_defs& R, collide::rq_callback* CB,
     LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
 {
-    lock->Enter();
-    BOOL _res = _RayQuery2(dest, R, CB, user_data, tb, ignore_object);
-    r_spatial.clear();
-    lock->Leave();
+    ContextScope scope(*this);
+    return _RayQuery2(scope.ctx, dest, R, CB, user_data, tb, ignore_object);
+}
+BOOL CObjectSpace::RayQuery(QueryContext& ctx, collide::rq_results& dest, const collide::ray_defs& R,
+    collide::rq_callback* CB, LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
+{
+    BOOL _res = _RayQuery2(ctx, dest, R, CB, user_data, tb, ignore_object);
+    ctx.r_spatial.clear();
     return (_res);
 }
-BOOL CObjectSpace::_RayQuery2(collide::rq_results& r_dest, const collide::ray_defs& R, collide::rq_callback* CB,
-    LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
+BOOL CObjectSpace::_RayQuery2(QueryContext& ctx, collide::rq_results& r_dest, const collide::ray_defs& R,
+    collide::rq_callback* CB, LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
 {
     // initialize query
     r_dest.r_clear();
-    r_temp.r_clear();
+    ctx.r_temp.r_clear();
 
     rq_target s_mask = rqtStatic;
     rq_target d_mask = rq_target(((R.tgt & rqtObject) ? rqtObject : rqtNone) |
@@ -206,20 +218,20 @@ BOOL CObjectSpace::_RayQuery2(collide::rq_results& r_dest, const collide::ray_de
     // Test static
     if (R.tgt & s_mask)
     {
-        xrc.ray_options(R.flags);
-        xrc.ray_query(&Static, R.start, R.dir, R.range);
+        ctx.xrc.ray_options(R.flags);
+        ctx.xrc.ray_query(&Static, R.start, R.dir, R.range);
 
-        for(auto &i : *xrc.r_get())
-            r_temp.append_result(rq_result().set(0, i.range, i.id));
+        for(auto &i : *ctx.xrc.r_get())
+            ctx.r_temp.append_result(rq_result().set(0, i.range, i.id));
     }
     // Test dynamic
     if (R.tgt & d_mask)
     {
         // Traverse object database
-        g_SpatialSpace->q_ray(r_spatial, 0, d_flags, R.start, R.dir, R.range);
-        for (u32 o_it = 0; o_it < r_spatial.size(); o_it++)
+        g_SpatialSpace->q_ray(ctx.r_spatial, 0, d_flags, R.start, R.dir, R.range);
+        for (u32 o_it = 0; o_it < ctx.r_spatial.size(); o_it++)
         {
-            IGameObject* collidable = r_spatial[o_it]->dcast_GameObject();
+            IGameObject* collidable = ctx.r_spatial[o_it]->dcast_GameObject();
             if (0 == collidable)
                 continue;
             if (collidable == ignore_object)
@@ -230,14 +242,14 @@ BOOL CObjectSpace::_RayQuery2(collide::rq_results& r_dest, const collide::ray_de
             {
                 if (tb && !tb(R, collidable, user_data))
                     continue;
-                cform->_RayQuery(R, r_temp);
+                cform->_RayQuery(R, ctx.r_temp);
             }
         }
     }
-    if (r_temp.r_count())
+    if (ctx.r_temp.r_count())
     {
-        r_temp.r_sort();
-        for(auto &i : *r_temp.r_get())
+        ctx.r_temp.r_sort();
+        for(auto &i : *ctx.r_temp.r_get())
         {
             r_dest.append_result(i);
             if (!(CB ? CB(i, user_data) : TRUE))
@@ -249,8 +261,8 @@ BOOL CObjectSpace::_RayQuery2(collide::rq_results& r_dest, const collide::ray_de
     return r_dest.r_count();
 }
 
-BOOL CObjectSpace::_RayQuery3(collide::rq_results& r_dest, const collide::ray_defs& R, collide::rq_callback* CB,
-    LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
+BOOL CObjectSpace::_RayQuery3(QueryContext& ctx, collide::rq_results& r_dest, const collide::ray_defs& R,
+    collide::rq_callback* CB, LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
 {
     // initialize query
     r_dest.r_clear();
@@ -266,27 +278,27 @@ BOOL CObjectSpace::_RayQuery3(collide::rq_results& r_dest, const collide::ray_de
 
     do
     {
-        r_temp.r_clear();
+        ctx.r_temp.r_clear();
         if (R.tgt & s_mask)
         {
             // static test allowed
 
             // test static
-            xrc.ray_options(s_rd.flags);
-            xrc.ray_query(&Static, s_rd.start, s_rd.dir, s_rd.range);
+            ctx.xrc.ray_options(s_rd.flags);
+            ctx.xrc.ray_query(&Static, s_rd.start, s_rd.dir, s_rd.range);
 
-            if (xrc.r_count())
+            if (ctx.xrc.r_count())
             {
-                VERIFY(xrc.r_count() == 1);
+                VERIFY(ctx.xrc.r_count() == 1);
                 rq_result s_res;
-                s_res.set(0, xrc.r_begin()->range, xrc.r_begin()->id);
+                s_res.set(0, ctx.xrc.r_begin()->range, ctx.xrc.r_begin()->id);
                 // update dynamic test range
                 d_rd.range = s_res.range;
                 // set next static start & range
                 s_rd.range -= (s_res.range + EPS_L);
                 s_rd.start.mad(s_rd.dir, s_res.range + EPS_L);
                 s_res.range = R.range - s_rd.range - EPS_L;
-                r_temp.append_result(s_res);
+                ctx.r_temp.append_result(s_res);
             }
             else
             {
@@ -297,10 +309,10 @@ BOOL CObjectSpace::_RayQuery3(collide::rq_results& r_dest, const collide::ray_de
         if (R.tgt & d_mask)
         {
             // Traverse object database
-            g_SpatialSpace->q_ray(r_spatial, 0, d_flags, d_rd.start, d_rd.dir, d_rd.range);
-            for (u32 o_it = 0; o_it < r_spatial.size(); o_it++)
+            g_SpatialSpace->q_ray(ctx.r_spatial, 0, d_flags, d_rd.start, d_rd.dir, d_rd.range);
+            for (u32 o_it = 0; o_it < ctx.r_spatial.size(); o_it++)
             {
-                IGameObject* collidable = r_spatial[o_it]->dcast_GameObject();
+                IGameObject* collidable = ctx.r_spatial[o_it]->dcast_GameObject();
                 if (0 == collidable)
                     continue;
                 if (collidable == ignore_object)
@@ -312,11 +324,11 @@ BOOL CObjectSpace::_RayQuery3(collide::rq_results& r_dest, const collide::ray_de
                 {
                     if (tb && !tb(d_rd, collidable, user_data))
                         continue;
-                    u32 r_cnt = r_temp.r_count();
-                    cform->_RayQuery(d_rd, r_temp);
-                    for (int k = r_cnt; k < r_temp.r_count(); k++)
+                    u32 r_cnt = ctx.r_temp.r_count();
+                    cform->_RayQuery(d_rd, ctx.r_temp);
+                    for (int k = r_cnt; k < ctx.r_temp.r_count(); k++)
                     {
-                        rq_result& d_res = *(r_temp.r_begin() + k);
+                        rq_result& d_res = *(ctx.r_temp.r_begin() + k);
                         d_res.range += d_range;
                     }
                 }
@@ -325,10 +337,10 @@ BOOL CObjectSpace::_RayQuery3(collide::rq_results& r_dest, const collide::ray_de
         // set dynamic ray def
         d_rd.start = s_rd.start;
         d_range = R.range - s_rd.range;
-        if (r_temp.r_count())
+        if (ctx.r_temp.r_count())
         {
-            r_temp.r_sort();
-            for (auto &i : *r_temp.r_get())
+            ctx.r_temp.r_sort();
+            for (auto &i : *ctx.r_temp.r_get())
             {
                 r_dest.append_result(i);
                 if (!(CB ? CB(i, user_data) : TRUE))
@@ -339,12 +351,12 @@ BOOL CObjectSpace::_RayQuery3(collide::rq_results& r_dest, const collide::ray_de
         }
         if ((R.flags & (CDB::OPT_ONLYNEAREST | CDB::OPT_ONLYFIRST)) && r_dest.r_count())
             return r_dest.r_count();
-    } while (r_temp.r_count());
+    } while (ctx.r_temp.r_count());
     return r_dest.r_count();
 }
 
-BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_defs& R, collide::rq_callback* CB,
-    LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
+BOOL CObjectSpace::_RayQuery(QueryContext& ctx, collide::rq_results& r_dest, const collide::ray_defs& R,
+    collide::rq_callback* CB, LPVOID user_data, collide::test_callback* tb, IGameObject* ignore_object)
 {
 #ifdef DEBUG
     if (R.range < EPS || !_valid(R.range))
@@ -352,7 +364,7 @@ BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_def
 #endif
     // initialize query
     r_dest.r_clear();
-    r_temp.r_clear();
+    ctx.r_temp.r_clear();
 
     Flags32 sd_test;
     sd_test.assign(R.tgt);
@@ -376,11 +388,11 @@ BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_def
             // Test static model
             if (s_rd.range > EPS)
             {
-                xrc.ray_options(s_rd.flags);
-                xrc.ray_query(&Static, s_rd.start, s_rd.dir, s_rd.range);
-                if (xrc.r_count())
+                ctx.xrc.ray_options(s_rd.flags);
+                ctx.xrc.ray_query(&Static, s_rd.start, s_rd.dir, s_rd.range);
+                if (ctx.xrc.r_count())
                 {
-                    if (s_res.set_if_less(xrc.r_begin()))
+                    if (s_res.set_if_less(ctx.xrc.r_begin()))
                     {
                         // set new static start & range
                         s_rd.range -= (s_res.range + EPS_L);
@@ -399,16 +411,16 @@ BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_def
         }
         if ((R.tgt & d_mask) && sd_test.is_any(d_mask) && (next_test & d_mask))
         {
-            r_temp.r_clear();
+            ctx.r_temp.r_clear();
 
             if (d_rd.range > EPS)
             {
                 // Traverse object database
-                g_SpatialSpace->q_ray(r_spatial, 0, d_flags, d_rd.start, d_rd.dir, d_rd.range);
+                g_SpatialSpace->q_ray(ctx.r_spatial, 0, d_flags, d_rd.start, d_rd.dir, d_rd.range);
                 // Determine visibility for dynamic part of scene
-                for (u32 o_it = 0; o_it < r_spatial.size(); o_it++)
+                for (u32 o_it = 0; o_it < ctx.r_spatial.size(); o_it++)
                 {
-                    IGameObject* collidable = r_spatial[o_it]->dcast_GameObject();
+                    IGameObject* collidable = ctx.r_spatial[o_it]->dcast_GameObject();
                     if (0 == collidable)
                         continue;
                     if (collidable == ignore_object)
@@ -420,20 +432,21 @@ BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_def
                     {
                         if (tb && !tb(d_rd, collidable, user_data))
                             continue;
-                        cform->_RayQuery(d_rd, r_temp);
+                        cform->_RayQuery(d_rd, ctx.r_temp);
                     }
 #ifdef DEBUG
-                    if (!((0 == r_temp.r_count()) || (r_temp.r_count() && (fis_zero(r_temp.r_begin()->range, EPS) ||
-                                                                              (r_temp.r_begin()->range >= 0.f)))))
+                    if (!((0 == ctx.r_temp.r_count()) ||
+                            (ctx.r_temp.r_count() && (fis_zero(ctx.r_temp.r_begin()->range, EPS) ||
+                                                         (ctx.r_temp.r_begin()->range >= 0.f)))))
                         xrDebug::Fatal(DEBUG_INFO, "Invalid RayQuery dynamic range: %f (%f). /#2/",
-                            r_temp.r_begin()->range, d_rd.range);
+                            ctx.r_temp.r_begin()->range, d_rd.range);
 #endif
                 }
             }
-            if (r_temp.r_count())
+            if (ctx.r_temp.r_count())
             {
                 // set new dynamic start & range
-                rq_result& d_res = *r_temp.r_begin();
+                rq_result& d_res = *ctx.r_temp.r_begin();
                 d_rd.range -= (d_res.range + EPS_L);
                 d_rd.start.mad(d_rd.dir, d_res.range + EPS_L);
                 d_res.range = R.range - d_rd.range - EPS_L;
@@ -448,10 +461,10 @@ BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_def
                 sd_test.set(d_mask, FALSE);
             }
         }
-        if (s_res.valid() && r_temp.r_count())
+        if (s_res.valid() && ctx.r_temp.r_count())
         {
             // all test return result
-            if (s_res.range < r_temp.r_begin()->range)
+            if (s_res.range < ctx.r_temp.r_begin()->range)
             {
                 // static nearer
                 BOOL need_calc = CB ? CB(s_res, user_data) : TRUE;
@@ -461,9 +474,9 @@ BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_def
             else
             {
                 // dynamic nearer
-                BOOL need_calc = CB ? CB(*r_temp.r_begin(), user_data) : TRUE;
+                BOOL need_calc = CB ? CB(*ctx.r_temp.r_begin(), user_data) : TRUE;
                 next_test = need_calc ? d_mask : rqtNone;
-                r_dest.append_result(*r_temp.r_begin());
+                r_dest.append_result(*ctx.r_temp.r_begin());
             }
         }
         else if (s_res.valid())
@@ -473,12 +486,12 @@ BOOL CObjectSpace::_RayQuery(collide::rq_results& r_dest, const collide::ray_def
             next_test = need_calc ? s_mask : rqtNone;
             r_dest.append_result(s_res);
         }
-        else if (r_temp.r_count())
+        else if (ctx.r_temp.r_count())
         {
             // only dynamic return result
-            BOOL need_calc = CB ? CB(*r_temp.r_begin(), user_data) : TRUE;
+            BOOL need_calc = CB ? CB(*ctx.r_temp.r_begin(), user_data) : TRUE;
             next_test = need_calc ? d_mask : rqtNone;
-            r_dest.append_result(*r_temp.r_begin());
+            r_dest.append_result(*ctx.r_temp.r_begin());
         }
         else
         {
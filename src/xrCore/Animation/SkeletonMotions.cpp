@@ -7,9 +7,175 @@
 #include "FMesh.hpp"
 #include "Motion.hpp"
 #include "Include/xrRender/Kinematics.h"
+#include "xrCore/Threading/ScopeLock.hpp"
+
+#pragma warning(push)
+#pragma warning(disable : 4995)
+#include <emmintrin.h>
+#pragma warning(pop)
 
 motions_container* g_pMotionsContainer = nullptr;
 
+namespace
+{
+Lock streams_lock; // the streams are built by any thread calculating bones
+
+// Four keys to floats, with the sign
+ICF __m128 load_keys(const s16* keys)
+{
+    const __m128i packed = _mm_loadl_epi64((const __m128i*)keys);
+    return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16));
+}
+
+ICF __m128 madd(__m128 a, __m128 b, __m128 c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+} // namespace
+
+CMotionStreams::CMotionStreams(const CMotion* const* tracks, u32 tracks_count)
+{
+    VERIFY(tracks_count);
+    m_count = tracks[0]->get_count();
+    m_groups = (tracks_count + 3) / 4;
+    m_keysR.resize(m_count * m_groups);
+    m_keysT.resize(m_count * m_groups);
+    m_tracksT.resize(m_groups);
+
+    for (u32 group = 0; group < m_groups; ++group)
+    {
+        CTrackT4& TT = m_tracksT[group];
+        for (u32 lane = 0; lane < 4; ++lane)
+        {
+            const u32 track = group * 4 + lane;
+            const CMotion* M = track < tracks_count ? tracks[track] : nullptr;
+            VERIFY(!M || M->get_count() == m_count);
+            const bool translated = M && M->test_flag(flTKeyPresent);
+            for (u32 k = 0; k < 3; ++k)
+            {
+                TT.init[k][lane] = M ? M->_initT[k] : 0.f;
+                TT.size[k][lane] = translated ? M->_sizeT[k] : 0.f;
+            }
+
+            for (u32 frame = 0; frame < m_count; ++frame)
+            {
+                CKeyQR4& R = m_keysR[frame * m_groups + group];
+                CKeyQT4& T = m_keysT[frame * m_groups + group];
+                T.x[lane] = T.y[lane] = T.z[lane] = 0;
+                if (!M)
+                {
+                    R.x[lane] = R.y[lane] = R.z[lane] = 0;
+                    R.w[lane] = s16(KEY_Quant);
+                    continue;
+                }
+
+                const CKeyQR& QR = M->_keysR[M->test_flag(flRKeyAbsent) ? 0 : frame];
+                R.x[lane] = QR.x;
+                R.y[lane] = QR.y;
+                R.z[lane] = QR.z;
+                R.w[lane] = QR.w;
+
+                if (!translated)
+                    continue;
+                if (M->test_flag(flTKey16IsBit))
+                {
+                    const CKeyQT16& QT = M->_keysT16[frame];
+                    T.x[lane] = QT.x1;
+                    T.y[lane] = QT.y1;
+                    T.z[lane] = QT.z1;
+                }
+                else
+                {
+                    const CKeyQT8& QT = M->_keysT8[frame];
+                    T.x[lane] = QT.x1;
+                    T.y[lane] = QT.y1;
+                    T.z[lane] = QT.z1;
+                }
+            }
+        }
+    }
+}
+
+void CMotionStreams::Dequantize(CKey (&result)[4], u32 group, float time) const
+{
+    VERIFY(group < m_groups);
+    const float frame_time = time * SAMPLE_FPS;
+    VERIFY(frame_time >= 0.f);
+    const u32 frame = iFloor(frame_time);
+    const float delta = clampr(frame_time - float(frame), 0.f, 1.f);
+    const u32 key0 = (frame % m_count) * m_groups + group;
+    const u32 key1 = ((frame + 1) % m_count) * m_groups + group;
+
+    // rotation
+    const __m128 quant = _mm_set1_ps(KEY_QuantI);
+    const CKeyQR4& R0 = m_keysR[key0];
+    const CKeyQR4& R1 = m_keysR[key1];
+    const __m128 x0 = _mm_mul_ps(load_keys(R0.x), quant);
+    const __m128 y0 = _mm_mul_ps(load_keys(R0.y), quant);
+    const __m128 z0 = _mm_mul_ps(load_keys(R0.z), quant);
+    const __m128 w0 = _mm_mul_ps(load_keys(R0.w), quant);
+    const __m128 x1 = _mm_mul_ps(load_keys(R1.x), quant);
+    const __m128 y1 = _mm_mul_ps(load_keys(R1.y), quant);
+    const __m128 z1 = _mm_mul_ps(load_keys(R1.z), quant);
+    const __m128 w1 = _mm_mul_ps(load_keys(R1.w), quant);
+
+    // Slerp is approximated with nlerp of the corrected time (D. Kapoulkine, "Approximating slerp"),
+    // the error stays under 0.1 degree and is much less for the close keys of the neighbour frames
+    const __m128 cosom = madd(x0, x1, madd(y0, y1, madd(z0, z1, _mm_mul_ps(w0, w1))));
+    const __m128 sign = _mm_and_ps(cosom, _mm_set1_ps(-0.f));
+    const __m128 d = _mm_xor_ps(cosom, sign);
+    const __m128 A = madd(d, madd(d, madd(d, _mm_set1_ps(-1.43519f), _mm_set1_ps(3.55645f)),
+        _mm_set1_ps(-3.2452f)), _mm_set1_ps(1.0904f));
+    const __m128 B = madd(d, madd(d, _mm_set1_ps(0.215638f), _mm_set1_ps(-1.06021f)), _mm_set1_ps(0.848013f));
+    const float th = delta - 0.5f;
+    const __m128 k = madd(A, _mm_set1_ps(th * th), B);
+    const __m128 t = madd(k, _mm_set1_ps(delta * th * (delta - 1.f)), _mm_set1_ps(delta));
+    const __m128 s0 = _mm_sub_ps(_mm_set1_ps(1.f), t);
+    const __m128 s1 = _mm_xor_ps(t, sign);
+
+    __m128 x = madd(x0, s0, _mm_mul_ps(x1, s1));
+    __m128 y = madd(y0, s0, _mm_mul_ps(y1, s1));
+    __m128 z = madd(z0, s0, _mm_mul_ps(z1, s1));
+    __m128 w = madd(w0, s0, _mm_mul_ps(w1, s1));
+    const __m128 length = _mm_sqrt_ps(madd(x, x, madd(y, y, madd(z, z, _mm_mul_ps(w, w)))));
+    const __m128 i_length = _mm_div_ps(_mm_set1_ps(1.f), length);
+    x = _mm_mul_ps(x, i_length);
+    y = _mm_mul_ps(y, i_length);
+    z = _mm_mul_ps(z, i_length);
+    w = _mm_mul_ps(w, i_length);
+
+    // translation
+    const CTrackT4& TT = m_tracksT[group];
+    const CKeyQT4& T0 = m_keysT[key0];
+    const CKeyQT4& T1 = m_keysT[key1];
+    const s16* keys0[3] = { T0.x, T0.y, T0.z };
+    const s16* keys1[3] = { T1.x, T1.y, T1.z };
+    const __m128 dt = _mm_set1_ps(delta);
+    alignas(16) float T[3][4];
+    for (u32 i = 0; i < 3; ++i)
+    {
+        const __m128 init = _mm_loadu_ps(TT.init[i]);
+        const __m128 size = _mm_loadu_ps(TT.size[i]);
+        const __m128 t0 = madd(load_keys(keys0[i]), size, init);
+        const __m128 t1 = madd(load_keys(keys1[i]), size, init);
+        _mm_store_ps(T[i], madd(_mm_sub_ps(t1, t0), dt, t0));
+    }
+
+    alignas(16) float Q[4][4];
+    _mm_store_ps(Q[0], x);
+    _mm_store_ps(Q[1], y);
+    _mm_store_ps(Q[2], z);
+    _mm_store_ps(Q[3], w);
+    for (u32 lane = 0; lane < 4; ++lane)
+    {
+        result[lane].Q.set(Q[3][lane], Q[0][lane], Q[1][lane], Q[2][lane]);
+        result[lane].T.set(T[0][lane], T[1][lane], T[2][lane]);
+    }
+}
+
+u32 CMotionStreams::mem_usage() const
+{
+    return u32(sizeof(*this) + m_keysR.size() * sizeof(CKeyQR4) + m_keysT.size() * sizeof(CKeyQT4) +
+        m_tracksT.size() * sizeof(CTrackT4));
+}
+
 u16 CPartition::part_id(const shared_str& name) const
 {
     for (u16 i = 0; i < MAX_PARTS; ++i)
@@ -178,8 +344,14 @@ BOOL motions_value::load(LPCSTR N, IReader* data, vecBones* bones)
     VERIFY(dwCNT < 0x3FFF); // MotionID 2 bit - slot, 14 bit - motion index
 
     // set per bone motion size
+    m_tracks.resize(bones->size());
     for (u32 i = 0; i < bones->size(); i++)
-        m_motions[bones->at(i)->name].resize(dwCNT);
+    {
+        MotionVec& motions = m_motions[bones->at(i)->name];
+        motions.resize(dwCNT);
+        m_tracks[i] = &motions;
+    }
+    m_streams = xr_vector<std::atomic<CMotionStreams*>>(dwCNT);
 
     // load motions
     for (u16 m_idx = 0; m_idx < (u16)dwCNT; m_idx++)
@@ -254,6 +426,45 @@ MotionVec* motions_value::bone_motions(shared_str bone_name)
 
     return &(*I).second;
 }
+
+u16 motions_value::track(shared_str bone_name)
+{
+    const MotionVec* motions = bone_motions(bone_name);
+    const auto I = std::find(m_tracks.begin(), m_tracks.end(), motions);
+    if (!motions || I == m_tracks.end())
+        return BI_NONE;
+    return u16(I - m_tracks.begin());
+}
+
+const CMotionStreams* motions_value::streams(u16 motion_idx)
+{
+    VERIFY(motion_idx < m_streams.size());
+    std::atomic<CMotionStreams*>& slot = m_streams[motion_idx];
+    CMotionStreams* result = slot.load(std::memory_order_acquire);
+    if (result)
+        return result;
+
+    ScopeLock scope(&streams_lock);
+    result = slot.load(std::memory_order_relaxed);
+    if (!result)
+    {
+        xr_vector<const CMotion*> tracks(m_tracks.size());
+        for (size_t i = 0; i < m_tracks.size(); ++i)
+            tracks[i] = &m_tracks[i]->at(motion_idx);
+        result = new CMotionStreams(tracks.data(), u32(tracks.size()));
+        slot.store(result, std::memory_order_release);
+    }
+    return result;
+}
+
+motions_value::~motions_value()
+{
+    for (auto& it : m_streams)
+    {
+        CMotionStreams* streams = it.load(std::memory_order_relaxed);
+        xr_delete(streams);
+    }
+}
 //-----------------------------------
 motions_container::motions_container() {}
 // extern shared_str s_bones_array_const;
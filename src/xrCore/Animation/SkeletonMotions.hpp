@@ -3,10 +3,13 @@
 #define SkeletonMotionsH
 
 #include "Bone.hpp"
+#include "Common/Noncopyable.hpp"
 #include "SkeletonMotionDefs.hpp"
 #include "xrCore/_quaternion.h"
 #include "xrCore/_vector3d.h"
 
+#include <atomic>
+
 // fwd. decl.
 class CKinematicsAnimated;
 class CBlend;
@@ -95,6 +98,50 @@ public:
     }
 };
 
+//*** Motion streams ******************************************************************************
+#pragma pack(push, 2)
+// Keys of four tracks of one frame, structure of arrays
+struct CKeyQR4
+{
+    s16 x[4], y[4], z[4], w[4];
+};
+struct CKeyQT4
+{
+    s16 x[4], y[4], z[4];
+};
+#pragma pack(pop)
+
+// Translation dequantization of four tracks
+struct CTrackT4
+{
+    float init[3][4];
+    float size[3][4];
+};
+
+/*
+ * Keys of all the bones of one motion, packed by four tracks per frame, so the bones
+ * sharing a blend are dequantized and interpolated together with SSE.
+ * Converted from CMotion keys: an absent rotation key is repeated for every frame,
+ * 8 bit translations are widened to 16 bits, an absent translation has zero size.
+ * Lanes past the tracks count hold the identity.
+ */
+class XRCORE_API CMotionStreams : Noncopyable
+{
+    u32 m_count; // frames
+    u32 m_groups; // four tracks each
+    xr_vector<CKeyQR4> m_keysR; // frame * groups + group
+    xr_vector<CKeyQT4> m_keysT; // frame * groups + group
+    xr_vector<CTrackT4> m_tracksT; // by group
+
+public:
+    CMotionStreams(const CMotion* const* tracks, u32 tracks_count);
+
+    u32 groups() const { return m_groups; }
+    // Keys of the group tracks at the motion time, the same Dequantize gives up to the slerp approximation
+    void Dequantize(CKey (&result)[4], u32 group, float time) const;
+    u32 mem_usage() const;
+};
+
 class XRCORE_API motion_marks
 {
 public:
@@ -200,11 +247,17 @@ struct XRCORE_API motions_value
     u32 m_dwReference;
     BoneMotionMap m_motions;
     MotionDefVec m_mdefs;
+    xr_vector<MotionVec*> m_tracks; // bone motions in the order of the streams lanes
+    xr_vector<std::atomic<CMotionStreams*>> m_streams; // by motion, built on the first use
 
     shared_str m_id;
 
+    ~motions_value();
+
     BOOL load(LPCSTR N, IReader* data, vecBones* bones);
     MotionVec* bone_motions(shared_str bone_name);
+    u16 track(shared_str bone_name);
+    const CMotionStreams* streams(u16 motion_idx);
 
     u32 mem_usage()
     {
@@ -214,6 +267,11 @@ struct XRCORE_API motions_value
         for (auto bm_it = m_motions.begin(); bm_it != m_motions.end(); ++bm_it)
             for (auto m_it = bm_it->second.begin(); m_it != bm_it->second.end(); ++m_it)
                 sz += m_it->mem_usage();
+        for (auto& it : m_streams)
+        {
+            if (const CMotionStreams* streams = it.load(std::memory_order_acquire))
+                sz += streams->mem_usage();
+        }
         return sz;
     }
 };
@@ -230,6 +288,13 @@ public:
     motions_value* dock(shared_str key, IReader* data, vecBones* bones);
     void dump();
     void clean(bool force_destroy);
+
+    template <typename Callback>
+    void for_each(Callback&& callback)
+    {
+        for (auto& it : container)
+            callback(*it.second);
+    }
 };
 
 extern XRCORE_API motions_container* g_pMotionsContainer;
@@ -277,6 +342,16 @@ public:
         VERIFY(p_);
         return p_->bone_motions(bone_name);
     }
+    u16 track(shared_str bone_name)
+    {
+        VERIFY(p_);
+        return p_->track(bone_name);
+    }
+    const CMotionStreams* streams(u16 motion_idx)
+    {
+        VERIFY(p_);
+        return p_->streams(motion_idx);
+    }
     accel_map* motion_map()
     {
         VERIFY(p_);
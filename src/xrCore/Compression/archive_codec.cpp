@@ -0,0 +1,304 @@
+#include "stdafx.h"
+#pragma hdrstop
+
+#include "archive_codec.h"
+
+#include "lzo/lzo1x.h"
+
+#ifdef XR_ARCHIVE_CODEC_LZ4
+#include <lz4.h>
+#include <lz4hc.h>
+#endif
+
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+#include <zstd.h>
+#include <zdict.h>
+#endif
+
+namespace
+{
+constexpr pcstr codec_names[] = { "lzo", "lz4", "zstd", "zstd_dict" };
+static_assert(std::size(codec_names) == size_t(ArchiveCodec::Count), "Update codec names");
+
+thread_local xr_vector<u8> lzo_workmem;
+
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+constexpr int ZSTD_FAST_LEVEL = 3;
+constexpr int ZSTD_HIGH_LEVEL = 19;
+
+// Contexts are reusable, but not shareable between threads
+struct ZstdContexts
+{
+    ZSTD_CCtx* cctx = nullptr;
+    ZSTD_DCtx* dctx = nullptr;
+
+    ~ZstdContexts()
+    {
+        ZSTD_freeCCtx(cctx);
+        ZSTD_freeDCtx(dctx);
+    }
+
+    ZSTD_CCtx* compression()
+    {
+        if (!cctx)
+            cctx = ZSTD_createCCtx();
+        return cctx;
+    }
+
+    ZSTD_DCtx* decompression()
+    {
+        if (!dctx)
+            dctx = ZSTD_createDCtx();
+        return dctx;
+    }
+};
+
+thread_local ZstdContexts zstd_contexts;
+#endif
+} // namespace
+
+ArchiveDictionary::ArchiveDictionary(const void* dict, size_t size)
+    : data(static_cast<const u8*>(dict), static_cast<const u8*>(dict) + size), ddict(nullptr)
+{
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+    ddict = ZSTD_createDDict(data.data(), data.size());
+#endif
+}
+
+ArchiveDictionary::~ArchiveDictionary()
+{
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+    ZSTD_freeDDict(static_cast<ZSTD_DDict*>(ddict));
+#endif
+}
+
+pcstr archive_codec_name(ArchiveCodec codec)
+{
+    return codec < ArchiveCodec::Count ? codec_names[size_t(codec)] : "unknown";
+}
+
+ArchiveCodec archive_codec_by_name(pcstr name, ArchiveCodec fallback /*= ArchiveCodec::LZO*/)
+{
+    for (size_t i = 0; i < std::size(codec_names); ++i)
+    {
+        if (0 == xr_stricmp(name, codec_names[i]))
+            return ArchiveCodec(i);
+    }
+    return fallback;
+}
+
+bool archive_codec_supported(ArchiveCodec codec)
+{
+    switch (codec)
+    {
+    case ArchiveCodec::LZO: return true;
+#ifdef XR_ARCHIVE_CODEC_LZ4
+    case ArchiveCodec::LZ4: return true;
+#endif
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+    case ArchiveCodec::Zstd:
+    case ArchiveCodec::ZstdDict: return true;
+#endif
+    default: return false;
+    }
+}
+
+size_t archive_compress_bound(ArchiveCodec codec, size_t src_len)
+{
+    switch (codec)
+    {
+#ifdef XR_ARCHIVE_CODEC_LZ4
+    case ArchiveCodec::LZ4: return size_t(LZ4_compressBound(int(src_len)));
+#endif
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+    case ArchiveCodec::Zstd:
+    case ArchiveCodec::ZstdDict: return ZSTD_compressBound(src_len);
+#endif
+    default: return rtc_csize(u32(src_len));
+    }
+}
+
+size_t archive_compress(ArchiveCodec codec, bool high, void* dst, size_t dst_len, const void* src, size_t src_len,
+    const ArchiveDictionary* dict /*= nullptr*/)
+{
+    switch (codec)
+    {
+    case ArchiveCodec::LZO:
+    {
+        if (!high)
+            return rtc_compress(dst, dst_len, src, src_len);
+
+        if (lzo_workmem.empty())
+            lzo_workmem.resize(LZO1X_999_MEM_COMPRESS);
+
+        lzo_uint result = dst_len;
+        if (LZO_E_OK != lzo1x_999_compress((const lzo_bytep)src, lzo_uint(src_len), (lzo_bytep)dst, &result,
+            lzo_workmem.data()))
+            return 0;
+
+        // Rearranges the data for faster decompression, fails only on broken data
+        lzo_uint original = src_len;
+        xr_vector<u8> temp(src_len);
+        if (LZO_E_OK != lzo1x_optimize((lzo_bytep)dst, result, temp.data(), &original, nullptr))
+            return 0;
+        return result;
+    }
+
+#ifdef XR_ARCHIVE_CODEC_LZ4
+    case ArchiveCodec::LZ4:
+    {
+        const int result = high ?
+            LZ4_compress_HC((pcstr)src, (pstr)dst, int(src_len), int(dst_len), LZ4HC_CLEVEL_MAX) :
+            LZ4_compress_default((pcstr)src, (pstr)dst, int(src_len), int(dst_len));
+        return result > 0 ? size_t(result) : 0;
+    }
+#endif
+
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+    case ArchiveCodec::Zstd:
+    case ArchiveCodec::ZstdDict:
+    {
+        const int level = high ? ZSTD_HIGH_LEVEL : ZSTD_FAST_LEVEL;
+        size_t result;
+        if (codec == ArchiveCodec::ZstdDict)
+        {
+            R_ASSERT2(dict, "Zstd dictionary is required");
+            result = ZSTD_compress_usingDict(zstd_contexts.compression(), dst, dst_len, src, src_len,
+                dict->pointer(), dict->size(), level);
+        }
+        else
+            result = ZSTD_compressCCtx(zstd_contexts.compression(), dst, dst_len, src, src_len, level);
+        return ZSTD_isError(result) ? 0 : result;
+    }
+#endif
+
+    default:
+        Msg("! Archive codec [%s] isn't supported by this build", archive_codec_name(codec));
+        return 0;
+    }
+}
+
+size_t archive_decompress(ArchiveCodec codec, void* dst, size_t dst_len, const void* src, size_t src_len,
+    const ArchiveDictionary* dict /*= nullptr*/)
+{
+    switch (codec)
+    {
+    case ArchiveCodec::LZO: return rtc_decompress(dst, dst_len, src, src_len);
+
+#ifdef XR_ARCHIVE_CODEC_LZ4
+    case ArchiveCodec::LZ4:
+    {
+        const int result = LZ4_decompress_safe((pcstr)src, (pstr)dst, int(src_len), int(dst_len));
+        return result > 0 ? size_t(result) : 0;
+    }
+#endif
+
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+    case ArchiveCodec::Zstd:
+    case ArchiveCodec::ZstdDict:
+    {
+        size_t result;
+        if (codec == ArchiveCodec::ZstdDict)
+        {
+            if (!dict || !dict->decompression_dict())
+                return 0;
+            result = ZSTD_decompress_usingDDict(zstd_contexts.decompression(), dst, dst_len, src, src_len,
+                static_cast<const ZSTD_DDict*>(dict->decompression_dict()));
+        }
+        else
+            result = ZSTD_decompressDCtx(zstd_contexts.decompression(), dst, dst_len, src, src_len);
+        return ZSTD_isError(result) ? 0 : result;
+    }
+#endif
+
+    default: return 0;
+    }
+}
+
+size_t archive_decompress_block(ArchiveCodec codec, void* dst, size_t dst_len, const void* src, size_t src_len,
+    const ArchiveDictionary* dict /*= nullptr*/)
+{
+    if (src_len == dst_len)
+    {
+        CopyMemory(dst, src, dst_len);
+        return dst_len;
+    }
+    return archive_decompress(codec, dst, dst_len, src, src_len, dict);
+}
+
+size_t archive_compress_blocks(ArchiveCodec codec, bool high, xr_vector<u8>& dst, const void* src, size_t src_len,
+    u32 block_size /*= ARCHIVE_BLOCK_SIZE*/, const ArchiveDictionary* dict /*= nullptr*/)
+{
+    R_ASSERT(block_size);
+    const u32 count = archive_blocks_count(src_len, block_size);
+    const size_t table_size = archive_blocks_table_size(count);
+
+    dst.resize(table_size);
+    *(u32*)dst.data() = block_size;
+
+    xr_vector<u8> temp(archive_compress_bound(codec, block_size));
+    const u8* block = static_cast<const u8*>(src);
+    for (u32 i = 0; i < count; ++i)
+    {
+        const size_t real = std::min<size_t>(block_size, src_len - size_t(i) * block_size);
+        const size_t offset = dst.size();
+        ((u32*)(dst.data() + sizeof(u32)))[i] = u32(offset);
+
+        const size_t compressed = archive_compress(codec, high, temp.data(), temp.size(), block, real, dict);
+        if (0 == compressed || compressed >= real)
+            dst.insert(dst.end(), block, block + real);
+        else
+            dst.insert(dst.end(), temp.data(), temp.data() + compressed);
+
+        block += real;
+    }
+    ((u32*)(dst.data() + sizeof(u32)))[count] = u32(dst.size());
+    return dst.size();
+}
+
+size_t archive_decompress_blocks(ArchiveCodec codec, void* dst, size_t dst_len, const void* src, size_t src_len,
+    const ArchiveDictionary* dict /*= nullptr*/)
+{
+    const u8* entry = static_cast<const u8*>(src);
+    if (src_len < sizeof(u32))
+        return 0;
+
+    const u32 block_size = *(const u32*)entry;
+    if (0 == block_size)
+        return 0;
+
+    const u32 count = archive_blocks_count(dst_len, block_size);
+    if (src_len < archive_blocks_table_size(count))
+        return 0;
+
+    const u32* offsets = (const u32*)(entry + sizeof(u32));
+    u8* block = static_cast<u8*>(dst);
+    for (u32 i = 0; i < count; ++i)
+    {
+        const size_t real = std::min<size_t>(block_size, dst_len - size_t(i) * block_size);
+        if (offsets[i] > offsets[i + 1] || offsets[i + 1] > src_len)
+            return 0;
+
+        if (real != archive_decompress_block(codec, block, real, entry + offsets[i], offsets[i + 1] - offsets[i], dict))
+            return 0;
+        block += real;
+    }
+    return dst_len;
+}
+
+size_t archive_train_dictionary(
+    void* dict, size_t dict_capacity, const void* samples, const size_t* sample_sizes, u32 samples_count)
+{
+#ifdef XR_ARCHIVE_CODEC_ZSTD
+    const size_t result = ZDICT_trainFromBuffer(dict, dict_capacity, samples, sample_sizes, samples_count);
+    if (ZDICT_isError(result))
+    {
+        Msg("! Can't train Zstd dictionary: %s", ZDICT_getErrorName(result));
+        return 0;
+    }
+    return result;
+#else
+    Msg("! Zstd isn't supported by this build, can't train dictionary");
+    return 0;
+#endif
+}
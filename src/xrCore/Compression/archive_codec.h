@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Common/Noncopyable.hpp"
+
+// Codec of a compressed file inside .db/.xdb archive.
+// Files packed by the original tools are always LZO.
+// LZ4 and Zstd are available only when the engine is built with them
+// (XR_ARCHIVE_CODEC_LZ4 / XR_ARCHIVE_CODEC_ZSTD).
+enum class ArchiveCodec : u8
+{
+    LZO = 0,
+    LZ4 = 1,
+    Zstd = 2,
+    ZstdDict = 3, // Zstd with the dictionary stored in the archive
+
+    Count
+};
+
+// Set in the file table entry size when the entry is followed by the codec byte
+constexpr u16 ARCHIVE_ENTRY_CODEC_MARK = 1 << 15;
+
+// Set in the codec byte when the file is split into independently compressed blocks,
+// so CStreamReader can decompress it window by window. Layout of such file:
+//   u32 block_size
+//   u32 offsets[blocks_count + 1] - from the file start
+//   blocks, a block that can't be compressed is stored as is
+constexpr u8 ARCHIVE_CODEC_BLOCKS = 1 << 7;
+constexpr u32 ARCHIVE_BLOCK_SIZE = 256 * 1024;
+
+inline ArchiveCodec archive_entry_codec(u8 codec) { return ArchiveCodec(codec & ~ARCHIVE_CODEC_BLOCKS); }
+inline bool archive_entry_has_blocks(u8 codec) { return (codec & ARCHIVE_CODEC_BLOCKS) != 0; }
+
+inline u32 archive_blocks_count(size_t size_real, u32 block_size) { return u32((size_real + block_size - 1) / block_size); }
+inline size_t archive_blocks_table_size(u32 blocks_count) { return sizeof(u32) * (blocks_count + 2); }
+
+// Dictionary shared by the files of one archive
+class XRCORE_API ArchiveDictionary : Noncopyable
+{
+    xr_vector<u8> data;
+    void* ddict; // prepared for decompression
+
+public:
+    ArchiveDictionary(const void* dict, size_t size);
+    ~ArchiveDictionary();
+
+    const u8* pointer() const { return data.data(); }
+    size_t size() const { return data.size(); }
+    void* decompression_dict() const { return ddict; }
+};
+
+XRCORE_API pcstr archive_codec_name(ArchiveCodec codec);
+XRCORE_API ArchiveCodec archive_codec_by_name(pcstr name, ArchiveCodec fallback = ArchiveCodec::LZO);
+XRCORE_API bool archive_codec_supported(ArchiveCodec codec);
+
+XRCORE_API size_t archive_compress_bound(ArchiveCodec codec, size_t src_len);
+
+// high - the best ratio at the cost of compression speed.
+// Returns compressed size or 0 if the data can't be compressed.
+XRCORE_API size_t archive_compress(ArchiveCodec codec, bool high, void* dst, size_t dst_len, const void* src,
+    size_t src_len, const ArchiveDictionary* dict = nullptr);
+
+// Returns decompressed size or 0 on error
+XRCORE_API size_t archive_decompress(ArchiveCodec codec, void* dst, size_t dst_len, const void* src, size_t src_len,
+    const ArchiveDictionary* dict = nullptr);
+
+// Block is stored as is when its size didn't change
+XRCORE_API size_t archive_decompress_block(ArchiveCodec codec, void* dst, size_t dst_len, const void* src,
+    size_t src_len, const ArchiveDictionary* dict = nullptr);
+
+// Split into blocks (see ARCHIVE_CODEC_BLOCKS), returns the size of result or 0 on failure
+XRCORE_API size_t archive_compress_blocks(ArchiveCodec codec, bool high, xr_vector<u8>& dst, const void* src,
+    size_t src_len, u32 block_size = ARCHIVE_BLOCK_SIZE, const ArchiveDictionary* dict = nullptr);
+
+// Returns decompressed size or 0 on error
+XRCORE_API size_t archive_decompress_blocks(ArchiveCodec codec, void* dst, size_t dst_len, const void* src,
+    size_t src_len, const ArchiveDictionary* dict = nullptr);
+
+// Builds the Zstd dictionary from the samples, stored one after another.
+// Returns dictionary size or 0 on failure.
+XRCORE_API size_t archive_train_dictionary(
+    void* dict, size_t dict_capacity, const void* samples, const size_t* sample_sizes, u32 samples_count);
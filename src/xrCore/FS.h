@@ -17,6 +17,7 @@
 
 #define CFS_CompressMark (1ul << 31ul)
 #define CFS_HeaderChunkID (666)
+#define CFS_DictionaryChunkID (667) // ArchiveDictionary of the archive files
 
 XRCORE_API void VerifyPath(pcstr path);
 
@@ -18,7 +18,12 @@
 #include "stream_reader.h"
 #include "file_stream_reader.h"
 #include "xrCore/Threading/Lock.hpp"
+#include "xrCore/Threading/ScopeLock.hpp"
+#include "xrCore/Threading/TaskManager.hpp"
 #include "Crypto/trivial_encryptor.h"
+#include "Compression/archive_codec.h"
+
+#include <thread>
 
 #if defined(LINUX) || defined(FREEBSD)
 #include "SDL.h"
@@ -30,6 +35,12 @@ constexpr size_t VFS_STANDARD_FILE = std::numeric_limits<size_t>::max();
 
 const u32 BIG_FILE_READER_WINDOW_SIZE = 1024 * 1024;
 
+// Bump when the archive file table or the cache format changes
+constexpr u32 INDEX_CACHE_VERSION = 3;
+
+// Decoded data waiting for r_open() can't take more
+constexpr size_t PREFETCH_BUDGET = 256 * 1024 * 1024;
+
 xr_unique_ptr<CLocatorAPI> xr_FS;
 
 #ifdef _EDITOR
@@ -159,11 +170,14 @@ XRCORE_API void _dump_open_files(int mode)
     Log("----total count = ", g_open_files.size());
 }
 
-CLocatorAPI::CLocatorAPI() : bNoRecurse(true), m_auth_code(0),
+CLocatorAPI::CLocatorAPI() : m_files_ordered_valid(false), bNoRecurse(true), m_auth_code(0),
+    m_prefetch_bytes(0), m_stat_prefetched(0), m_stat_prefetch_hits(0),
 #ifdef CONFIG_PROFILE_LOCKS
-    m_auth_lock(new Lock(MUTEX_PROFILE_ID(CLocatorAPI::m_auth_lock)))
+    m_auth_lock(new Lock(MUTEX_PROFILE_ID(CLocatorAPI::m_auth_lock))),
+    m_async_lock(new Lock(MUTEX_PROFILE_ID(CLocatorAPI::m_async_lock)))
 #else
-    m_auth_lock(new Lock)
+    m_auth_lock(new Lock),
+    m_async_lock(new Lock)
 #endif // CONFIG_PROFILE_LOCKS
 {
     m_Flags.zero();
@@ -184,6 +198,7 @@ CLocatorAPI::~CLocatorAPI()
     VERIFY(0 == m_iLockRescan);
     _dump_open_files(1);
     delete m_auth_lock;
+    delete m_async_lock;
 }
 
 const CLocatorAPI::file* CLocatorAPI::RegisterExternal(pcstr name)
@@ -195,7 +210,7 @@ const CLocatorAPI::file* CLocatorAPI::RegisterExternal(pcstr name)
 }
 
 const CLocatorAPI::file* CLocatorAPI::Register(
-    pcstr name, size_t vfs, u32 crc, u32 ptr, u32 size_real, u32 size_compressed, u32 modif)
+    pcstr name, size_t vfs, u32 crc, u32 ptr, u32 size_real, u32 size_compressed, u32 modif, u8 codec /*= 0*/)
 {
     string256 temp_file_name;
     xr_strcpy(temp_file_name, sizeof temp_file_name, name);
@@ -213,9 +228,10 @@ const CLocatorAPI::file* CLocatorAPI::Register(
     desc.size_real = size_real;
     desc.size_compressed = size_compressed;
     desc.modif = modif & ~u32(0x3);
+    desc.codec = codec;
     // Msg("registering file %s - %d", name, size_real);
     // if file already exist - update info
-    files_it I = m_files.find(desc);
+    files_it I = file_find(desc.name);
     if (I != m_files.end())
     {
         //. Msg("-- file already scanned [%s]", I->name);
@@ -232,41 +248,57 @@ const CLocatorAPI::file* CLocatorAPI::Register(
     }
 
     // otherwise insert file
-    auto result = m_files.insert(desc).first;
+    auto result = file_insert(desc).first;
 
     // Try to register folder(s)
+    for_each_folder(desc.name, [this](pcstr path) { register_folder(path); });
+    return &*result;
+}
+
+// Calls the functor for every parent folder of the file, starting from the nearest one
+template <typename F>
+void CLocatorAPI::for_each_folder(pcstr name, F&& f)
+{
     string_path temp;
-    xr_strcpy(temp, sizeof temp, desc.name);
+    xr_strcpy(temp, sizeof temp, name);
     string_path path;
     string_path folder;
     while (temp[0])
     {
         _splitpath(temp, path, folder, nullptr, nullptr);
         xr_strcat(path, folder);
-        if (!exist(path))
-        {
-            desc.name = xr_strdup(path);
-            desc.vfs = VFS_STANDARD_FILE;
-            desc.ptr = 0;
-            desc.size_real = 0;
-            desc.size_compressed = 0;
-            desc.modif = u32(-1);
-            std::pair<files_it, bool> I2 = m_files.insert(desc);
-
-            cpcstr failureDescription = "Failed to register file in filesystem.\n"
-                "First argument is the file we tried to insert, "
-                "second is the file that prevented the insertion.";
-            R_ASSERT4(I2.second, failureDescription, path, I2.first->name);
-        }
+        f(path);
         xr_strcpy(temp, sizeof temp, folder);
         if (xr_strlen(temp))
             temp[xr_strlen(temp) - 1] = 0;
     }
-    return &*result;
 }
 
+void CLocatorAPI::register_folder(pcstr path)
+{
+    if (exist(path))
+        return;
+
+    file desc;
+    desc.name = xr_strdup(path);
+    desc.vfs = VFS_STANDARD_FILE;
+    desc.crc = 0;
+    desc.ptr = 0;
+    desc.size_real = 0;
+    desc.size_compressed = 0;
+    desc.modif = u32(-1);
+    desc.codec = 0;
+    std::pair<files_it, bool> I = file_insert(desc);
+
+    cpcstr failureDescription = "Failed to register file in filesystem.\n"
+        "First argument is the file we tried to insert, "
+        "second is the file that prevented the insertion.";
+    R_ASSERT4(I.second, failureDescription, path, I.first->name);
+}
+
+// Reads the chunk as it is stored in the archive
 #if defined(WINDOWS)
-IReader* open_chunk(void* ptr, u32 ID, pcstr archiveName, size_t archiveSize, bool shouldDecrypt = false)
+bool read_chunk(void* ptr, u32 ID, u8*& data, size_t& size, bool& compressed)
 {
     u32 dwType = INVALID_SET_FILE_POINTER;
     size_t dwSize = 0;
@@ -279,7 +311,7 @@ IReader* open_chunk(void* ptr, u32 ID, pcstr archiveName, size_t archiveSize, bo
         bool res = ReadFile(ptr, &dwType, 4, &read_byte, nullptr);
 
         if (read_byte == 0)
-            return nullptr;
+            return false;
         //. VERIFY(res&&(read_byte==4));
 
         u32 tempSize = 0;
@@ -287,50 +319,30 @@ IReader* open_chunk(void* ptr, u32 ID, pcstr archiveName, size_t archiveSize, bo
         dwSize = tempSize;
 
         if (read_byte == 0)
-            return nullptr;
+            return false;
         //. VERIFY(res&&(read_byte==4));
 
         if ((dwType & ~CFS_CompressMark) == ID)
         {
-            u8* src_data = xr_alloc<u8>(dwSize);
-            res = ReadFile(ptr, src_data, dwSize, &read_byte, nullptr);
+            data = xr_alloc<u8>(dwSize);
+            res = ReadFile(ptr, data, dwSize, &read_byte, nullptr);
 
             VERIFY(res && (read_byte == dwSize));
-            if (dwType & CFS_CompressMark)
-            {
-                BYTE* dest = nullptr;
-                size_t dest_sz = 0;
-
-                if (shouldDecrypt) // Try WW key first
-                    g_trivial_encryptor.decode(src_data, dwSize, src_data);
-
-                bool result = _decompressLZ(&dest, &dest_sz, src_data, dwSize, archiveSize);
-
-                if (!result && shouldDecrypt)
-                {
-                    // Let's try to decode with RU key
-                    g_trivial_encryptor.encode(src_data, dwSize, src_data); // rollback
-                    g_trivial_encryptor.decode(src_data, dwSize, src_data, trivial_encryptor::key_flag::russian);
-                    result = _decompressLZ(&dest, &dest_sz, src_data, dwSize, archiveSize);
-                }
-                R_ASSERT3(result, "Can't decompress archive", archiveName);
-
-                xr_free(src_data);
-                return new CTempReader(dest, dest_sz, 0);
-            }
-            return new CTempReader(src_data, dwSize, 0);
+            size = dwSize;
+            compressed = dwType & CFS_CompressMark;
+            return true;
         }
 
         pt = SetFilePointer(ptr, dwSize, nullptr, FILE_CURRENT);
         if (pt == INVALID_SET_FILE_POINTER)
-            return nullptr;
+            return false;
     }
-    return nullptr;
+    return false;
 };
 #endif
 
 #if defined(LINUX) || defined(FREEBSD)
-IReader* open_chunk(int fd, u32 ID, pcstr archiveName, size_t archiveSize, bool shouldDecrypt = false)
+bool read_chunk(int fd, u32 ID, u8*& data, size_t& size, bool& compressed)
 {
     u32 dwType;
     size_t dwSize = 0;
@@ -341,51 +353,71 @@ IReader* open_chunk(int fd, u32 ID, pcstr archiveName, size_t archiveSize, bool
     {
         read_byte = ::read(fd, &dwType, 4);
         if (read_byte == -1)
-            return nullptr;
+            return false;
 
         u32 tempSize = 0;
         read_byte = ::read(fd, &tempSize, 4);
         dwSize = tempSize;
         if (read_byte == -1)
-            return nullptr;
+            return false;
 
         if ((dwType & ~CFS_CompressMark) == ID)
         {
-            u8* src_data = xr_alloc<u8>(dwSize);
-            read_byte = ::read(fd, src_data, dwSize);
+            data = xr_alloc<u8>(dwSize);
+            read_byte = ::read(fd, data, dwSize);
 
             VERIFY(read_byte == dwSize);
-            if (dwType & CFS_CompressMark)
-            {
-                BYTE* dest = nullptr;
-                size_t dest_sz = 0;
-
-                if (shouldDecrypt)
-                    g_trivial_encryptor.decode(src_data, dwSize, src_data);
-
-                bool result = _decompressLZ(&dest, &dest_sz, src_data, dwSize, archiveSize);
-
-                if (!result && shouldDecrypt)
-                {
-                    // Let's try to decode with RU key
-                    g_trivial_encryptor.decode(src_data, dwSize, src_data, trivial_encryptor::key_flag::russian);
-                    result = _decompressLZ(&dest, &dest_sz, src_data, dwSize, archiveSize);
-                }
-                R_ASSERT3(result, "Can't decompress archive", archiveName);
-
-                xr_free(src_data);
-                return new CTempReader(dest, dest_sz, 0);
-            }
-            return new CTempReader(src_data, dwSize, 0);
+            size = dwSize;
+            compressed = dwType & CFS_CompressMark;
+            return true;
         }
 
         if(-1 == ::lseek(fd, dwSize, SEEK_CUR))
-            return nullptr;
+            return false;
     }
-    return nullptr;
+    return false;
 };
 #endif
 
+// Takes the ownership of the data read by read_chunk()
+IReader* decode_chunk(u8* src_data, size_t dwSize, bool compressed, pcstr archiveName, size_t archiveSize,
+    bool shouldDecrypt)
+{
+    if (!compressed)
+        return new CTempReader(src_data, dwSize, 0);
+
+    BYTE* dest = nullptr;
+    size_t dest_sz = 0;
+
+    if (shouldDecrypt) // Try WW key first
+        g_trivial_encryptor.decode(src_data, dwSize, src_data);
+
+    bool result = _decompressLZ(&dest, &dest_sz, src_data, dwSize, archiveSize);
+
+    if (!result && shouldDecrypt)
+    {
+        // Let's try to decode with RU key
+        g_trivial_encryptor.encode(src_data, dwSize, src_data); // rollback
+        g_trivial_encryptor.decode(src_data, dwSize, src_data, trivial_encryptor::key_flag::russian);
+        result = _decompressLZ(&dest, &dest_sz, src_data, dwSize, archiveSize);
+    }
+    R_ASSERT3(result, "Can't decompress archive", archiveName);
+
+    xr_free(src_data);
+    return new CTempReader(dest, dest_sz, 0);
+}
+
+template <typename Handle>
+IReader* open_chunk(Handle handle, u32 ID, pcstr archiveName, size_t archiveSize, bool shouldDecrypt = false)
+{
+    u8* data;
+    size_t size;
+    bool compressed;
+    if (!read_chunk(handle, ID, data, size, compressed))
+        return nullptr;
+    return decode_chunk(data, size, compressed, archiveName, archiveSize, shouldDecrypt);
+}
+
 void CLocatorAPI::LoadArchive(archive& A, pcstr entrypoint)
 {
     // Create base path
@@ -448,21 +480,55 @@ void CLocatorAPI::LoadArchive(archive& A, pcstr entrypoint)
 
     // Read FileSystem
     A.open();
-    IReader* hdr = open_chunk(A.hSrcFile, 1, A.path.c_str(), A.size, shouldDecrypt);
+    u8* table;
+    size_t table_size;
+    bool table_compressed;
+    const bool table_found = read_chunk(A.hSrcFile, 1, table, table_size, table_compressed);
+    R_ASSERT3(table_found, "File table not found", A.path.c_str());
+
+    // The raw table is only checksummed on a cache hit, its decoding and parsing are skipped
+    const u32 table_crc = crc32(table, table_size);
+    bool needDictionary = false;
+    if (index_cache_load(A, table_crc, fs_entry_point, needDictionary))
+        xr_free(table);
+    else
+    {
+        needDictionary =
+            LoadArchiveTable(A, table_crc, fs_entry_point, table, table_size, table_compressed, shouldDecrypt);
+    }
+
+    if (needDictionary && !A.dictionary)
+    {
+        IReader* dict = open_chunk(A.hSrcFile, CFS_DictionaryChunkID, A.path.c_str(), A.size);
+        R_ASSERT3(dict, "Archive dictionary not found", A.path.c_str());
+        A.dictionary = new ArchiveDictionary(dict->pointer(), dict->length());
+        dict->close();
+    }
+}
 
-    R_ASSERT(hdr);
+// Registers the entries of the file table and saves them to the index cache
+bool CLocatorAPI::LoadArchiveTable(archive& A, u32 table_crc, pcstr fs_entry_point, u8* table, size_t table_size,
+    bool table_compressed, bool shouldDecrypt)
+{
+    IReader* hdr = decode_chunk(table, table_size, table_compressed, A.path.c_str(), A.size, shouldDecrypt);
 
+    xr_vector<const file*> entries;
+    bool needDictionary = false;
     while (!hdr->eof())
     {
         string_path name, full;
         archive_header header;
 
         u16 buffer_size = hdr->r_u16(); // Read the total length of all crap
-        VERIFY(buffer_size < sizeof(name) + sizeof(archive_header) + sizeof(u32));
+        // Entries of the non-LZO files end with the codec
+        const bool hasCodec = buffer_size & ARCHIVE_ENTRY_CODEC_MARK;
+        buffer_size &= ~ARCHIVE_ENTRY_CODEC_MARK;
+        const size_t codec_size = hasCodec ? sizeof(u8) : 0;
+        VERIFY(buffer_size < sizeof(name) + sizeof(archive_header) + sizeof(u32) + codec_size);
 
         hdr->r(&header, sizeof(archive_header)); // Read header
 
-        const size_t name_length = buffer_size - sizeof(archive_header) - sizeof(u32);
+        const size_t name_length = buffer_size - sizeof(archive_header) - sizeof(u32) - codec_size;
         VERIFY(name_length > 0);
         hdr->r(&name, name_length); // Read file name
         name[name_length] = 0;
@@ -470,12 +536,167 @@ void CLocatorAPI::LoadArchive(archive& A, pcstr entrypoint)
         u32 ptr = 0;
         hdr->r(&ptr, sizeof(ptr)); // Obtain internal pointer to the file in archive
 
+        const u8 codec = hasCodec ? hdr->r_u8() : u8(ArchiveCodec::LZO);
+        needDictionary |= archive_entry_codec(codec) == ArchiveCodec::ZstdDict;
+
         strconcat(sizeof full, full, fs_entry_point, name);
-        Register(full, A.vfs_idx, header.crc, ptr, header.size_real, header.size_compr, 0);
+        entries.push_back(Register(full, A.vfs_idx, header.crc, ptr, header.size_real, header.size_compr, 0, codec));
     }
     hdr->close();
+
+    index_cache_save(A, table_crc, fs_entry_point, needDictionary, entries);
+    return needDictionary;
 } //-V773
 
+bool CLocatorAPI::index_cache_name(const archive& A, string_path& name)
+{
+    if (strstr(Core.Params, "-no_fs_index_cache"))
+        return false;
+
+    FS_Path* root = nullptr;
+    if (!get_path("$app_data_root$", &root))
+        return false;
+
+    const u32 crc = crc32(A.path.c_str(), A.path.size());
+    xr_sprintf(name, "%sfs_index_cache" DELIMITER "%08x.idx", root->m_Path, crc);
+    return true;
+}
+
+// Registers the entries of the archive saved by index_cache_save(), if its file table wasn't changed since then
+bool CLocatorAPI::index_cache_load(const archive& A, u32 table_crc, pcstr fs_entry_point, bool& need_dictionary)
+{
+    string_path name;
+    if (!index_cache_name(A, name) || !exist(name, FSType::External))
+        return false;
+
+    IReader* F = new CFileReader(name);
+    const auto r_name = [F]() -> pcstr
+    {
+        const intptr_t left = F->elapsed();
+        pcstr str = static_cast<pcstr>(F->pointer());
+        if (left <= 0 || !memchr(str, 0, left))
+            return nullptr;
+        F->advance(xr_strlen(str) + 1);
+        return str;
+    };
+
+    bool valid = F->length() > 2 * sizeof(u32) + 2 * sizeof(u64) && F->r_u32() == INDEX_CACHE_VERSION &&
+        F->r_u64() == A.size && F->r_u64() == A.modif && F->r_u32() == table_crc;
+
+    pcstr path = valid ? r_name() : nullptr;
+    pcstr entry_point = path ? r_name() : nullptr;
+    valid = path && entry_point && A.path == path && 0 == xr_strcmp(entry_point, fs_entry_point);
+
+    // Nothing is registered until the whole cache is validated
+    constexpr intptr_t entry_size = 4 * sizeof(u32) + sizeof(u8);
+    xr_vector<pcstr> folders;
+    xr_vector<file> entries;
+    bool dictionary = false;
+    if (valid && F->elapsed() >= intptr_t(sizeof(u8) + sizeof(u32)))
+    {
+        dictionary = F->r_u8() != 0;
+        folders.resize(F->r_u32());
+        for (pcstr& folder : folders)
+        {
+            folder = r_name();
+            if (!folder)
+            {
+                valid = false;
+                break;
+            }
+        }
+    }
+    else
+        valid = false;
+
+    if (valid && F->elapsed() >= intptr_t(sizeof(u32)))
+    {
+        entries.resize(F->r_u32());
+        for (file& desc : entries)
+        {
+            desc.name = r_name();
+            if (!desc.name || F->elapsed() < entry_size)
+            {
+                valid = false;
+                break;
+            }
+            desc.vfs = A.vfs_idx;
+            desc.crc = F->r_u32();
+            desc.ptr = F->r_u32();
+            desc.size_real = F->r_u32();
+            desc.size_compressed = F->r_u32();
+            desc.modif = 0;
+            desc.codec = F->r_u8();
+        }
+        valid = valid && F->eof();
+    }
+    else
+        valid = false;
+
+    if (valid)
+    {
+        for (pcstr folder : folders)
+            register_folder(folder);
+
+        for (file& desc : entries)
+        {
+            files_it I = file_find(desc.name);
+            if (I != m_files.end())
+            {
+                desc.name = I->name;
+                const_cast<file&>(*I) = desc;
+            }
+            else
+            {
+                desc.name = xr_strdup(desc.name);
+                file_insert(desc);
+            }
+        }
+        need_dictionary = dictionary;
+    }
+    xr_delete(F);
+    return valid;
+}
+
+void CLocatorAPI::index_cache_save(
+    const archive& A, u32 table_crc, pcstr fs_entry_point, bool need_dictionary, const xr_vector<const file*>& entries)
+{
+    string_path name;
+    if (!index_cache_name(A, name))
+        return;
+
+    CFileWriter W(name, false);
+    if (!W.valid())
+        return;
+
+    xr_vector<xr_string> folders;
+    for (const file* desc : entries)
+        for_each_folder(desc->name, [&folders](pcstr path) { folders.emplace_back(path); });
+    std::sort(folders.begin(), folders.end());
+    folders.erase(std::unique(folders.begin(), folders.end()), folders.end());
+
+    W.w_u32(INDEX_CACHE_VERSION);
+    W.w_u64(A.size);
+    W.w_u64(A.modif);
+    W.w_u32(table_crc);
+    W.w_stringZ(A.path);
+    W.w_stringZ(fs_entry_point);
+    W.w_u8(need_dictionary ? 1 : 0);
+    W.w_u32(u32(folders.size()));
+    for (const xr_string& folder : folders)
+        W.w_stringZ(folder.c_str());
+    W.w_u32(u32(entries.size()));
+    for (const file* desc : entries)
+    {
+        W.w_stringZ(desc->name);
+        W.w_u32(desc->crc);
+        W.w_u32(desc->ptr);
+        W.w_u32(desc->size_real);
+        W.w_u32(desc->size_compressed);
+        W.w_u8(desc->codec);
+    }
+}
+
 void CLocatorAPI::archive::open()
 {
 #if defined(WINDOWS)
@@ -488,6 +709,9 @@ void CLocatorAPI::archive::open()
     hSrcMap = CreateFileMapping(hSrcFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
     R_ASSERT(hSrcMap != INVALID_HANDLE_VALUE);
     size = GetFileSize(hSrcFile, nullptr);
+    FILETIME writeTime;
+    if (GetFileTime(hSrcFile, nullptr, nullptr, &writeTime))
+        modif = (u64(writeTime.dwHighDateTime) << 32) | writeTime.dwLowDateTime;
 #elif defined(LINUX) || defined(FREEBSD)
     // Open the file
     if (hSrcFile)
@@ -501,6 +725,7 @@ void CLocatorAPI::archive::open()
     struct stat file_info;
     ::fstat(hSrcFile, &file_info);
     size = file_info.st_size;
+    modif = u64(file_info.st_mtime);
 #endif
     R_ASSERT(size > 0);
 }
@@ -552,8 +777,10 @@ void CLocatorAPI::ProcessArchive(pcstr _path)
 
 void CLocatorAPI::unload_archive(CLocatorAPI::archive& A)
 {
-    files_it I = m_files.begin();
-    for (; I != m_files.end(); ++I)
+    // Background decoding may read from this archive
+    prefetch_clear();
+
+    for (files_it I = m_files.begin(); I != m_files.end(); ++I)
     {
         const file& entry = *I;
         if (entry.vfs == A.vfs_idx)
@@ -562,8 +789,8 @@ void CLocatorAPI::unload_archive(CLocatorAPI::archive& A)
             Msg("unregistering file [%s]", I->name);
 #endif // #ifndef MASTER_GOLD
             auto str = pstr(I->name);
+            file_erase(I);
             xr_free(str);
-            m_files.erase(I);
             break;
         }
     }
@@ -1027,6 +1254,7 @@ void CLocatorAPI::_initialize(u32 flags, pcstr target_folder, pcstr fs_name)
 
 void CLocatorAPI::_destroy()
 {
+    prefetch_clear();
     CloseLog();
 
     for (auto& it : m_files)
@@ -1035,6 +1263,8 @@ void CLocatorAPI::_destroy()
         xr_free(str);
     }
     m_files.clear();
+    m_files_ordered.clear();
+    m_files_ordered_valid = false;
 
     for (auto& it : m_paths)
     {
@@ -1047,6 +1277,7 @@ void CLocatorAPI::_destroy()
     for (auto& it : m_archives)
     {
         xr_delete(it.header);
+        xr_delete(it.dictionary);
         it.close();
     }
     m_archives.clear();
@@ -1118,18 +1349,16 @@ xr_vector<pstr>* CLocatorAPI::file_list_open(pcstr _path, u32 flags)
     else
         xr_strcpy(N, sizeof N, _path);
 
-    file desc;
-    desc.name = N;
-    files_it I = m_files.find(desc);
-    if (I == m_files.end())
+    if (file_find(N) == m_files.end())
         return nullptr;
 
     xr_vector<char*>* dest = new xr_vector<char*>();
 
     size_t base_len = xr_strlen(N);
-    for (++I; I != m_files.end(); ++I)
+    // the folder itself is the first entry
+    for (auto I = file_lower_bound(N) + 1; I != m_files_ordered.cend(); ++I)
     {
-        const file& entry = *I;
+        const file& entry = **I;
         if (0 != strncmp(entry.name, N, base_len))
             break; // end of list
         const char* end_symbol = entry.name + xr_strlen(entry.name) - 1;
@@ -1186,10 +1415,7 @@ size_t CLocatorAPI::file_list(FS_FileSet& dest, pcstr path, u32 flags /*= FS_Lis
     else
         xr_strcpy(N, sizeof N, path);
 
-    file desc;
-    desc.name = N;
-    files_it I = m_files.find(desc);
-    if (I == m_files.end())
+    if (file_find(N) == m_files.end())
         return 0;
 
     SStringVec masks;
@@ -1197,9 +1423,9 @@ size_t CLocatorAPI::file_list(FS_FileSet& dest, pcstr path, u32 flags /*= FS_Lis
     bool b_mask = !masks.empty();
 
     size_t base_len = xr_strlen(N);
-    for (++I; I != m_files.end(); ++I)
+    for (auto I = file_lower_bound(N) + 1; I != m_files_ordered.cend(); ++I)
     {
-        const file& entry = *I;
+        const file& entry = **I;
         if (0 != strncmp(entry.name, N, base_len))
             break; // end of list
         pcstr end_symbol = entry.name + xr_strlen(entry.name) - 1;
@@ -1382,13 +1608,34 @@ void CLocatorAPI::file_from_archive(IReader*& R, pcstr fname, const file& desc)
     if (desc.size_real == desc.size_compressed)
     {
         R = new CPackReader(ptr, ptr + ptr_offs, desc.size_real);
+
+        ScopeLock scope(m_async_lock);
+        ++A.stat_opened;
         return;
     }
 
     // Compressed
+    const ArchiveCodec codec = archive_entry_codec(desc.codec);
+    R_ASSERT4(archive_codec_supported(codec), "Archive codec isn't supported by this build", archive_codec_name(codec),
+        temp);
+
+    CTimer timer;
+    timer.Start();
     u8* dest = xr_alloc<u8>(desc.size_real);
-    rtc_decompress(dest, desc.size_real, ptr + ptr_offs, desc.size_compressed);
+    const size_t decoded = archive_entry_has_blocks(desc.codec) ?
+        archive_decompress_blocks(codec, dest, desc.size_real, ptr + ptr_offs, desc.size_compressed, A.dictionary) :
+        archive_decompress(codec, dest, desc.size_real, ptr + ptr_offs, desc.size_compressed, A.dictionary);
+    R_ASSERT3(decoded == desc.size_real, "Can't decompress file", temp);
     R = new CTempReader(dest, desc.size_real, 0);
+    {
+        const u64 decodeTime = timer.GetElapsed_ns();
+        ScopeLock scope(m_async_lock);
+        ++A.stat_opened;
+        ++A.stat_decoded;
+        A.stat_bytes_compressed += desc.size_compressed;
+        A.stat_bytes_decoded += desc.size_real;
+        A.stat_decode_time += decodeTime;
+    }
 #if defined(WINDOWS)
     UnmapViewOfFile(ptr);
 #elif defined(LINUX) || defined(FREEBSD)
@@ -1403,8 +1650,37 @@ void CLocatorAPI::file_from_archive(IReader*& R, pcstr fname, const file& desc)
 void CLocatorAPI::file_from_archive(CStreamReader*& R, pcstr fname, const file& desc)
 {
     archive& A = m_archives[desc.vfs];
-    R_ASSERT2(desc.size_compressed == desc.size_real,
-        make_string("cannot use stream reading for compressed data %s, do not compress data to be streamed", fname));
+
+    if (desc.size_compressed != desc.size_real)
+    {
+        R_ASSERT2(archive_entry_has_blocks(desc.codec),
+            make_string("cannot use stream reading for compressed data %s, compress it in blocks to be streamed", fname));
+
+        const ArchiveCodec codec = archive_entry_codec(desc.codec);
+        R_ASSERT4(archive_codec_supported(codec), "Archive codec isn't supported by this build",
+            archive_codec_name(codec), fname);
+
+        auto blocks = xr_make_shared<CStreamBlocks>();
+#if defined(WINDOWS)
+        blocks->file_mapping_handle = A.hSrcMap;
+#elif defined(LINUX) || defined(FREEBSD)
+        blocks->file_mapping_handle = A.hSrcFile;
+#endif
+        blocks->archive_size = A.size;
+        blocks->offset = desc.ptr;
+        blocks->size_compressed = desc.size_compressed;
+        blocks->size_real = desc.size_real;
+        blocks->codec = codec;
+        blocks->dictionary = A.dictionary;
+        blocks->load_table(fname);
+
+        R = new CStreamReader();
+        R->construct(blocks, 0, desc.size_real);
+
+        ScopeLock scope(m_async_lock);
+        ++A.stat_opened;
+        return;
+    }
 
     R = new CStreamReader();
 #if defined(WINDOWS)
@@ -1513,9 +1789,7 @@ bool CLocatorAPI::check_for_file(pcstr path, pcstr _fname, string_path& fname, c
         update_path(fname, path, fname);
 
     // Search entry
-    file desc_f;
-    desc_f.name = fname;
-    files_it I = m_files.find(desc_f);
+    files_it I = file_find(fname);
     if (I == m_files.end())
     {
         if (!exist(fname, FSType::External))
@@ -1534,19 +1808,26 @@ bool CLocatorAPI::check_for_file(pcstr path, pcstr _fname, string_path& fname, c
 template <typename T>
 T* CLocatorAPI::r_open_impl(pcstr path, pcstr _fname)
 {
-    T* R = nullptr;
     string_path fname;
     const file* desc = nullptr;
-    pcstr source_name = &fname[0];
 
     if (!check_for_file(path, _fname, fname, desc))
         return nullptr;
 
+    return r_open_file<T>(fname, *desc);
+}
+
+template <typename T>
+T* CLocatorAPI::r_open_file(string_path& fname, const file& desc)
+{
+    T* R = nullptr;
+    pcstr source_name = &fname[0];
+
     // OK, analyse
-    if (VFS_STANDARD_FILE == desc->vfs)
-        file_from_cache(R, fname, sizeof fname, *desc, source_name);
-    else
-        file_from_archive(R, fname, *desc);
+    if (VFS_STANDARD_FILE == desc.vfs)
+        file_from_cache(R, fname, sizeof fname, desc, source_name);
+    else if (!file_from_prefetch(R, fname))
+        file_from_archive(R, fname, desc);
 
 #ifdef DEBUG
     if (R && m_Flags.is(flBuildCopy | flReady))
@@ -1577,6 +1858,190 @@ void CLocatorAPI::r_close(CStreamReader*& fs)
     fs->close();
 }
 
+CAsyncReader* CLocatorAPI::decode_async(pcstr fname, const file& desc)
+{
+    CAsyncReader* handle = new CAsyncReader();
+    handle->name = fname;
+    handle->size = desc.size_real;
+    handle->background = true;
+
+    TaskScheduler->AddTask("CLocatorAPI::decode_async", Task::Type::Core, [this, handle, desc]()
+    {
+        file_from_archive(handle->reader, handle->name.c_str(), desc);
+        handle->done.store(true, std::memory_order_release);
+    });
+    return handle;
+}
+
+void CLocatorAPI::wait_async(const CAsyncReader& handle)
+{
+    while (!handle.ready())
+    {
+        if (!TaskScheduler->ExecuteOneTask())
+            std::this_thread::yield();
+    }
+}
+
+CAsyncReader* CLocatorAPI::take_prefetched(pcstr fname)
+{
+    ScopeLock scope(m_async_lock);
+    if (m_prefetched.empty())
+        return nullptr;
+
+    const auto it = m_prefetched.find(fname);
+    if (it == m_prefetched.end())
+        return nullptr;
+
+    CAsyncReader* handle = it->second;
+    m_prefetched.erase(it);
+    m_prefetch_bytes -= handle->size;
+    ++m_stat_prefetch_hits;
+    return handle;
+}
+
+bool CLocatorAPI::file_from_prefetch(IReader*& R, pcstr fname)
+{
+    CAsyncReader* handle = take_prefetched(fname);
+    if (!handle)
+        return false;
+
+    wait_async(*handle);
+    R = handle->reader;
+    xr_delete(handle);
+    return true;
+}
+
+CAsyncReader* CLocatorAPI::r_open_async(pcstr path, pcstr _fname)
+{
+    string_path fname;
+    const file* desc = nullptr;
+
+    if (!check_for_file(path, _fname, fname, desc))
+        return nullptr;
+
+    if (CAsyncReader* handle = take_prefetched(fname))
+        return handle;
+
+    if (!TaskScheduler || VFS_STANDARD_FILE == desc->vfs || desc->size_real == desc->size_compressed)
+    {
+        CAsyncReader* handle = new CAsyncReader();
+        handle->name = fname;
+        handle->size = desc->size_real;
+        handle->reader = r_open_file<IReader>(fname, *desc);
+        handle->done.store(true, std::memory_order_release);
+        return handle;
+    }
+
+    return decode_async(fname, *desc);
+}
+
+IReader* CLocatorAPI::r_wait(CAsyncReader*& handle)
+{
+    if (!handle)
+        return nullptr;
+
+    wait_async(*handle);
+    IReader* R = handle->reader;
+
+    // Opened immediately files are registered by r_open_file()
+    if (R && handle->background && m_Flags.test(flDumpFileActivity))
+        _register_open_file(R, handle->name.c_str());
+
+    xr_delete(handle);
+    return R;
+}
+
+void CLocatorAPI::prefetch(pcstr path, const xr_vector<shared_str>& files)
+{
+    if (!TaskScheduler)
+        return;
+
+    for (const shared_str& it : files)
+    {
+        string_path fname;
+        const file* desc = nullptr;
+
+        if (!check_for_file(path, it.c_str(), fname, desc))
+            continue;
+
+        // Nothing to decode, r_open() only maps such files.
+        // Files compressed in blocks are streamed by rs_open(), it never takes the prefetched data
+        if (VFS_STANDARD_FILE == desc->vfs || desc->size_real == desc->size_compressed ||
+            archive_entry_has_blocks(desc->codec))
+            continue;
+
+        ScopeLock scope(m_async_lock);
+        if (m_prefetched.find(fname) != m_prefetched.end())
+            continue;
+
+        if (m_prefetch_bytes + desc->size_real > PREFETCH_BUDGET)
+            continue;
+
+        CAsyncReader* handle = decode_async(fname, *desc);
+        m_prefetched.emplace(handle->name.c_str(), handle);
+        m_prefetch_bytes += handle->size;
+        ++m_stat_prefetched;
+    }
+}
+
+void CLocatorAPI::prefetch_list(pcstr path, pcstr list)
+{
+    IReader* F = r_open(path, list);
+    if (!F)
+        return;
+
+    xr_vector<shared_str> files;
+    string_path name;
+    while (!F->eof())
+    {
+        F->r_string(name, sizeof name);
+        _Trim(name);
+        if (name[0] && name[0] != ';')
+            files.emplace_back(name);
+    }
+    r_close(F);
+
+    prefetch(path, files);
+}
+
+void CLocatorAPI::prefetch_clear()
+{
+    prefetch_map pending;
+    {
+        ScopeLock scope(m_async_lock);
+        pending.swap(m_prefetched);
+        m_prefetch_bytes = 0;
+    }
+
+    for (auto& it : pending)
+    {
+        CAsyncReader* handle = it.second;
+        wait_async(*handle);
+#ifndef MASTER_GOLD
+        Msg("~ prefetched file was not used [%s]", handle->name.c_str());
+#endif
+        xr_delete(handle->reader);
+        xr_delete(handle);
+    }
+}
+
+void CLocatorAPI::dump_archive_stats()
+{
+    ScopeLock scope(m_async_lock);
+
+    Log("----archives load statistics");
+    for (const archive& A : m_archives)
+    {
+        if (!A.stat_opened)
+            continue;
+
+        Msg("[%s] opened: %u, decoded: %u (%.2f Mb -> %.2f Mb) in %.2f ms", A.path.c_str(), A.stat_opened,
+            A.stat_decoded, float(A.stat_bytes_compressed) / (1024 * 1024), float(A.stat_bytes_decoded) / (1024 * 1024),
+            float(A.stat_decode_time) / 1000000.f);
+    }
+    Msg("prefetched: %u, used: %u, pending: %u", m_stat_prefetched, m_stat_prefetch_hits, u32(m_prefetched.size()));
+}
+
 IWriter* CLocatorAPI::w_open(pcstr path, pcstr _fname)
 {
     string_path fname;
@@ -1633,14 +2098,58 @@ void CLocatorAPI::w_close(IWriter*& S)
 CLocatorAPI::files_it CLocatorAPI::file_find_it(pcstr fname)
 {
     check_pathes();
+    return file_find(fname);
+}
+
+size_t CLocatorAPI::file_hash::operator()(const file& x) const
+{
+    // FNV-1a
+    u64 hash = 14695981039346656037ull;
+    for (pcstr name = x.name; *name; ++name)
+    {
+        hash ^= u8(*name);
+        hash *= 1099511628211ull;
+    }
+    return size_t(hash);
+}
+
+CLocatorAPI::files_it CLocatorAPI::file_find(pcstr name)
+{
+    file desc;
+    desc.name = name;
+    return m_files.find(desc);
+}
+
+std::pair<CLocatorAPI::files_it, bool> CLocatorAPI::file_insert(const file& desc)
+{
+    auto result = m_files.insert(desc);
+    if (result.second)
+        m_files_ordered_valid = false;
+    return result;
+}
 
-    file desc_f;
-    string_path file_name;
-    VERIFY(xr_strlen(fname) * sizeof(char) < sizeof(file_name));
-    xr_strcpy(file_name, sizeof file_name, fname);
-    desc_f.name = file_name;
+void CLocatorAPI::file_erase(files_it it)
+{
+    // the ordered view keeps pointers to the other entries, so it may still be walked
+    m_files_ordered_valid = false;
+    m_files.erase(it);
+}
 
-    return m_files.find(desc_f);
+CLocatorAPI::files_ordered::const_iterator CLocatorAPI::file_lower_bound(pcstr name)
+{
+    if (!m_files_ordered_valid)
+    {
+        // Rebuilt after the files were added or removed, that happens in bulk on archive loading and rescans
+        m_files_ordered.clear();
+        m_files_ordered.reserve(m_files.size());
+        for (const file& entry : m_files)
+            m_files_ordered.push_back(&entry);
+        std::sort(m_files_ordered.begin(), m_files_ordered.end(),
+            [](const file* x, const file* y) { return xr_strcmp(x->name, y->name) < 0; });
+        m_files_ordered_valid = true;
+    }
+    return std::lower_bound(m_files_ordered.cbegin(), m_files_ordered.cend(), name,
+        [](const file* x, pcstr y) { return xr_strcmp(x->name, y) < 0; });
 }
 
 bool CLocatorAPI::dir_delete(pcstr initial, pcstr nm, bool remove_files)
@@ -1651,19 +2160,14 @@ bool CLocatorAPI::dir_delete(pcstr initial, pcstr nm, bool remove_files)
     else
         xr_strcpy(fpath, sizeof fpath, nm);
 
-    files_set folders;
-    files_it I;
+    xr_vector<pcstr> folders;
     // remove files
-    I = file_find_it(fpath);
-    if (I != m_files.end())
+    if (file_find_it(fpath) != m_files.end())
     {
         size_t base_len = xr_strlen(fpath);
-        for (; I != m_files.end();)
+        for (auto I = file_lower_bound(fpath); I != m_files_ordered.cend(); ++I)
         {
-            files_it cur_item = I;
-            const file& entry = *cur_item;
-            I = cur_item;
-            ++I;
+            const file& entry = **I;
             if (0 != strncmp(entry.name, fpath, base_len))
                 break; // end of list
             const char* end_symbol = entry.name + xr_strlen(entry.name) - 1;
@@ -1673,24 +2177,21 @@ bool CLocatorAPI::dir_delete(pcstr initial, pcstr nm, bool remove_files)
                 if (!remove_files)
                     return false;
                 xr_unlink(entry.name);
-                m_files.erase(cur_item);
+                file_erase(file_find(entry.name));
             }
             else
             {
-                folders.insert(entry);
+                folders.push_back(entry.name);
             }
         }
     }
-    // remove folders
-    files_set::reverse_iterator r_it = folders.rbegin();
-    for (; r_it != folders.rend(); ++r_it)
+    // remove folders, the nested ones first
+    for (auto r_it = folders.rbegin(); r_it != folders.rend(); ++r_it)
     {
-        const char* end_symbol = r_it->name + xr_strlen(r_it->name) - 1;
-        if (*end_symbol == _DELIMITER)
-        {
-            _rmdir(r_it->name);
-            m_files.erase(*r_it);
-        }
+        _rmdir(*r_it);
+        const files_it it = file_find(*r_it);
+        if (it != m_files.end())
+            file_erase(it);
     }
     return true;
 }
@@ -1709,8 +2210,8 @@ void CLocatorAPI::file_delete(pcstr path, pcstr nm)
         // remove file
         xr_unlink(I->name);
         auto str = pstr(I->name);
+        file_erase(I);
         xr_free(str);
-        m_files.erase(I);
     }
 }
 
@@ -1744,18 +2245,18 @@ void CLocatorAPI::file_rename(pcstr src, pcstr dest, bool overwrite)
                 return;
             xr_unlink(D->name);
             auto str = pstr(D->name);
+            file_erase(D);
             xr_free(str);
-            m_files.erase(D);
         }
 
         file new_desc = *S;
         // remove existing item
         auto str = pstr(S->name);
+        file_erase(S);
         xr_free(str);
-        m_files.erase(S);
         // insert updated item
         new_desc.name = xr_strdup(dest);
-        m_files.insert(new_desc);
+        file_insert(new_desc);
 
         // physically rename file
         VerifyPath(dest);
@@ -1867,19 +2368,14 @@ void CLocatorAPI::set_file_age(pcstr nm, u32 age)
 
 void CLocatorAPI::rescan_path(pcstr full_path, bool bRecurse)
 {
-    file desc;
-    desc.name = full_path;
-    files_it I = m_files.lower_bound(desc);
-    if (I == m_files.end())
+    auto I = file_lower_bound(full_path);
+    if (I == m_files_ordered.cend())
         return;
 
     size_t base_len = xr_strlen(full_path);
-    for (; I != m_files.end();)
+    for (; I != m_files_ordered.cend(); ++I)
     {
-        files_it cur_item = I;
-        const file& entry = *cur_item;
-        I = cur_item;
-        ++I;
+        const file& entry = **I;
         if (0 != strncmp(entry.name, full_path, base_len))
             break; // end of list
         if (entry.vfs != VFS_STANDARD_FILE)
@@ -1888,9 +2384,9 @@ void CLocatorAPI::rescan_path(pcstr full_path, bool bRecurse)
         if (!bRecurse && strchr(entry_begin, _DELIMITER))
             continue;
         // erase item
-        auto str = pstr(cur_item->name);
+        auto str = pstr(entry.name);
+        file_erase(file_find(str));
         xr_free(str);
-        m_files.erase(cur_item);
     }
     bNoRecurse = !bRecurse;
     Recurse(full_path);
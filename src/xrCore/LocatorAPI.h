@@ -10,10 +10,13 @@
 #include "LocatorAPI_defs.h"
 //#include "xrCore/Threading/Lock.hpp"
 #include "xrCommon/xr_map.h"
+#include "xrCommon/xr_unordered_set.h"
 #include "xrCommon/xr_smart_pointers.h"
 #include "xrCommon/predicates.h"
 #include "Common/Noncopyable.hpp"
 
+#include <atomic>
+
 #if defined(LINUX) || defined(FREEBSD)
 #include <stdint.h>
 #define _A_HIDDEN      0x02
@@ -52,6 +55,22 @@ struct _finddata32_t
 
 class CStreamReader;
 class Lock;
+class ArchiveDictionary;
+
+// Handle of the file being decoded in background, see CLocatorAPI::r_open_async()
+class XRCORE_API CAsyncReader : Noncopyable
+{
+    friend class CLocatorAPI;
+
+    shared_str name;
+    IReader* reader = nullptr;
+    u32 size = 0; // decoded size
+    bool background = false;
+    std::atomic_bool done{ false };
+
+public:
+    bool ready() const { return done.load(std::memory_order_acquire); }
+};
 
 enum class FSType
 {
@@ -94,11 +113,13 @@ public:
         u32 size_real; //
         u32 size_compressed; // if (size_real==size_compressed) - uncompressed
         u32 modif; // for editor
+        u8 codec; // ArchiveCodec of compressed archived file
     };
 
     struct archive
     {
         size_t size = 0;
+        u64 modif = 0; // last write time, to validate the index cache
         size_t vfs_idx = size_t(-1);
         shared_str path;
 #if defined(WINDOWS)
@@ -108,7 +129,15 @@ public:
         int hSrcFile = 0;
 #endif
         CInifile* header = nullptr;
-        
+        ArchiveDictionary* dictionary = nullptr;
+
+        // Load statistics, guarded by CLocatorAPI::m_async_lock
+        u32 stat_opened = 0;
+        u32 stat_decoded = 0;
+        u64 stat_bytes_compressed = 0;
+        u64 stat_bytes_decoded = 0;
+        u64 stat_decode_time = 0; // ns
+
         archive() = default;
         void open();
         void close();
@@ -129,16 +158,24 @@ public:
     void LoadArchive(archive& A, pcstr entrypoint = nullptr);
 
 private:
-    struct file_pred
+    using PathMap = xr_map<pcstr, FS_Path*, pred_str>;
+    PathMap m_paths;
+
+    struct file_hash
     {
-        bool operator()(const file& x, const file& y) const { return xr_strcmp(x.name, y.name) < 0; }
+        size_t operator()(const file& x) const;
     };
 
-    using PathMap = xr_map<pcstr, FS_Path*, pred_str>;
-    PathMap m_paths;
+    struct file_equal
+    {
+        bool operator()(const file& x, const file& y) const { return 0 == xr_strcmp(x.name, y.name); }
+    };
 
-    using files_set = xr_set<file, file_pred>;
+    // Exact name lookups go to the hash set,
+    // the ordered view is built on demand to enumerate folders
+    using files_set = xr_unordered_set<file, file_hash, file_equal>;
     using files_it = files_set::iterator;
+    using files_ordered = xr_vector<const file*>;
 
     using FFVec = xr_vector<_finddata_t>;
     FFVec rec_files;
@@ -147,18 +184,44 @@ private:
     void check_pathes();
 
     files_set m_files;
+    files_ordered m_files_ordered; // sorted by name, valid if m_files_ordered_valid
+    bool m_files_ordered_valid;
     bool bNoRecurse;
 
     Lock* m_auth_lock;
     u64 m_auth_code;
 
+    // Files decoded in background and not opened yet, the key is CAsyncReader::name
+    using prefetch_map = xr_map<pcstr, CAsyncReader*, pred_str>;
+    prefetch_map m_prefetched;
+    size_t m_prefetch_bytes;
+    u32 m_stat_prefetched;
+    u32 m_stat_prefetch_hits;
+    Lock* m_async_lock;
+
     const file* RegisterExternal(pcstr name);
-    const file* Register(pcstr name, size_t vfs, u32 crc, u32 ptr, u32 size_real, u32 size_compressed, u32 modif);
+    const file* Register(
+        pcstr name, size_t vfs, u32 crc, u32 ptr, u32 size_real, u32 size_compressed, u32 modif, u8 codec = 0);
+    template <typename F>
+    void for_each_folder(pcstr name, F&& f);
+    void register_folder(pcstr path);
     void ProcessArchive(pcstr path);
     void ProcessOne(pcstr path, const _finddata_t& entry);
     bool Recurse(pcstr path);
 
     files_it file_find_it(pcstr n);
+    files_it file_find(pcstr name);
+    std::pair<files_it, bool> file_insert(const file& desc);
+    void file_erase(files_it it);
+    // The first entry of the ordered view not less than the name
+    files_ordered::const_iterator file_lower_bound(pcstr name);
+
+    bool LoadArchiveTable(archive& A, u32 table_crc, pcstr fs_entry_point, u8* table, size_t table_size,
+        bool table_compressed, bool shouldDecrypt);
+    bool index_cache_name(const archive& A, string_path& name);
+    bool index_cache_load(const archive& A, u32 table_crc, pcstr fs_entry_point, bool& need_dictionary);
+    void index_cache_save(const archive& A, u32 table_crc, pcstr fs_entry_point, bool need_dictionary,
+        const xr_vector<const file*>& entries);
 
 public:
     enum : u32
@@ -189,6 +252,12 @@ private:
     void file_from_archive(IReader*& R, pcstr fname, const file& desc);
     void file_from_archive(CStreamReader*& R, pcstr fname, const file& desc);
 
+    CAsyncReader* decode_async(pcstr fname, const file& desc);
+    void wait_async(const CAsyncReader& handle);
+    CAsyncReader* take_prefetched(pcstr fname);
+    bool file_from_prefetch(IReader*& R, pcstr fname);
+    bool file_from_prefetch(CStreamReader*& R, pcstr fname) { return false; }
+
     void copy_file_to_build(IWriter* W, IReader* r);
     void copy_file_to_build(IWriter* W, CStreamReader* r);
     template <typename T>
@@ -198,6 +267,8 @@ private:
 
     template <typename T>
     T* r_open_impl(pcstr path, pcstr _fname);
+    template <typename T>
+    T* r_open_file(string_path& fname, const file& desc);
 
     void setup_fs_path(pcstr fs_name, string_path& fs_path);
     void setup_fs_path(pcstr fs_name);
@@ -215,6 +286,23 @@ public:
     void r_close(IReader*& S);
     void r_close(CStreamReader*& fs);
 
+    // Compressed archived files are decoded on the task workers,
+    // the others are opened immediately. Returns nullptr if there is no such file.
+    CAsyncReader* r_open_async(pcstr initial, pcstr N);
+    // Waits for the file (executing other tasks meanwhile),
+    // releases the handle and returns the reader (close it with r_close())
+    IReader* r_wait(CAsyncReader*& handle);
+
+    // Starts background decoding of the files, so the following
+    // r_open() calls get already decoded data. Missing files are skipped.
+    void prefetch(pcstr initial, const xr_vector<shared_str>& files);
+    // Same for the list file with one file name per line
+    void prefetch_list(pcstr initial, pcstr list);
+    // Waits for the started decoding and frees the data nobody has opened
+    void prefetch_clear();
+
+    void dump_archive_stats();
+
     IWriter* w_open(pcstr initial, pcstr N);
     IWriter* w_open(pcstr N) { return w_open(nullptr, N); }
     IWriter* w_open_ex(pcstr initial, pcstr N);
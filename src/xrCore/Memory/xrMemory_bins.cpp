@@ -0,0 +1,159 @@
+#include "stdafx.h"
+
+#include "xrMemory_bins.h"
+
+#include <atomic>
+#include <thread>
+
+namespace xrMemoryBins
+{
+namespace
+{
+constexpr size_t CHUNK_SIZE = 64 * 1024;
+constexpr u32 CACHE_BATCH = 32; // blocks moved between thread cache and shared list at once
+constexpr u32 CACHE_LIMIT = 2 * CACHE_BATCH;
+
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+// Can't use Lock here: it allocates memory itself
+struct SpinLock
+{
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+
+    void lock()
+    {
+        while (flag.test_and_set(std::memory_order_acquire))
+            std::this_thread::yield();
+    }
+
+    void unlock() { flag.clear(std::memory_order_release); }
+};
+
+struct SharedBin
+{
+    SpinLock lock;
+    FreeBlock* head = nullptr;
+    u8* cursor = nullptr;
+    size_t left = 0;
+};
+
+SharedBin shared[BINS_COUNT];
+std::atomic<size_t> reservedBytes{ 0 };
+
+struct ThreadCache
+{
+    FreeBlock* head[BINS_COUNT] = {};
+    u32 count[BINS_COUNT] = {};
+
+    ~ThreadCache() { flush(); }
+
+    void flush()
+    {
+        for (u16 bin = 0; bin < BINS_COUNT; ++bin)
+        {
+            if (!head[bin])
+                continue;
+
+            FreeBlock* tail = head[bin];
+            while (tail->next)
+                tail = tail->next;
+
+            SharedBin& S = shared[bin];
+            S.lock.lock();
+            tail->next = S.head;
+            S.head = head[bin];
+            S.lock.unlock();
+
+            head[bin] = nullptr;
+            count[bin] = 0;
+        }
+    }
+};
+
+thread_local ThreadCache cache;
+
+// Moves up to CACHE_BATCH blocks from the shared bin to the thread cache
+void refill(u16 bin)
+{
+    const size_t size = bin_size(bin);
+    SharedBin& S = shared[bin];
+
+    S.lock.lock();
+    u32 moved = 0;
+    while (moved < CACHE_BATCH)
+    {
+        FreeBlock* block = S.head;
+        if (block)
+            S.head = block->next;
+        else
+        {
+            if (S.left < size)
+            {
+                S.cursor = (u8*)malloc(CHUNK_SIZE);
+                R_ASSERT2(S.cursor, "Out of memory in small-object bins");
+                S.left = CHUNK_SIZE;
+                reservedBytes.fetch_add(CHUNK_SIZE, std::memory_order_relaxed);
+            }
+            block = (FreeBlock*)S.cursor;
+            S.cursor += size;
+            S.left -= size;
+        }
+
+        block->next = cache.head[bin];
+        cache.head[bin] = block;
+        ++moved;
+    }
+    S.lock.unlock();
+
+    cache.count[bin] += moved;
+}
+
+// Returns CACHE_BATCH blocks from the thread cache to the shared bin
+void drain(u16 bin)
+{
+    FreeBlock* first = cache.head[bin];
+    FreeBlock* last = first;
+    for (u32 i = 1; i < CACHE_BATCH; ++i)
+        last = last->next;
+
+    cache.head[bin] = last->next;
+    cache.count[bin] -= CACHE_BATCH;
+
+    SharedBin& S = shared[bin];
+    S.lock.lock();
+    last->next = S.head;
+    S.head = first;
+    S.lock.unlock();
+}
+} // namespace
+
+void* alloc(u16 bin)
+{
+    VERIFY(bin < BINS_COUNT);
+    if (!cache.head[bin])
+        refill(bin);
+
+    FreeBlock* block = cache.head[bin];
+    cache.head[bin] = block->next;
+    --cache.count[bin];
+    return block;
+}
+
+void free(void* ptr, u16 bin)
+{
+    VERIFY(bin < BINS_COUNT);
+    FreeBlock* block = (FreeBlock*)ptr;
+    block->next = cache.head[bin];
+    cache.head[bin] = block;
+
+    if (++cache.count[bin] > CACHE_LIMIT)
+        drain(bin);
+}
+
+void flush_thread_cache() { cache.flush(); }
+
+size_t reserved() { return reservedBytes.load(std::memory_order_relaxed); }
+} // namespace xrMemoryBins
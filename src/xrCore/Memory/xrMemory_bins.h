@@ -0,0 +1,35 @@
+#pragma once
+
+/*
+ * Thread-caching small-object allocator.
+ * Blocks up to MAX_BIN_SIZE bytes are grouped into size classes (bins).
+ * Every thread keeps a short free list per bin and exchanges blocks
+ * with the shared bin lists in batches, so most allocations and frees
+ * don't take any lock. Memory of the bins is never returned to the system.
+ */
+namespace xrMemoryBins
+{
+constexpr size_t BIN_GRANULARITY = 16;
+constexpr size_t MAX_BIN_SIZE = 512;
+constexpr u16 BINS_COUNT = MAX_BIN_SIZE / BIN_GRANULARITY;
+constexpr u16 NO_BIN = u16(-1);
+
+// Returns bin index for the block of given size or NO_BIN if it's too big
+inline u16 bin_for(size_t size)
+{
+    if (size == 0 || size > MAX_BIN_SIZE)
+        return NO_BIN;
+    return u16((size + BIN_GRANULARITY - 1) / BIN_GRANULARITY - 1);
+}
+
+inline size_t bin_size(u16 bin) { return (size_t(bin) + 1) * BIN_GRANULARITY; }
+
+void* alloc(u16 bin);
+void free(void* ptr, u16 bin);
+
+// Returns blocks cached by the calling thread to the shared lists
+void flush_thread_cache();
+
+// Bytes reserved from the system for all bins
+size_t reserved();
+} // namespace xrMemoryBins
@@ -0,0 +1,35 @@
+#include "stdafx.h"
+#include "SharedLock.hpp"
+#ifndef WINDOWS
+#include <shared_mutex>
+#endif
+
+struct SharedLockImpl
+{
+#ifdef WINDOWS
+    SRWLOCK lock;
+
+    SharedLockImpl() { InitializeSRWLock(&lock); }
+
+    ICF void Lock() { AcquireSRWLockExclusive(&lock); }
+    ICF void Unlock() { ReleaseSRWLockExclusive(&lock); }
+    ICF void LockShared() { AcquireSRWLockShared(&lock); }
+    ICF void UnlockShared() { ReleaseSRWLockShared(&lock); }
+#else
+    std::shared_mutex mutex;
+
+    ICF void Lock() { mutex.lock(); }
+    ICF void Unlock() { mutex.unlock(); }
+    ICF void LockShared() { mutex.lock_shared(); }
+    ICF void UnlockShared() { mutex.unlock_shared(); }
+#endif
+};
+
+SharedLock::SharedLock() : impl(new SharedLockImpl) {}
+SharedLock::~SharedLock() { delete impl; }
+
+void SharedLock::Enter() { impl->Lock(); }
+void SharedLock::Leave() { impl->Unlock(); }
+
+void SharedLock::EnterShared() { impl->LockShared(); }
+void SharedLock::LeaveShared() { impl->UnlockShared(); }
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "Common/Noncopyable.hpp"
+
+// Readers-writer lock: any number of shared owners or one exclusive owner.
+// Unlike Lock, it isn't recursive.
+class XRCORE_API SharedLock : Noncopyable
+{
+    struct SharedLockImpl* impl;
+
+public:
+    SharedLock();
+    ~SharedLock();
+
+    void Enter();
+    void Leave();
+
+    void EnterShared();
+    void LeaveShared();
+};
@@ -3,23 +3,69 @@
 #include "Task.hpp"
 #include "TaskManager.hpp"
 
-Task::Task(pcstr name, Type type, TaskFunc task, IsAllowedCallback allowed /*= nullptr*/, DoneCallback done /*= nullptr*/)
-    : isExecutionAllowed(allowed), onTaskDone(done), task(task), name(name), type(type), isStarted(false)
+Task::Task()
+    : parent(nullptr), continuations{}, continuationsCount(0), unfinishedJobs(0),
+      name(nullptr), type(Type::Other), isStarted(false), isPushed(false), inUse(false), references(0)
+{
+}
+
+void Task::Initialize(pcstr name, Type type, TaskFunc task, Task* parent,
+    IsAllowedCallback allowed, DoneCallback done)
 {
     R_ASSERT2(name && xr_strlen(name) > 1, "Please, specify task name!");
+
+    this->isExecutionAllowed = allowed;
+    this->onTaskDone = done;
+    this->task = task;
+    this->parent = parent;
+    this->name = name;
+    this->type = type;
+
+    continuationsCount.store(0, std::memory_order_relaxed);
+    unfinishedJobs.store(1, std::memory_order_relaxed);
+    isStarted.store(false, std::memory_order_relaxed);
+    isPushed.store(false, std::memory_order_relaxed);
+    references.store(1, std::memory_order_relaxed);
+
+    if (parent)
+        parent->unfinishedJobs.fetch_add(1, std::memory_order_relaxed);
 }
 
-tbb::task* Task::execute()
+void Task::Execute()
 {
     timer.Start();
-    isStarted = true;
+    isStarted.store(true, std::memory_order_relaxed);
 
-    task();
+    if (task)
+        task();
 
     if (onTaskDone)
         onTaskDone();
 
     TaskScheduler->TaskDone(this, timer.GetElapsed_ms());
 
-    return nullptr;
+    Finish();
+}
+
+void Task::Finish()
+{
+    const int left = unfinishedJobs.fetch_sub(1, std::memory_order_acq_rel) - 1;
+    if (left > 0)
+        return;
+
+    if (parent)
+        parent->Finish();
+
+    const int count = continuationsCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i)
+        TaskScheduler->PushTask(continuations[i]);
+
+    Release();
+}
+
+void Task::Release()
+{
+    // Slot can be reused from now
+    if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        inUse.store(false, std::memory_order_release);
 }
@@ -3,10 +3,12 @@
 #include "xrCore/xrDelegate/xrDelegate.h"
 #include "xrCore/FTimer.h"
 
-#include <tbb/task.h>
+#include <atomic>
 
-class XRCORE_API Task : public tbb::task
+class XRCORE_API Task
 {
+    friend class TaskManagerBase;
+
 public:
     enum class Type
     {
@@ -30,18 +32,44 @@ public:
     using DoneCallback = xrDelegate<void()>;
     using TaskFunc = xrDelegate<void()>;
 
+    // Continuations are pushed when the task (and all its children) is finished
+    static constexpr size_t MAX_CONTINUATIONS = 8;
+
 private:
     IsAllowedCallback isExecutionAllowed;
     DoneCallback onTaskDone;
     TaskFunc task;
     CTimer timer;
 
+    Task* parent;
+    Task* continuations[MAX_CONTINUATIONS];
+    std::atomic_int continuationsCount;
+    // The task itself plus its unfinished children
+    std::atomic_int unfinishedJobs;
+
     pcstr name;
     Type type;
-    bool isStarted;
+    std::atomic_bool isStarted;
+    std::atomic_bool isPushed;
+    // Slot is owned by a task that is not finished yet or is held
+    std::atomic_bool inUse;
+    // Execution plus the holders, see TaskManagerBase::Hold()
+    std::atomic_int references;
+
+    void Initialize(pcstr name, Type type, TaskFunc task, Task* parent,
+        IsAllowedCallback allowed, DoneCallback done);
+
+    // Called by the worker thread which picked the task up
+    void Execute();
+
+    // Decrements unfinished jobs counter, notifies parent and pushes continuations
+    void Finish();
+
+    // Frees the slot when nobody refers to the task anymore
+    void Release();
 
 public:
-    Task(pcstr name, Type type, TaskFunc task, IsAllowedCallback allowed = nullptr, DoneCallback done = nullptr);
+    Task();
 
     pcstr GetName() const
     {
@@ -53,9 +81,19 @@ public:
         return type;
     }
 
+    Task* GetParent() const
+    {
+        return parent;
+    }
+
     bool IsStarted() const
     {
-        return isStarted;
+        return isStarted.load(std::memory_order_relaxed);
+    }
+
+    bool IsFinished() const
+    {
+        return unfinishedJobs.load(std::memory_order_acquire) <= 0;
     }
 
     virtual bool IsComplex()
@@ -74,6 +112,4 @@ public:
     {
         return timer.GetElapsed_ms();
     }
-
-    tbb::task* execute() override;
 };
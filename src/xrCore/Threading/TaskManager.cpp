@@ -9,7 +9,30 @@
 
 xr_unique_ptr<TaskManagerBase> TaskScheduler;
 
-TaskManagerBase::TaskManagerBase() : taskerSleepTime(2), shouldStop(true) {}
+static_assert((TASK_POOL_SIZE & (TASK_POOL_SIZE - 1)) == 0, "TASK_POOL_SIZE must be power of two");
+
+namespace
+{
+// Index of the queue owned by the current thread, -1 for non-worker threads
+thread_local s32 s_tl_queue = -1;
+
+struct WorkerStartupInfo
+{
+    TaskManagerBase* manager;
+    s32 queue;
+};
+} // namespace
+
+TaskManagerBase::TaskManagerBase()
+    : taskPool(nullptr), allocatedTasks(0), workersCount(0), deferredCount(0), sleepingWorkers(0),
+      aliveWorkers(0), pendingTasks(0), shouldStop(true), statExecuted(0), statStolen(0), statDeferred(0)
+{
+}
+
+TaskManagerBase::~TaskManagerBase()
+{
+    Destroy();
+}
 
 void TaskManagerBase::Initialize()
 {
@@ -17,8 +40,25 @@ void TaskManagerBase::Initialize()
         return;
 
     shouldStop = false;
-    Threading::SpawnThread(taskManagerThread, "X-Ray Task Scheduler thread", 0, this);
-    Threading::SpawnThread(taskWatcherThread, "X-Ray Task Watcher thread", 0, this);
+
+    const u32 threads = std::thread::hardware_concurrency();
+    workersCount = threads > 1 ? threads - 1 : 1;
+
+    taskPool = new Task[TASK_POOL_SIZE];
+
+    // Caller's queue + workers' queues + shared queue
+    queues.resize(workersCount + 2);
+    for (TaskQueue*& queue : queues)
+        queue = new TaskQueue();
+
+    s_tl_queue = 0;
+
+    for (u32 i = 1; i <= workersCount; ++i)
+    {
+        ++aliveWorkers;
+        Threading::SpawnThread(taskWorkerThread, "X-Ray Task Worker thread", 0,
+            new WorkerStartupInfo{ this, static_cast<s32>(i) });
+    }
 }
 
 void TaskManagerBase::Destroy()
@@ -27,219 +67,326 @@ void TaskManagerBase::Destroy()
         return;
 
     shouldStop = true;
-    mainThreadExit.Wait();
-    watcherThreadExit.Wait();
+    while (aliveWorkers.load() > 0)
+    {
+        newWorkEvent.Set();
+        workersExit.Wait(WORKER_DEFERRED_SLEEP_TIME);
+    }
+
+    s_tl_queue = -1;
+
+    for (TaskQueue*& queue : queues)
+        xr_delete(queue);
+    queues.clear();
+
+    deferredTasks.clear();
+    deferredCount = 0;
+    pendingTasks = 0;
+
+    delete[] taskPool;
+    taskPool = nullptr;
 }
 
 bool TaskManagerBase::TaskQueueIsEmpty() const
 {
-    return tasks.empty() && tasksInExecution.empty();
+    return pendingTasks.load(std::memory_order_acquire) == 0;
 }
 
-void TaskManagerBase::taskManagerThread(void* thisPtr)
+void TaskManagerBase::taskWorkerThread(void* startupInfo)
 {
-    TaskManagerBase& self = *static_cast<TaskManagerBase*>(thisPtr);
+    const WorkerStartupInfo info = *static_cast<WorkerStartupInfo*>(startupInfo);
+    delete static_cast<WorkerStartupInfo*>(startupInfo);
+
+    TaskManagerBase& self = *info.manager;
+    s_tl_queue = info.queue;
 
+    u32 spins = 0;
     while (!self.shouldStop)
     {
-        self.lock.Enter();
-        if (self.tasks.empty())
+        if (self.ExecuteOneTask())
         {
-            self.lock.Leave();
-            Sleep(self.taskerSleepTime);
+            spins = 0;
             continue;
         }
 
-        for (Task* task : self.tasks)
+        if (++spins < WORKER_SPIN_COUNT)
         {
-            if (task->CheckIfExecutionAllowed())
-            {
-                self.SpawnTask(task);
-                break; // Iterators are invalid now, we should break here
-            }
+            std::this_thread::yield();
+            continue;
         }
-        self.lock.Leave();
+
+        ++self.sleepingWorkers;
+        self.newWorkEvent.Wait(self.deferredCount ? WORKER_DEFERRED_SLEEP_TIME : WORKER_SLEEP_TIME);
+        --self.sleepingWorkers;
+        spins = 0;
     }
-    self.mainThreadExit.Set();
+
+    --self.aliveWorkers;
+    self.workersExit.Set();
 }
 
-void TaskManagerBase::taskWatcherThread(void* thisPtr)
+TaskManagerBase::TaskQueue& TaskManagerBase::GetQueue()
 {
-    TaskManagerBase& self = *static_cast<TaskManagerBase*>(thisPtr);
-    bool calmDown = false;
+    if (s_tl_queue >= 0)
+        return *queues[s_tl_queue];
+    return *queues.back();
+}
 
-    while (!self.shouldStop)
+Task* TaskManagerBase::AllocateTask()
+{
+    for (u32 attempt = 0; attempt < TASK_POOL_SIZE; ++attempt)
     {
-        self.executionLock.Enter();
-        if (self.tasksInExecution.empty())
-        {
-            self.executionLock.Leave();
-            Sleep(WATCHER_CALM_DOWN_PERIOD);
-            continue;
-        }
+        const u32 index = allocatedTasks.fetch_add(1, std::memory_order_relaxed) & (TASK_POOL_SIZE - 1);
+        Task& task = taskPool[index];
 
-#ifndef MASTER_GOLD
-        for (Task* task : self.tasksInExecution)
-        {
-            if (!task->IsStarted())
-                continue;
-
-            const u64 time = task->GetElapsedMs();
-
-            if (time > ABNORMAL_EXECUTION_TIME)
-            {
-                calmDown = true;
-                Msg("! Abnormal task execution time [%dms] in [ %s ]", time, task->GetName());
-            }
-
-#ifdef PROFILE_TASKS
-            bool tooLong;
-            bool veryLong;
-
-            else if (task->IsComplex())
-            {
-                tooLong = time > COMPLEX_TASK_ACCEPTABLE_EXECUTION_TIME;
-                veryLong = time > COMPLEX_TASK_ACCEPTABLE_EXECUTION_TIME * 2;
-            }
-            else
-            {
-                tooLong = time > SIMPLE_TASK_ACCEPTABLE_EXECUTION_TIME;
-                veryLong = time > SIMPLE_TASK_ACCEPTABLE_EXECUTION_TIME * 2;
-            }
-
-            if (veryLong)
-            {
-                calmDown = true;
-                Msg("! Task [%s] runs too long %dms", task->GetName(), time);
-            }
-            else if (tooLong)
-            {
-                calmDown = true;
-                Msg("~ Task [%s] runs very long %dms", task->GetName(), time);
-            }
-#endif // PROFILE_TASKS
-        }
-#endif // MASTER_GOLD
-        self.executionLock.Leave();
-        if (calmDown)
-        {
-            Sleep(WATCHER_CALM_DOWN_PERIOD);
-            calmDown = false;
-        }
+        bool expected = false;
+        if (task.inUse.compare_exchange_strong(expected, true, std::memory_order_acquire))
+            return &task;
     }
 
-    // Wait until last task is done
-    while (true)
-    {
-        ScopeLock scope(&self.executionLock);
-        
-        if (self.tasksInExecution.empty())
-            break;
+    FATAL("Task pool is exhausted. Too many unfinished tasks.");
+    return nullptr;
+}
 
-        Sleep(WATCHER_CALM_DOWN_PERIOD);
-    }
+Task* TaskManagerBase::CreateTask(pcstr name, Task::Type type, Task::TaskFunc taskFunc, Task* parent /*= nullptr*/,
+    Task::IsAllowedCallback allowed /*= nullptr*/, Task::DoneCallback done /*= nullptr*/)
+{
+    Task* task = AllocateTask();
+    task->Initialize(name, type, taskFunc, parent, allowed, done);
+    return task;
+}
 
-    self.watcherThreadExit.Set();
+void TaskManagerBase::AddContinuation(Task& predecessor, Task& continuation)
+{
+    R_ASSERT3(!predecessor.isPushed, "Continuation must be added before the task is pushed", predecessor.GetName());
+
+    const int index = predecessor.continuationsCount.fetch_add(1, std::memory_order_relaxed);
+    R_ASSERT3(index < Task::MAX_CONTINUATIONS, "Too many continuations for the task", predecessor.GetName());
+
+    predecessor.continuations[index] = &continuation;
 }
 
-void TaskManagerBase::AddTask(pcstr name, Task::Type type, Task::TaskFunc taskFunc,
-    Task::IsAllowedCallback callback, Task::DoneCallback done /*= nullptr*/)
+void TaskManagerBase::Hold(Task& task)
 {
-    Task* task = new (tbb::task::allocate_root()) Task(name, type, taskFunc, callback, done);
+    R_ASSERT3(!task.isPushed, "Task must be held before it is pushed", task.GetName());
+    task.references.fetch_add(1, std::memory_order_relaxed);
+}
 
-    lock.Enter();
-    tasks.push_back(task);
-    lock.Leave();
+void TaskManagerBase::Release(Task& task)
+{
+    VERIFY(task.IsFinished());
+    task.Release();
 }
 
-void TaskManagerBase::RemoveTasksWithName(pcstr name)
+void TaskManagerBase::PushTask(Task* task)
 {
-    ScopeLock scope(&lock);
+    VERIFY(task && !task->isPushed);
+    task->isPushed.store(true, std::memory_order_relaxed);
+    ++pendingTasks;
 
-    for (Task* task : tasks)
+    if (!task->CheckIfExecutionAllowed())
+    {
+        ScopeLock scope(&deferredLock);
+        deferredTasks.push_back(task);
+        ++deferredCount;
+        ++statDeferred;
+    }
+    else
     {
-        if (0 == xr_strcmp(name, task->GetName()))
-            Task::destroy(*task);
+        TaskQueue& queue = GetQueue();
+        ScopeLock scope(&queue.lock);
+        queue.tasks.push_back(task);
     }
 
-    xr_vector<Task*>::iterator it;
+    WakeUpWorker();
+}
+
+Task* TaskManagerBase::AddTask(pcstr name, Task::Type type, Task::TaskFunc taskFunc,
+    Task::IsAllowedCallback callback /*= nullptr*/, Task::DoneCallback done /*= nullptr*/)
+{
+    Task* task = CreateTask(name, type, taskFunc, nullptr, callback, done);
+    PushTask(task);
+    return task;
+}
+
+void TaskManagerBase::WakeUpWorker()
+{
+    if (sleepingWorkers.load(std::memory_order_relaxed) > 0)
+        newWorkEvent.Set();
+}
+
+Task* TaskManagerBase::PopTask()
+{
+    TaskQueue& queue = GetQueue();
+    ScopeLock scope(&queue.lock);
+
+    if (queue.tasks.empty())
+        return nullptr;
+
+    Task* task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return task;
+}
+
+Task* TaskManagerBase::StealTask()
+{
+    const size_t count = queues.size();
+    const size_t self = s_tl_queue >= 0 ? s_tl_queue : count - 1;
 
-    const auto search = [&]()
+    for (size_t i = 1; i < count; ++i)
     {
-        it = std::find_if(tasks.begin(), tasks.end(), [&](Task* task)
+        TaskQueue& victim = *queues[(self + i) % count];
+        if (!victim.lock.TryEnter())
+            continue;
+
+        Task* task = nullptr;
+        if (!victim.tasks.empty())
         {
-            return 0 == xr_strcmp(name, task->GetName());
-        });
-        return it;
-    };
+            task = victim.tasks.front();
+            victim.tasks.pop_front();
+        }
+        victim.lock.Leave();
 
-    while (search() != tasks.end())
-    {
-        tasks.erase(it);
+        if (task)
+        {
+            ++statStolen;
+            return task;
+        }
     }
+    return nullptr;
 }
 
-void TaskManagerBase::RemoveTasksWithType(Task::Type type)
+Task* TaskManagerBase::TakeDeferredTask()
 {
-    ScopeLock scope(&lock);
+    if (!deferredCount.load(std::memory_order_relaxed))
+        return nullptr;
 
-    for (Task* task : tasks)
+    if (!deferredLock.TryEnter())
+        return nullptr;
+
+    Task* result = nullptr;
+    for (auto it = deferredTasks.begin(); it != deferredTasks.end(); ++it)
     {
-        if (task->GetType() == type)
-            Task::destroy(*task);
+        if ((*it)->CheckIfExecutionAllowed())
+        {
+            result = *it;
+            deferredTasks.erase(it);
+            --deferredCount;
+            break;
+        }
     }
+    deferredLock.Leave();
+    return result;
+}
 
-    xr_vector<Task*>::iterator it;
+bool TaskManagerBase::ExecuteOneTask()
+{
+    Task* task = PopTask();
+    if (!task)
+        task = StealTask();
+    if (!task)
+        task = TakeDeferredTask();
+    if (!task)
+        return false;
+
+    ExecuteTask(task);
+    return true;
+}
+
+void TaskManagerBase::ExecuteTask(Task* task)
+{
+    task->Execute();
+    ++statExecuted;
+    --pendingTasks;
+}
+
+void TaskManagerBase::CancelTask(Task* task)
+{
+    // Parent and continuations should not wait forever
+    task->Finish();
+    --pendingTasks;
+}
 
-    const auto search = [&]()
+void TaskManagerBase::Wait(const Task& task)
+{
+    while (!task.IsFinished())
     {
-        it = std::find_if(tasks.begin(), tasks.end(), [&](Task* task)
-        {
-            return type == task->GetType();
-        });
-        return it;
-    };
+        if (!ExecuteOneTask())
+            std::this_thread::yield();
+    }
+}
 
-    while (search() != tasks.end())
+void TaskManagerBase::WaitForAll()
+{
+    while (!TaskQueueIsEmpty())
     {
-        tasks.erase(it);
+        if (!ExecuteOneTask())
+            std::this_thread::yield();
     }
 }
 
-void TaskManagerBase::SpawnTask(Task* task)
+template <typename Predicate>
+void TaskManagerBase::RemoveTasks(Predicate&& predicate)
 {
-    const auto it = std::find(tasks.begin(), tasks.end(), task);
-    R_ASSERT3(it != tasks.end(), "Task is deleted from the task manager", task->GetName());
+    xr_vector<Task*> removed;
 
-    // Remove it from the queue
-    tasks.erase(it);
-    
-    // Watch it
-    executionLock.Enter();
-    tasksInExecution.push_back(task);
-    executionLock.Leave();
+    const auto extract = [&](auto& container)
+    {
+        const auto it = std::remove_if(container.begin(), container.end(), predicate);
+        removed.insert(removed.end(), it, container.end());
+        container.erase(it, container.end());
+    };
+
+    for (TaskQueue* queue : queues)
+    {
+        ScopeLock scope(&queue->lock);
+        extract(queue->tasks);
+    }
+
+    {
+        ScopeLock scope(&deferredLock);
+        extract(deferredTasks);
+        deferredCount = static_cast<int>(deferredTasks.size());
+    }
 
-    // Run it
-    tbb::task::spawn(*task);
+    for (Task* task : removed)
+        CancelTask(task);
 }
 
-void TaskManagerBase::TaskDone(Task* task, u64 executionTime)
+void TaskManagerBase::RemoveTasksWithName(pcstr name)
 {
-    executionLock.Enter();
-
-    const auto it = std::find(tasksInExecution.begin(), tasksInExecution.end(), task);
-    R_ASSERT3(it != tasksInExecution.end(), "Task is deleted from the task watcher", task->GetName());
+    RemoveTasks([name](Task* task)
+    {
+        return 0 == xr_strcmp(name, task->GetName());
+    });
+}
 
-    tasksInExecution.erase(it);
+void TaskManagerBase::RemoveTasksWithType(Task::Type type)
+{
+    RemoveTasks([type](Task* task)
+    {
+        return type == task->GetType();
+    });
+}
 
-    executionLock.Leave();
+TaskManagerBase::Statistics TaskManagerBase::GetStatistics()
+{
+    Statistics stats;
+    stats.workers = workersCount;
+    stats.executed = statExecuted.exchange(0, std::memory_order_relaxed);
+    stats.stolen = statStolen.exchange(0, std::memory_order_relaxed);
+    stats.deferred = statDeferred.exchange(0, std::memory_order_relaxed);
+    return stats;
+}
 
+void TaskManagerBase::TaskDone(Task* task, u64 executionTime)
+{
     if (executionTime > ABNORMAL_EXECUTION_TIME)
     {
-        Msg("! Task done after abnormal execution time [%dms] in [%s]", time, task->GetName());
+        Msg("! Task done after abnormal execution time [%dms] in [%s]", executionTime, task->GetName());
     }
     else if (executionTime > BIG_EXECUTION_TIME)
     {
-        Msg("~ Task done after big execution time [%dms] in [%s]", time, task->GetName());
+        Msg("~ Task done after big execution time [%dms] in [%s]", executionTime, task->GetName());
     }
 }
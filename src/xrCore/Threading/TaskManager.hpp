@@ -1,8 +1,11 @@
 #pragma once
 
 #include "Event.hpp"
+#include "Lock.hpp"
 #include "Task.hpp"
 
+#include "xrCommon/xr_deque.h"
+
 //#define TASKS_PROFILER
 
 #ifdef PROFILE_TASKS
@@ -18,24 +21,81 @@ constexpr u64 COMPLEX_TASK_ACCEPTABLE_EXECUTION_TIME = 16; // ms
 constexpr u64 ABNORMAL_EXECUTION_TIME = 1000; // ms
 constexpr u64 BIG_EXECUTION_TIME = 500; // ms
 
-constexpr u64 WATCHER_CALM_DOWN_PERIOD = 5; // ms
-
+// Tasks are allocated from the ring buffer, so a task handle
+// stays valid until TASK_POOL_SIZE more tasks are created
+constexpr u32 TASK_POOL_SIZE = 4096; // must be power of two
+
+constexpr u32 WORKER_SPIN_COUNT = 64; // empty loops before going to sleep
+constexpr u32 WORKER_SLEEP_TIME = 10; // ms, in case a wakeup was missed
+constexpr u32 WORKER_DEFERRED_SLEEP_TIME = 1; // ms, while there are deferred tasks
+
+/*
+ * Work-stealing task manager.
+ * Every worker thread (and the thread which initialized the manager)
+ * owns a queue: it pushes and pops tasks from the back of it,
+ * while idle threads steal from the front of the others' queues.
+ * Threads which aren't workers push into the shared queue.
+ *
+ * Tasks can have a parent (parent is finished only when all its children are)
+ * and up to Task::MAX_CONTINUATIONS continuations, which are pushed
+ * when the task is finished.
+ * Wait() doesn't block the calling thread: it executes other tasks meanwhile.
+ */
 class XRCORE_API TaskManagerBase
 {
-    xr_vector<Task*> tasks;
-    xr_vector<Task*> tasksInExecution;
-
-    Lock lock;
-    Lock executionLock;
-    Event mainThreadExit;
-    Event watcherThreadExit;
-    u32 taskerSleepTime;
-    bool shouldStop;
-
-    static void taskManagerThread(void* thisPtr);
-    static void taskWatcherThread(void* thisPtr);
-
-    void SpawnTask(Task* task);
+public:
+    struct Statistics
+    {
+        u32 workers;
+        u32 executed;
+        u32 stolen;
+        u32 deferred;
+    };
+
+private:
+    struct TaskQueue
+    {
+        Lock lock;
+        xr_deque<Task*> tasks;
+    };
+
+    Task* taskPool;
+    std::atomic<u32> allocatedTasks;
+
+    // [0] - the thread that called Initialize(), [1..workersCount] - workers,
+    // the last one is shared between all other threads
+    xr_vector<TaskQueue*> queues;
+    u32 workersCount;
+
+    // Tasks with execution not allowed yet
+    Lock deferredLock;
+    xr_vector<Task*> deferredTasks;
+    std::atomic_int deferredCount;
+
+    Event newWorkEvent;
+    Event workersExit;
+    std::atomic_int sleepingWorkers;
+    std::atomic_int aliveWorkers;
+    std::atomic_int pendingTasks;
+    std::atomic_bool shouldStop;
+
+    std::atomic<u32> statExecuted;
+    std::atomic<u32> statStolen;
+    std::atomic<u32> statDeferred;
+
+    static void taskWorkerThread(void* thisPtr);
+
+    TaskQueue& GetQueue();
+    Task* AllocateTask();
+    Task* PopTask();
+    Task* StealTask();
+    Task* TakeDeferredTask();
+    void ExecuteTask(Task* task);
+    void CancelTask(Task* task);
+    void WakeUpWorker();
+
+    template <typename Predicate>
+    void RemoveTasks(Predicate&& predicate);
 
 protected:
     friend class Task;
@@ -43,18 +103,107 @@ protected:
 
 public:
     TaskManagerBase();
+    virtual ~TaskManagerBase();
 
     void Initialize();
     void Destroy();
 
     bool TaskQueueIsEmpty() const;
 
-    void AddTask(pcstr name, Task::Type type, Task::TaskFunc taskFunc,
-        Task::IsAllowedCallback callback, Task::DoneCallback done = nullptr);
+    u32 GetWorkersCount() const
+    {
+        return workersCount;
+    }
+
+    // Creates a task, but doesn't push it,
+    // so continuations can be attached to it
+    Task* CreateTask(pcstr name, Task::Type type, Task::TaskFunc taskFunc, Task* parent = nullptr,
+        Task::IsAllowedCallback allowed = nullptr, Task::DoneCallback done = nullptr);
+
+    // Continuation will be pushed automatically when predecessor is finished
+    void AddContinuation(Task& predecessor, Task& continuation);
+
+    void PushTask(Task* task);
+
+    // Shortcut for CreateTask() + PushTask()
+    Task* AddTask(pcstr name, Task::Type type, Task::TaskFunc taskFunc,
+        Task::IsAllowedCallback callback = nullptr, Task::DoneCallback done = nullptr);
+
+    // Executes one of the queued tasks on the calling thread.
+    // Returns false if there was nothing to do.
+    bool ExecuteOneTask();
+
+    // The slot of a finished task is reused, so a task pointer kept after PushTask() must be held:
+    // the task is held before it's pushed and released when it's not waited for or checked anymore
+    void Hold(Task& task);
+    void Release(Task& task);
+
+    // Wait and help: the calling thread executes other tasks
+    // until the awaited one (and all its children) is finished
+    void Wait(const Task& task);
+    void WaitForAll();
+
+    // Chunk size ParallelFor uses for 'count' elements and the requested 'grain'.
+    // The number of chunks is limited, so the grain grows for the big ranges.
+    size_t GetParallelForGrain(size_t count, size_t grain) const
+    {
+        const size_t max_chunks = size_t(workersCount + 1) * 16;
+        if (grain == 0)
+            grain = count / ((workersCount + 1) * 4);
+        return std::max<size_t>({ 1, grain, (count + max_chunks - 1) / max_chunks });
+    }
+
+    // Splits [begin, end) into chunks of at least 'grain' elements (0 - choose automatically)
+    // and calls function(from, to) for every chunk in parallel. Returns when all chunks are done.
+    // Chunk i starts at begin + i * GetParallelForGrain(end - begin, grain).
+    template <typename Function>
+    void ParallelFor(size_t begin, size_t end, size_t grain, Function&& function)
+    {
+        if (end <= begin)
+            return;
+
+        const size_t count = end - begin;
+        grain = GetParallelForGrain(count, grain);
+
+        if (count <= grain || !workersCount)
+        {
+            function(begin, end);
+            return;
+        }
+
+        Task* root = CreateTask("ParallelFor", Task::Type::Core, nullptr);
+        Hold(*root);
+        for (size_t from = begin; from < end; from += grain)
+        {
+            const size_t to = std::min(from + grain, end);
+            PushTask(CreateTask("ParallelFor chunk", Task::Type::Core, [&function, from, to]()
+            {
+                function(from, to);
+            }, root));
+        }
+        PushTask(root);
+        Wait(*root);
+        Release(*root);
+    }
+
+    // Calls function(element) for every element of the random access container in parallel
+    template <typename Container, typename Function>
+    void ParallelForEach(Container& container, Function&& function, size_t grain = 0)
+    {
+        auto first = std::begin(container);
+        ParallelFor(0, container.size(), grain, [&first, &function](size_t from, size_t to)
+        {
+            for (size_t i = from; i < to; ++i)
+                function(first[i]);
+        });
+    }
 
     void RemoveTasksWithName(pcstr name);
     void RemoveTasksWithType(Task::Type type);
 
+    // Returns counters accumulated since the previous call
+    Statistics GetStatistics();
+
     virtual void DumpStatistics(class IGameFont& font, class IPerformanceAlert* alert) = 0;
 };
 
@@ -1,10 +1,73 @@
 #include "stdafx.h"
 #include "stream_reader.h"
 #include "xrCore/_std_extensions.h"
+#include "Compression/archive_codec.h"
 #ifdef LINUX
 #include <sys/mman.h>
 #endif
 
+namespace
+{
+// Maps [offset, offset + size) of the archive,
+// view and view_size are to be passed to unmap_archive_range()
+#if defined(WINDOWS)
+const u8* map_archive_range(const HANDLE& handle, size_t archive_size, size_t offset, size_t size, u8*& view,
+    size_t& view_size)
+#elif defined(LINUX) || defined(FREEBSD)
+const u8* map_archive_range(int handle, size_t archive_size, size_t offset, size_t size, u8*& view,
+    size_t& view_size)
+#endif
+{
+    const size_t granularity = FS.dwAllocGranularity;
+    const size_t start = offset / granularity * granularity;
+    size_t end = (offset + size + granularity - 1) / granularity * granularity;
+    if (end > archive_size)
+        end = archive_size;
+
+    view_size = end - start;
+#if defined(WINDOWS)
+    view = static_cast<u8*>(MapViewOfFile(handle, FILE_MAP_READ, 0, start, view_size));
+    R_ASSERT(view);
+#elif defined(LINUX) || defined(FREEBSD)
+    view = static_cast<u8*>(::mmap(NULL, view_size, PROT_READ, MAP_SHARED, handle, start));
+    R_ASSERT(view && view != MAP_FAILED);
+#endif
+    return view + (offset - start);
+}
+
+void unmap_archive_range(u8* view, size_t view_size)
+{
+#if defined(WINDOWS)
+    UnmapViewOfFile(view);
+#elif defined(LINUX) || defined(FREEBSD)
+    ::munmap(view, view_size);
+#endif
+}
+} // namespace
+
+void CStreamBlocks::load_table(pcstr name)
+{
+    u8* view;
+    size_t view_size;
+    const u8* data = map_archive_range(file_mapping_handle, archive_size, offset, sizeof(u32), view, view_size);
+    block_size = *(const u32*)data;
+    unmap_archive_range(view, view_size);
+    R_ASSERT3(block_size, "Corrupted block-compressed file", name);
+
+    const u32 count = archive_blocks_count(size_real, block_size);
+    const size_t table_size = archive_blocks_table_size(count);
+    R_ASSERT3(table_size <= size_compressed, "Corrupted block-compressed file", name);
+
+    data = map_archive_range(file_mapping_handle, archive_size, offset, table_size, view, view_size);
+    const u32* table = (const u32*)(data + sizeof(u32));
+    offsets.assign(table, table + count + 1);
+    unmap_archive_range(view, view_size);
+
+    for (u32 i = 0; i < count; ++i)
+        R_ASSERT3(offsets[i] <= offsets[i + 1] && offsets[i + 1] <= size_compressed, "Corrupted block-compressed file",
+            name);
+}
+
 #if defined(WINDOWS)
 void CStreamReader::construct(const HANDLE& file_mapping_handle, const size_t& start_offset, const size_t& file_size,
     const size_t& archive_size, const size_t& window_size)
@@ -31,9 +94,83 @@ void CStreamReader::construct(int file_mapping_handle, const size_t& start_offse
 }
 #endif
 
-void CStreamReader::destroy() { unmap(); }
+void CStreamReader::construct(
+    const xr_shared_ptr<CStreamBlocks>& blocks, const size_t& start_offset, const size_t& file_size)
+{
+    VERIFY(start_offset + file_size <= blocks->size_real);
+    m_blocks = blocks;
+    m_file_mapping_handle = blocks->file_mapping_handle;
+    m_start_offset = start_offset;
+    m_file_size = file_size;
+    m_archive_size = blocks->archive_size;
+    m_window_size = blocks->block_size;
+
+    m_block_data = xr_alloc<u8>(blocks->block_size);
+    m_block_index = u32(-1);
+
+    map(0);
+}
+
+void CStreamReader::destroy()
+{
+    unmap();
+    if (m_blocks)
+    {
+        xr_free(m_block_data);
+        m_blocks.reset();
+    }
+}
+
+void CStreamReader::decompress_block(u32 block)
+{
+    const CStreamBlocks& B = *m_blocks;
+    const size_t real = std::min<size_t>(B.block_size, B.size_real - size_t(block) * B.block_size);
+    const size_t compressed = B.offsets[block + 1] - B.offsets[block];
+
+    u8* view;
+    size_t view_size;
+    const u8* data =
+        map_archive_range(B.file_mapping_handle, B.archive_size, B.offset + B.offsets[block], compressed, view, view_size);
+    const size_t decompressed = archive_decompress_block(B.codec, m_block_data, real, data, compressed, B.dictionary);
+    unmap_archive_range(view, view_size);
+
+    R_ASSERT2(decompressed == real, "Can't decompress block of streamed file");
+    m_block_index = block;
+}
+
+void CStreamReader::map_block(const size_t& new_offset)
+{
+    VERIFY(new_offset <= m_file_size);
+    m_current_offset_from_start = new_offset;
+
+    // Like the mapped window, the block may continue after the end of this reader
+    const CStreamBlocks& B = *m_blocks;
+    const size_t offset = m_start_offset + new_offset;
+    if (offset >= B.size_real)
+    {
+        m_current_window_size = 0;
+        m_start_pointer = m_current_pointer = m_block_data;
+        return;
+    }
+
+    const u32 block = u32(offset / B.block_size);
+    if (block != m_block_index)
+        decompress_block(block);
+
+    const size_t block_start = size_t(block) * B.block_size;
+    const size_t block_end = std::min<size_t>(block_start + B.block_size, B.size_real);
+    m_current_window_size = block_end - offset;
+    m_start_pointer = m_current_pointer = m_block_data + (offset - block_start);
+}
+
 void CStreamReader::map(const size_t& new_offset)
 {
+    if (m_blocks)
+    {
+        map_block(new_offset);
+        return;
+    }
+
     VERIFY(new_offset <= m_file_size);
     m_current_offset_from_start = new_offset;
 
@@ -127,7 +264,10 @@ CStreamReader* CStreamReader::open_chunk(const size_t& chunk_id)
 
     R_ASSERT2(!compressed, "cannot use CStreamReader on compressed chunks");
     CStreamReader* result = new CStreamReader();
-    result->construct(file_mapping_handle(), m_start_offset + tell(), size, m_archive_size, m_window_size);
+    if (m_blocks)
+        result->construct(m_blocks, m_start_offset + tell(), size);
+    else
+        result->construct(file_mapping_handle(), m_start_offset + tell(), size, m_archive_size, m_window_size);
     return (result);
 }
 
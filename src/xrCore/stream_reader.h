@@ -1,6 +1,34 @@
 #ifndef STREAM_READER_H
 #define STREAM_READER_H
 
+#include "xrCommon/xr_smart_pointers.h"
+
+enum class ArchiveCodec : u8;
+class ArchiveDictionary;
+
+// Block-compressed archive file (see ARCHIVE_CODEC_BLOCKS),
+// shared by the stream reader and readers of its chunks
+struct XRCORE_API CStreamBlocks
+{
+#if defined(WINDOWS)
+    HANDLE file_mapping_handle;
+#elif defined(LINUX) || defined(FREEBSD)
+    int file_mapping_handle;
+#endif
+    size_t archive_size;
+    size_t offset; // of the file inside archive
+    size_t size_compressed;
+    size_t size_real;
+    ArchiveCodec codec;
+    const ArchiveDictionary* dictionary;
+
+    u32 block_size;
+    xr_vector<u32> offsets; // blocks_count + 1, from the file start
+
+    // Reads block size and offsets from the archive
+    void load_table(pcstr name);
+};
+
 class XRCORE_API CStreamReader : public IReaderBase<CStreamReader>, Noncopyable
 {
 private:
@@ -21,6 +49,16 @@ private:
     u8* m_start_pointer;
     u8* m_current_pointer;
 
+private:
+    // Block-compressed file: windows are decompressed blocks,
+    // m_start_offset and m_file_size are in the decompressed data
+    xr_shared_ptr<CStreamBlocks> m_blocks;
+    u8* m_block_data = nullptr;
+    u32 m_block_index = u32(-1);
+
+    void map_block(const size_t& new_offset);
+    void decompress_block(u32 block);
+
 private:
     void map(const size_t& new_offset);
     IC void unmap();
@@ -36,6 +74,7 @@ public:
     virtual void construct(int file_mapping_handle, const size_t& start_offset, const size_t& file_size,
         const size_t& archive_size, const size_t& window_size);
 #endif
+    void construct(const xr_shared_ptr<CStreamBlocks>& blocks, const size_t& start_offset, const size_t& file_size);
     virtual void destroy();
 
 public:
@@ -10,11 +10,17 @@ IC const HANDLE& CStreamReader::file_mapping_handle() const { return (m_file_map
 IC const int& CStreamReader::file_mapping_handle() const { return (m_file_mapping_handle); }
 #endif
 
+IC void CStreamReader::unmap()
+{
+    // Decompressed block is kept until destroy()
+    if (m_blocks)
+        return;
 #if defined(WINDOWS)
-IC void CStreamReader::unmap() { UnmapViewOfFile(m_current_map_view_of_file); }
+    UnmapViewOfFile(m_current_map_view_of_file);
 #else
-IC void CStreamReader::unmap() { ::munmap(const_cast<u8*>(m_current_map_view_of_file), m_current_window_size); }
+    ::munmap(const_cast<u8*>(m_current_map_view_of_file), m_current_window_size);
 #endif
+}
 IC void CStreamReader::remap(const size_t& new_offset)
 {
     unmap();
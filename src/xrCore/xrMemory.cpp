@@ -2,6 +2,11 @@
 
 #include "SDL.h"
 
+#include "Memory/xrMemory_bins.h"
+
+#include <atomic>
+#include <thread>
+
 #if defined(WINDOWS)
 #include <Psapi.h>
 #elif defined(LINUX)
@@ -50,13 +55,106 @@ xrMemory Memory;
 // Also used in src\xrCore\xrDebug.cpp to prevent use of g_pStringContainer before it initialized
 bool shared_str_initialized = false;
 
-xrMemory::xrMemory()
+namespace
+{
+// Every block is prefixed with the header, so it can be freed
+// by the allocator it came from and accounted for the right tag
+struct alignas(16) MemoryHeader
+{
+    size_t size;
+    u16 bin;
+    MemoryTag tag;
+};
+static_assert(sizeof(MemoryHeader) == 16, "Memory header must keep blocks 16 bytes aligned");
+
+MemoryHeader* header_of(void* ptr) { return static_cast<MemoryHeader*>(ptr) - 1; }
+
+// Written only by the owner thread, read by anyone
+struct ThreadStats
+{
+    std::atomic<s64> bytes[size_t(MemoryTag::Count)];
+    std::atomic<s64> blocks[size_t(MemoryTag::Count)];
+    std::atomic<u64> allocations[size_t(MemoryTag::Count)];
+    std::atomic<u64> calls;
+    ThreadStats* next;
+};
+
+// Stats of all threads ever allocated anything. Never freed.
+std::atomic<ThreadStats*> allThreadStats{ nullptr };
+u64 callsBaseline = 0;
+
+thread_local ThreadStats* s_tl_stats = nullptr;
+thread_local MemoryTag s_tl_tag = MemoryTag::General;
+
+ThreadStats& thread_stats()
+{
+    if (!s_tl_stats)
+    {
+        // Can't use new here
+        void* memory = calloc(1, sizeof(ThreadStats));
+        R_ASSERT(memory);
+        ThreadStats* stats = new (memory) ThreadStats();
+        stats->next = allThreadStats.load(std::memory_order_relaxed);
+        while (!allThreadStats.compare_exchange_weak(stats->next, stats, std::memory_order_release))
+            ;
+        s_tl_stats = stats;
+    }
+    return *s_tl_stats;
+}
+
+// Counters are owned by the thread, so there's no need in atomic RMW
+template <typename T>
+void stat_add(std::atomic<T>& counter, T value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void stat_block(const MemoryHeader& header, s64 sign)
+{
+    ThreadStats& stats = thread_stats();
+    const size_t tag = size_t(header.tag);
+    stat_add(stats.calls, u64(1));
+    stat_add(stats.bytes[tag], sign * s64(header.size));
+    stat_add(stats.blocks[tag], sign);
+    if (sign > 0)
+        stat_add(stats.allocations[tag], u64(1));
+}
+
+// Frame arena
+constexpr size_t frame_arena_size = 8 * 1024 * 1024;
+constexpr size_t frame_arena_alignment = 16;
+u8* frameArena = nullptr;
+std::atomic<size_t> frameArenaUsed{ 0 };
+std::atomic<void*> frameOverflow{ nullptr }; // list of blocks allocated when the arena is full
+} // namespace
+
+pcstr get_memory_tag_name(MemoryTag tag)
+{
+    switch (tag)
+    {
+    case MemoryTag::General: return "general";
+    case MemoryTag::Render: return "render";
+    case MemoryTag::AI: return "ai";
+    case MemoryTag::ALife: return "alife";
+    case MemoryTag::Scripts: return "scripts";
+    case MemoryTag::Sound: return "sound";
+    case MemoryTag::Physics: return "physics";
+    case MemoryTag::Network: return "network";
+    default: return "unknown";
+    }
+}
+
+xrMemory::xrMemory() : allocator(Allocator::System)
 {
 }
 
 void xrMemory::_initialize()
 {
-    stat_calls = 0;
+    if (strstr(Core.Params, "-mem_cached"))
+        allocator = Allocator::ThreadCached;
+
+    frameArena = static_cast<u8*>(xr_internal_malloc(frame_arena_size));
+    frameArenaUsed = 0;
 
     g_pStringContainer = new str_container();
     shared_str_initialized = true;
@@ -67,6 +165,10 @@ void xrMemory::_destroy()
 {
     xr_delete(g_pSharedMemoryContainer);
     xr_delete(g_pStringContainer);
+
+    frame_reset();
+    xr_internal_free(frameArena);
+    frameArena = nullptr;
 }
 
 XRCORE_API void vminfo(size_t* _free, size_t* reserved, size_t* committed)
@@ -149,22 +251,133 @@ void xrMemory::mem_compact()
 
 void* xrMemory::mem_alloc(size_t size)
 {
-    stat_calls++;
-    return xr_internal_malloc(size);
+    const u16 bin = allocator == Allocator::ThreadCached ?
+        xrMemoryBins::bin_for(size + sizeof(MemoryHeader)) : xrMemoryBins::NO_BIN;
+
+    MemoryHeader* header;
+    if (bin != xrMemoryBins::NO_BIN)
+        header = static_cast<MemoryHeader*>(xrMemoryBins::alloc(bin));
+    else
+        header = static_cast<MemoryHeader*>(xr_internal_malloc(size + sizeof(MemoryHeader)));
+
+    if (!header)
+        return nullptr;
+
+    header->size = size;
+    header->bin = bin;
+    header->tag = s_tl_tag;
+    stat_block(*header, 1);
+    return header + 1;
 }
 
 void* xrMemory::mem_realloc(void* ptr, size_t size)
 {
-    stat_calls++;
-    return xr_internal_realloc(ptr, size);
+    if (!ptr)
+        return mem_alloc(size);
+
+    MemoryHeader* header = header_of(ptr);
+    if (header->bin != xrMemoryBins::NO_BIN)
+    {
+        // Still fits into the same block
+        if (size + sizeof(MemoryHeader) <= xrMemoryBins::bin_size(header->bin))
+        {
+            stat_block(*header, -1);
+            header->size = size;
+            stat_block(*header, 1);
+            return ptr;
+        }
+
+        void* result = mem_alloc(size);
+        if (result)
+        {
+            CopyMemory(result, ptr, std::min(header->size, size));
+            mem_free(ptr);
+        }
+        return result;
+    }
+
+    const MemoryHeader old = *header;
+    header = static_cast<MemoryHeader*>(xr_internal_realloc(header, size + sizeof(MemoryHeader)));
+    if (!header)
+        return nullptr;
+
+    stat_block(old, -1);
+    header->size = size;
+    stat_block(*header, 1);
+    return header + 1;
 }
 
 void xrMemory::mem_free(void* ptr)
 {
-    stat_calls++;
-    xr_internal_free(ptr);
+    if (!ptr)
+        return;
+
+    MemoryHeader* header = header_of(ptr);
+    stat_block(*header, -1);
+
+    if (header->bin != xrMemoryBins::NO_BIN)
+        xrMemoryBins::free(header, header->bin);
+    else
+        xr_internal_free(header);
+}
+
+void xrMemory::set_tag(MemoryTag tag) { s_tl_tag = tag; }
+MemoryTag xrMemory::get_tag() { return s_tl_tag; }
+
+void xrMemory::stat_tag(MemoryTag tag, TagStats& result) const
+{
+    result = {};
+    const size_t index = size_t(tag);
+    for (ThreadStats* it = allThreadStats.load(std::memory_order_acquire); it; it = it->next)
+    {
+        result.bytes += it->bytes[index].load(std::memory_order_relaxed);
+        result.blocks += it->blocks[index].load(std::memory_order_relaxed);
+        result.allocations += it->allocations[index].load(std::memory_order_relaxed);
+    }
+}
+
+u64 xrMemory::stat_calls() const
+{
+    u64 calls = 0;
+    for (ThreadStats* it = allThreadStats.load(std::memory_order_acquire); it; it = it->next)
+        calls += it->calls.load(std::memory_order_relaxed);
+    return calls - callsBaseline;
+}
+
+void xrMemory::stat_calls_reset() { callsBaseline += stat_calls(); }
+
+size_t xrMemory::stat_bins_reserved() const { return xrMemoryBins::reserved(); }
+
+void* xrMemory::frame_alloc(size_t size)
+{
+    size = (size + frame_arena_alignment - 1) & ~(frame_arena_alignment - 1);
+    const size_t offset = frameArenaUsed.fetch_add(size, std::memory_order_relaxed);
+    if (frameArena && offset + size <= frame_arena_size)
+        return frameArena + offset;
+
+    // Arena is full, fall back to the heap.
+    // The first bytes of the block are used to link it into the overflow list
+    void** block = static_cast<void**>(mem_alloc(size + frame_arena_alignment));
+    *block = frameOverflow.load(std::memory_order_relaxed);
+    while (!frameOverflow.compare_exchange_weak(*block, block, std::memory_order_release))
+        ;
+    return reinterpret_cast<u8*>(block) + frame_arena_alignment;
+}
+
+void xrMemory::frame_reset()
+{
+    void* block = frameOverflow.exchange(nullptr, std::memory_order_acquire);
+    while (block)
+    {
+        void* next = *static_cast<void**>(block);
+        mem_free(block);
+        block = next;
+    }
+    frameArenaUsed.store(0, std::memory_order_relaxed);
 }
 
+size_t xrMemory::frame_used() const { return frameArenaUsed.load(std::memory_order_relaxed); }
+
 // xr_strdup
 XRCORE_API pstr xr_strdup(pcstr string)
 {
@@ -2,14 +2,43 @@
 
 #include "_types.h"
 
+// Subsystem the allocation is made for, see MemoryTagScope
+enum class MemoryTag : u8
+{
+    General,
+    Render,
+    AI,
+    ALife,
+    Scripts,
+    Sound,
+    Physics,
+    Network,
+
+    Count
+};
+
 class XRCORE_API xrMemory
 {
 public:
+    enum class Allocator : u8
+    {
+        System, // every block goes to the system allocator
+        ThreadCached, // small blocks go to the thread-caching bins
+    };
+
+    struct TagStats
+    {
+        s64 bytes; // currently allocated
+        s64 blocks; // currently allocated
+        u64 allocations; // total since start
+    };
+
     xrMemory();
     void _initialize();
     void _destroy();
 
-    u32 stat_calls;
+private:
+    Allocator allocator;
 
 public:
     size_t mem_usage();
@@ -18,10 +47,43 @@ public:
     void* mem_alloc(size_t size);
     void* mem_realloc(void* ptr, size_t size);
     void mem_free(void* ptr);
+
+    // Allocator can be switched at any moment, blocks remember their origin
+    void set_allocator(Allocator type) { allocator = type; }
+    Allocator get_allocator() const { return allocator; }
+
+    // Tag for the allocations made by the calling thread
+    static void set_tag(MemoryTag tag);
+    static MemoryTag get_tag();
+
+    // Statistics are gathered per thread and summed up on request
+    void stat_tag(MemoryTag tag, TagStats& stats) const;
+    u64 stat_calls() const;
+    void stat_calls_reset();
+    size_t stat_bins_reserved() const;
+
+    // Scratch memory valid until the next frame_reset(). Never free it.
+    void* frame_alloc(size_t size);
+    void frame_reset();
+    size_t frame_used() const;
 };
 
 extern XRCORE_API xrMemory Memory;
 
+class MemoryTagScope
+{
+    MemoryTag previous;
+
+public:
+    explicit MemoryTagScope(MemoryTag tag) : previous(xrMemory::get_tag()) { xrMemory::set_tag(tag); }
+    ~MemoryTagScope() { xrMemory::set_tag(previous); }
+
+    MemoryTagScope(const MemoryTagScope&) = delete;
+    MemoryTagScope& operator=(const MemoryTagScope&) = delete;
+};
+
+XRCORE_API pcstr get_memory_tag_name(MemoryTag tag);
+
 #undef ZeroMemory
 #undef CopyMemory
 #undef FillMemory
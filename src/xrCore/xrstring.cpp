@@ -12,72 +12,194 @@ XRCORE_API str_container* g_pStringContainer = NULL;
 
 #if 1
 
+/*
+ * String table is split into shards, every shard has its own lock,
+ * so threads docking different strings rarely wait for each other.
+ * Shard is selected by the low bits of the cached CRC, bucket - by the rest.
+ * Small strings are allocated from the per-shard arena pages, freed values
+ * are kept in size-class free lists and reused by the same shard.
+ */
 struct str_container_impl
 {
-    Lock cs;
-    static const u32 buffer_size = 1024 * 256;
-    str_value* buffer[buffer_size];
-    int num_docs;
+    static const u32 shards_count = 64; // must be power of two
+    static const u32 shard_bits = 6;
+    static const u32 buckets_count = 1024 * 256 / shards_count;
 
-    str_container_impl()
-    {
-        num_docs = 0;
-        ZeroMemory(buffer, sizeof(buffer));
-    }
+    static const u32 arena_page_size = 64 * 1024;
+    static const u32 arena_granularity = 16;
+    static const u32 arena_max_size = 512; // bigger values are allocated from the heap
+    static const u32 arena_classes = arena_max_size / arena_granularity;
 
-    str_value* find(str_value* value, const char* str)
+    struct shard
     {
-        str_value* candidate = buffer[value->dwCRC % buffer_size];
-        while (candidate)
+        Lock cs;
+        str_value* buffer[buckets_count];
+        str_value* free_list[arena_classes];
+
+        xr_vector<u8*> pages;
+        u8* page_cursor;
+        u32 page_left;
+
+        u32 strings;
+        u32 docks;
+        u32 hits;
+        u32 contended;
+        size_t arena_used;
+        size_t heap_used;
+
+        shard() : page_cursor(nullptr), page_left(0), strings(0), docks(0), hits(0), contended(0),
+            arena_used(0), heap_used(0)
         {
-            if (candidate->dwCRC == value->dwCRC && candidate->dwLength == value->dwLength &&
-                !memcmp(candidate->value, str, value->dwLength))
+            ZeroMemory(buffer, sizeof(buffer));
+            ZeroMemory(free_list, sizeof(free_list));
+        }
+
+        static u32 size_of(u32 length) { return sizeof(str_value) + length + 1; }
+        static u32 size_class(u32 size) { return (size + arena_granularity - 1) / arena_granularity - 1; }
+
+        str_value* allocate(u32 length)
+        {
+            const u32 size = size_of(length);
+            if (size > arena_max_size)
             {
-                return candidate;
+                heap_used += size;
+                return (str_value*)xr_malloc(size);
             }
 
-            candidate = candidate->next;
-        }
+            const u32 cls = size_class(size);
+            arena_used += (cls + 1) * arena_granularity;
+            if (free_list[cls])
+            {
+                str_value* value = free_list[cls];
+                free_list[cls] = value->next;
+                return value;
+            }
 
-        return NULL;
-    }
+            const u32 rounded = (cls + 1) * arena_granularity;
+            if (page_left < rounded)
+            {
+                page_cursor = (u8*)xr_malloc(arena_page_size);
+                page_left = arena_page_size;
+                pages.push_back(page_cursor);
+            }
 
-    void insert(str_value* value)
-    {
-        str_value** element = &buffer[value->dwCRC % buffer_size];
-        value->next = *element;
-        *element = value;
-    }
+            str_value* value = (str_value*)page_cursor;
+            page_cursor += rounded;
+            page_left -= rounded;
+            return value;
+        }
 
-    void clean()
-    {
-        for (u32 i = 0; i < buffer_size; ++i)
+        void release(str_value* value)
         {
-            str_value** current = &buffer[i];
+            const u32 size = size_of(value->dwLength);
+            if (size > arena_max_size)
+            {
+                heap_used -= size;
+                xr_free(value);
+                return;
+            }
 
-            while (*current != NULL)
+            const u32 cls = size_class(size);
+            arena_used -= (cls + 1) * arena_granularity;
+            value->next = free_list[cls];
+            free_list[cls] = value;
+        }
+
+        str_value* find(str_value* value, const char* str)
+        {
+            str_value* candidate = buffer[(value->dwCRC >> shard_bits) % buckets_count];
+            while (candidate)
             {
-                str_value* value = *current;
-                if (!value->dwReference)
+                if (candidate->dwCRC == value->dwCRC && candidate->dwLength == value->dwLength &&
+                    !memcmp(candidate->value, str, value->dwLength))
                 {
-                    *current = value->next;
-                    xr_free(value);
+                    return candidate;
                 }
-                else
+
+                candidate = candidate->next;
+            }
+
+            return NULL;
+        }
+
+        void insert(str_value* value)
+        {
+            str_value** element = &buffer[(value->dwCRC >> shard_bits) % buckets_count];
+            value->next = *element;
+            *element = value;
+            ++strings;
+        }
+
+        void clean()
+        {
+            for (u32 i = 0; i < buckets_count; ++i)
+            {
+                str_value** current = &buffer[i];
+
+                while (*current != NULL)
                 {
-                    current = &value->next;
+                    str_value* value = *current;
+                    if (!value->dwReference)
+                    {
+                        *current = value->next;
+                        release(value);
+                        --strings;
+                    }
+                    else
+                    {
+                        current = &value->next;
+                    }
                 }
             }
         }
+
+        template <typename Callback>
+        void for_each(Callback&& callback) const
+        {
+            for (u32 i = 0; i < buckets_count; ++i)
+            {
+                for (str_value* value = buffer[i]; value; value = value->next)
+                    callback(value);
+            }
+        }
+
+        ~shard()
+        {
+            // Someone may still hold the strings, keep them alive then
+            if (strings)
+                return;
+
+            for (u8* page : pages)
+                xr_free(page);
+        }
+    };
+
+    shard shards[shards_count];
+
+    shard& get_shard(u32 crc) { return shards[crc & (shards_count - 1)]; }
+
+    template <typename Callback>
+    void for_each_shard(Callback&& callback)
+    {
+        for (shard& S : shards)
+        {
+            S.cs.Enter();
+            callback(S);
+            S.cs.Leave();
+        }
+    }
+
+    void clean()
+    {
+        for_each_shard([](shard& S) { S.clean(); });
     }
 
     void verify()
     {
         Msg("strings verify started");
-        for (u32 i = 0; i < buffer_size; ++i)
+        for_each_shard([](shard& S)
         {
-            str_value* value = buffer[i];
-            while (value)
+            S.for_each([](str_value* value)
             {
                 u32 crc = crc32(value->value, value->dwLength);
                 string32 crc_str;
@@ -85,65 +207,69 @@ struct str_container_impl
                     xr_itoa(value->dwCRC, crc_str, 16));
                 R_ASSERT3(value->dwLength == xr_strlen(value->value),
                     "CorePanic: read-only memory corruption (shared_strings, internal structures)", value->value);
-                value = value->next;
-            }
-        }
+            });
+        });
         Msg("strings verify completed");
     }
 
-    void dump(FILE* f) const
+    void dump(FILE* f)
     {
-        for (u32 i = 0; i < buffer_size; ++i)
+        for_each_shard([f](shard& S)
         {
-            str_value* value = buffer[i];
-            while (value)
+            S.for_each([f](str_value* value)
             {
                 fprintf(f, "ref[%4u]-len[%3u]-crc[%8X] : %s\n", value->dwReference, value->dwLength, value->dwCRC,
                     value->value);
-                value = value->next;
-            }
-        }
+            });
+        });
     }
 
-    void dump(IWriter* f) const
+    void dump(IWriter* f)
     {
-        for (u32 i = 0; i < buffer_size; ++i)
+        for_each_shard([f](shard& S)
         {
-            str_value* value = buffer[i];
-            string4096 temp;
-            while (value)
+            S.for_each([f](str_value* value)
             {
-                xr_sprintf(temp, sizeof(temp), "ref[%4u]-len[%3u]-crc[%8X] : %s\n", value->dwReference, value->dwLength,
-                    value->dwCRC, value->value);
+                string4096 temp;
+                xr_sprintf(temp, sizeof(temp), "ref[%4u]-len[%3u]-crc[%8X] : %s\n", value->dwReference,
+                    value->dwLength, value->dwCRC, value->value);
                 f->w_string(temp);
-                value = value->next;
-            }
-        }
+            });
+        });
     }
 
-    int stat_economy()
+    int stat_economy(str_container_stats* stats)
     {
         int counter = 0;
-        for (u32 i = 0; i < buffer_size; ++i)
+        str_container_stats result = {};
+        for_each_shard([&](shard& S)
         {
-            str_value* value = buffer[i];
-            while (value)
+            S.for_each([&counter](str_value* value)
             {
                 counter -= sizeof(str_value);
                 counter += (value->dwReference - 1) * (value->dwLength + 1);
-                value = value->next;
-            }
-        }
-
+            });
+
+            result.strings += S.strings;
+            result.docks += S.docks;
+            result.hits += S.hits;
+            result.contended += S.contended;
+            result.arena_reserved += S.pages.size() * arena_page_size;
+            result.arena_used += S.arena_used;
+            result.heap_used += S.heap_used;
+        });
+
+        // Arena pages not used by the strings are pure overhead
+        counter -= int(result.arena_reserved - result.arena_used);
+
+        if (stats)
+            *stats = result;
         return counter;
     }
 };
 
 str_container::str_container() :
     impl(new str_container_impl())
-#ifdef CONFIG_PROFILE_LOCKS
-    , cs(MUTEX_PROFILE_ID(str_container))
-#endif
 {}
 
 str_value* str_container::dock(pcstr value)
@@ -151,8 +277,6 @@ str_value* str_container::dock(pcstr value)
     if (0 == value)
         return 0;
 
-    impl->cs.Enter();
-
     str_value* result = 0;
 
     // calc len
@@ -167,8 +291,17 @@ str_value* str_container::dock(pcstr value)
     sv->dwLength = s_len;
     sv->dwCRC = crc32(value, s_len);
 
+    // only the shard of this string is locked
+    str_container_impl::shard& S = impl->get_shard(sv->dwCRC);
+    if (!S.cs.TryEnter())
+    {
+        S.cs.Enter();
+        ++S.contended;
+    }
+    ++S.docks;
+
     // search
-    result = impl->find(sv, value);
+    result = S.find(sv, value);
 
 #ifdef DEBUG
     bool is_leaked_string = !xr_strcmp(value, "enter leaked string here");
@@ -181,7 +314,7 @@ str_value* str_container::dock(pcstr value)
 #endif // DEBUG
         )
     {
-        result = (str_value*)xr_malloc(sizeof(str_value) + s_len_with_zero);
+        result = S.allocate(s_len);
 
 #ifdef DEBUG
         static int num_leaked_string = 0;
@@ -197,50 +330,42 @@ str_value* str_container::dock(pcstr value)
         result->dwCRC = sv->dwCRC;
         CopyMemory(result->value, value, s_len_with_zero);
 
-        impl->insert(result);
+        S.insert(result);
     }
-    impl->cs.Leave();
+    else
+        ++S.hits;
+    S.cs.Leave();
 
     return result;
 }
 
 void str_container::clean()
 {
-    impl->cs.Enter();
     impl->clean();
-    impl->cs.Leave();
 }
 
 void str_container::verify()
 {
-    impl->cs.Enter();
     impl->verify();
-    impl->cs.Leave();
 }
 
 void str_container::dump()
 {
-    impl->cs.Enter();
     FILE* F = fopen("d:\\$str_dump$.txt", "w");
     impl->dump(F);
     fclose(F);
-    impl->cs.Leave();
 }
 
 void str_container::dump(IWriter* W)
 {
-    impl->cs.Enter();
     impl->dump(W);
-    impl->cs.Leave();
 }
 
-u32 str_container::stat_economy()
+u32 str_container::stat_economy(str_container_stats* stats /*= nullptr*/)
 {
-    impl->cs.Enter();
     int counter = 0;
     counter -= sizeof(*this);
-    counter += impl->stat_economy();
-    impl->cs.Leave();
+    counter += impl->stat_economy(stats);
     return u32(counter);
 }
 
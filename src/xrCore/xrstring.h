@@ -46,6 +46,18 @@ struct XRCORE_API str_hash_function
 
 struct str_container_impl;
 class IWriter;
+
+struct str_container_stats
+{
+    u32 strings; // unique strings docked
+    u32 docks; // total dock() calls
+    u32 hits; // dock() calls returning an existing string
+    u32 contended; // dock() calls which had to wait for the shard lock
+    size_t arena_reserved;
+    size_t arena_used;
+    size_t heap_used; // long strings don't go to the arena
+};
+
 //////////////////////////////////////////////////////////////////////////
 class XRCORE_API str_container
 {
@@ -58,7 +70,7 @@ public:
     void dump();
     void dump(IWriter* W);
     void verify();
-    u32 stat_economy();
+    u32 stat_economy(str_container_stats* stats = nullptr);
 
 private:
     str_container_impl* impl;
@@ -77,6 +77,7 @@ void CRenderDevice::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
     font.OutNext("*** ENGINE:   %2.2fms", stats.EngineTotal.result);
     font.OutNext("FPS/RFPS:     %3.1f/%3.1f", stats.fFPS, stats.fRFPS);
     font.OutNext("TPS:          %2.2f M", stats.fTPS);
+    font.OutNext("Frame jobs:   %2.2fms wait, %u jobs", stats.FrameJobsWait.result, seqParallel.GetRunningCount());
     if (alert && stats.fFPS < 30)
         alert->Print(font, "FPS       < 30:   %3.1f", stats.fFPS);
 }
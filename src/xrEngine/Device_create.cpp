@@ -39,7 +39,6 @@ void CRenderDevice::Create()
 
     Threading::SetThreadName(NULL, "X-Ray Window thread");
     Threading::SpawnThread(PrimaryThreadProc, "X-RAY Primary thread", 0, this);
-    Threading::SpawnThread(SecondaryThreadProc, "X-Ray Secondary thread", 0, this);
     // Threading::SpawnThread(RenderThreadProc, "X-Ray Render thread", 0, this);
 
     TaskScheduler = std::make_unique<TaskManager>();
@@ -30,7 +30,7 @@ void CRenderDevice::Destroy()
     seqFrame.Clear();
     seqFrameMT.Clear();
     seqDeviceReset.Clear();
-    seqParallel.clear();
+    seqParallel.Clear();
     xr_delete(Statistic);
 
     SDL_DestroyWindow(m_sdlWnd);
@@ -5,11 +5,141 @@
 #include "xr_collide_form.h"
 #include "IGame_Level.h"
 #include "xrCDB/Intersect.hpp"
+#include "GameFont.h"
+#include "xrCore/Threading/ScopeLock.hpp"
+#include "xrCore/Threading/TaskManager.hpp"
+
+ENGINE_API int psVisionBatch = 1;
+ENGINE_API int psVisionRayBudget = 256;
 
 namespace Feel
 {
+/*
+ * Static geometry traces of all the observers.
+ * Vision::o_trace() queues the items whose ray cache is outdated, the frame job traces the queued rays
+ * in parallel while the frame is rendered and the next update of the observer takes the result,
+ * so such an item is checked one update later. The observer traces the dynamic objects itself then,
+ * the collision state of the skeletons is built on demand and it isn't thread safe.
+ * An item is queued once, a newer ray replaces the queued one. The oldest rays go first,
+ * ai_vision_ray_budget of them per frame, the rest wait for the next frame.
+ */
+class VisionBatch : Noncopyable
+{
+    struct Entry
+    {
+        Vision* observer;
+        IGameObject* object;
+        float vis_threshold;
+    };
+
+    Lock lock; // observers can be updated in parallel by the scheduler
+    xr_vector<Entry> entries;
+    xr_vector<Entry> running; // taken by the frame job
+    bool scheduled;
+
+    // Statistics
+    u32 cached; // checks answered by the ray cache
+    u32 queued;
+    u32 deduped; // newer rays of the queued items
+    u32 traced; // by the last batch
+    u32 deferred; // by the budget
+    float time; // ms
+
+    VisionBatch() : scheduled(false), cached(0), queued(0), deduped(0), traced(0), deferred(0), time(0.f) {}
+
+    void schedule()
+    {
+        scheduled = true;
+        Device.seqParallel.Add(fastdelegate::FastDelegate0<>(this, &VisionBatch::process), FrameJobChain::Vision);
+    }
+
+public:
+    static VisionBatch& instance()
+    {
+        static VisionBatch batch;
+        return batch;
+    }
+
+    void on_cached() { ++cached; }
+
+    void queue(Vision* observer, Vision::feel_visible_Item& I, float vis_threshold)
+    {
+        if (I.trace_state == Vision::feel_visible_Item::trace_queued)
+        {
+            ++deduped;
+            return;
+        }
+        I.trace_state = Vision::feel_visible_Item::trace_queued;
+
+        ScopeLock scope(&lock);
+        entries.push_back({ observer, I.O, vis_threshold });
+        ++queued;
+        if (!scheduled)
+            schedule();
+    }
+
+    // Drops the queued rays of the observer to the object, or all of them
+    void remove(Vision* observer, IGameObject* object = nullptr)
+    {
+        ScopeLock scope(&lock);
+        const auto it = std::remove_if(entries.begin(), entries.end(), [&](const Entry& entry)
+        {
+            return entry.observer == observer && (!object || entry.object == object);
+        });
+        entries.erase(it, entries.end());
+    }
+
+    // Frame job
+    void process()
+    {
+        CTimer timer;
+        timer.Start();
+        {
+            ScopeLock scope(&lock);
+            scheduled = false;
+            size_t count = entries.size();
+            if (psVisionRayBudget > 0)
+                count = std::min(count, size_t(psVisionRayBudget));
+            running.assign(entries.begin(), entries.begin() + count);
+            entries.erase(entries.begin(), entries.begin() + count);
+            deferred = u32(entries.size());
+            if (!entries.empty())
+                schedule(); // next frame
+        }
+
+        TaskScheduler->ParallelFor(0, running.size(), 8, [this](size_t from, size_t to)
+        {
+            collide::rq_results R;
+            for (size_t i = from; i < to; ++i)
+            {
+                const Entry& entry = running[i];
+                xr_vector<Vision::feel_visible_Item>& items = entry.observer->feel_visible;
+                const auto it = std::find_if(items.begin(), items.end(),
+                    [&](const Vision::feel_visible_Item& item) { return item.O == entry.object; });
+                VERIFY(it != items.end() && it->trace_state == Vision::feel_visible_Item::trace_queued);
+
+                R.r_clear();
+                it->trace_vis = entry.observer->o_query(*it, it->trace_P, it->trace_D, it->trace_range,
+                    entry.vis_threshold, collide::rqtStatic, R);
+                it->trace_state = Vision::feel_visible_Item::trace_done;
+            }
+        });
+
+        traced = u32(running.size());
+        running.clear();
+        time = timer.GetElapsed_sec() * 1000.f;
+    }
+
+    void statistics(IGameFont& font)
+    {
+        font.OutNext("- batch:      %u rays, %u cached, %u queued, %u deduped", traced, cached, queued, deduped);
+        font.OutNext("- batch time: %2.2fms, %u deferred", time, deferred);
+        cached = queued = deduped = 0;
+    }
+};
+
 Vision::Vision(IGameObject const* owner) : pure_relcase(&Vision::feel_vision_relcase), m_owner(owner) {}
-Vision::~Vision() {}
+Vision::~Vision() { VisionBatch::instance().remove(this); }
 struct SFeelParam
 {
     Vision* parent;
@@ -48,6 +178,7 @@ void Vision::o_new(IGameObject* O)
     I.fuzzy = -EPS_S;
     I.cp_LP = O->get_new_local_point_on_mesh(I.bone_id);
     I.cp_LAST = O->get_last_local_point_on_mesh(I.cp_LP, I.bone_id);
+    I.trace_state = feel_visible_Item::trace_none;
 }
 void Vision::o_delete(IGameObject* O)
 {
@@ -55,6 +186,8 @@ void Vision::o_delete(IGameObject* O)
     for (; I != TE; ++I)
         if (I->O == O)
         {
+            if (I->trace_state == feel_visible_Item::trace_queued)
+                VisionBatch::instance().remove(this, O);
             feel_visible.erase(I);
             return;
         }
@@ -66,8 +199,11 @@ void Vision::feel_vision_clear()
     query.clear();
     diff.clear();
     feel_visible.clear();
+    VisionBatch::instance().remove(this);
 }
 
+void Vision::feel_vision_batch_stats(IGameFont& font) { VisionBatch::instance().statistics(font); }
+
 void Vision::feel_vision_relcase(IGameObject* object)
 {
     xr_vector<IGameObject*>::iterator Io;
@@ -84,6 +220,8 @@ void Vision::feel_vision_relcase(IGameObject* object)
     for (; Ii != IiE; ++Ii)
         if (Ii->O == object)
         {
+            if (Ii->trace_state == feel_visible_Item::trace_queued)
+                VisionBatch::instance().remove(this, object);
             feel_visible.erase(Ii);
             break;
         }
@@ -149,15 +287,103 @@ void Vision::feel_vision_update(IGameObject* parent, Fvector& P, float dt, float
     query = seen;
     o_trace(P, dt, vis_threshold);
 }
+
+float Vision::o_query(feel_visible_Item& I, const Fvector& P, const Fvector& D, float f, float vis_threshold,
+    collide::rq_target tgt, collide::rq_results& R)
+{
+    VERIFY(!fis_zero(D.magnitude()));
+    collide::ray_defs RD(P, D, f, CDB::OPT_CULL, tgt);
+    SFeelParam feel_params(this, &I, vis_threshold);
+    const bool cached = tgt & collide::rqtStatic; // only the static geometry stays in place
+    if (g_pGameLevel->ObjectSpace.RayQuery(R, RD, feel_vision_callback, &feel_params, NULL, NULL))
+    {
+        if (cached)
+        {
+            I.Cache_vis = feel_params.vis;
+            I.Cache.set(P, D, f, TRUE);
+        }
+    }
+    else
+    {
+        // feel_params.vis = 0.f;
+        // I->Cache_vis = feel_params.vis ;
+        if (cached)
+            I.Cache.set(P, D, f, FALSE);
+    }
+    return feel_params.vis;
+}
+
+float Vision::o_trace_objects(feel_visible_Item& I, const Fvector& P, const Fvector& D, float f, float vis,
+    float vis_threshold, bool query_objects)
+{
+    if (vis < vis_threshold)
+        return vis;
+
+    if (query_objects)
+    {
+        vis *= o_query(I, P, D, f, vis_threshold, collide::rq_target(collide::rqtObject | collide::rqtObstacle), RQR);
+        if (vis < vis_threshold)
+            return vis;
+    }
+
+    r_spatial.clear();
+    g_SpatialSpace->q_ray(r_spatial, 0, STYPE_VISIBLEFORAI, P, D, f);
+
+    collide::ray_defs RD(P, D, f, CDB::OPT_ONLYFIRST,
+        collide::rq_target(collide::rqtStatic | /**/ collide::rqtObject | /**/ collide::rqtObstacle));
+    for (ISpatial* spatial : r_spatial)
+    {
+        if (spatial == m_owner)
+            continue;
+
+        if (spatial == I.O)
+            continue;
+
+        IGameObject const* object = spatial->dcast_GameObject();
+        RQR.r_clear();
+        if (object && object->GetCForm() && !object->GetCForm()->_RayQuery(RD, RQR))
+            continue;
+
+        return 0.f;
+    }
+    return vis;
+}
+
+void Vision::o_update(feel_visible_Item& I, float vis, float dt, float vis_threshold)
+{
+    if (vis < vis_threshold)
+    {
+        // INVISIBLE, choose next point
+        I.fuzzy -= fuzzy_update_novis * dt;
+        clamp(I.fuzzy, -.5f, 1.f);
+        I.cp_LP = I.O->get_new_local_point_on_mesh(I.bone_id);
+    }
+    else
+    {
+        // VISIBLE
+        I.fuzzy += fuzzy_update_vis * dt;
+        clamp(I.fuzzy, -.5f, 1.f);
+    }
+}
+
 void Vision::o_trace(Fvector& P, float dt, float vis_threshold)
 {
+    const bool batch = psVisionBatch != 0;
     RQR.r_clear();
-    xr_vector<feel_visible_Item>::iterator I = feel_visible.begin(), E = feel_visible.end();
-    for (; I != E; ++I)
+    for (feel_visible_Item& I : feel_visible)
     {
-        if (0 == I->O->GetCForm())
+        if (0 == I.O->GetCForm())
+        {
+            I.fuzzy = -1;
+            continue;
+        }
+
+        // The static geometry was traced by the batch, the rest is done here
+        if (I.trace_state == feel_visible_Item::trace_done)
         {
-            I->fuzzy = -1;
+            I.trace_state = feel_visible_Item::trace_none;
+            const float vis = o_trace_objects(I, I.trace_P, I.trace_D, I.trace_range, I.trace_vis, vis_threshold, true);
+            o_update(I, vis, dt, vis_threshold);
             continue;
         }
 
@@ -166,16 +392,16 @@ void Vision::o_trace(Fvector& P, float dt, float vis_threshold)
         // P.similar(I->cp_LR_src,lr_granularity))
         // continue;
 
-        I->cp_LR_dst = I->O->Position();
-        I->cp_LR_src = P;
-        I->cp_LAST = I->O->get_last_local_point_on_mesh(I->cp_LP, I->bone_id);
+        I.cp_LR_dst = I.O->Position();
+        I.cp_LR_src = P;
+        I.cp_LAST = I.O->get_last_local_point_on_mesh(I.cp_LP, I.bone_id);
 
         //
-        Fvector D, OP = I->cp_LAST;
+        Fvector D, OP = I.cp_LAST;
         D.sub(OP, P);
         if (fis_zero(D.magnitude()))
         {
-            I->fuzzy = 1.f;
+            I.fuzzy = 1.f;
             continue;
         }
 
@@ -183,92 +409,44 @@ void Vision::o_trace(Fvector& P, float dt, float vis_threshold)
         if (f > fuzzy_guaranteed)
         {
             D.div(f);
-            // setup ray defs & feel params
-            collide::ray_defs RD(P, D, f, CDB::OPT_CULL,
-                collide::rq_target(collide::rqtStatic | /**/ collide::rqtObject | /**/ collide::rqtObstacle));
-            SFeelParam feel_params(this, &*I, vis_threshold);
+            float vis;
+            bool query_objects = batch;
             // check cache
-            if (I->Cache.result && I->Cache.similar(P, D, f))
+            float _u, _v, _range;
+            if (I.Cache.result && I.Cache.similar(P, D, f))
             {
                 // similar with previous query
-                feel_params.vis = I->Cache_vis;
-                // Log("cache 0");
+                vis = I.Cache_vis;
+                VisionBatch::instance().on_cached();
             }
-            else
+            else if (CDB::TestRayTri(P, D, I.Cache.verts, _u, _v, _range, false) && (_range > 0 && _range < f))
             {
-                float _u, _v, _range;
-                if (CDB::TestRayTri(P, D, I->Cache.verts, _u, _v, _range, false) && (_range > 0 && _range < f))
-                {
-                    feel_params.vis = 0.f;
-                    // Log("cache 1");
-                }
-                else
-                {
-                    // cache outdated. real query.
-                    VERIFY(!fis_zero(RD.dir.magnitude()));
-
-                    if (g_pGameLevel->ObjectSpace.RayQuery(RQR, RD, feel_vision_callback, &feel_params, NULL, NULL))
-                    {
-                        I->Cache_vis = feel_params.vis;
-                        I->Cache.set(P, D, f, TRUE);
-                    }
-                    else
-                    {
-                        // feel_params.vis = 0.f;
-                        // I->Cache_vis = feel_params.vis ;
-                        I->Cache.set(P, D, f, FALSE);
-                    }
-                    // Log("query");
-                }
+                vis = 0.f;
+                VisionBatch::instance().on_cached();
             }
-            // Log("Vis",feel_params.vis);
-            r_spatial.clear();
-            g_SpatialSpace->q_ray(r_spatial, 0, STYPE_VISIBLEFORAI, P, D, f);
-
-            RD.flags = CDB::OPT_ONLYFIRST;
-
-            bool collision_found = false;
-            xr_vector<ISpatial*>::const_iterator i = r_spatial.begin();
-            xr_vector<ISpatial*>::const_iterator e = r_spatial.end();
-            for (; i != e; ++i)
-            {
-                if (*i == m_owner)
-                    continue;
-
-                if (*i == I->O)
-                    continue;
-
-                IGameObject const* object = (*i)->dcast_GameObject();
-                RQR.r_clear();
-                if (object && object->GetCForm() && !object->GetCForm()->_RayQuery(RD, RQR))
-                    continue;
-
-                collision_found = true;
-                break;
-            }
-
-            if (collision_found)
-                feel_params.vis = 0.f;
-
-            if (feel_params.vis < feel_params.vis_threshold)
+            else if (batch)
             {
-                // INVISIBLE, choose next point
-                I->fuzzy -= fuzzy_update_novis * dt;
-                clamp(I->fuzzy, -.5f, 1.f);
-                I->cp_LP = I->O->get_new_local_point_on_mesh(I->bone_id);
+                // cache outdated, the batch will do the real query
+                I.trace_P = P;
+                I.trace_D = D;
+                I.trace_range = f;
+                VisionBatch::instance().queue(this, I, vis_threshold);
+                continue;
             }
             else
             {
-                // VISIBLE
-                I->fuzzy += fuzzy_update_vis * dt;
-                clamp(I->fuzzy, -.5f, 1.f);
+                // cache outdated. real query.
+                vis = o_query(I, P, D, f, vis_threshold,
+                    collide::rq_target(collide::rqtStatic | /**/ collide::rqtObject | /**/ collide::rqtObstacle), RQR);
+                query_objects = false;
             }
+            o_update(I, o_trace_objects(I, P, D, f, vis, vis_threshold, query_objects), dt, vis_threshold);
         }
         else
         {
             // VISIBLE, 'cause near
-            I->fuzzy += fuzzy_update_vis * dt;
-            clamp(I->fuzzy, -.5f, 1.f);
+            I.fuzzy += fuzzy_update_vis * dt;
+            clamp(I.fuzzy, -.5f, 1.f);
         }
     }
 }
@@ -7,6 +7,10 @@
 class IRender_Sector;
 class IGameObject;
 class ISpatial;
+class IGameFont;
+
+ENGINE_API extern int psVisionBatch; // trace the static geometry of all observers at once, see Feel::VisionBatch
+ENGINE_API extern int psVisionRayBudget; // batched rays per frame, 0 - no limit
 
 namespace Feel
 {
@@ -18,6 +22,7 @@ const float lr_granularity = 0.1f; // assume similar positions
 class ENGINE_API Vision : private pure_relcase
 {
     friend class pure_relcase;
+    friend class VisionBatch;
 
 private:
     xr_vector<IGameObject*> seen;
@@ -45,9 +50,29 @@ public:
         float fuzzy; // note range: (-1[no]..1[yes])
         float Cache_vis;
         u16 bone_id;
+
+        // Static geometry trace queued to the batch, the result is taken by the next update
+        enum : u8
+        {
+            trace_none,
+            trace_queued,
+            trace_done,
+        };
+        Fvector trace_P;
+        Fvector trace_D;
+        float trace_range;
+        float trace_vis;
+        u8 trace_state;
     };
     xr_vector<feel_visible_Item> feel_visible;
 
+private:
+    float o_query(feel_visible_Item& I, const Fvector& P, const Fvector& D, float f, float vis_threshold,
+        collide::rq_target tgt, collide::rq_results& R);
+    float o_trace_objects(feel_visible_Item& I, const Fvector& P, const Fvector& D, float f, float vis,
+        float vis_threshold, bool query_objects);
+    void o_update(feel_visible_Item& I, float vis, float dt, float vis_threshold);
+
 public:
     void feel_vision_clear();
     void feel_vision_query(Fmatrix& mFull, Fvector& P);
@@ -75,5 +100,7 @@ public:
     }
     virtual bool feel_vision_isRelevant(IGameObject* O) = 0;
     virtual float feel_vision_mtl_transp(IGameObject* O, u32 element) = 0;
+
+    static void feel_vision_batch_stats(IGameFont& font);
 };
 };
@@ -0,0 +1,121 @@
+#include "stdafx.h"
+#include "FrameJobs.h"
+
+#include "xrCore/Threading/ScopeLock.hpp"
+#include "xrCore/Threading/TaskManager.hpp"
+
+ENGINE_API int psFrameJobsMT = 1;
+
+namespace
+{
+struct ChainTask
+{
+    pcstr name;
+    Task::Type type;
+};
+
+constexpr ChainTask chain_tasks[] =
+{
+    { "Frame jobs: game", Task::Type::Game },
+    { "Frame jobs: vision", Task::Type::AI },
+    { "Frame jobs: bullets", Task::Type::Game },
+    { "Frame job", Task::Type::Engine },
+};
+static_assert(std::size(chain_tasks) == size_t(FrameJobChain::Count), "Update chain tasks");
+} // namespace
+
+void CFrameJobs::Add(const Job& job, FrameJobChain chain /*= FrameJobChain::Game*/)
+{
+    VERIFY(chain < FrameJobChain::Count);
+    ScopeLock scope(&lock);
+    pending.push_back({ job, chain });
+}
+
+void CFrameJobs::Remove(const Job& job)
+{
+    ScopeLock scope(&lock);
+    const auto I = std::find_if(pending.begin(), pending.end(), [&](const Entry& it) { return it.job == job; });
+    if (I != pending.end())
+        pending.erase(I);
+}
+
+bool CFrameJobs::Has(const Job& job)
+{
+    ScopeLock scope(&lock);
+    return pending.end() !=
+        std::find_if(pending.begin(), pending.end(), [&](const Entry& it) { return it.job == job; });
+}
+
+void CFrameJobs::Clear()
+{
+    VERIFY(!root);
+    ScopeLock scope(&lock);
+    pending.clear();
+    running.clear();
+}
+
+void CFrameJobs::RunChain(FrameJobChain chain)
+{
+    for (const Entry& it : running)
+    {
+        if (it.chain == chain)
+            it.job();
+    }
+}
+
+void CFrameJobs::Start()
+{
+    VERIFY(!root);
+    {
+        ScopeLock scope(&lock);
+        running.swap(pending);
+        pending.clear();
+    }
+    if (running.empty())
+        return;
+
+    root = TaskScheduler->CreateTask("Frame jobs", Task::Type::Engine, nullptr);
+    TaskScheduler->Hold(*root);
+    if (!psFrameJobsMT)
+    {
+        TaskScheduler->PushTask(TaskScheduler->CreateTask("Frame jobs: all", Task::Type::Game, [this]()
+        {
+            for (const Entry& it : running)
+                it.job();
+        }, root));
+        TaskScheduler->PushTask(root);
+        return;
+    }
+
+    bool chains[u32(FrameJobChain::Independent)] = {};
+    for (const Entry& it : running)
+    {
+        if (it.chain == FrameJobChain::Independent)
+        {
+            const Job job = it.job;
+            const ChainTask& task = chain_tasks[u32(it.chain)];
+            TaskScheduler->PushTask(TaskScheduler->CreateTask(task.name, task.type, [job]() { job(); }, root));
+        }
+        else
+            chains[u32(it.chain)] = true;
+    }
+    for (u32 i = 0; i < u32(FrameJobChain::Independent); ++i)
+    {
+        if (!chains[i])
+            continue;
+        const FrameJobChain chain = FrameJobChain(i);
+        TaskScheduler->PushTask(TaskScheduler->CreateTask(chain_tasks[i].name, chain_tasks[i].type,
+            [this, chain]() { RunChain(chain); }, root));
+    }
+    TaskScheduler->PushTask(root);
+}
+
+void CFrameJobs::Wait()
+{
+    if (!root)
+        return;
+    TaskScheduler->Wait(*root);
+    TaskScheduler->Release(*root);
+    root = nullptr;
+    running.clear();
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common/Noncopyable.hpp"
+#include "xrCore/fastdelegate.h"
+#include "xrCore/Threading/Lock.hpp"
+
+class Task;
+
+ENGINE_API extern int psFrameJobsMT;
+
+// The jobs of one chain run one after another in the order they were added, different chains run in parallel.
+// Jobs that can touch the same data must share the chain.
+enum class FrameJobChain : u32
+{
+    Game, // game objects, ALife, scripts and path builders: everything not proven to be independent
+    Vision, // AI visibility
+    Bullets,
+    Independent, // every job is a task of its own
+
+    Count
+};
+
+/*
+ * Jobs of the frame, the task workers run them while the frame is rendered
+ * and the device joins them before the next frame. A job added while
+ * the jobs are running waits for the next frame, so does a removal.
+ * With mt_frame_jobs 0 all the jobs run one after another, like they did on the secondary thread.
+ */
+class ENGINE_API CFrameJobs : Noncopyable
+{
+public:
+    using Job = fastdelegate::FastDelegate0<>;
+
+private:
+    struct Entry
+    {
+        Job job;
+        FrameJobChain chain;
+    };
+
+    Lock lock; // guards pending
+    xr_vector<Entry> pending;
+    xr_vector<Entry> running;
+    Task* root;
+
+    void RunChain(FrameJobChain chain);
+
+public:
+    CFrameJobs() : root(nullptr) {}
+
+    void Add(const Job& job, FrameJobChain chain = FrameJobChain::Game);
+    void Remove(const Job& job);
+    bool Has(const Job& job);
+    void Clear();
+
+    // Device only
+    void Start();
+    void Wait();
+    u32 GetRunningCount() const { return u32(running.size()); }
+};
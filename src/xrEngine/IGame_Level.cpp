@@ -86,6 +86,12 @@ bool IGame_Level::Load(u32 dwNum)
         xrDebug::Fatal(DEBUG_INFO, "Can't find level configuration file '%s'.", temp);
     pLevel = new CInifile(temp);
 
+    // Decode the level data in background, while the previous parts are being loaded.
+    // Not the geometry, rs_open() streams it, and not level.som, it is read after the level is loaded
+    const xr_vector<shared_str> prefetch = { "level", "level.cform", "level.details", "level.hom", "level.wallmarks" };
+    FS.prefetch("$level$", prefetch);
+    FS.prefetch_list("$level$", "level.prefetch");
+
     // Open
     g_pGamePersistent->SetLoadStageTitle("st_opening_stream");
     g_pGamePersistent->LoadTitle();
@@ -124,6 +130,7 @@ bool IGame_Level::Load(u32 dwNum)
 
     // Done
     FS.r_close(LL_Stream);
+    FS.prefetch_clear();
     bReady = true;
 
     if (!GEnv.isDedicatedServer)
@@ -186,6 +186,9 @@ public:
     {
         CStatTimer Culling; // portal traversal, frustum culling, entities "renderable_Render"
         CStatTimer Animation; // skeleton calculation
+        CStatTimer AnimationBatch; // ...skeletons drawn by the previous frame, calculated in parallel
+        u32 AnimationSkeletons; // ...number of skeletons in the batch
+        u32 AnimationBones; // ...number of their bones
         CStatTimer Primitives; // actual primitive rendering
         CStatTimer Wait; // ...waiting something back (queries results, etc.)
         CStatTimer WaitS; // ...frame-limit sync
@@ -212,6 +215,9 @@ public:
         {
             Culling.FrameStart();
             Animation.FrameStart();
+            AnimationBatch.FrameStart();
+            AnimationSkeletons = 0;
+            AnimationBones = 0;
             Primitives.FrameStart();
             Wait.FrameStart();
             WaitS.FrameStart();
@@ -239,6 +245,7 @@ public:
         {
             Culling.FrameEnd();
             Animation.FrameEnd();
+            AnimationBatch.FrameEnd();
             Primitives.FrameEnd();
             Wait.FrameEnd();
             WaitS.FrameEnd();
@@ -423,6 +430,7 @@ public:
     virtual bool GetForceGPU_REF() = 0;
     virtual u32 GetCacheStatPolys() = 0;
     virtual void BeforeFrame() = 0;
+    virtual void BeforeRender() = 0; // the game has updated the frame, the rendering is about to start
     virtual void Begin() = 0;
     virtual void Clear() = 0;
     virtual void End() = 0;
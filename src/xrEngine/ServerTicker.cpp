@@ -0,0 +1,108 @@
+#include "stdafx.h"
+#include "ServerTicker.h"
+
+#include <thread>
+
+ENGINE_API int psServerTickCatchUp = 3;
+ENGINE_API int psServerTickSpin = 500;
+
+CServerTicker::CServerTicker() : period(0), rate(0), resetRequested(false) { ResetStats(); }
+
+void CServerTicker::ResetStats()
+{
+    std::fill(std::begin(histogram), std::end(histogram), 0);
+    ticks = overruns = skipped = 0;
+    workTotal = workMax = lateTotal = Duration::zero();
+}
+
+void CServerTicker::WaitUntil(Time time) const
+{
+    const Duration spin = std::chrono::microseconds(psServerTickSpin);
+    while (true)
+    {
+        const Duration remaining = time - Clock::now();
+        if (remaining <= Duration::zero())
+            return;
+        if (remaining > spin)
+            std::this_thread::sleep_for(remaining - spin);
+        else
+            std::this_thread::yield();
+    }
+}
+
+void CServerTicker::BeginTick(u32 tickRate)
+{
+    VERIFY(tickRate);
+    tickStart = Clock::now();
+    if (tickRate != rate)
+    {
+        // New timeline starting from now
+        rate = tickRate;
+        period = std::chrono::duration_cast<Duration>(std::chrono::seconds(1)) / rate;
+        deadline = tickStart;
+    }
+    if (resetRequested.exchange(false))
+        ResetStats();
+
+    if (tickStart > deadline)
+    {
+        // Deadlines of the following ticks passed too, some of them are dropped
+        const u64 behind = u64((tickStart - deadline) / period);
+        const u64 catchUp = u64(psServerTickCatchUp);
+        if (behind > catchUp)
+        {
+            deadline += period * (behind - catchUp);
+            skipped += behind - catchUp;
+        }
+        lateTotal += tickStart - deadline;
+    }
+}
+
+void CServerTicker::EndTick()
+{
+    const Time now = Clock::now();
+    const Duration work = now - tickStart;
+
+    ++ticks;
+    workTotal += work;
+    workMax = std::max(workMax, work);
+    if (work > period)
+        ++overruns;
+
+    const u64 percents = u64(work.count()) * 100 / u64(period.count());
+    u32 bucket = 0;
+    while (bucket < std::size(histogram_bounds) && percents >= histogram_bounds[bucket])
+        ++bucket;
+    ++histogram[bucket];
+
+    deadline += period;
+    WaitUntil(deadline);
+}
+
+void CServerTicker::Dump() const
+{
+    using ms = std::chrono::duration<float, std::milli>;
+    if (!ticks)
+    {
+        Msg("* Server tick: no ticks");
+        return;
+    }
+
+    Msg("* Server tick: %u Hz, %.3f ms budget, %llu ticks, %llu over budget, %llu skipped", rate,
+        ms(period).count(), ticks, overruns, skipped);
+    Msg("* Work: %.3f ms avg, %.3f ms max, start late by %.3f ms avg", ms(workTotal).count() / ticks,
+        ms(workMax).count(), ms(lateTotal).count() / ticks);
+
+    u32 lower = 0;
+    for (u32 i = 0; i < HISTOGRAM_SIZE; ++i)
+    {
+        const float share = 100.f * histogram[i] / ticks;
+        if (i < std::size(histogram_bounds))
+        {
+            Msg("* %4u..%4u%%: %10llu %6.2f%%", lower, histogram_bounds[i], histogram[i], share);
+            lower = histogram_bounds[i];
+        }
+        else
+            Msg("* %4u%%+    : %10llu %6.2f%%", lower, histogram[i], share);
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Common/Noncopyable.hpp"
+#include "xrCore/FTimer.h"
+
+#include <atomic>
+
+ENGINE_API extern int psServerTickCatchUp;
+ENGINE_API extern int psServerTickSpin;
+
+/*
+ * Fixed rate tick of the dedicated server.
+ * Deadlines are kept on an absolute timeline, so a late tick doesn't shift the following ones:
+ * the missed ticks run back to back, but when more than sv_tick_catch_up of them are behind the rest is skipped.
+ * The wait sleeps until sv_tick_spin microseconds are left and yields the rest,
+ * the sleep of the OS alone is too coarse for the high rates.
+ */
+class ENGINE_API CServerTicker : Noncopyable
+{
+public:
+    using Clock = CTimerBase::Clock;
+    using Time = CTimerBase::Time;
+    using Duration = CTimerBase::Duration;
+
+    // Tick work in percents of the period, the last bucket takes the rest
+    static constexpr u32 histogram_bounds[] = { 10, 25, 50, 75, 100, 150, 200 };
+    static constexpr u32 HISTOGRAM_SIZE = std::size(histogram_bounds) + 1;
+
+private:
+    Time deadline; // of the current tick
+    Time tickStart;
+    Duration period;
+    u32 rate;
+
+    u64 histogram[HISTOGRAM_SIZE];
+    u64 ticks, overruns, skipped;
+    Duration workTotal, workMax, lateTotal;
+    std::atomic<bool> resetRequested;
+
+    void ResetStats();
+    void WaitUntil(Time time) const;
+
+public:
+    CServerTicker();
+
+    void BeginTick(u32 tickRate);
+    void EndTick(); // accounts the tick work and waits for the next tick
+
+    void RequestReset() { resetRequested = true; }
+    void Dump() const;
+};
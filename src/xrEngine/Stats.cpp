@@ -101,12 +101,12 @@ static void DumpSpatialStatistics(IGameFont& font, IPerformanceAlert* alert, ISp
 
 void CStats::Show()
 {
-    float memCalls = float(Memory.stat_calls);
+    float memCalls = float(Memory.stat_calls());
     if (memCalls > fMem_calls)
         fMem_calls = memCalls;
     else
         fMem_calls = 0.9f * fMem_calls + 0.1f * memCalls;
-    Memory.stat_calls = 0;
+    Memory.stat_calls_reset();
     if (GEnv.isDedicatedServer)
         return;
     auto& font = *statsFont;
@@ -44,6 +44,12 @@ void TaskManager::DumpStatistics(class IGameFont& font, class IPerformanceAlert*
     font.OutNext("- min:         %2.2f ms", minExecutionTime);
     font.OutNext("- max:         %2.2f ms", maxExecutionTime);
 
+    const Statistics stats = GetStatistics();
+    font.OutNext("- workers:     %u", stats.workers);
+    font.OutNext("- executed:    %u", stats.executed);
+    font.OutNext("- stolen:      %u", stats.stolen);
+    font.OutNext("- deferred:    %u", stats.deferred);
+
     if (alert && averageExecutionTime > BIG_EXECUTION_TIME)
         alert->Print(font, "Tasks    > %dms:  %3.1f", BIG_EXECUTION_TIME, averageExecutionTime);
 
@@ -200,30 +200,16 @@ void CRenderDevice::PrimaryThreadProc(void* context)
             device.precacheWhileReset = false;
         }
 
-        device.ProcessFrame();
+        if (GEnv.isDedicatedServer)
+            device.ProcessServerTick();
+        else
+            device.ProcessFrame();
 
         device.primaryFrameDone.Set();
     }
 }
 
-void CRenderDevice::SecondaryThreadProc(void* context)
-{
-    auto& device = *static_cast<CRenderDevice*>(context);
-    while (true)
-    {
-        device.syncProcessFrame.Wait();
-        if (device.mt_bMustExit)
-        {
-            device.syncThreadExit.Set();
-            return;
-        }
-        for (u32 pit = 0; pit < device.seqParallel.size(); pit++)
-            device.seqParallel[pit]();
-        device.seqParallel.clear();
-        device.seqFrameMT.Process();
-        device.syncFrameDone.Set();
-    }
-}
+void CRenderDevice::ProcessFrameMT() { seqFrameMT.Process(); }
 
 #include "IGame_Level.h"
 void CRenderDevice::PreCache(u32 amount, bool b_draw_loadscreen, bool b_wait_user_input)
@@ -340,6 +326,8 @@ void CRenderDevice::DoRender()
     if (GEnv.isDedicatedServer)
         return;
 
+    MemoryTagScope memoryTag(MemoryTag::Render);
+
     CStatTimer renderTotalReal;
     renderTotalReal.FrameStart();
     renderTotalReal.Begin();
@@ -362,15 +350,21 @@ void CRenderDevice::ProcessFrame()
     if (!BeforeFrame())
         return;
 
+    // Nobody uses the previous frame scratch memory at this point
+    Memory.frame_reset();
+
     const u64 frameStartTime = TimerGlobal.GetElapsed_ms();
 
     GEnv.Render->BeforeFrame();
     FrameMove();
 
     BeforeRender();
+    GEnv.Render->BeforeRender(); // before the frame jobs start
 
     // renderProcessFrame.Set(); // allow render thread to do its job
-    syncProcessFrame.Set(); // allow secondary thread to do its job
+    // last in the game chain, after the jobs it used to follow on the secondary thread
+    seqParallel.Add(fastdelegate::FastDelegate0<>(this, &CRenderDevice::ProcessFrameMT));
+    seqParallel.Start(); // the workers run the jobs while we render
     mtProcessingAllowed = true;
 
     DoRender();
@@ -380,25 +374,46 @@ void CRenderDevice::ProcessFrame()
 
     u32 updateDelta = 2; // 2 ms
 
-    if (GEnv.isDedicatedServer)
-        updateDelta = 1000 / g_svDedicateServerUpdateReate;
-
-    else if (Device.Paused())
+    if (Device.Paused())
         updateDelta = 16; // 16 ms, ~60 FPS max while paused
 
     if (frameTime < updateDelta)
         Sleep(updateDelta - frameTime);
 
-    syncFrameDone.Wait(); // wait until secondary thread finish its job
+    stats.FrameJobsWait.FrameStart();
+    stats.FrameJobsWait.Begin();
+    seqParallel.Wait(); // join the frame jobs, helping the workers
     // renderFrameDone.Wait(); // wait until render thread finish its job
-    while (!TaskScheduler->TaskQueueIsEmpty())
-        std::this_thread::yield();
+    TaskScheduler->WaitForAll(); // help workers instead of spinning
+    stats.FrameJobsWait.End();
+    stats.FrameJobsWait.FrameEnd();
     mtProcessingAllowed = false;
 
     if (!b_is_Active)
         Sleep(1);
 }
 
+void CRenderDevice::ProcessServerTick()
+{
+    if (!BeforeFrame())
+        return;
+
+    Memory.frame_reset();
+
+    serverTicker.BeginTick(g_svDedicateServerUpdateReate);
+    FrameMove();
+
+    // Nothing to render, the tick joins its jobs at once
+    seqParallel.Add(fastdelegate::FastDelegate0<>(this, &CRenderDevice::ProcessFrameMT));
+    seqParallel.Start();
+    mtProcessingAllowed = true;
+    seqParallel.Wait();
+    TaskScheduler->WaitForAll();
+    mtProcessingAllowed = false;
+
+    serverTicker.EndTick();
+}
+
 void CRenderDevice::message_loop_weather_editor()
 {
     m_editor->run();
@@ -548,9 +563,6 @@ void CRenderDevice::Run()
     
     // renderProcessFrame.Set();
     // renderThreadExit.Wait();
-    
-    syncProcessFrame.Set();
-    syncThreadExit.Wait();
 }
 
 u32 app_inactive_time = 0;
@@ -17,6 +17,8 @@
 #include "xrCore/Threading/Event.hpp"
 #include "xrCore/fastdelegate.h"
 #include "xrCore/ModuleLookup.hpp"
+#include "FrameJobs.h"
+#include "ServerTicker.h"
 
 #define VIEWPORT_NEAR 0.2f
 
@@ -38,6 +40,7 @@ public:
     {
         CStatTimer RenderTotal; // pureRender
         CStatTimer EngineTotal; // pureFrame
+        CStatTimer FrameJobsWait; // the frame jobs weren't done by the end of the frame
         float fFPS, fRFPS, fTPS; // FPS, RenderFPS, TPS
 
         RenderDeviceStatictics()
@@ -207,7 +210,8 @@ public:
     MessageRegistry<pureFrame> seqFrameMT;
     MessageRegistry<pureDeviceReset> seqDeviceReset;
     MessageRegistry<pureUIReset> seqUIReset;
-    xr_vector<fastdelegate::FastDelegate0<>> seqParallel;
+    CFrameJobs seqParallel;
+    CServerTicker serverTicker; // dedicated server only
     CSecondVPParams m_SecondViewport; //--#SM+#-- +SecondVP+
 
     Fmatrix mInvFullTransform;
@@ -233,8 +237,9 @@ public:
 
 private:
     static void PrimaryThreadProc(void* context);
-    static void SecondaryThreadProc(void* context);
     static void RenderThreadProc(void* context);
+    void ProcessFrameMT();
+    void ProcessServerTick();
 
 public:
     // Scene control
@@ -304,7 +309,6 @@ private:
     std::atomic<bool> mtProcessingAllowed;
     Event deviceCreated, deviceReadyToRun;
     Event primaryProcessFrame, primaryFrameDone, primaryThreadExit; // Primary thread events
-    Event syncProcessFrame, syncFrameDone, syncThreadExit; // Secondary thread events
     Event renderProcessFrame, renderFrameDone, renderThreadExit; // Render thread events
 
 public:
@@ -315,13 +319,7 @@ public:
         return mtProcessingAllowed;
     }
 
-    ICF void remove_from_seq_parallel(const fastdelegate::FastDelegate0<>& delegate)
-    {
-        xr_vector<fastdelegate::FastDelegate0<>>::iterator I =
-            std::find(seqParallel.begin(), seqParallel.end(), delegate);
-        if (I != seqParallel.end())
-            seqParallel.erase(I);
-    }
+    ICF void remove_from_seq_parallel(const fastdelegate::FastDelegate0<>& delegate) { seqParallel.Remove(delegate); }
 
 private:
     void CalcFrameStats();
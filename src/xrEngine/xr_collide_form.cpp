@@ -10,6 +10,7 @@
 
 #include "Include/xrRender/Kinematics.h"
 #include "xrCore/Animation/Bone.hpp"
+#include "xrCore/Threading/ScopeLock.hpp"
 #ifdef DEBUG
 IC float DET(const Fmatrix& a)
 {
@@ -213,6 +214,7 @@ void CCF_Skeleton::BuildTopLevel()
 
 BOOL CCF_Skeleton::_RayQuery(const collide::ray_defs& Q, collide::rq_results& R)
 {
+    ScopeLock scope(&stateLock);
     if (dwFrameTL != Device.dwFrame)
         BuildTopLevel();
 
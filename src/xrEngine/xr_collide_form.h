@@ -6,6 +6,7 @@
 #include "xrCore/_obb.h"
 #include "xrCore/_cylinder.h"
 #include "xrCore/_sphere.h"
+#include "xrCore/Threading/Lock.hpp"
 
 // refs
 class ENGINE_API IGameObject;
@@ -146,6 +147,7 @@ private:
 
     u32 dwFrame; // The model itself
     u32 dwFrameTL; // Top level
+    Lock stateLock; // the state is built lazily by the first query of the frame, queries come from the workers too
 
     void BuildState();
     void BuildTopLevel();
@@ -17,6 +17,8 @@
 
 #include "xr_object.h"
 #include "xr_object_list.h"
+#include "TaskScheduler.hpp"
+#include "Feel_Vision.h"
 
 extern u32 Vid_SelectedMonitor;
 extern u32 Vid_SelectedRefreshRate;
@@ -97,6 +99,261 @@ public:
     CCC_DbgStrDump(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
     virtual void Execute(LPCSTR args) { g_pStringContainer->dump(); }
 };
+
+// Interning throughput, single thread vs all task workers
+class CCC_DbgStrBench : public IConsole_Command
+{
+public:
+    CCC_DbgStrBench(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+    virtual void Execute(LPCSTR args)
+    {
+        u32 count = 100000;
+        if (args && args[0])
+            sscanf(args, "%u", &count);
+        clamp(count, u32(1000), u32(10000000));
+
+        // Every string is docked several times, like names from configs are
+        constexpr u32 repeats = 4;
+        xr_vector<xr_string> names(count);
+        for (u32 i = 0; i < count; ++i)
+            names[i] = make_string("dbg_str_bench_%u_%u", Device.dwFrame, i).c_str();
+
+        const auto run = [&](pcstr mode, bool parallel)
+        {
+            CTimer timer;
+            timer.Start();
+            const auto dock = [&](size_t from, size_t to)
+            {
+                for (size_t i = from; i < to; ++i)
+                    g_pStringContainer->dock(names[i % count].c_str());
+            };
+            if (parallel)
+                TaskScheduler->ParallelFor(0, count * repeats, 1024, dock);
+            else
+                dock(0, count * repeats);
+
+            const float seconds = timer.GetElapsed_sec();
+            Msg("* [%s] %u docks in %2.3f sec: %2.2f M/sec", mode, count * repeats, seconds,
+                float(count * repeats) / seconds / 1000000.f);
+        };
+
+        run("single thread", false);
+        run("all workers", true);
+
+        str_container_stats stats;
+        const int economy = (int)g_pStringContainer->stat_economy(&stats);
+        Msg("* strings: %u unique, %u docks, %u hits, %u contended", stats.strings, stats.docks, stats.hits,
+            stats.contended);
+        Msg("* arena: %zu K used of %zu K, heap: %zu K, economy: %d K", stats.arena_used / 1024,
+            stats.arena_reserved / 1024, stats.heap_used / 1024, economy / 1024);
+
+        g_pStringContainer->clean();
+    }
+};
+
+// Static geometry ray throughput, one by one vs packets of four
+class CCC_DbgCdbRayBench : public IConsole_Command
+{
+public:
+    CCC_DbgCdbRayBench(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+    virtual void Execute(LPCSTR args)
+    {
+        if (!g_pGameLevel)
+        {
+            Msg("! Level isn't loaded");
+            return;
+        }
+
+        u32 count = 100000;
+        if (args && args[0])
+            sscanf(args, "%u", &count);
+        clamp(count, u32(1000), u32(10000000));
+
+        const CDB::MODEL* model = g_pGameLevel->ObjectSpace.GetStaticModel();
+        CDB::COLLIDER collider;
+        collider.ray_options(CDB::OPT_ONLYNEAREST | CDB::OPT_CULL);
+
+        const auto run = [&](pcstr mode, bool coherent)
+        {
+            // Coherent rays are like AI visibility checks: from one point into the view cone
+            xr_vector<CDB::RAY> rays(count);
+            for (CDB::RAY& ray : rays)
+            {
+                ray.start.set(Device.vCameraPosition);
+                if (coherent)
+                    ray.dir.random_dir(Device.vCameraDirection, deg2rad(30.f));
+                else
+                    ray.dir.random_dir();
+                ray.range = 100.f;
+            }
+
+            xr_vector<float> ranges(count);
+            CTimer timer;
+            timer.Start();
+            for (u32 i = 0; i < count; ++i)
+            {
+                collider.ray_query(model, rays[i].start, rays[i].dir, rays[i].range);
+                ranges[i] = collider.r_count() ? collider.r_begin()->range : -1.f;
+            }
+            const float single = timer.GetElapsed_sec();
+
+            constexpr u32 batch = 256;
+            u32 mismatches = 0;
+            timer.Start();
+            for (u32 first = 0; first < count; first += batch)
+            {
+                const u32 size = std::min(batch, count - first);
+                collider.ray_query(model, rays.data() + first, size);
+                for (u32 i = 0; i < size; ++i)
+                {
+                    const float range = collider.r_ray_count(i) ? collider.r_ray_begin(i)->range : -1.f;
+                    if (range != ranges[first + i])
+                        ++mismatches;
+                }
+            }
+            const float packets = timer.GetElapsed_sec();
+
+            Msg("* [%s] %u rays: single %2.3f sec (%2.2f M/sec), packets %2.3f sec (%2.2f M/sec), %u mismatches",
+                mode, count, single, float(count) / single / 1000000.f, packets, float(count) / packets / 1000000.f,
+                mismatches);
+        };
+
+        run("coherent", true);
+        run("incoherent", false);
+    }
+};
+
+// Static geometry queries with the OPCODE tree vs the compact one
+class CCC_DbgCdbBench : public IConsole_Command
+{
+public:
+    CCC_DbgCdbBench(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+    virtual void Execute(LPCSTR args)
+    {
+        if (!g_pGameLevel)
+        {
+            Msg("! Level isn't loaded");
+            return;
+        }
+
+        u32 count = 100000;
+        if (args && args[0])
+            sscanf(args, "%u", &count);
+        clamp(count, u32(1000), u32(10000000));
+
+        CDB::MODEL* source = g_pGameLevel->ObjectSpace.GetStaticModel();
+        CDB::MODEL models[2];
+        constexpr pcstr names[2] = { "opcode", "compact" };
+        models[0].set_layout(CDB::TreeLayout::OPCODE);
+        models[1].set_layout(CDB::TreeLayout::Compact);
+        for (CDB::MODEL& model : models)
+        {
+            CTimer timer;
+            timer.Start();
+            model.build(source->get_verts(), source->get_verts_count(), source->get_tris(), source->get_tris_count());
+            model.syncronize();
+            Msg("* [%s] built in %2.3f sec, %u K", names[&model - models], timer.GetElapsed_sec(),
+                model.memory() / 1024);
+        }
+        if (CDB::TreeLayout::Compact != models[1].get_layout())
+            return;
+
+        // Queries around the camera, like the game does
+        xr_vector<CDB::RAY> rays(count);
+        xr_vector<Fbox> boxes(count);
+        xr_vector<CFrustum> frustums(count / 100);
+        for (u32 i = 0; i < count; ++i)
+        {
+            rays[i].start.set(Device.vCameraPosition);
+            rays[i].dir.random_dir();
+            rays[i].range = 100.f;
+
+            Fvector center, size;
+            center.random_dir().mul(::Random.randF(0.f, 50.f)).add(Device.vCameraPosition);
+            size.set(::Random.randF(.5f, 2.f), ::Random.randF(.5f, 2.f), ::Random.randF(.5f, 2.f));
+            boxes[i].set(center, center).grow(size);
+        }
+        for (CFrustum& F : frustums)
+        {
+            Fvector dir, up;
+            dir.random_dir(Device.vCameraDirection, deg2rad(60.f));
+            up.set(0.f, 1.f, 0.f);
+            if (_abs(dir.dotproduct(up)) > .99f)
+                up.set(1.f, 0.f, 0.f);
+
+            Fmatrix P, V, PV;
+            P.build_projection(deg2rad(20.f), 1.f, .1f, 50.f);
+            V.build_camera_dir(Device.vCameraPosition, dir, up);
+            PV.mul(P, V);
+            F.CreateFromMatrix(PV, FRUSTUM_P_ALL);
+        }
+
+        // Number of results or the nearest range of every query, to compare the trees
+        xr_vector<float> results[2];
+        CDB::COLLIDER collider;
+        collider.ray_options(CDB::OPT_ONLYNEAREST | CDB::OPT_CULL);
+        const auto run = [&](pcstr query, u32 queries, const auto& execute)
+        {
+            float seconds[2];
+            for (u32 m = 0; m < 2; ++m)
+            {
+                results[m].clear();
+                CTimer timer;
+                timer.Start();
+                execute(models[m], results[m]);
+                seconds[m] = timer.GetElapsed_sec();
+            }
+
+            u32 mismatches = 0;
+            for (size_t i = 0; i < results[0].size(); ++i)
+            {
+                if (results[0][i] != results[1][i])
+                    ++mismatches;
+            }
+            Msg("* [%s] %u queries: %s %2.3f sec (%2.2f K/sec), %s %2.3f sec (%2.2f K/sec), %u mismatches", query,
+                queries, names[0], seconds[0], float(queries) / seconds[0] / 1000.f, names[1], seconds[1],
+                float(queries) / seconds[1] / 1000.f, mismatches);
+        };
+
+        run("ray", count, [&](const CDB::MODEL& model, xr_vector<float>& dest)
+        {
+            for (const CDB::RAY& ray : rays)
+            {
+                collider.ray_query(&model, ray.start, ray.dir, ray.range);
+                dest.push_back(collider.r_count() ? collider.r_begin()->range : -1.f);
+            }
+        });
+        run("ray packets", count, [&](const CDB::MODEL& model, xr_vector<float>& dest)
+        {
+            constexpr u32 batch = 256;
+            for (u32 first = 0; first < count; first += batch)
+            {
+                const u32 size = std::min(batch, count - first);
+                collider.ray_query(&model, rays.data() + first, size);
+                for (u32 i = 0; i < size; ++i)
+                    dest.push_back(collider.r_ray_count(i) ? collider.r_ray_begin(i)->range : -1.f);
+            }
+        });
+        run("box", count, [&](const CDB::MODEL& model, xr_vector<float>& dest)
+        {
+            for (const Fbox& box : boxes)
+            {
+                Fvector center, size;
+                box.get_CD(center, size);
+                collider.box_query(&model, center, size);
+                dest.push_back(float(collider.r_count()));
+            }
+        });
+        run("frustum", u32(frustums.size()), [&](const CDB::MODEL& model, xr_vector<float>& dest)
+        {
+            for (const CFrustum& F : frustums)
+            {
+                collider.frustum_query(&model, F);
+                dest.push_back(float(collider.r_count()));
+            }
+        });
+    }
+};
 //-----------------------------------------------------------------------
 class CCC_MotionsStat : public IConsole_Command
 {
@@ -195,6 +452,13 @@ public:
     }
 };
 
+class CCC_DumpArchiveStats : public IConsole_Command
+{
+public:
+    CCC_DumpArchiveStats(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = TRUE; };
+    virtual void Execute(LPCSTR args) { FS.dump_archive_stats(); }
+};
+
 //-----------------------------------------------------------------------
 class CCC_SaveCFG : public IConsole_Command
 {
@@ -777,6 +1041,21 @@ public:
     }
 };
 
+class CCC_ServerTickStats : public IConsole_Command
+{
+public:
+    CCC_ServerTickStats(pcstr name) : IConsole_Command(name) { bEmptyArgsHandled = true; }
+    void Execute(pcstr args) override
+    {
+        if (0 == xr_strcmp(args, "reset"))
+            Device.serverTicker.RequestReset();
+        else
+            Device.serverTicker.Dump();
+    }
+
+    void Info(TInfo& I) override { xr_strcpy(I, "dedicated server tick stats, 'reset' to start over"); }
+};
+
 ENGINE_API float g_fov = 67.5f;
 ENGINE_API float psHUD_FOV = 0.45f;
 
@@ -825,6 +1104,9 @@ void CCC_Register()
 
     CMD1(CCC_DbgStrCheck, "dbg_str_check");
     CMD1(CCC_DbgStrDump, "dbg_str_dump");
+    CMD1(CCC_DbgStrBench, "dbg_str_bench");
+    CMD1(CCC_DbgCdbRayBench, "dbg_cdb_ray_bench");
+    CMD1(CCC_DbgCdbBench, "dbg_cdb_bench");
 
     CMD3(CCC_Mask, "mt_sound", &psDeviceFlags, mtSound);
     CMD3(CCC_Mask, "mt_physics", &psDeviceFlags, mtPhysics);
@@ -897,8 +1179,11 @@ void CCC_Register()
     CMD1(CCC_SND_Restart, "snd_restart");
     CMD3(CCC_Mask, "snd_acceleration", &psSoundFlags, ss_Hardware);
     CMD3(CCC_Mask, "snd_efx", &psSoundFlags, ss_EAX);
+    CMD3(CCC_Mask, "snd_mixer_thread", &psSoundFlags, ss_MixerThread);
     CMD4(CCC_Integer, "snd_targets", &psSoundTargets, 4, 32);
     CMD4(CCC_Integer, "snd_cache_size", &psSoundCacheSizeMB, 4, 64);
+    CMD4(CCC_Integer, "snd_decode_ahead", &psSoundDecodeAhead, 0, 2000);
+    CMD4(CCC_Integer, "snd_occlusion_budget", &psSoundOcclusionBudget, 0, 1024);
     CMD3(CCC_Token, "snd_precache_all", &psSoundPrecacheAll, snd_precache_all_token);
 
 #ifdef DEBUG
@@ -923,6 +1208,9 @@ void CCC_Register()
 
     CMD1(CCC_CenterScreen, "center_screen");
     CMD4(CCC_Integer, "always_active", &ps_always_active, 0, 1);
+    CMD4(CCC_Integer, "mt_frame_jobs", &psFrameJobsMT, 0, 1);
+    CMD4(CCC_Integer, "ai_vision_batch", &psVisionBatch, 0, 1);
+    CMD4(CCC_Integer, "ai_vision_ray_budget", &psVisionRayBudget, 0, 4096);
 
     CMD1(CCC_renderer, "renderer");
 
@@ -940,6 +1228,7 @@ void CCC_Register()
 
 #ifdef DEBUG
     CMD1(CCC_DumpOpenFiles, "dump_open_files");
+    CMD1(CCC_DumpArchiveStats, "dump_archive_stats");
 #endif
 
     CMD1(CCC_ExclusiveMode, "input_exclusive_mode");
@@ -949,6 +1238,9 @@ void CCC_Register()
 #endif
     extern int g_svDedicateServerUpdateReate;
     CMD4(CCC_Integer, "sv_dedicated_server_update_rate", &g_svDedicateServerUpdateReate, 1, 1000);
+    CMD4(CCC_Integer, "sv_tick_catch_up", &psServerTickCatchUp, 0, 100);
+    CMD4(CCC_Integer, "sv_tick_spin", &psServerTickSpin, 0, 5000);
+    CMD1(CCC_ServerTickStats, "sv_tick_stats");
 
     CMD1(CCC_HideConsole, "hide");
 
@@ -258,7 +258,8 @@ void CObjectList::Update(bool bForce)
             stats.Total = objects_active.size() + objects_sleeping.size();
 
             u32 const objects_count = workload->size();
-            IGameObject** objects = (IGameObject**)xr_alloca(objects_count * sizeof(IGameObject*));
+            // Hundreds of objects don't belong on the stack
+            IGameObject** objects = (IGameObject**)Memory.frame_alloc(objects_count * sizeof(IGameObject*));
             std::copy(workload->begin(), workload->end(), objects);
 
             m_primary_crows.clear();
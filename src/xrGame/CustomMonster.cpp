@@ -319,6 +319,7 @@ void CCustomMonster::net_Import(NET_Packet& P)
 
 void CCustomMonster::shedule_Update(u32 DT)
 {
+    MemoryTagScope memoryTag(MemoryTag::AI);
     VERIFY(!g_Alive() || processing_enabled());
     // Queue shrink
     VERIFY(_valid(Position()));
@@ -333,11 +334,13 @@ void CCustomMonster::shedule_Update(u32 DT)
     {
         if (false && g_mt_config.test(mtAiVision))
 #ifndef DEBUG
-            Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CCustomMonster::Exec_Visibility));
+            Device.seqParallel.Add(
+                fastdelegate::FastDelegate0<>(this, &CCustomMonster::Exec_Visibility), FrameJobChain::Vision);
 #else // DEBUG
         {
             if (!psAI_Flags.test(aiStalker) || !!smart_cast<CActor*>(Level().CurrentEntity()))
-                Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CCustomMonster::Exec_Visibility));
+                Device.seqParallel.Add(
+                    fastdelegate::FastDelegate0<>(this, &CCustomMonster::Exec_Visibility), FrameJobChain::Vision);
             else
                 Exec_Visibility();
         }
@@ -428,6 +431,7 @@ void CCustomMonster::net_update::lerp(CCustomMonster::net_update& A, CCustomMons
 void CCustomMonster::update_sound_player() { sound().update(client_update_fdelta()); }
 void CCustomMonster::UpdateCL()
 {
+    MemoryTagScope memoryTag(MemoryTag::AI);
     START_PROFILE("CustomMonster/client_update")
     m_client_update_delta = (u32)std::min(Device.dwTimeGlobal - m_last_client_update_time, u32(100));
     m_last_client_update_time = Device.dwTimeGlobal;
@@ -458,7 +462,7 @@ void CCustomMonster::UpdateCL()
     */
 
     if (g_mt_config.test(mtSoundPlayer))
-        Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CCustomMonster::update_sound_player));
+        Device.seqParallel.Add(fastdelegate::FastDelegate0<>(this, &CCustomMonster::update_sound_player));
     else
     {
         START_PROFILE("CustomMonster/client_update/sound_player")
@@ -665,6 +669,7 @@ void CCustomMonster::eye_pp_s2()
 
 void CCustomMonster::Exec_Visibility()
 {
+    MemoryTagScope memoryTag(MemoryTag::AI);
     // if (0==Sector())				return;
     if (!g_Alive())
         return;
@@ -918,7 +918,7 @@ void CGameObject::spatial_update(float eps_P, float eps_R)
     }
     else
     {
-        if (spatial.node_ptr)
+        if (spatial.registered())
         {
             // Object registered!
             if (!fsimilar(Radius(), spatial.sphere.R, eps_R))
@@ -1365,7 +1365,7 @@ void CGameObject::UpdateCL()
     if (Device.dwFrame == dbg_update_cl)
         xrDebug::Fatal(DEBUG_INFO, "'UpdateCL' called twice per frame for %s", *cName());
     dbg_update_cl = Device.dwFrame;
-    if (Parent && spatial.node_ptr)
+    if (Parent && spatial.registered())
         xrDebug::Fatal(DEBUG_INFO, "Object %s has parent but is still registered inside spatial DB", *cName());
     if (!CForm && (spatial.type & STYPE_COLLIDEABLE))
         xrDebug::Fatal(DEBUG_INFO, "Object %s registered as 'collidable' but has no collidable model", *cName());
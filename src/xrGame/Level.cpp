@@ -445,7 +445,7 @@ void CLevel::OnFrame()
             R_ASSERT(m_map_manager);
             if (true)
             {
-                Device.seqParallel.push_back(
+                Device.seqParallel.Add(
                     fastdelegate::FastDelegate0<>(m_map_manager, &CMapManager::Update));
             }
             else
@@ -567,7 +567,7 @@ void CLevel::OnFrame()
             R_ASSERT(m_level_sound_manager);
             if (true)
             {
-                Device.seqParallel.push_back(
+                Device.seqParallel.Add(
                     fastdelegate::FastDelegate0<>(m_level_sound_manager, &CLevelSoundManager::Update));
             }
             else
@@ -587,7 +587,7 @@ void CLevel::OnFrame()
         {
             if (true)
             {
-                Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CLevel::script_gc));
+                Device.seqParallel.Add(fastdelegate::FastDelegate0<>(this, &CLevel::script_gc));
             }
             else
             {
@@ -789,6 +789,7 @@ void CLevel::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
     font.OutNext("- compress:   %2.2fms", stats.ClientCompressor.result);
     font.OutNext("- int send:   %2.2fms, %d", stats.ClientSendInternal.result, stats.ClientSendInternal.count);
     font.OutNext("- bmcommit:   %2.2fms, %d", stats.BulletManagerCommit.result, stats.BulletManagerCommit.count);
+    BulletManager().DumpStatistics(font);
     stats.FrameStart();
     if (Server)
         Server->DumpStatistics(font, alert);
@@ -800,6 +801,7 @@ void CLevel::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
     font.OutNext("AI vision:    %2.2fms, %d", AIStats.Vis.result, AIStats.Vis.count);
     font.OutNext("- query:      %2.2fms", AIStats.VisQuery.result);
     font.OutNext("- rayCast:    %2.2fms", AIStats.VisRayTests.result);
+    Feel::Vision::feel_vision_batch_stats(font);
     AIStats.FrameStart();
 }
 
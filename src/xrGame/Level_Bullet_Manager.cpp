@@ -16,6 +16,7 @@
 #include "Include/xrRender/UIRender.h"
 #include "Include/xrRender/Kinematics.h"
 #include "xrEngine/TaskScheduler.hpp"
+#include "xrEngine/GameFont.h"
 
 #ifdef DEBUG
 #include "debug_renderer.h"
@@ -34,6 +35,9 @@ static float const air_resistance_epsilon = .1f;
 #endif // #ifdef DEBUG
 float g_bullet_time_factor = 1.f;
 
+// bullets per chunk of the parallel update
+static u32 const bullet_chunk_size = 16;
+
 SBullet::SBullet() {}
 SBullet::~SBullet() {}
 void SBullet::Init(const Fvector& position, const Fvector& direction, float starting_speed, float power,
@@ -84,6 +88,7 @@ void SBullet::Init(const Fvector& position, const Fvector& direction, float star
 
     targetID = 0;
     density_mode = 0;
+    random.seed(::Random.randI());
 }
 
 CBulletManager::CBulletManager()
@@ -100,11 +105,17 @@ CBulletManager::CBulletManager()
 {
     m_Bullets.clear();
     m_Bullets.reserve(100);
+    m_BulletWhines.reserve(100);
+    m_UpdateBullets = m_UpdateRays = 0;
+    m_StatsBullets = m_StatsRays = 0;
+    m_StatsTime = 0;
+    m_BulletsPerSecond = m_RaysPerBullet = 0.f;
 }
 
 CBulletManager::~CBulletManager()
 {
     m_Bullets.clear();
+    m_BulletWhines.clear();
     m_WhineSounds.clear();
     m_Events.clear();
 }
@@ -160,22 +171,23 @@ void CBulletManager::PlayExplodePS(const Fmatrix& xf)
     GamePersistent().ps_needtoplay.push_back(ps);
 }
 
-void CBulletManager::PlayWhineSound(SBullet* bullet, IGameObject* object, const Fvector& pos)
+void CBulletManager::PlayWhineSound(SBullet* bullet, ref_sound& whine_snd, IGameObject* object, const Fvector& pos)
 {
     if (m_WhineSounds.empty())
         return;
-    if (bullet->m_whine_snd._feedback() != NULL)
+    if (whine_snd._feedback() != NULL)
         return;
     if (bullet->hit_type != ALife::eHitTypeFireWound)
         return;
 
-    bullet->m_whine_snd = m_WhineSounds[Random.randI(0, m_WhineSounds.size())];
-    bullet->m_whine_snd.play_at_pos(object, pos);
+    whine_snd = m_WhineSounds[Random.randI(0, m_WhineSounds.size())];
+    whine_snd.play_at_pos(object, pos);
 }
 
 void CBulletManager::Clear()
 {
     m_Bullets.clear();
+    m_BulletWhines.clear();
     m_Events.clear();
 }
 
@@ -193,6 +205,7 @@ void CBulletManager::AddBullet(const Fvector& position, const Fvector& direction
     //	u32 CurID					= Level().CurrentControlEntity()->ID();
     //	u32 OwnerID					= sender_id;
     m_Bullets.push_back(SBullet());
+    m_BulletWhines.push_back(ref_sound());
     SBullet& bullet = m_Bullets.back();
     bullet.Init(position, direction, starting_speed, power, /*power_critical,*/ impulse, sender_id, sendersweapon_id,
         e_hit_type, maximum_distance, cartridge, air_resistance_factor, SendHit);
@@ -208,15 +221,11 @@ void CBulletManager::AddBullet(const Fvector& position, const Fvector& direction
     }
 }
 
-void CBulletManager::UpdateWorkload()
+void CBulletManager::process_chunk(_chunk& chunk, u32 from, u32 to, float delta_time)
 {
-    VERIFY(g_mt_config.test(mtBullets) || m_thread_id == Threading::GetCurrThreadId());
-
-    rq_storage.r_clear();
-
-    u32 const time_delta = Device.dwTimeDelta;
-    if (!time_delta)
-        return;
+    chunk.rq_storage.r_clear();
+    chunk.events.clear();
+    chunk.rays = 0;
 
     collide::rq_result dummy;
 
@@ -224,18 +233,55 @@ void CBulletManager::UpdateWorkload()
     // when index in vector passed through the tgt_material field
     // and we can remove them only in case when we iterate bullets
     // in the reversed order
-    BulletVec::reverse_iterator i = m_Bullets.rbegin();
-    BulletVec::reverse_iterator e = m_Bullets.rend();
-    for (u16 j = u16(e - i); i != e; ++i, --j)
+    u32 const count = m_Bullets.size();
+    for (u32 i = from; i < to; ++i)
     {
-        if (process_bullet(rq_storage, *i, time_delta * g_bullet_time_factor))
+        chunk.bullet = u16(count - 1 - i);
+        SBullet& bullet = m_Bullets[chunk.bullet];
+        if (process_bullet(chunk, bullet, delta_time))
             continue;
 
-        VERIFY(j > 0);
-        RegisterEvent(EVENT_REMOVE, FALSE, &*i, Fvector().set(0, 0, 0), dummy, j - 1);
+        RegisterEvent(chunk, EVENT_REMOVE, FALSE, &bullet, Fvector().set(0, 0, 0), dummy, chunk.bullet);
     }
 }
 
+void CBulletManager::UpdateWorkload()
+{
+    VERIFY(g_mt_config.test(mtBullets) || m_thread_id == Threading::GetCurrThreadId());
+
+    u32 const time_delta = Device.dwTimeDelta;
+    if (!time_delta || m_Bullets.empty())
+        return;
+
+    VERIFY(m_Bullets.size() <= u32(u16(-1)));
+    float const delta_time = time_delta * g_bullet_time_factor;
+    u32 const count = m_Bullets.size();
+    u32 const grain = g_mt_config.test(mtBulletsParallel) ?
+        u32(TaskScheduler->GetParallelForGrain(count, bullet_chunk_size)) : count;
+    u32 const chunks = (count + grain - 1) / grain;
+    if (m_Chunks.size() < chunks)
+        m_Chunks.resize(chunks);
+
+    TaskScheduler->ParallelFor(0, count, grain, [&](size_t from, size_t to)
+    {
+        process_chunk(m_Chunks[from / grain], u32(from), u32(to), delta_time);
+    });
+
+    // chunk order is the order of the serial update
+    for (u32 i = 0; i < chunks; ++i)
+    {
+        _chunk& chunk = m_Chunks[i];
+        m_Events.insert(m_Events.end(), chunk.events.begin(), chunk.events.end());
+        chunk.events.clear();
+        m_UpdateRays += chunk.rays;
+#ifdef DEBUG
+        m_bullet_points.insert(m_bullet_points.end(), chunk.bullet_points.begin(), chunk.bullet_points.end());
+        chunk.bullet_points.clear();
+#endif // #ifdef DEBUG
+    }
+    m_UpdateBullets = count;
+}
+
 static Fvector parabolic_velocity(
     Fvector const& start_velocity, Fvector const& gravity, float const air_resistance, float const time)
 {
@@ -455,13 +501,13 @@ static float trajectory_select_pick_time(
     return (low);
 }
 
-void CBulletManager::add_bullet_point(Fvector const& start_position, Fvector& previous_position,
+void CBulletManager::add_bullet_point(_chunk& chunk, Fvector const& start_position, Fvector& previous_position,
     Fvector const& start_velocity, Fvector const& gravity, float const air_resistance, float const current_time)
 {
 #ifdef DEBUG
     Fvector const temp = trajectory_position(start_position, start_velocity, gravity, air_resistance, current_time);
-    m_bullet_points.push_back(previous_position);
-    m_bullet_points.push_back(temp);
+    chunk.bullet_points.push_back(previous_position);
+    chunk.bullet_points.push_back(temp);
     previous_position = temp;
 #endif // #ifdef DEBUG
 }
@@ -591,7 +637,8 @@ BOOL CBulletManager::firetrace_callback(collide::rq_result& result, LPVOID param
     if (!result.O)
     {
         CDB::TRI const& triangle = *(Level().ObjectSpace.GetStaticTris() + result.element);
-        bullet_manager.RegisterEvent(EVENT_HIT, FALSE, &bullet, collide_position, result, triangle.material);
+        bullet_manager.RegisterEvent(
+            *data.chunk, EVENT_HIT, FALSE, &bullet, collide_position, result, triangle.material);
         return (FALSE);
     }
 
@@ -602,12 +649,13 @@ BOOL CBulletManager::firetrace_callback(collide::rq_result& result, LPVOID param
         return (FALSE);
 
     CBoneData const& bone_data = kinematics->LL_GetData((u16)result.element);
-    bullet_manager.RegisterEvent(EVENT_HIT, TRUE, &bullet, collide_position, result, bone_data.game_mtl_idx);
+    bullet_manager.RegisterEvent(
+        *data.chunk, EVENT_HIT, TRUE, &bullet, collide_position, result, bone_data.game_mtl_idx);
     return (FALSE);
 }
 
-bool CBulletManager::trajectory_check_error(Fvector& previous_position, collide::rq_results& storage, SBullet& bullet,
-    float& low, float& high, Fvector const& gravity, float const air_resistance)
+bool CBulletManager::trajectory_check_error(Fvector& previous_position, _chunk& chunk, SBullet& bullet, float& low,
+    float& high, Fvector const& gravity, float const air_resistance)
 {
     Fvector const& position = bullet.start_position;
     Fvector const& velocity = bullet.start_velocity;
@@ -622,6 +670,7 @@ bool CBulletManager::trajectory_check_error(Fvector& previous_position, collide:
 
     bullet_test_callback_data data;
     data.pBullet = &bullet;
+    data.chunk = &chunk;
 #if 1 // def DEBUG
     data.high_time = high;
 #endif // #ifdef DEBUG
@@ -629,17 +678,18 @@ bool CBulletManager::trajectory_check_error(Fvector& previous_position, collide:
     bullet.dir = start_to_target;
 
     collide::ray_defs RD(start, start_to_target, distance, CDB::OPT_FULL_TEST, collide::rqtBoth);
+    ++chunk.rays;
     BOOL const result = Level().ObjectSpace.RayQuery(
-        storage, RD, CBulletManager::firetrace_callback, &data, CBulletManager::test_callback, NULL);
+        chunk.rq_storage, RD, CBulletManager::firetrace_callback, &data, CBulletManager::test_callback, NULL);
     if (!result || (data.collide_time == 0.f))
     {
         add_bullet_point(
-            bullet.start_position, previous_position, bullet.start_velocity, gravity, air_resistance, high);
+            chunk, bullet.start_position, previous_position, bullet.start_velocity, gravity, air_resistance, high);
         return (true);
     }
 
-    add_bullet_point(
-        bullet.start_position, previous_position, bullet.start_velocity, gravity, air_resistance, data.collide_time);
+    add_bullet_point(chunk, bullet.start_position, previous_position, bullet.start_velocity, gravity, air_resistance,
+        data.collide_time);
 
     low = 0.f;
 
@@ -683,7 +733,7 @@ static bool try_update_bullet(SBullet& bullet, Fvector const& gravity, float con
     return (true);
 }
 
-bool CBulletManager::process_bullet(collide::rq_results& storage, SBullet& bullet, float delta_time)
+bool CBulletManager::process_bullet(_chunk& chunk, SBullet& bullet, float delta_time)
 {
     float const time_delta = delta_time / 1000.f;
     Fvector const gravity = Fvector().set(0.f, -m_fGravityConst, 0.f);
@@ -733,7 +783,7 @@ bool CBulletManager::process_bullet(collide::rq_results& storage, SBullet& bulle
 
             float safe_time = time;
             VERIFY2(safe_time <= high, make_string("safe_time[%f], high[%f]", safe_time, high));
-            if (!trajectory_check_error(previous_position, storage, bullet, low, time, gravity, air_resistance))
+            if (!trajectory_check_error(previous_position, chunk, bullet, low, time, gravity, air_resistance))
             {
                 VERIFY2(safe_time >= time, make_string("safe_time[%f], time[%f]", safe_time, time));
                 VERIFY2(safe_time <= high, make_string("safe_time[%f], high[%f]", safe_time, high));
@@ -909,8 +959,8 @@ void CBulletManager::CommitRenderSet() // @ the end of frame
     {
         if (true)
         {
-            Device.seqParallel.push_back(
-                fastdelegate::FastDelegate0<>(this, &CBulletManager::UpdateWorkload));
+            Device.seqParallel.Add(
+                fastdelegate::FastDelegate0<>(this, &CBulletManager::UpdateWorkload), FrameJobChain::Bullets);
 
         }
         else
@@ -949,26 +999,52 @@ void CBulletManager::CommitEvents() // @ the start of frame
                 Game().m_WeaponUsageStatistic->OnBullet_Remove(&E.bullet);
             m_Bullets[E.tgt_material] = m_Bullets.back();
             m_Bullets.pop_back();
+            m_BulletWhines[E.tgt_material] = m_BulletWhines.back();
+            m_BulletWhines.pop_back();
+        }
+        break;
+        case EVENT_WHINE:
+        {
+            IGameObject* initiator = Level().Objects.net_Find(E.bullet.parent_id);
+            PlayWhineSound(&m_Bullets[E.tgt_material], m_BulletWhines[E.tgt_material], initiator, E.point);
         }
         break;
         }
     }
     m_Events.clear();
+
+    m_StatsBullets += m_UpdateBullets;
+    m_StatsRays += m_UpdateRays;
+    m_UpdateBullets = m_UpdateRays = 0;
+    u32 const elapsed = Device.dwTimeGlobal - m_StatsTime;
+    if (elapsed >= 1000)
+    {
+        m_BulletsPerSecond = m_StatsBullets * 1000.f / elapsed;
+        m_RaysPerBullet = m_StatsBullets ? float(m_StatsRays) / m_StatsBullets : 0.f;
+        m_StatsBullets = m_StatsRays = 0;
+        m_StatsTime = Device.dwTimeGlobal;
+    }
 }
 
-void CBulletManager::RegisterEvent(
-    EventType Type, BOOL _dynamic, SBullet* bullet, const Fvector& end_point, collide::rq_result& R, u16 tgt_material)
+void CBulletManager::DumpStatistics(IGameFont& font) const
+{
+    font.OutNext("- bullets:    %u, %.0f/s, %2.2f rays/bullet", u32(m_Bullets.size()), m_BulletsPerSecond,
+        m_RaysPerBullet);
+}
+
+void CBulletManager::RegisterEvent(_chunk& chunk, EventType Type, BOOL _dynamic, SBullet* bullet,
+    const Fvector& end_point, collide::rq_result& R, u16 tgt_material)
 {
 #if 0 // def DEBUG
-    if (m_Events.size() > 1000) {
+    if (chunk.events.size() > 1000) {
         static bool breakpoint = true;
         if (breakpoint)
             DEBUG_BREAK;
     }
 #endif // #ifdef DEBUG
 
-    m_Events.push_back(_event());
-    _event& E = m_Events.back();
+    chunk.events.push_back(_event());
+    _event& E = chunk.events.back();
     E.Type = Type;
     E.bullet = *bullet;
 
@@ -1008,5 +1084,11 @@ void CBulletManager::RegisterEvent(
     case EVENT_REMOVE: { E.tgt_material = tgt_material;
     }
     break;
+    case EVENT_WHINE:
+    {
+        E.point = end_point;
+        E.tgt_material = tgt_material;
+    }
+    break;
     }
 }
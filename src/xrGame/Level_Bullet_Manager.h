@@ -71,8 +71,8 @@ struct SBullet
     ALife::EHitType hit_type;
     //---------------------------------
     u32 m_dwID;
-    ref_sound m_whine_snd;
     ref_sound m_mtl_snd;
+    CRandom random; // own sequence, the bullets are traced in parallel
     //---------------------------------
     u16 targetID;
     //---------------------------------
@@ -92,22 +92,22 @@ public:
 };
 
 class CLevel;
+struct bullet_test_callback_data;
 
 class CBulletManager
 {
     static float const parent_ignore_distance;
 
-    collide::rq_results rq_storage;
-    collide::rq_results m_rq_results;
-
     using SoundVec = xr_vector<ref_sound>;
     using BulletVec = xr_vector<SBullet>;
     friend CLevel;
+    friend bullet_test_callback_data;
 
     enum EventType
     {
         EVENT_HIT = u8(0),
         EVENT_REMOVE,
+        EVENT_WHINE, // whine sounds play on the primary thread
 
         EVENT_DUMMY = u8(-1),
     };
@@ -134,6 +134,9 @@ protected:
 
     BulletVec m_Bullets; // working set, locked
     BulletVec m_BulletsRendered; // copy for rendering
+    // whine sound of every bullet in m_Bullets, it's not a part of SBullet
+    // since the events copy bullets on the workers and the sound reference count isn't atomic
+    SoundVec m_BulletWhines;
     xr_vector<_event> m_Events;
 
 #ifdef DEBUG
@@ -143,6 +146,31 @@ protected:
     BulletPoints m_bullet_points;
 #endif // #ifdef DEBUG
 
+    // Bullets are traced in chunks on the workers, each chunk has its own query storage and events.
+    // A chunk takes bullets in reversed order and the events are merged chunk by chunk,
+    // so the result is the same as of the serial update
+    struct _chunk
+    {
+        collide::rq_results rq_storage;
+        collide::rq_results rq_results; // cform tests of test_callback
+        xr_vector<_event> events;
+        u16 bullet; // index of the traced bullet
+        u32 rays;
+#ifdef DEBUG
+        BulletPoints bullet_points;
+#endif // #ifdef DEBUG
+    };
+    xr_vector<_chunk> m_Chunks;
+
+    // counters of the last update, gathered by CommitEvents
+    u32 m_UpdateBullets;
+    u32 m_UpdateRays;
+    u32 m_StatsBullets;
+    u32 m_StatsRays;
+    u32 m_StatsTime;
+    float m_BulletsPerSecond;
+    float m_RaysPerBullet;
+
     //отрисовка трассеров от пуль
     CTracer tracers;
 
@@ -167,15 +195,15 @@ protected:
     float m_fTracerLengthMin;
 
 protected:
-    void PlayWhineSound(SBullet* bullet, IGameObject* object, const Fvector& pos);
+    void PlayWhineSound(SBullet* bullet, ref_sound& whine_snd, IGameObject* object, const Fvector& pos);
     void PlayExplodePS(const Fmatrix& xf);
     //функция обработки хитов объектов
     static BOOL test_callback(const collide::ray_defs& rd, IGameObject* object, LPVOID params);
     static BOOL firetrace_callback(collide::rq_result& result, LPVOID params);
 
     // Deffer event
-    void RegisterEvent(EventType Type, BOOL _dynamic, SBullet* bullet, const Fvector& end_point, collide::rq_result& R,
-        u16 target_material);
+    void RegisterEvent(_chunk& chunk, EventType Type, BOOL _dynamic, SBullet* bullet, const Fvector& end_point,
+        collide::rq_result& R, u16 target_material);
 
     //попадание по динамическому объекту
     void DynamicObjectHit(_event& E);
@@ -194,11 +222,12 @@ protected:
     //и равномерно, а после просчета также изменяется текущая
     //скорость и положение с учетом гравитации и ветра
     //возвращаем true если пуля продолжает полет
-    bool trajectory_check_error(Fvector& previous_position, collide::rq_results& rq_storage, SBullet& bullet,
-        float& low, float& high, Fvector const& gravity, float const air_resistance);
-    void add_bullet_point(Fvector const& start_position, Fvector& previous_position, Fvector const& start_velocity,
-        Fvector const& gravity, float const ait_resistance, float const current_time);
-    bool process_bullet(collide::rq_results& rq_storage, SBullet& bullet, float delta_time);
+    bool trajectory_check_error(Fvector& previous_position, _chunk& chunk, SBullet& bullet, float& low, float& high,
+        Fvector const& gravity, float const air_resistance);
+    void add_bullet_point(_chunk& chunk, Fvector const& start_position, Fvector& previous_position,
+        Fvector const& start_velocity, Fvector const& gravity, float const ait_resistance, float const current_time);
+    bool process_bullet(_chunk& chunk, SBullet& bullet, float delta_time);
+    void process_chunk(_chunk& chunk, u32 from, u32 to, float delta_time);
     void __stdcall UpdateWorkload();
 
 public:
@@ -215,12 +244,14 @@ public:
     void CommitEvents(); // @ the start of frame
     void CommitRenderSet(); // @ the end of frame
     void Render();
+    void DumpStatistics(class IGameFont& font) const;
 };
 
 struct bullet_test_callback_data
 {
     Fvector collide_position;
     SBullet* pBullet;
+    CBulletManager::_chunk* chunk;
     float collide_time;
 #if 1 // def DEBUG
     float high_time;
@@ -22,6 +22,7 @@
 #include "ik/math3d.h"
 #include "Actor.h"
 #include "ai/monsters/basemonster/base_monster.h"
+#include "xrCore/Threading/ScopeLock.hpp"
 
 //константы ShootFactor, определяющие
 //поведение пули при столкновении с объектом
@@ -117,7 +118,7 @@ BOOL CBulletManager::test_callback(const collide::ray_defs& rd, IGameObject* obj
                             ahp = dist_factor * actor->HitProbability() + (1.f - dist_factor) * 1.f;
                         }
 #endif
-                        if (Random.randF(0.f, 1.f) > (ahp * hpf))
+                        if (bullet->random.randF(0.f, 1.f) > (ahp * hpf))
                         {
                             bRes = FALSE; // don't hit actor
                             play_whine = true; // play whine sound
@@ -125,9 +126,9 @@ BOOL CBulletManager::test_callback(const collide::ray_defs& rd, IGameObject* obj
                         else
                         {
                             // real test actor CFORM
-                            Level().BulletManager().m_rq_results.r_clear();
+                            pData->chunk->rq_results.r_clear();
 
-                            if (cform->_RayQuery(rd, Level().BulletManager().m_rq_results))
+                            if (cform->_RayQuery(rd, pData->chunk->rq_results))
                             {
                                 bRes = TRUE; // hit actor
                                 play_whine = false; // don't play whine sound
@@ -144,7 +145,10 @@ BOOL CBulletManager::test_callback(const collide::ray_defs& rd, IGameObject* obj
                     {
                         Fvector pt;
                         pt.mad(bullet->bullet_pos, bullet->dir, dist);
-                        Level().BulletManager().PlayWhineSound(bullet, initiator, pt);
+                        collide::rq_result dummy;
+                        CBulletManager::_chunk& chunk = *pData->chunk;
+                        Level().BulletManager().RegisterEvent(
+                            chunk, EVENT_WHINE, FALSE, bullet, pt, dummy, chunk.bullet);
                     }
                 }
                 else
@@ -360,9 +364,10 @@ void CBulletManager::DynamicObjectHit(CBulletManager::_event& E)
 
 #ifdef DEBUG
 FvectorVec g_hit[3];
+static Lock g_hit_lock;
 #endif
 
-extern void random_dir(Fvector& tgt_dir, const Fvector& src_dir, float dispersion);
+extern void random_dir(Fvector& tgt_dir, const Fvector& src_dir, float dispersion, CRandom& random);
 
 bool CBulletManager::ObjectHit(SBullet_Hit* hit_res, SBullet* bullet, const Fvector& end_point, collide::rq_result& R,
     u16 target_material, Fvector& hit_normal)
@@ -474,10 +479,10 @@ bool CBulletManager::ObjectHit(SBullet_Hit* hit_res, SBullet* bullet, const Fvec
     Fvector new_dir;
     new_dir.reflect(bullet->dir, hit_normal);
     Fvector tgt_dir;
-    random_dir(tgt_dir, new_dir, deg2rad(10.0f));
+    random_dir(tgt_dir, new_dir, deg2rad(10.0f), bullet->random);
     float ricoshet_factor = bullet->dir.dotproduct(tgt_dir);
 
-    float f = Random.randF(0.5f, 0.8f); //(0.5f,1.f);
+    float f = bullet->random.randF(0.5f, 0.8f); //(0.5f,1.f);
     if ((f < ricoshet_factor) && !mtl->Flags.test(SGameMtl::flNoRicoshet) && bullet->flags.allow_ricochet)
     {
         // уменьшение скорости полета в зависимости от угла падения пули (чем прямее угол, тем больше потеря)
@@ -512,7 +517,7 @@ bool CBulletManager::ObjectHit(SBullet_Hit* hit_res, SBullet* bullet, const Fvec
         bullet->bullet_pos.mad(bullet->bullet_pos, bullet->dir, EPS); // fake
         //ввести коэффициент случайности при простреливании
         Fvector rand_normal;
-        rand_normal.random_dir(bullet->dir, deg2rad(2.0f), Random);
+        rand_normal.random_dir(bullet->dir, deg2rad(2.0f), bullet->random);
         bullet->dir.set(rand_normal);
 #ifdef DEBUG
         bullet_state = 2;
@@ -530,6 +535,7 @@ bool CBulletManager::ObjectHit(SBullet_Hit* hit_res, SBullet* bullet, const Fvec
     extern BOOL g_bDrawBulletHit;
     if (g_bDrawBulletHit)
     {
+        ScopeLock scope(&g_hit_lock);
         //		g_hit[bullet_state].push_back(dbg_bullet_pos);
         g_hit[bullet_state].push_back(end_point);
     }
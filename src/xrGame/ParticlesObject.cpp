@@ -185,7 +185,7 @@ void CParticlesObject::shedule_Update(u32 _dt)
         { //.psDeviceFlags.test(mtParticles))	{    //. AlexMX comment this line// NO UNCOMMENT - DON'T WORK PROPERLY
             mt_dt = dt;
             fastdelegate::FastDelegate0<> delegate(this, &CParticlesObject::PerformAllTheWork_mt);
-            Device.seqParallel.push_back(delegate);
+            Device.seqParallel.Add(delegate, FrameJobChain::Independent);
         }
         else
         {
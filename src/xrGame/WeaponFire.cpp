@@ -18,7 +18,7 @@
 
 #define FLAME_TIME 0.05f
 
-float _nrand(float sigma)
+float _nrand(float sigma, CRandom& random = ::Random)
 {
 #define ONE_OVER_SIGMA_EXP (1.0f / 0.7975f)
 
@@ -28,19 +28,19 @@ float _nrand(float sigma)
     float y;
     do
     {
-        y = -logf(Random.randF());
-    } while (Random.randF() > expf(-_sqr(y - 1.0f) * 0.5f));
-    if (rand() & 0x1)
+        y = -logf(random.randF());
+    } while (random.randF() > expf(-_sqr(y - 1.0f) * 0.5f));
+    if (random.randI() & 0x1)
         return y * sigma * ONE_OVER_SIGMA_EXP;
     else
         return -y * sigma * ONE_OVER_SIGMA_EXP;
 }
 
-void random_dir(Fvector& tgt_dir, const Fvector& src_dir, float dispersion)
+void random_dir(Fvector& tgt_dir, const Fvector& src_dir, float dispersion, CRandom& random)
 {
     float sigma = dispersion / 3.f;
-    float alpha = clampr(_nrand(sigma), -dispersion, dispersion);
-    float theta = Random.randF(0, PI);
+    float alpha = clampr(_nrand(sigma, random), -dispersion, dispersion);
+    float theta = random.randF(0, PI);
     float r = tan(alpha);
     Fvector U, V, T;
     Fvector::generate_orthonormal_basis(src_dir, U, V);
@@ -50,6 +50,11 @@ void random_dir(Fvector& tgt_dir, const Fvector& src_dir, float dispersion)
     tgt_dir.add(src_dir, T).normalize();
 }
 
+void random_dir(Fvector& tgt_dir, const Fvector& src_dir, float dispersion)
+{
+    random_dir(tgt_dir, src_dir, dispersion, ::Random);
+}
+
 float CWeapon::GetWeaponDeterioration() { return conditionDecreasePerShot; };
 void CWeapon::FireTrace(const Fvector& P, const Fvector& D)
 {
@@ -642,9 +642,7 @@ void CAI_Stalker::net_Destroy()
 
 #ifdef DEBUG
     fastdelegate::FastDelegate0<> f = fastdelegate::FastDelegate0<>(this, &CAI_Stalker::update_object_handler);
-    xr_vector<fastdelegate::FastDelegate0<>>::const_iterator I;
-    I = std::find(Device.seqParallel.begin(), Device.seqParallel.end(), f);
-    VERIFY(I == Device.seqParallel.end());
+    VERIFY(!Device.seqParallel.Has(f));
 #endif // DEBUG
 
     xr_delete(m_ce_close);
@@ -815,6 +813,7 @@ void CAI_Stalker::destroy_anim_mov_ctrl()
 
 void CAI_Stalker::UpdateCL()
 {
+    MemoryTagScope memoryTag(MemoryTag::AI);
     START_PROFILE("stalker")
     START_PROFILE("stalker/client_update")
     VERIFY2(PPhysicsShell() || getEnabled(), *cName());
@@ -824,12 +823,8 @@ void CAI_Stalker::UpdateCL()
         if (g_mt_config.test(mtObjectHandler) && CObjectHandler::planner().initialized())
         {
             fastdelegate::FastDelegate0<> f = fastdelegate::FastDelegate0<>(this, &CAI_Stalker::update_object_handler);
-#ifdef DEBUG
-            xr_vector<fastdelegate::FastDelegate0<>>::const_iterator I;
-            I = std::find(Device.seqParallel.begin(), Device.seqParallel.end(), f);
-            VERIFY(I == Device.seqParallel.end());
-#endif
-            Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CAI_Stalker::update_object_handler));
+            VERIFY(!Device.seqParallel.Has(f));
+            Device.seqParallel.Add(f);
         }
         else
         {
@@ -899,6 +894,7 @@ CPHDestroyable* CAI_Stalker::ph_destroyable() { return smart_cast<CPHDestroyable
 
 void CAI_Stalker::shedule_Update(u32 DT)
 {
+    MemoryTagScope memoryTag(MemoryTag::AI);
     START_PROFILE("stalker")
     START_PROFILE("stalker/schedule_update")
     VERIFY2(getEnabled() || PPhysicsShell(), *cName());
@@ -936,7 +932,8 @@ void CAI_Stalker::shedule_Update(u32 DT)
 		memory().visual().check_visibles();
 #endif
         if (false && g_mt_config.test(mtAiVision))
-            Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CCustomMonster::Exec_Visibility));
+            Device.seqParallel.Add(
+                fastdelegate::FastDelegate0<>(this, &CCustomMonster::Exec_Visibility), FrameJobChain::Vision);
         else
         {
             START_PROFILE("stalker/schedule_update/vision")
@@ -0,0 +1,114 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: alife_switch_grid.cpp
+//	Created 	: 16.10.2026
+//	Description : ALife switch grid: game vertices of the current level bucketed by position
+////////////////////////////////////////////////////////////////////////////
+
+#include "StdAfx.h"
+#include "alife_switch_grid.h"
+#include "ai_space.h"
+#include "xrAICore/Navigation/game_graph.h"
+#include "xrAICore/Navigation/game_level_cross_table.h"
+#include "xrAICore/Navigation/level_graph.h"
+
+static float const cell_size = 64.f;
+// objects may stand a bit off their level vertex
+static float const object_margin = 2.f;
+// a cell gets near closer than online distance + band_near and gets distant further than online distance + band_far
+static float const band_near = 8.f;
+static float const band_far = 24.f;
+
+CALifeSwitchGrid::CALifeSwitchGrid() : m_level_id(GameGraph::_LEVEL_ID(-1)), m_built(false) {}
+
+void CALifeSwitchGrid::clear()
+{
+    m_cells.clear();
+    m_vertex_cells.clear();
+    m_crossed.clear();
+    m_level_id = GameGraph::_LEVEL_ID(-1);
+    m_built = false;
+}
+
+void CALifeSwitchGrid::build(GameGraph::_LEVEL_ID level_id)
+{
+    clear();
+    m_level_id = level_id;
+    m_built = true;
+
+    const CGameGraph& game_graph = ai().game_graph();
+    const u32 vertex_count = game_graph.header().vertex_count();
+    m_vertex_cells.assign(vertex_count, invalid_cell);
+
+    xr_map<u32, u32> cell_ids;
+    for (u32 i = 0; i < vertex_count; ++i)
+    {
+        const CGameGraph::CVertex* vertex = game_graph.vertex(i);
+        if (vertex->level_id() != level_id)
+            continue;
+
+        const Fvector& point = vertex->level_point();
+        const u32 x = u32(s32(iFloor(point.x / cell_size)) & 0xffff);
+        const u32 z = u32(s32(iFloor(point.z / cell_size)) & 0xffff);
+        const auto inserted = cell_ids.insert(std::make_pair((x << 16) | z, u32(m_cells.size())));
+        if (inserted.second)
+        {
+            m_cells.push_back(SCell());
+            m_cells.back().box.set(point, point);
+            m_cells.back().distant = false;
+        }
+
+        SCell& cell = m_cells[inserted.first->second];
+        cell.box.modify(point);
+        cell.vertices.push_back(GameGraph::_GRAPH_ID(i));
+        m_vertex_cells[i] = inserted.first->second;
+    }
+
+    const CLevelGraph* level_graph = ai().get_level_graph();
+    const CGameLevelCrossTable* cross_table = ai().get_cross_table();
+    if (level_graph && cross_table)
+    {
+        const u32 level_vertex_count = cross_table->header().level_vertex_count();
+        for (u32 i = 0; i < level_vertex_count; ++i)
+        {
+            const GameGraph::_GRAPH_ID game_vertex_id = cross_table->vertex(i).game_vertex_id();
+            if (game_vertex_id >= vertex_count || m_vertex_cells[game_vertex_id] == invalid_cell)
+                continue;
+            m_cells[m_vertex_cells[game_vertex_id]].box.modify(level_graph->vertex_position(i));
+        }
+    }
+
+    for (SCell& cell : m_cells)
+        cell.box.grow(object_margin);
+}
+
+void CALifeSwitchGrid::update(const Fvector& actor_position, float online_distance)
+{
+    m_crossed.clear();
+    const float near_distance = _sqr(online_distance + band_near);
+    const float far_distance = _sqr(online_distance + band_far);
+    for (u32 i = 0, n = m_cells.size(); i < n; ++i)
+    {
+        SCell& cell = m_cells[i];
+        Fvector nearest;
+        nearest.x = clampr(actor_position.x, cell.box.vMin.x, cell.box.vMax.x);
+        nearest.y = clampr(actor_position.y, cell.box.vMin.y, cell.box.vMax.y);
+        nearest.z = clampr(actor_position.z, cell.box.vMin.z, cell.box.vMax.z);
+        const float distance = actor_position.distance_to_sqr(nearest);
+
+        if (!cell.distant)
+            cell.distant = distance > far_distance;
+        else if (distance <= near_distance)
+        {
+            cell.distant = false;
+            m_crossed.push_back(i);
+        }
+    }
+}
+
+bool CALifeSwitchGrid::distant(GameGraph::_GRAPH_ID vertex_id) const
+{
+    if (vertex_id >= m_vertex_cells.size())
+        return false;
+    const u32 cell = m_vertex_cells[vertex_id];
+    return cell != invalid_cell && m_cells[cell].distant;
+}
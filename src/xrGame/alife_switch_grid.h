@@ -0,0 +1,50 @@
+////////////////////////////////////////////////////////////////////////////
+//	Module 		: alife_switch_grid.h
+//	Created 	: 16.10.2026
+//	Description : ALife switch grid: game vertices of the current level bucketed by position
+////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "xrAICore/Navigation/game_graph_space.h"
+
+/*
+ * Game vertices of the current level are bucketed into square cells.
+ * Cell box covers the vertices and all the level vertices the cross table assigns to them,
+ * so an offline object standing on its level vertex is inside the box of its game vertex cell.
+ * A cell is distant when the box is further from the actor than the online distance,
+ * offline objects of distant cells can't switch online by distance and the switch pass skips them.
+ * The band is changed with hysteresis, the cells which got near are reported once,
+ * their objects are examined in the same update.
+ */
+class CALifeSwitchGrid
+{
+public:
+    static const u32 invalid_cell = u32(-1);
+
+    struct SCell
+    {
+        Fbox box;
+        xr_vector<GameGraph::_GRAPH_ID> vertices;
+        bool distant;
+    };
+
+private:
+    xr_vector<SCell> m_cells;
+    xr_vector<u32> m_vertex_cells; // game vertex -> cell, invalid_cell for the other levels
+    xr_vector<u32> m_crossed; // cells which got near during the last update
+    GameGraph::_LEVEL_ID m_level_id;
+    bool m_built;
+
+public:
+    CALifeSwitchGrid();
+
+    void build(GameGraph::_LEVEL_ID level_id);
+    void clear();
+    void update(const Fvector& actor_position, float online_distance);
+
+    bool built(GameGraph::_LEVEL_ID level_id) const { return m_built && m_level_id == level_id; }
+    bool distant(GameGraph::_GRAPH_ID vertex_id) const;
+    const xr_vector<SCell>& cells() const { return m_cells; }
+    const xr_vector<u32>& crossed() const { return m_crossed; }
+};
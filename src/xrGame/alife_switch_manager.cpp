@@ -24,6 +24,9 @@
 
 using namespace ALife;
 
+BOOL g_alife_switch_grid = TRUE;
+int g_alife_switch_distant_period = 8;
+
 struct remove_non_savable_predicate
 {
     IPureServer* m_server;
@@ -111,6 +114,7 @@ void CALifeSwitchManager::switch_online(CSE_ALifeDynamicObject* object)
         Device.dwTimeGlobal, object->name_replace(), object->ID, VPUSH(graph().actor()->o_Position),
         VPUSH(object->o_Position), "*SERVER*");
 #endif
+    ++m_switch_switched;
     object->switch_online();
     STOP_PROFILE
 }
@@ -124,6 +128,7 @@ void CALifeSwitchManager::switch_offline(CSE_ALifeDynamicObject* object)
         Device.dwTimeGlobal, object->name_replace(), object->ID, VPUSH(graph().actor()->o_Position),
         VPUSH(object->o_Position), "*SERVER*");
 #endif
+    ++m_switch_switched;
     object->switch_offline();
     STOP_PROFILE
 }
@@ -254,3 +259,100 @@ void CALifeSwitchManager::switch_object(CSE_ALifeDynamicObject* I)
     if (I->redundant())
         release(I);
 }
+
+bool CALifeSwitchManager::switch_skip(CSE_ALifeDynamicObject* I, u64 cycle_count)
+{
+    if (!g_alife_switch_grid || I->m_bOnline || (0xffff != I->ID_Parent) || !I->used_ai_locations())
+        return (false);
+
+    // these are switched regardless of the distance
+    if (!I->can_switch_online() || !I->can_switch_offline())
+        return (false);
+
+    if (!m_switch_grid.distant(I->m_tGraphID))
+        return (false);
+
+    // distant objects still get the whole switch update once in a while:
+    // it keeps their schedule and location up to date and finds the objects moved off their game vertex
+    if (!((cycle_count + I->ID) % u64(g_alife_switch_distant_period)))
+        return (false);
+
+    ++m_switch_skipped;
+    return (true);
+}
+
+void CALifeSwitchManager::switch_object(CSE_ALifeDynamicObject* I, u64 cycle_count)
+{
+    if (switch_skip(I, cycle_count))
+        return;
+
+    ++m_switch_examined;
+    switch_object(I);
+}
+
+void CALifeSwitchManager::update_switch_grid()
+{
+    START_PROFILE("ALife/switch/grid")
+    m_switch_examined = m_switch_skipped = m_switch_switched = 0;
+    if (!g_alife_switch_grid)
+        return;
+
+    GameGraph::_LEVEL_ID const level_id = graph().level().level_id();
+    if (!m_switch_grid.built(level_id))
+    {
+        m_switch_grid.build(level_id);
+        m_switch_updates = m_switch_examined_total = m_switch_skipped_total = m_switch_switched_total = 0;
+    }
+
+    m_switch_grid.update(graph().actor()->o_Position, online_distance());
+
+    // objects of the cells got near are examined right away, not when the level registry gets to them
+    m_crossed_objects.clear();
+    for (u32 cell_id : m_switch_grid.crossed())
+    {
+        for (GameGraph::_GRAPH_ID vertex_id : m_switch_grid.cells()[cell_id].vertices)
+        {
+            for (const auto& it : graph().objects()[vertex_id].objects().objects())
+                m_crossed_objects.push_back(it.first);
+        }
+    }
+
+    for (ALife::_OBJECT_ID id : m_crossed_objects)
+    {
+        // switching an object can release or attach the others
+        CSE_ALifeDynamicObject* object = graph().level().object(id, true);
+        if (!object || object->m_bOnline)
+            continue;
+
+        ++m_switch_examined;
+        switch_object(object);
+    }
+    STOP_PROFILE
+}
+
+void CALifeSwitchManager::update_switch_end()
+{
+    ++m_switch_updates;
+    m_switch_examined_total += m_switch_examined;
+    m_switch_skipped_total += m_switch_skipped;
+    m_switch_switched_total += m_switch_switched;
+}
+
+void CALifeSwitchManager::switch_statistics() const
+{
+    u32 distant = 0;
+    for (const CALifeSwitchGrid::SCell& cell : m_switch_grid.cells())
+        distant += cell.distant ? 1 : 0;
+
+    Msg("* ALife switch: grid %s, %u cells, %u distant, %u got near in the last update",
+        g_alife_switch_grid ? "on" : "off", u32(m_switch_grid.cells().size()), distant,
+        u32(m_switch_grid.crossed().size()));
+    Msg("* Last update: %u examined, %u skipped, %u switched", m_switch_examined, m_switch_skipped,
+        m_switch_switched);
+    if (!m_switch_updates)
+        return;
+
+    Msg("* Per update: %.1f examined, %.1f skipped, %.2f switched (%llu updates)",
+        float(m_switch_examined_total) / m_switch_updates, float(m_switch_skipped_total) / m_switch_updates,
+        float(m_switch_switched_total) / m_switch_updates, m_switch_updates);
+}
@@ -8,6 +8,10 @@
 
 #pragma once
 #include "alife_simulator_base.h"
+#include "alife_switch_grid.h"
+
+extern BOOL g_alife_switch_grid;
+extern int g_alife_switch_distant_period;
 
 // XXX: WTF is this? CALifeSwitchManager IS-A CRandom??? I think NOT! CRandom should be aggregated, NOT inherited from!
 class CALifeSwitchManager : public virtual CALifeSimulatorBase, CRandom
@@ -24,9 +28,23 @@ protected:
 
 private:
     OBJECT_VECTOR m_saved_chidren;
+    CALifeSwitchGrid m_switch_grid;
+    xr_vector<ALife::_OBJECT_ID> m_crossed_objects;
+
+    // counters of the last switch update and the totals since the grid was built
+    u32 m_switch_examined;
+    u32 m_switch_skipped;
+    u32 m_switch_switched;
+    u64 m_switch_updates;
+    u64 m_switch_examined_total;
+    u64 m_switch_skipped_total;
+    u64 m_switch_switched_total;
 
 protected:
     bool synchronize_location(CSE_ALifeDynamicObject* object);
+    bool switch_skip(CSE_ALifeDynamicObject* object, u64 cycle_count);
+    void update_switch_grid();
+    void update_switch_end();
 
 public:
     void try_switch_online(CSE_ALifeDynamicObject* object);
@@ -40,6 +58,8 @@ public:
     IC CALifeSwitchManager(IPureServer* server, LPCSTR section);
     virtual ~CALifeSwitchManager();
     void switch_object(CSE_ALifeDynamicObject* object);
+    void switch_object(CSE_ALifeDynamicObject* object, u64 cycle_count);
+    void switch_statistics() const;
     IC float online_distance() const noexcept;
     IC float offline_distance() const noexcept;
     IC float switch_distance() const noexcept;
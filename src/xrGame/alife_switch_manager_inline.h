@@ -14,6 +14,8 @@ IC CALifeSwitchManager::CALifeSwitchManager(IPureServer* server, LPCSTR section)
     m_switch_factor = pSettings->r_float(section, "switch_factor");
     set_switch_distance(m_switch_distance);
     seed(u32(CPU::QPC() & 0xffffffff));
+    m_switch_examined = m_switch_skipped = m_switch_switched = 0;
+    m_switch_updates = m_switch_examined_total = m_switch_skipped_total = m_switch_switched_total = 0;
 }
 
 IC float CALifeSwitchManager::online_distance() const noexcept { return (m_online_distance); }
@@ -46,7 +46,7 @@ public:
 
     IC void operator()(CALifeLevelRegistry::_iterator& i, u64 cycle_count) const
     {
-        m_switch_manager->switch_object((*i).second);
+        m_switch_manager->switch_object((*i).second, cycle_count);
     }
 };
 
@@ -81,7 +81,9 @@ void CALifeUpdateManager::update_switch()
     init_ef_storage();
 
     START_PROFILE("ALife/switch");
+    update_switch_grid();
     graph().level().update(CSwitchPredicate(this), Device.dwPrecacheFrame > 0);
+    update_switch_end();
     STOP_PROFILE
 }
 
@@ -97,6 +99,7 @@ void CALifeUpdateManager::update_scheduled(bool init_ef)
 
 void CALifeUpdateManager::update()
 {
+    MemoryTagScope memoryTag(MemoryTag::ALife);
     update_switch();
     update_scheduled(false);
 }
@@ -110,7 +113,7 @@ void CALifeUpdateManager::shedule_Update(u32 dt)
 
     if (!m_first_time && g_mt_config.test(mtALife))
     {
-        Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CALifeUpdateManager::update));
+        Device.seqParallel.Add(fastdelegate::FastDelegate0<>(this, &CALifeUpdateManager::update));
         return;
     }
 
@@ -119,7 +119,7 @@ void register_mp_console_commands();
 BOOL g_bCheckTime = FALSE;
 int net_cl_inputupdaterate = 50;
 Flags32 g_mt_config = {mtLevelPath | mtDetailPath | mtObjectHandler | mtSoundPlayer | mtAiVision | mtBullets |
-    mtLUA_GC | mtLevelSounds | mtALife | mtMap};
+    mtLUA_GC | mtLevelSounds | mtALife | mtMap | mtBulletsParallel};
 #ifdef DEBUG
 Flags32 dbg_net_Draw_Flags = {0};
 #endif
@@ -163,6 +163,15 @@ static void full_memory_stats()
     Msg("* [ Render ]: textures[%d K]", (m_base + m_lmaps) / 1024);
     Msg("* [ x-ray  ]: process heap[%u K]", _process_heap / 1024);
     Msg("* [ x-ray  ]: economy: strings[%d K], smem[%d K]", _eco_strings / 1024, _eco_smem);
+    Msg("* [ x-ray  ]: small-object bins[%u K], frame arena[%u K]", ::Memory.stat_bins_reserved() / 1024,
+        ::Memory.frame_used() / 1024);
+    for (u32 tag = 0; tag < u32(MemoryTag::Count); ++tag)
+    {
+        xrMemory::TagStats stats;
+        ::Memory.stat_tag(MemoryTag(tag), stats);
+        Msg("* [ memory ]: %-8s: %lld K in %lld blocks, %llu allocations", get_memory_tag_name(MemoryTag(tag)),
+            stats.bytes / 1024, stats.blocks, stats.allocations);
+    }
 #ifdef FS_DEBUG
     Msg("* [ x-ray  ]: file mapping: memory[%d K], count[%d]", g_file_mapped_memory / 1024, g_file_mapped_count);
     dump_file_mappings();
@@ -410,6 +419,19 @@ public:
     }
 };
 
+class CCC_ALifeSwitchStats : public IConsole_Command
+{
+public:
+    CCC_ALifeSwitchStats(LPCSTR N) : IConsole_Command(N) { bEmptyArgsHandled = true; };
+    virtual void Execute(LPCSTR args)
+    {
+        if (ai().get_alife())
+            ai().alife().switch_statistics();
+        else
+            Log("!ALife simulator is not running");
+    }
+};
+
 //-----------------------------------------------------------------------
 class CCC_DemoRecord : public IConsole_Command
 {
@@ -1867,6 +1889,9 @@ void CCC_RegisterCommands()
     CMD1(CCC_ALifeProcessTime, "al_process_time"); // set process time
     CMD1(CCC_ALifeObjectsPerUpdate, "al_objects_per_update"); // set process time
     CMD1(CCC_ALifeSwitchFactor, "al_switch_factor"); // set switch factor
+    CMD4(CCC_Integer, "al_switch_grid", &g_alife_switch_grid, 0, 1); // skip offline objects of distant cells
+    CMD4(CCC_Integer, "al_switch_distant_period", &g_alife_switch_distant_period, 1, 256);
+    CMD1(CCC_ALifeSwitchStats, "al_switch_stats");
 #endif // #ifndef MASTER_GOLD
 
     CMD3(CCC_Mask, "hud_weapon", &psHUD_Flags, HUD_WEAPON);
@@ -1898,6 +1923,7 @@ void CCC_RegisterCommands()
     CMD3(CCC_Mask, "mt_object_handler", &g_mt_config, mtObjectHandler);
     CMD3(CCC_Mask, "mt_sound_player", &g_mt_config, mtSoundPlayer);
     CMD3(CCC_Mask, "mt_bullets", &g_mt_config, mtBullets);
+    CMD3(CCC_Mask, "mt_bullets_parallel", &g_mt_config, mtBulletsParallel);
     CMD3(CCC_Mask, "mt_script_gc", &g_mt_config, mtLUA_GC);
     CMD3(CCC_Mask, "mt_level_sounds", &g_mt_config, mtLevelSounds);
     CMD3(CCC_Mask, "mt_alife", &g_mt_config, mtALife);
@@ -1999,6 +2025,7 @@ void CCC_RegisterCommands()
     // Physics
     CMD1(CCC_PHFps, "ph_frequency");
     CMD1(CCC_PHIterations, "ph_iterations");
+    CMD4(CCC_Integer, "ph_parallel_step", &ph_console::ph_parallel_step, 0, 1);
 
 #ifdef DEBUG
     CMD1(CCC_PHGravity, "ph_gravity");
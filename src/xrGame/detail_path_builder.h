@@ -40,7 +40,7 @@ public:
     void register_to_process()
     {
         m_object->m_wait_for_distributed_computation = true;
-        Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CDetailPathBuilder::process));
+        Device.seqParallel.Add(fastdelegate::FastDelegate0<>(this, &CDetailPathBuilder::process));
     }
 
     void process_impl(bool separate_computing = true)
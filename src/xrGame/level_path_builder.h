@@ -65,7 +65,7 @@ public:
         if (Device.dwTimeGlobal < m_last_fail_time + time_to_wait_after_fail)
             return;
 
-        Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(this, &CLevelPathBuilder::process));
+        Device.seqParallel.Add(fastdelegate::FastDelegate0<>(this, &CLevelPathBuilder::process));
     }
 
     void process_impl()
@@ -199,7 +199,7 @@ void CUIPdaWnd::Update()
     }
 
     if (pUILogsWnd)
-        Device.seqParallel.push_back(fastdelegate::FastDelegate0<>(pUILogsWnd, &CUILogsWnd::PerformWork));
+        Device.seqParallel.Add(fastdelegate::FastDelegate0<>(pUILogsWnd, &CUILogsWnd::PerformWork));
 }
 
 void CUIPdaWnd::SetActiveSubdialog(const shared_str& section)
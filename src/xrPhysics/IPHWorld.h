@@ -22,21 +22,32 @@ public:
     struct PHWorldStatistics
     {
         CStatTimer Collision; // collision
+        CStatTimer Broadphase; // collision candidates, a part of collision
+        CStatTimer Tune; // before integrate
         CStatTimer Core; // integrate
+        CStatTimer Update; // after integrate
         CStatTimer MovCollision; // movement+collision
+        u32 Islands; // integrated islands
 
         PHWorldStatistics() { FrameStart(); }
         void FrameStart()
         {
             Collision.FrameStart();
+            Broadphase.FrameStart();
+            Tune.FrameStart();
             Core.FrameStart();
+            Update.FrameStart();
             MovCollision.FrameStart();
+            Islands = 0;
         }
 
         void FrameEnd()
         {
             Collision.FrameEnd();
+            Broadphase.FrameEnd();
+            Tune.FrameEnd();
             Core.FrameEnd();
+            Update.FrameEnd();
             MovCollision.FrameEnd();
         }
     };
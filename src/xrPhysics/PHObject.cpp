@@ -82,26 +82,86 @@ void CPHObject::spatial_move()
     m_flags.set(st_dirty, TRUE);
 }
 
-void CPHObject::Collide()
+namespace
+{
+bool ray_motion(CPHMoveStorage::iterator& I, const Fvector*& from, Fvector& dir, float& magnitude)
+{
+    const Fvector* to = 0;
+    I.Positions(from, to);
+    if (from->x == -dInfinity)
+        return false;
+    dir.sub(*to, *from);
+    magnitude = dir.magnitude();
+    if (magnitude < EPS)
+        return false;
+    dir.mul(1.f / magnitude);
+    return true;
+}
+
+thread_local qResultVec ray_query_result;
+} // namespace
+
+bool CPHObject::HasCollideCandidates() const
+{
+    return ph_world->CollideCandidatesGathered() && m_candidates.step == ph_world->m_steps_num;
+}
+
+// Can be called from a worker thread, touches only the object itself and the spatial db
+void CPHObject::CollideQuery()
 {
+    m_candidates.rays.clear();
+    m_candidates.ray_ends.clear();
     if (m_flags.test(fl_ray_motions))
     {
         CPHMoveStorage* tracers = MoveStorage();
         CPHMoveStorage::iterator I = tracers->begin(), E = tracers->end();
         for (; E != I; ++I)
         {
-            const Fvector *from = 0, *to = 0;
+            const Fvector* from = 0;
             Fvector dir;
-            I.Positions(from, to);
-            if (from->x == -dInfinity)
-                continue;
-            dir.sub(*to, *from);
-            float magnitude = dir.magnitude();
-            if (magnitude < EPS)
+            float magnitude;
+            if (ray_motion(I, from, dir, magnitude))
+            {
+                g_SpatialSpacePhysic->q_ray(ray_query_result, 0, STYPE_PHYSIC, *from, dir, magnitude);
+                m_candidates.rays.insert(m_candidates.rays.end(), ray_query_result.begin(), ray_query_result.end());
+            }
+            m_candidates.ray_ends.push_back(u32(m_candidates.rays.size()));
+        }
+    }
+    g_SpatialSpacePhysic->q_box(m_candidates.dynamics, 0, STYPE_PHYSIC, spatial.sphere.P, AABB);
+    m_candidates.step = ph_world->m_steps_num;
+}
+
+void CPHObject::Collide()
+{
+    const bool gathered = HasCollideCandidates();
+    if (m_flags.test(fl_ray_motions))
+    {
+        CPHMoveStorage* tracers = MoveStorage();
+        CPHMoveStorage::iterator I = tracers->begin(), E = tracers->end();
+        for (u32 tracer = 0; E != I; ++I, ++tracer)
+        {
+            const Fvector* from = 0;
+            Fvector dir;
+            float magnitude;
+            if (!ray_motion(I, from, dir, magnitude))
                 continue;
-            dir.mul(1.f / magnitude);
-            g_SpatialSpacePhysic->q_ray(
-                ph_world->r_spatial, 0, STYPE_PHYSIC, *from, dir, magnitude); //|ISpatial_DB::O_ONLYFIRST
+
+            ISpatial* const* i;
+            ISpatial* const* e;
+            if (gathered)
+            {
+                VERIFY(tracer < m_candidates.ray_ends.size());
+                i = m_candidates.rays.data() + (tracer ? m_candidates.ray_ends[tracer - 1] : 0);
+                e = m_candidates.rays.data() + m_candidates.ray_ends[tracer];
+            }
+            else
+            {
+                g_SpatialSpacePhysic->q_ray(
+                    ph_world->r_spatial, 0, STYPE_PHYSIC, *from, dir, magnitude); //|ISpatial_DB::O_ONLYFIRST
+                i = ph_world->r_spatial.data();
+                e = i + ph_world->r_spatial.size();
+            }
 #ifdef DEBUG
             if (debug_output().ph_dbg_draw_mask().test(phDbgDrawRayMotions))
             {
@@ -112,8 +172,6 @@ void CPHObject::Collide()
             }
 
 #endif
-            qResultVec& result = ph_world->r_spatial;
-            auto i = result.begin(), e = result.end();
             for (; i != e; ++i)
             {
                 CPHObject* obj2 = smart_cast<CPHObject*>(*i);
@@ -132,12 +190,17 @@ void CPHObject::Collide()
     if (CPHCollideValidator::DoCollideStatic(*this))
         CollideStatic(dSpacedGeom(), this);
     m_flags.set(st_dirty, FALSE);
+    m_candidates.step = u64(-1);
 }
 void CPHObject::CollideDynamics()
 {
-    g_SpatialSpacePhysic->q_box(ph_world->r_spatial, 0, STYPE_PHYSIC, spatial.sphere.P, AABB);
-    qResultVec& result = ph_world->r_spatial;
-    auto i = result.begin(), e = result.end();
+    qResultVec* result = &m_candidates.dynamics;
+    if (!HasCollideCandidates())
+    {
+        result = &ph_world->r_spatial;
+        g_SpatialSpacePhysic->q_box(*result, 0, STYPE_PHYSIC, spatial.sphere.P, AABB);
+    }
+    auto i = result->begin(), e = result->end();
     for (; i != e; ++i)
     {
         CPHObject* obj2 = smart_cast<CPHObject*>(*i);
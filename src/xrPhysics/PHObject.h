@@ -40,6 +40,17 @@ class CPHObject : public SpatialBase
     u8 m_check_count;
     _flags<CLClassBits> m_collide_class_bits;
 
+    // Broadphase results gathered by CollideQuery() for Collide() of the same step
+    struct SCollideCandidates
+    {
+        qResultVec dynamics;
+        qResultVec rays; // of all ray motions one after another
+        xr_vector<u32> ray_ends; // where the results of every ray motion end
+        u64 step = u64(-1);
+    } m_candidates;
+
+    bool HasCollideCandidates() const;
+
 public:
     enum ECastType
     {
@@ -104,6 +115,7 @@ public:
     void collision_enable();
     virtual void ClearRecentlyDeactivated() { ; }
     virtual void Collide();
+    virtual void CollideQuery();
     virtual void near_callback(CPHObject* obj) { ; }
     virtual void RMotionsQuery(qResultVec& res) { ; }
     virtual CPHMoveStorage* MoveStorage() { return NULL; }
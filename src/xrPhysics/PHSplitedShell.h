@@ -8,6 +8,7 @@ class CPHSplitedShell : public CPHShell
     virtual void SetMaxAABBRadius(float size) { m_max_AABBradius = size; }
 protected:
     virtual void Collide();
+    virtual void CollideQuery() {} // collides with the static geometry only
     virtual void get_spatial_params();
     virtual void DisableObject();
 
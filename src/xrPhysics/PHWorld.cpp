@@ -11,6 +11,7 @@
 #include "xrEngine/device.h"
 #include "xrEngine/GameFont.h"
 #include "xrEngine/PerformanceAlert.hpp"
+#include "xrEngine/TaskScheduler.hpp"
 
 #include "params.h"
 #ifdef DEBUG
@@ -133,6 +134,7 @@ CPHWorld::CPHWorld()
     m_update_delay_count = 0;
     b_world_freezed = false;
     b_processing = false;
+    b_collide_candidates = false;
     m_gravity = default_world_gravity;
     b_exist = false;
 }
@@ -266,7 +268,10 @@ void CPHWorld::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
     float percentage = 100.0f * stats.MovCollision.result / engineTotal;
     font.OutNext("Physics:      %2.2fms, %2.1f%%", stats.MovCollision.result, percentage);
     font.OutNext("- collider:   %2.2fms", stats.Collision.result);
-    font.OutNext("- solver:     %2.2fms, %d", stats.Core.result, stats.Core.count);
+    font.OutNext("  - gather:   %2.2fms", stats.Broadphase.result);
+    font.OutNext("- tune:       %2.2fms", stats.Tune.result);
+    font.OutNext("- solver:     %2.2fms, %d, islands: %u", stats.Core.result, stats.Core.count, stats.Islands);
+    font.OutNext("- update:     %2.2fms", stats.Update.result);
     if (alert && stats.MovCollision.result > 5.0f)
         alert->Print(font, "Physics   > 5ms:  %3.1f", stats.MovCollision.result);
 }
@@ -301,8 +306,12 @@ void CPHWorld::Step()
 
     ++m_steps_num;
     ++m_steps_short_num;
+    const bool parallel = ph_console::ph_parallel_step && TaskScheduler->GetWorkersCount();
     stats.Collision.Begin();
 
+    if (parallel)
+        GatherCollideCandidates();
+
     for (i_object = m_objects.begin(); m_objects.end() != i_object;)
     {
         CPHObject* obj = (*i_object);
@@ -315,6 +324,7 @@ void CPHWorld::Step()
 #endif
         ++i_object;
     }
+    b_collide_candidates = false;
 
     stats.Collision.End();
 
@@ -328,6 +338,7 @@ void CPHWorld::Step()
     }
 #endif
 
+    stats.Tune.Begin();
     for (i_object = m_objects.begin(); m_objects.end() != i_object;)
     {
         CPHObject* obj = (*i_object);
@@ -350,6 +361,7 @@ void CPHWorld::Step()
         ++i_update_object;
         obj->PhTune(fixed_step);
     }
+    stats.Tune.End();
 
     stats.Core.Begin();
 
@@ -363,34 +375,42 @@ void CPHWorld::Step()
     m_update_callback->update_step();
     //	m_commander						->update();
     //////////////////////////////////////////////////////////////////////
-    for (i_object = m_objects.begin(); m_objects.end() != i_object;)
+    if (parallel)
+        StepIslands();
+    else
     {
-        CPHObject* obj = (*i_object);
-        ++i_object;
-#ifdef DEBUG
-        if (debug_output().ph_dbg_draw_mask().test(phDbgDrawObjectStatistics))
+        for (i_object = m_objects.begin(); m_objects.end() != i_object;)
         {
-            if (obj->Island().IsActive())
+            CPHObject* obj = (*i_object);
+            ++i_object;
+#ifdef DEBUG
+            if (debug_output().ph_dbg_draw_mask().test(phDbgDrawObjectStatistics))
             {
-                debug_output().dbg_islands_num()++;
-                debug_output().dbg_joints_num() += obj->Island().nj;
-                debug_output().dbg_bodies_num() += obj->Island().nb;
+                if (obj->Island().IsActive())
+                {
+                    debug_output().dbg_islands_num()++;
+                    debug_output().dbg_joints_num() += obj->Island().nj;
+                    debug_output().dbg_bodies_num() += obj->Island().nb;
+                }
             }
-        }
 #endif
 
 #ifdef DEBUG
-        debug_output().DBG_ObjBeforeStep(obj);
+            debug_output().DBG_ObjBeforeStep(obj);
 #endif
-        obj->IslandStep(fixed_step);
+            if (obj->Island().IsActive())
+                ++stats.Islands;
+            obj->IslandStep(fixed_step);
 
 #ifdef DEBUG
-        debug_output().DBG_ObjAfterStep(obj);
+            debug_output().DBG_ObjAfterStep(obj);
 #endif
+        }
     }
 
     stats.Core.End();
 
+    stats.Update.Begin();
     for (i_object = m_objects.begin(); m_objects.end() != i_object;)
     {
         CPHObject* obj = (*i_object);
@@ -416,6 +436,7 @@ void CPHWorld::Step()
         ++i_update_object;
         obj->PhDataUpdate(fixed_step);
     }
+    stats.Update.End();
 
 #ifdef DEBUG
     debug_output().dbg_contacts_num() = ContactGroup->num;
@@ -431,6 +452,60 @@ void CPHWorld::Step()
     };
 }
 
+// Broadphase of all active objects: only reads the spatial db, so every object gathers its candidates on its own
+void CPHWorld::GatherCollideCandidates()
+{
+    stats.Broadphase.Begin();
+    m_step_objects.clear();
+    for (PH_OBJECT_I i_object = m_objects.begin(); m_objects.end() != i_object; ++i_object)
+        m_step_objects.push_back(*i_object);
+
+    TaskScheduler->ParallelFor(0, m_step_objects.size(), 0, [this](size_t from, size_t to)
+    {
+        for (size_t i = from; i < to; ++i)
+            m_step_objects[i]->CollideQuery();
+    });
+    b_collide_candidates = true;
+    stats.Broadphase.End();
+}
+
+// Active islands share no bodies and joints after the collision, so they are integrated in parallel.
+// The solver doesn't use any global state, the result depends only on the island itself.
+void CPHWorld::StepIslands()
+{
+    m_step_islands.clear();
+    for (PH_OBJECT_I i_object = m_objects.begin(); m_objects.end() != i_object; ++i_object)
+    {
+        CPHObject* obj = (*i_object);
+#ifdef DEBUG
+        if (debug_output().ph_dbg_draw_mask().test(phDbgDrawObjectStatistics))
+        {
+            if (obj->Island().IsActive())
+            {
+                debug_output().dbg_islands_num()++;
+                debug_output().dbg_joints_num() += obj->Island().nj;
+                debug_output().dbg_bodies_num() += obj->Island().nb;
+            }
+        }
+        debug_output().DBG_ObjBeforeStep(obj);
+#endif
+        if (obj->Island().IsActive())
+            m_step_islands.push_back(&obj->Island());
+    }
+    stats.Islands += u32(m_step_islands.size());
+
+    TaskScheduler->ParallelFor(0, m_step_islands.size(), 0, [this](size_t from, size_t to)
+    {
+        for (size_t i = from; i < to; ++i)
+            m_step_islands[i]->Step(fixed_step);
+    });
+
+#ifdef DEBUG
+    for (PH_OBJECT_I i_object = m_objects.begin(); m_objects.end() != i_object; ++i_object)
+        debug_output().DBG_ObjAfterStep(*i_object);
+#endif
+}
+
 void CPHWorld::StepTouch()
 {
     PH_OBJECT_I i_object;
@@ -65,6 +65,10 @@ private:
     CObjectList* m_level_objects;
     CRenderDeviceBase* m_device;
     ;
+    // Parallel step, see ph_console::ph_parallel_step
+    xr_vector<CPHObject*> m_step_objects;
+    xr_vector<CPHIsland*> m_step_islands;
+    bool b_collide_candidates;
 
 public:
     xr_vector<ISpatial*> r_spatial;
@@ -112,6 +116,7 @@ public:
     void FrameStep(dReal step = 0.025f);
     void Step();
     void StepTouch();
+    IC bool CollideCandidatesGathered() const { return b_collide_candidates; }
     void CutVelocity(float l_limit, float a_limit);
     void GetState(V_PH_WORLD_STATE& state);
     void Freeze();
@@ -157,6 +162,8 @@ public:
 
 private:
     void StepNumIterations(int num_it);
+    void GatherCollideCandidates();
+    void StepIslands();
     iphysics_scripted& get_scripted() { return *this; }
     void set_step_time_callback(PhysicsStepTimeCallback* cb) { physics_step_time_callback = cb; }
     void set_update_callback(IPHWorldUpdateCallbck* cb)
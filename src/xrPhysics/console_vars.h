@@ -8,4 +8,5 @@ struct XRPHYSICS_API ph_console
     static float phBreakCommonFactor; //= 0.01f;
     static float phRigidBreakWeaponFactor; //= 1.f;
     static float ph_step_time; //=fixed_step;
+    static BOOL ph_parallel_step; //= 1;
 };
@@ -46,6 +46,7 @@ static void* lua_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
 {
     (void)ud;
     (void)osize;
+    MemoryTagScope memoryTag(MemoryTag::Scripts);
     if (!nsize)
     {
         xr_free(ptr);
@@ -56,6 +57,7 @@ static void* lua_alloc(void* ud, void* ptr, size_t osize, size_t nsize)
 
 static void* __cdecl luabind_allocator(void* context, const void* pointer, size_t const size)
 {
+    MemoryTagScope memoryTag(MemoryTag::Scripts);
     if (!size)
     {
         void* non_const_pointer = const_cast<LPVOID>(pointer);
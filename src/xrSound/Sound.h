@@ -35,6 +35,8 @@ XRSOUND_API extern float psSoundOcclusionScale;
 XRSOUND_API extern Flags32 psSoundFlags;
 XRSOUND_API extern int psSoundTargets;
 XRSOUND_API extern int psSoundCacheSizeMB;
+XRSOUND_API extern int psSoundDecodeAhead; // ms of sound decoded in background ahead of the playing position
+XRSOUND_API extern int psSoundOcclusionBudget; // emitters traced for occlusion per update, 0 - no limit
 XRSOUND_API extern u32 psSoundPrecacheAll;
 XRSOUND_API extern xr_token* snd_devices_token;
 XRSOUND_API extern u32 snd_device_id;
@@ -44,6 +46,7 @@ enum
 {
     ss_Hardware = 1ul << 1ul, //!< Use hardware mixing only
     ss_EAX = 1ul << 2ul, //!< Use eax
+    ss_MixerThread = 1ul << 3ul, //!< Update emitters and targets on the own thread
     ss_forcedword = u32(-1)
 };
 
@@ -17,3 +17,7 @@ const float s_f_def_source_footer = 0.0f; // sec of silence after buffer data, j
 const u32 sdef_env_version = 4; // current version of env-def
 const u32 sdef_level_version = 1; // current version of level-def
 const float s_f_def_event_pulse = 0.5f; // sec
+const float s_f_occlusion_cell = 2.f; // m, listener position is quantized by it for the occlusion cache
+const float s_f_occlusion_move = 0.5f; // m, emitter moved farther is traced again
+const float s_f_occlusion_lifetime = 0.5f; // sec, cached occlusion is traced again after that
+const u32 sdef_occlusion_to_cache = 1024; // get_occlusion_to() results kept, power of two
@@ -57,6 +57,8 @@ public:
         return c_storage[cat.table[id]].data;
     } //.
     u32 get_linesize() const { return _line; }
+    // Doesn't touch LRU
+    bool cached(const cache_cat& cat, u32 id) const { return CAT_FREE != cat.table[id % cat.size]; }
     void cat_create(cache_cat& cat, u32 bytes);
     void cat_destroy(cache_cat& cat);
 
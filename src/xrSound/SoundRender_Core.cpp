@@ -5,6 +5,7 @@
 #include "SoundRender_Core.h"
 #include "SoundRender_Source.h"
 #include "SoundRender_Emitter.h"
+#include "xrCore/Threading/ScopeLock.hpp"
 #if defined(WINDOWS)
 #pragma warning(push)
 #pragma warning(disable : 4995)
@@ -13,7 +14,7 @@
 #endif
 
 int psSoundTargets = 32;
-Flags32 psSoundFlags = {ss_Hardware | ss_EAX};
+Flags32 psSoundFlags = {ss_Hardware | ss_EAX | ss_MixerThread};
 float psSoundOcclusionScale = 0.5f;
 float psSoundCull = 0.01f;
 float psSoundRolloff = 0.75f;
@@ -23,6 +24,8 @@ float psSoundVFactor = 1.0f;
 
 float psSoundVMusic = 1.f;
 int psSoundCacheSizeMB = 32;
+int psSoundDecodeAhead = sdef_target_block;
+int psSoundOcclusionBudget = 32;
 u32 psSoundPrecacheAll = 1;
 CSoundRender_Core* SoundRender = nullptr;
 
@@ -47,6 +50,12 @@ CSoundRender_Core::CSoundRender_Core()
     fTimer_Value = Timer.GetElapsed_sec();
     fTimer_Delta = 0.0f;
     m_iPauseCounter = 1;
+    mixer_listener[0].set(0.f, 0.f, 0.f);
+    mixer_listener[1].set(0.f, 0.f, 1.f);
+    mixer_listener[2].set(0.f, 1.f, 0.f);
+    mixer_quit = false;
+    mixer_running = false;
+    occlusion_reset();
 }
 
 CSoundRender_Core::~CSoundRender_Core()
@@ -82,6 +91,7 @@ extern xr_vector<u8> g_target_temp_data;
 
 void CSoundRender_Core::_clear()
 {
+    mixer_stop();
     bReady = false;
     cache.destroy();
     env_unload();
@@ -93,18 +103,24 @@ void CSoundRender_Core::_clear()
     }
     s_sources.clear();
 
-    // remove emitters
-    for (u32 eit = 0; eit < s_emitters.size(); eit++)
-        xr_delete(s_emitters[eit]);
+    // remove emitters, the game side owns all of them
+    SoundNotify N;
+    while (mixer_notifies.pop(N))
+        continue;
+    mixer_overflow.clear();
+    s_occlusion_queue.clear();
     s_emitters.clear();
+    for (u32 eit = 0; eit < s_emitters_owned.size(); eit++)
+        xr_delete(s_emitters_owned[eit]);
+    s_emitters_owned.clear();
 
     g_target_temp_data.clear();
 }
 
 void CSoundRender_Core::stop_emitters()
 {
-    for (u32 eit = 0; eit < s_emitters.size(); eit++)
-        s_emitters[eit]->stop(false);
+    for (u32 eit = 0; eit < s_emitters_owned.size(); eit++)
+        s_emitters_owned[eit]->stop(false);
 }
 
 int CSoundRender_Core::pause_emitters(bool val)
@@ -112,8 +128,10 @@ int CSoundRender_Core::pause_emitters(bool val)
     m_iPauseCounter += val ? +1 : -1;
     VERIFY(m_iPauseCounter >= 0);
 
-    for (u32 it = 0; it < s_emitters.size(); it++)
-        ((CSoundRender_Emitter*)s_emitters[it])->pause(val, val ? m_iPauseCounter : m_iPauseCounter + 1);
+    SoundCommand C(SoundCommand::Pause);
+    C.flag = val;
+    C.id = val ? m_iPauseCounter : m_iPauseCounter + 1;
+    i_command(C);
 
     return m_iPauseCounter;
 }
@@ -145,20 +163,33 @@ void CSoundRender_Core::env_unload()
 
 void CSoundRender_Core::_restart()
 {
+    ScopeLock lock(&mixer_lock);
     cache.destroy();
     cache.initialize(psSoundCacheSizeMB * 1024, cache_bytes_per_line);
     env_apply();
 }
 
 void CSoundRender_Core::set_handler(sound_event* E) { Handler = E; }
-void CSoundRender_Core::set_geometry_occ(CDB::MODEL* M) { geom_MODEL = M; }
+void CSoundRender_Core::set_geometry_occ(CDB::MODEL* M)
+{
+    ScopeLock lock(&mixer_lock);
+    geom_MODEL = M;
+    occlusion_reset();
+}
 
 void CSoundRender_Core::set_geometry_som(IReader* I)
 {
+    // The new model is built without the lock, the mixer uses the old one meanwhile
+    CDB::MODEL* old_SOM;
+    {
+        ScopeLock lock(&mixer_lock);
+        old_SOM = geom_SOM;
+        geom_SOM = nullptr;
+    }
 #ifdef _EDITOR
-    ETOOLS::destroy_model(geom_SOM);
+    ETOOLS::destroy_model(old_SOM);
 #else
-    xr_delete(geom_SOM);
+    xr_delete(old_SOM);
 #endif
     if (nullptr == I)
         return;
@@ -180,6 +211,7 @@ void CSoundRender_Core::set_geometry_som(IReader* I)
         float occ;
     };
     // Create AABB-tree
+    CDB::MODEL* new_SOM;
 #ifdef _EDITOR
     CDB::Collector* CL = ETOOLS::create_collector();
     while (!geom->eof())
@@ -190,7 +222,7 @@ void CSoundRender_Core::set_geometry_som(IReader* I)
         if (P.b2sided)
             ETOOLS::collector_add_face_pd(CL, P.v3, P.v2, P.v1, *(u32*)&P.occ, 0.01f);
     }
-    geom_SOM = ETOOLS::create_model_cl(CL);
+    new_SOM = ETOOLS::create_model_cl(CL);
     ETOOLS::destroy_collector(CL);
 #else
     CDB::Collector CL;
@@ -202,19 +234,29 @@ void CSoundRender_Core::set_geometry_som(IReader* I)
         if (P.b2sided)
             CL.add_face_packed_D(P.v3, P.v2, P.v1, *(u32*)&P.occ, 0.01f);
     }
-    geom_SOM = new CDB::MODEL();
-    geom_SOM->build(CL.getV(), int(CL.getVS()), CL.getT(), int(CL.getTS()));
+    new_SOM = new CDB::MODEL();
+    new_SOM->build_cached(CL.getV(), int(CL.getVS()), CL.getT(), int(CL.getTS()));
 #endif
 
     geom->close();
+
+    ScopeLock lock(&mixer_lock);
+    geom_SOM = new_SOM;
+    occlusion_reset();
 }
 
 void CSoundRender_Core::set_geometry_env(IReader* I)
 {
+    CDB::MODEL* old_ENV;
+    {
+        ScopeLock lock(&mixer_lock);
+        old_ENV = geom_ENV;
+        geom_ENV = nullptr;
+    }
 #ifdef _EDITOR
-    ETOOLS::destroy_model(geom_ENV);
+    ETOOLS::destroy_model(old_ENV);
 #else
-    xr_delete(geom_ENV);
+    xr_delete(old_ENV);
 #endif
     if (nullptr == I)
         return;
@@ -257,12 +299,18 @@ void CSoundRender_Core::set_geometry_env(IReader* I)
         T->dummy = u32(ids[id_back] << 16) | u32(ids[id_front]);
     }
 #ifdef _EDITOR
-    geom_ENV = ETOOLS::create_model(verts, H.vertcount, tris, H.facecount);
-    env_apply();
+    CDB::MODEL* new_ENV = ETOOLS::create_model(verts, H.vertcount, tris, H.facecount);
 #else
-    geom_ENV = new CDB::MODEL();
-    geom_ENV->build(verts, H.vertcount, tris, H.facecount);
+    CDB::MODEL* new_ENV = new CDB::MODEL();
+    new_ENV->build_cached(verts, H.vertcount, tris, H.facecount);
 #endif
+    {
+        ScopeLock lock(&mixer_lock);
+        geom_ENV = new_ENV;
+#ifdef _EDITOR
+        env_apply();
+#endif
+    }
     geom_ch->close();
     geom->close();
     xr_free(_data);
@@ -289,23 +337,32 @@ void CSoundRender_Core::attach_tail(ref_sound& S, pcstr fName)
     xr_strcpy(fn, fName);
     if (strext(fn))
         *strext(fn) = 0;
-    if (S._p->fn_attached[0].size() && S._p->fn_attached[1].size())
+
+    CSoundRender_Source* s = SoundRender->i_create_source(fn);
     {
+        // The mixer takes the attached tails when the playing emitter reaches them
+        ScopeLock lock(&mixer_lock);
+        if (S._p->fn_attached[0].size() && S._p->fn_attached[1].size())
+        {
 #ifdef DEBUG
-        Msg("! 2 file already in queue [%s][%s]", S._p->fn_attached[0].c_str(), S._p->fn_attached[1].c_str());
+            Msg("! 2 file already in queue [%s][%s]", S._p->fn_attached[0].c_str(), S._p->fn_attached[1].c_str());
 #endif // #ifdef DEBUG
-        return;
-    }
-
-    u32 idx = S._p->fn_attached[0].size() ? 1 : 0;
+            SoundRender->i_destroy_source(s);
+            return;
+        }
 
-    S._p->fn_attached[idx] = fn;
+        u32 idx = S._p->fn_attached[0].size() ? 1 : 0;
 
-    CSoundRender_Source* s = SoundRender->i_create_source(fn);
-    S._p->dwBytesTotal += s->bytes_total();
-    S._p->fTimeTotal += s->length_sec();
+        S._p->fn_attached[idx] = fn;
+        S._p->dwBytesTotal += s->bytes_total();
+        S._p->fTimeTotal += s->length_sec();
+    }
     if (S._feedback())
-        ((CSoundRender_Emitter*)S._feedback())->fTimeToStop += s->length_sec();
+    {
+        SoundCommand C(SoundCommand::TimeToStop, (CSoundRender_Emitter*)S._feedback());
+        C.value[0] = s->length_sec();
+        i_command(C);
+    }
 
     SoundRender->i_destroy_source(s);
 }
@@ -316,10 +373,13 @@ void CSoundRender_Core::clone(ref_sound& S, const ref_sound& from, esound_type s
         return;
     S._p = new ref_sound_data();
     S._p->handle = from._p->handle;
-    S._p->dwBytesTotal = from._p->dwBytesTotal;
-    S._p->fTimeTotal = from._p->fTimeTotal;
-    S._p->fn_attached[0] = from._p->fn_attached[0];
-    S._p->fn_attached[1] = from._p->fn_attached[1];
+    {
+        ScopeLock lock(&mixer_lock); // the mixer may be taking the tails of the playing one
+        S._p->dwBytesTotal = from._p->dwBytesTotal;
+        S._p->fTimeTotal = from._p->fTimeTotal;
+        S._p->fn_attached[0] = from._p->fn_attached[0];
+        S._p->fn_attached[1] = from._p->fn_attached[1];
+    }
     S._p->g_type = (game_type == sg_SourceType) ? S._p->handle->game_type() : game_type;
     S._p->s_type = sound_type;
 }
@@ -330,7 +390,7 @@ void CSoundRender_Core::play(ref_sound& S, IGameObject* O, u32 flags, float dela
         return;
     S._p->g_object = O;
     if (S._feedback())
-        ((CSoundRender_Emitter*)S._feedback())->rewind();
+        ((CSoundRender_Emitter*)S._feedback())->replay();
     else
         i_play(&S, flags & sm_Looped, delay);
 
@@ -348,10 +408,13 @@ void CSoundRender_Core::play_no_feedback(
     S._p->handle = orig->handle;
     S._p->g_type = orig->g_type;
     S._p->g_object = O;
-    S._p->dwBytesTotal = orig->dwBytesTotal;
-    S._p->fTimeTotal = orig->fTimeTotal;
-    S._p->fn_attached[0] = orig->fn_attached[0];
-    S._p->fn_attached[1] = orig->fn_attached[1];
+    {
+        ScopeLock lock(&mixer_lock); // the mixer may be taking the tails of the playing one
+        S._p->dwBytesTotal = orig->dwBytesTotal;
+        S._p->fTimeTotal = orig->fTimeTotal;
+        S._p->fn_attached[0] = orig->fn_attached[0];
+        S._p->fn_attached[1] = orig->fn_attached[1];
+    }
 
     i_play(&S, flags & sm_Looped, delay);
 
@@ -375,7 +438,7 @@ void CSoundRender_Core::play_at_pos(ref_sound& S, IGameObject* O, const Fvector&
         return;
     S._p->g_object = O;
     if (S._feedback())
-        ((CSoundRender_Emitter*)S._feedback())->rewind();
+        ((CSoundRender_Emitter*)S._feedback())->replay();
     else
         i_play(&S, flags & sm_Looped, delay);
 
@@ -568,12 +631,12 @@ void CSoundRender_Core::object_relcase(IGameObject* obj)
 {
     if (obj)
     {
-        for (u32 eit = 0; eit < s_emitters.size(); eit++)
+        for (u32 eit = 0; eit < s_emitters_owned.size(); eit++)
         {
-            if (s_emitters[eit])
-                if (s_emitters[eit]->owner_data)
-                    if (obj == s_emitters[eit]->owner_data->g_object)
-                        s_emitters[eit]->owner_data->g_object = 0;
+            if (s_emitters_owned[eit])
+                if (s_emitters_owned[eit]->owner_data)
+                    if (obj == s_emitters_owned[eit]->owner_data->g_object)
+                        s_emitters_owned[eit]->owner_data->g_object = 0;
         }
     }
 }
@@ -583,6 +646,7 @@ void CSoundRender_Core::set_user_env(CSound_environment* E)
     if (0 == E && !bUserEnvironment)
         return;
 
+    ScopeLock lock(&mixer_lock);
     if (E)
     {
         s_user_environment = *((CSoundRender_Environment*)E);
@@ -597,14 +661,18 @@ void CSoundRender_Core::set_user_env(CSound_environment* E)
 
 void CSoundRender_Core::refresh_env_library()
 {
+    ScopeLock lock(&mixer_lock);
     env_unload();
     env_load();
     env_apply();
 }
 void CSoundRender_Core::refresh_sources()
 {
-    for (u32 eit = 0; eit < s_emitters.size(); eit++)
-        s_emitters[eit]->stop(false);
+    for (u32 eit = 0; eit < s_emitters_owned.size(); eit++)
+        s_emitters_owned[eit]->stop(false);
+
+    // Stops are executed and the background decoding is finished, the thread is started again with the next update
+    mixer_stop();
     for (const auto& kv : s_sources)
     {
         CSoundRender_Source* s = kv.second;
@@ -3,17 +3,47 @@
 #include "SoundRender.h"
 #include "SoundRender_Environment.h"
 #include "SoundRender_Cache.h"
+#include "SoundRender_Mixer.h"
 #include "xrCommon/xr_unordered_map.h"
+#include "xrCore/Threading/Event.hpp"
+#include "xrCore/Threading/Lock.hpp"
 
 class CSoundRender_Core : public ISoundManager
 {
 protected:
     struct SoundStatistics
     {
-        CStatTimer Update; // total time taken by sound subsystem (accurate only in single-threaded mode)
+        CStatTimer Update; // total time taken by the mixer, on its own thread with snd_mixer_thread
+
+        // Background decoding, see CSoundRender_Target::decode_ahead()
+        std::atomic<u32> DecodeLines; // decoded in background
+        std::atomic<u32> DecodeJobs;
+        std::atomic<u32> DecodeLatency; // us, from scheduling to the end of decoding
+        u32 DecodeHits; // missed lines found decoded in background
+        u32 DecodeMisses; // missed lines decoded on the spot
+        float DecodeWait; // ms, waiting for the background decoding
+
+        // Occlusion cache, see get_occlusion_cached()
+        u32 OcclusionRays; // traced for the emitters
+        u32 OcclusionReused; // emitter updates which took the cached value
+        u32 OcclusionToHits; // get_occlusion_to() calls answered by the cache
+        u32 OcclusionToMisses;
 
         SoundStatistics() { FrameStart(); }
-        void FrameStart() { Update.FrameStart(); }
+        void FrameStart()
+        {
+            Update.FrameStart();
+            DecodeLines = 0;
+            DecodeJobs = 0;
+            DecodeLatency = 0;
+            DecodeHits = 0;
+            DecodeMisses = 0;
+            DecodeWait = 0.f;
+            OcclusionRays = 0;
+            OcclusionReused = 0;
+            OcclusionToHits = 0;
+            OcclusionToMisses = 0;
+        }
         void FrameEnd() { Update.FrameEnd(); }
     };
 
@@ -49,6 +79,7 @@ protected:
     // Collider
 #ifndef _EDITOR
     CDB::COLLIDER geom_DB;
+    CDB::COLLIDER geom_DB_game; // get_occlusion_to() is called from the game thread
 #endif
     CDB::MODEL* geom_SOM;
     CDB::MODEL* geom_MODEL;
@@ -56,6 +87,7 @@ protected:
 
     // Containers
     xr_unordered_map<xr_string, CSoundRender_Source*> s_sources;
+    Lock s_sources_lock; // the mixer creates the attached sources
     xr_vector<CSoundRender_Emitter*> s_emitters;
     u32 s_emitters_u; // emitter update marker
     xr_vector<CSoundRender_Target*> s_targets;
@@ -66,6 +98,45 @@ protected:
 
     int m_iPauseCounter;
 
+    // Occlusion cache. Emitters keep the last traced value and queue themselves when it gets stale,
+    // the mixer traces the queued ones in batches of up to snd_occlusion_budget per update.
+    struct OcclusionToEntry
+    {
+        Ivector hear_cell;
+        Ivector snd_cell;
+        float value;
+        float time; // < 0 - empty
+    };
+    xr_vector<CSoundRender_Emitter*> s_occlusion_queue; // the longest waiting first
+    xr_vector<CDB::RAY> s_occlusion_rays;
+    xr_vector<CDB::RAY> s_occlusion_trace; // rays which missed the cached polygon
+    xr_vector<u32> s_occlusion_missed; // their emitters in the queue
+    xr_vector<float> s_occlusion_values;
+    OcclusionToEntry s_occlusion_to[sdef_occlusion_to_cache]; // game side, direct mapped
+
+    void occlusion_reset();
+    void update_occlusion();
+
+    // Mixer thread (snd_mixer_thread), see SoundRender_Core_Mixer.cpp.
+    // s_emitters and s_targets belong to the mixer, the game side knows its emitters by s_emitters_owned
+    // and talks to the mixer with commands only. Without the thread commands are executed on the spot.
+    xr_vector<CSoundRender_Emitter*> s_emitters_owned; // created and not released yet
+    CSoundRender_Queue<SoundCommand, sdef_mixer_queue> mixer_commands;
+    CSoundRender_Queue<SoundNotify, sdef_mixer_queue> mixer_notifies;
+    xr_vector<SoundNotify> mixer_overflow; // notifications which didn't fit into the queue
+    Fvector mixer_listener[3]; // position, direction, top
+    Lock mixer_lock; // held by the mixer for an update, the game side takes it to change the shared data
+    Event mixer_wake;
+    Event mixer_exited;
+    std::atomic_bool mixer_quit;
+    bool mixer_running;
+
+    bool mixer_start();
+    void mixer_stop();
+    static void mixer_thread(void* context);
+    void mixer_update();
+    void update_feedback();
+
 public:
     // Cache
     CSoundRender_Cache cache;
@@ -111,6 +182,12 @@ public:
 
     void update(const Fvector& P, const Fvector& D, const Fvector& N) override;
     virtual void update_events();
+
+    // Game side -> mixer, the command is executed right away without the mixer thread
+    void i_command(const SoundCommand& C);
+    // Mixer side
+    void i_execute(const SoundCommand& C);
+    void i_notify(const SoundNotify& N);
     void statistic(CSound_stats* dest, CSound_stats_ext* ext) override;
     void DumpStatistics(class IGameFont& font, class IPerformanceAlert* alert) override;
 
@@ -145,8 +222,20 @@ public:
     bool i_locked() override { return isLocked; }
     void object_relcase(IGameObject* obj) override;
 
+    // Background decoding stats, decode_done() is called from the worker threads
+    void decode_done(u32 lines, float latency)
+    {
+        Stats.DecodeLines += lines;
+        Stats.DecodeJobs++;
+        Stats.DecodeLatency += u32(latency * 1000000.f);
+    }
+    void decode_taken(bool decoded) { decoded ? Stats.DecodeHits++ : Stats.DecodeMisses++; }
+    void decode_waited(float time) { Stats.DecodeWait += time * 1000.f; }
+
     float get_occlusion_to(const Fvector& hear_pt, const Fvector& snd_pt, float dispersion = 0.2f) override;
     float get_occlusion(Fvector& P, float R, Fvector* occ) override;
+    // Mixer side, the traced value is reused while the emitter and the listener stay where they were
+    float get_occlusion_cached(CSoundRender_Emitter* E, bool trace_now);
     CSoundRender_Environment* get_environment(const Fvector& P);
 
     void env_load();
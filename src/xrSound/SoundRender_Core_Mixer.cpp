@@ -0,0 +1,175 @@
+#include "stdafx.h"
+
+#include "SoundRender_Core.h"
+#include "SoundRender_Emitter.h"
+#include "SoundRender_Source.h"
+#include "xrCore/Threading/ScopeLock.hpp"
+#include "xrCore/Threading/ThreadUtil.h"
+
+#include <thread>
+
+bool CSoundRender_Core::mixer_start()
+{
+    VERIFY(!mixer_running);
+    mixer_quit = false;
+    if (!Threading::SpawnThread(mixer_thread, "X-Ray Sound Mixer thread", 0, this))
+    {
+        Msg("! SOUND: Can't start the mixer thread, the sound is updated on the main thread");
+        return false;
+    }
+    mixer_running = true;
+    return true;
+}
+
+void CSoundRender_Core::mixer_stop()
+{
+    if (!mixer_running)
+        return;
+
+    mixer_quit = true;
+    mixer_wake.Set();
+    mixer_exited.Wait();
+    mixer_running = false;
+
+    // Left in the queue, they are executed right away from now on
+    SoundCommand C;
+    while (mixer_commands.pop(C))
+        i_execute(C);
+}
+
+void CSoundRender_Core::mixer_thread(void* context)
+{
+    auto& self = *static_cast<CSoundRender_Core*>(context);
+    while (!self.mixer_quit.load(std::memory_order_acquire))
+    {
+        {
+            ScopeLock lock(&self.mixer_lock);
+            self.mixer_update();
+        }
+        self.mixer_wake.Wait(sdef_mixer_period);
+    }
+    self.mixer_exited.Set();
+}
+
+void CSoundRender_Core::i_command(const SoundCommand& C)
+{
+    if (!mixer_running)
+    {
+        i_execute(C);
+        return;
+    }
+
+    while (!mixer_commands.push(C))
+    {
+        mixer_wake.Set();
+        std::this_thread::yield();
+    }
+}
+
+void CSoundRender_Core::i_notify(const SoundNotify& N)
+{
+    // Keep the order, the game side deletes the emitter on Released
+    if (!mixer_overflow.empty() || !mixer_notifies.push(N))
+        mixer_overflow.push_back(N);
+}
+
+void CSoundRender_Core::i_execute(const SoundCommand& C)
+{
+    CSoundRender_Emitter* E = C.emitter;
+    switch (C.type)
+    {
+    case SoundCommand::Play: s_emitters.push_back(E); break;
+
+    case SoundCommand::Stop:
+    {
+        E->i_stop();
+        const auto it = std::find(s_emitters.begin(), s_emitters.end(), E);
+        VERIFY(it != s_emitters.end());
+        if (it != s_emitters.end())
+            s_emitters.erase(it);
+        if (E->occlusion_queued)
+            s_occlusion_queue.erase(std::find(s_occlusion_queue.begin(), s_occlusion_queue.end(), E));
+        i_notify(SoundNotify(SoundNotify::Released, E));
+        break;
+    }
+
+    case SoundCommand::StopDeferred: E->bStopping = TRUE; break;
+
+    case SoundCommand::Rewind:
+        E->m_rewinds++;
+        if (E->isPlaying())
+            E->rewind();
+        else
+            E->restart();
+        break;
+
+    case SoundCommand::Position:
+        E->p_source.position = C.vec[0];
+        E->bMoved = true;
+        break;
+
+    case SoundCommand::Frequency: E->p_source.freq = C.value[0]; break;
+
+    case SoundCommand::Range:
+        E->p_source.min_distance = C.value[0];
+        E->p_source.max_distance = C.value[1];
+        break;
+
+    case SoundCommand::Volume: E->p_source.volume = C.value[0]; break;
+    case SoundCommand::Priority: E->priority_scale = C.value[0]; break;
+    case SoundCommand::Mode2D: E->b2D = C.flag; break;
+    case SoundCommand::TimeToStop: E->fTimeToStop += C.value[0]; break;
+
+    case SoundCommand::Pause:
+        for (CSoundRender_Emitter* it : s_emitters)
+            it->pause(C.flag, C.id);
+        break;
+
+    case SoundCommand::Listener:
+        mixer_listener[0] = C.vec[0];
+        mixer_listener[1] = C.vec[1];
+        mixer_listener[2] = C.vec[2];
+        break;
+
+    default: NODEFAULT;
+    }
+}
+
+void CSoundRender_Core::update_feedback()
+{
+    SoundNotify N;
+    while (mixer_notifies.pop(N))
+    {
+        CSoundRender_Emitter* E = N.emitter;
+        switch (N.type)
+        {
+        case SoundNotify::Event:
+            if (!E->bReleased && E->owner_data->g_object && Handler)
+                s_events.emplace_back(E->owner_data, N.value);
+            break;
+
+        case SoundNotify::Finished:
+            // Not if it's stopped already or the game has played it again meanwhile
+            if (!E->bReleased && N.rewinds == E->m_rewinds_owner)
+                E->stop(false);
+            break;
+
+        case SoundNotify::Released:
+        {
+            const auto it = std::find(s_emitters_owned.begin(), s_emitters_owned.end(), E);
+            VERIFY(it != s_emitters_owned.end());
+            if (it != s_emitters_owned.end())
+                s_emitters_owned.erase(it);
+            xr_delete(E);
+            break;
+        }
+
+        case SoundNotify::SourceChanged:
+            i_destroy_source((CSoundRender_Source*)E->owner_data->handle);
+            E->owner_data->handle = N.source;
+            break;
+
+        default: NODEFAULT;
+        }
+    }
+}
@@ -4,6 +4,7 @@
 #include "xrEngine/GameFont.h"
 #include "xrEngine/PerformanceAlert.hpp"
 #include "xrCDB/Intersect.hpp"
+#include "xrCore/Threading/ScopeLock.hpp"
 #include "SoundRender_Core.h"
 #include "SoundRender_Emitter.h"
 #include "SoundRender_Target.h"
@@ -15,17 +16,60 @@ CSoundRender_Emitter* CSoundRender_Core::i_play(ref_sound* S, bool _loop, float
     CSoundRender_Emitter* E = new CSoundRender_Emitter();
     S->_p->feedback = E;
     E->start(S, _loop, delay);
-    s_emitters.push_back(E);
+    s_emitters_owned.push_back(E);
+    i_command(SoundCommand(SoundCommand::Play, E));
     return E;
 }
 
 void CSoundRender_Core::update(const Fvector& P, const Fvector& D, const Fvector& N)
 {
-    u32 it;
     if (0 == bReady)
         return;
-    Stats.Update.Begin();
+
+    const bool threaded = !!psSoundFlags.test(ss_MixerThread);
+    if (threaded != mixer_running)
+    {
+        if (!threaded)
+            mixer_stop();
+        else if (!mixer_start())
+            psSoundFlags.set(ss_MixerThread, false);
+    }
+
     isLocked = true;
+    SoundCommand C(SoundCommand::Listener);
+    C.vec[0] = P;
+    C.vec[1] = D;
+    C.vec[2] = N;
+    i_command(C);
+
+    if (!mixer_running)
+        mixer_update();
+
+    update_feedback();
+    update_events();
+    isLocked = false;
+}
+
+void CSoundRender_Core::mixer_update()
+{
+    u32 it;
+    Stats.Update.Begin();
+
+    // Commands queued since the last update
+    SoundCommand C;
+    while (mixer_commands.pop(C))
+        i_execute(C);
+
+    // Try again with the notifications the game side hasn't had room for
+    size_t pushed = 0;
+    while (pushed < mixer_overflow.size() && mixer_notifies.push(mixer_overflow[pushed]))
+        ++pushed;
+    mixer_overflow.erase(mixer_overflow.begin(), mixer_overflow.begin() + pushed);
+
+    const Fvector& P = mixer_listener[0];
+    const Fvector& D = mixer_listener[1];
+    const Fvector& N = mixer_listener[2];
+
     float new_tm = Timer.GetElapsed_sec();
     fTimer_Delta = new_tm - fTimer_Value;
     //float dt = float(Timer_Delta)/1000.f;
@@ -66,15 +110,17 @@ void CSoundRender_Core::update(const Fvector& P, const Fvector& D, const Fvector
             pEmitter->update(dt_sec);
             pEmitter->marker = s_emitters_u;
         }
-        if (!pEmitter->isPlaying())
+        if (!pEmitter->isPlaying() && !pEmitter->bFinished)
         {
-            // Stopped
-            xr_delete(pEmitter);
-            s_emitters.erase(s_emitters.begin() + it);
-            it--;
+            // Stopped, stays here until the game side releases it
+            pEmitter->bFinished = true;
+            i_notify(SoundNotify(SoundNotify::Finished, pEmitter, 0.f, pEmitter->m_rewinds));
         }
     }
 
+    // Occlusion of the emitters which have asked for it
+    update_occlusion();
+
     // Get currently rendering emitters
     // Msg("! update: targets");
     s_targets_defer.clear();
@@ -90,9 +136,15 @@ void CSoundRender_Core::update(const Fvector& P, const Fvector& D, const Fvector
             {
                 /*if	(PU == it)*/ T->fill_parameters();
                 T->update();
+                T->decode_ahead(psSoundDecodeAhead);
             }
             else
+            {
+                // About to play: the first blocks are decoded in background during the rest of the update
+                if (psSoundDecodeAhead)
+                    T->decode_ahead(std::max(u32(psSoundDecodeAhead), sdef_target_size));
                 s_targets_defer.push_back(T);
+            }
         }
     }
 
@@ -129,13 +181,12 @@ void CSoundRender_Core::update(const Fvector& P, const Fvector& D, const Fvector
     {
         // Msg	("! update: start render");
         for (it = 0; it < s_targets_defer.size(); it++)
+        {
             s_targets_defer[it]->render();
+            s_targets_defer[it]->decode_ahead(psSoundDecodeAhead);
+        }
     }
 
-    // Events
-    update_events();
-
-    isLocked = false;
     Stats.Update.End();
 }
 
@@ -153,6 +204,7 @@ void CSoundRender_Core::update_events()
 
 void CSoundRender_Core::statistic(CSound_stats* dest, CSound_stats_ext* ext)
 {
+    ScopeLock lock(&mixer_lock);
     if (dest)
     {
         dest->_rendered = 0;
@@ -198,19 +250,79 @@ void CSoundRender_Core::statistic(CSound_stats* dest, CSound_stats_ext* ext)
 
 void CSoundRender_Core::DumpStatistics(IGameFont& font, IPerformanceAlert* alert)
 {
-    Stats.FrameEnd();
     CSound_stats sndStat;
     statistic(&sndStat, nullptr);
+
+    ScopeLock lock(&mixer_lock);
+    Stats.FrameEnd();
     font.OutNext("*** SOUND:    %2.2fms", Stats.Update.result);
     font.OutNext("Rendered:     %d", sndStat._rendered);
     font.OutNext("Simulated:    %d", sndStat._simulated);
     font.OutNext("Events:       %d", sndStat._events);
     font.OutNext("Hits/misses:  %d/%d", sndStat._cache_hits, sndStat._cache_misses);
+    const u32 jobs = Stats.DecodeJobs;
+    font.OutNext("Decoded:      %u lines, %u jobs, %2.2fms latency", u32(Stats.DecodeLines), jobs,
+        jobs ? Stats.DecodeLatency / 1000.f / jobs : 0.f);
+    font.OutNext("- hits/misses:%u/%u, wait %2.2fms", Stats.DecodeHits, Stats.DecodeMisses, Stats.DecodeWait);
+    font.OutNext("Occlusion:    %u rays, %u reused, %u queued", Stats.OcclusionRays, Stats.OcclusionReused,
+        u32(s_occlusion_queue.size()));
+    font.OutNext("- AI hits/misses:%u/%u", Stats.OcclusionToHits, Stats.OcclusionToMisses);
     Stats.FrameStart();
 }
 
+namespace
+{
+Ivector occlusion_cell(const Fvector& P)
+{
+    Ivector cell;
+    cell.set(iFloor(P.x / s_f_occlusion_cell), iFloor(P.y / s_f_occlusion_cell), iFloor(P.z / s_f_occlusion_cell));
+    return cell;
+}
+
+bool same_cell(const Ivector& a, const Ivector& b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+
+u32 cell_hash(const Ivector& cell)
+{
+    return u32(cell.x) * 73856093u ^ u32(cell.y) * 19349663u ^ u32(cell.z) * 83492791u;
+}
+
+void occlusion_ray(CDB::RAY& ray, const Fvector& from, const Fvector& to, float dispersion)
+{
+    Fvector pos;
+    pos.random_dir();
+    pos.mul(dispersion);
+    pos.add(to);
+    ray.start = from;
+    ray.dir.sub(pos, from);
+    ray.range = ray.dir.magnitude();
+    ray.dir.div(ray.range);
+}
+} // namespace
+
+void CSoundRender_Core::occlusion_reset()
+{
+    for (CSoundRender_Emitter* E : s_emitters)
+        E->occlusion_time = -1.f;
+    for (OcclusionToEntry& entry : s_occlusion_to)
+        entry.time = -1.f;
+}
+
 float CSoundRender_Core::get_occlusion_to(const Fvector& hear_pt, const Fvector& snd_pt, float dispersion)
 {
+    // AI hears the same sounds from the same places many times, the pair of cells is looked up first
+    const Ivector hear_cell = occlusion_cell(hear_pt);
+    const Ivector snd_cell = occlusion_cell(snd_pt);
+    const u32 hash = cell_hash(hear_cell) * 31 + cell_hash(snd_cell);
+    OcclusionToEntry& entry = s_occlusion_to[hash & (sdef_occlusion_to_cache - 1)];
+    const float time = Timer.GetElapsed_sec();
+    if (entry.time >= 0.f && time - entry.time < s_f_occlusion_lifetime && same_cell(entry.hear_cell, hear_cell) &&
+        same_cell(entry.snd_cell, snd_cell))
+    {
+        Stats.OcclusionToHits++;
+        return entry.value;
+    }
+    Stats.OcclusionToMisses++;
+
     float occ_value = 1.f;
 
     if (nullptr != geom_SOM)
@@ -230,10 +342,10 @@ float CSoundRender_Core::get_occlusion_to(const Fvector& hear_pt, const Fvector&
         u32 r_cnt = ETOOLS::r_count();
         CDB::RESULT* _B = ETOOLS::r_begin();
 #else
-        geom_DB.ray_options(CDB::OPT_CULL);
-        geom_DB.ray_query(geom_SOM, hear_pt, dir, range);
-        u32 r_cnt = geom_DB.r_count();
-        CDB::RESULT* _B = geom_DB.r_begin();
+        geom_DB_game.ray_options(CDB::OPT_CULL);
+        geom_DB_game.ray_query(geom_SOM, hear_pt, dir, range);
+        u32 r_cnt = geom_DB_game.r_count();
+        CDB::RESULT* _B = geom_DB_game.r_begin();
 #endif
         if (0 != r_cnt)
         {
@@ -244,6 +356,11 @@ float CSoundRender_Core::get_occlusion_to(const Fvector& hear_pt, const Fvector&
             }
         }
     }
+
+    entry.hear_cell = hear_cell;
+    entry.snd_cell = snd_cell;
+    entry.value = occ_value;
+    entry.time = time;
     return occ_value;
 }
 
@@ -324,3 +441,132 @@ float CSoundRender_Core::get_occlusion(Fvector& P, float R, Fvector* occ)
     }
     return occ_value;
 }
+
+float CSoundRender_Core::get_occlusion_cached(CSoundRender_Emitter* E, bool trace_now)
+{
+    const Ivector cell = occlusion_cell(listener_position());
+    if (trace_now)
+    {
+        E->occlusion = get_occlusion(E->p_source.position, .2f, E->occluder);
+        E->occlusion_time = fTimer_Value;
+        E->occlusion_pos = E->p_source.position;
+        E->occlusion_cell = cell;
+        Stats.OcclusionRays++;
+        return E->occlusion;
+    }
+
+    Stats.OcclusionReused++;
+    if (!E->occlusion_queued)
+    {
+        const bool stale = E->occlusion_time < 0.f || fTimer_Value - E->occlusion_time > s_f_occlusion_lifetime ||
+            !same_cell(E->occlusion_cell, cell) || !E->occlusion_pos.similar(E->p_source.position, s_f_occlusion_move);
+        if (stale)
+        {
+            // The old value is used until the ray gets traced
+            E->occlusion_queued = true;
+            s_occlusion_queue.push_back(E);
+        }
+    }
+    return E->occlusion;
+}
+
+void CSoundRender_Core::update_occlusion()
+{
+    // Stopped emitters don't need it anymore
+    const auto stopped = std::remove_if(s_occlusion_queue.begin(), s_occlusion_queue.end(), [](CSoundRender_Emitter* E)
+    {
+        if (E->isPlaying())
+            return false;
+        E->occlusion_queued = false;
+        return true;
+    });
+    s_occlusion_queue.erase(stopped, s_occlusion_queue.end());
+    if (s_occlusion_queue.empty())
+        return;
+
+    size_t count = s_occlusion_queue.size();
+    if (psSoundOcclusionBudget > 0)
+        count = std::min(count, size_t(psSoundOcclusionBudget));
+
+    const Fvector& base = listener_position();
+    const Ivector cell = occlusion_cell(base);
+
+#ifdef _EDITOR
+    for (size_t i = 0; i < count; ++i)
+    {
+        CSoundRender_Emitter* E = s_occlusion_queue[i];
+        E->occlusion = get_occlusion(E->p_source.position, .2f, E->occluder);
+    }
+#else
+    s_occlusion_rays.resize(count);
+    s_occlusion_values.assign(count, 1.f);
+    for (size_t i = 0; i < count; ++i)
+        occlusion_ray(s_occlusion_rays[i], base, s_occlusion_queue[i]->p_source.position, .2f);
+
+    if (nullptr != geom_MODEL)
+    {
+        // 1. Check cached polygons, the rest goes to the database at once
+        s_occlusion_trace.clear();
+        s_occlusion_missed.clear();
+        for (size_t i = 0; i < count; ++i)
+        {
+            const CDB::RAY& ray = s_occlusion_rays[i];
+            float _u, _v, _range;
+            if (CDB::TestRayTri(ray.start, ray.dir, s_occlusion_queue[i]->occluder, _u, _v, _range, true) &&
+                _range > 0 && _range < ray.range)
+            {
+                s_occlusion_values[i] = psSoundOcclusionScale;
+                continue;
+            }
+            s_occlusion_trace.push_back(ray);
+            s_occlusion_missed.push_back(u32(i));
+        }
+
+        // 2. Real database query, cache the polygons picked up
+        if (!s_occlusion_trace.empty())
+        {
+            geom_DB.ray_options(CDB::OPT_ONLYNEAREST);
+            geom_DB.ray_query(geom_MODEL, s_occlusion_trace.data(), s_occlusion_trace.size());
+            const CDB::TRI* tris = geom_MODEL->get_tris();
+            const Fvector* V = geom_MODEL->get_verts();
+            for (size_t k = 0; k < s_occlusion_trace.size(); ++k)
+            {
+                if (0 == geom_DB.r_ray_count(k))
+                    continue;
+                const u32 i = s_occlusion_missed[k];
+                const CDB::TRI& T = tris[geom_DB.r_ray_begin(k)->id];
+                Fvector* occ = s_occlusion_queue[i]->occluder;
+                occ[0].set(V[T.verts[0]]);
+                occ[1].set(V[T.verts[1]]);
+                occ[2].set(V[T.verts[2]]);
+                s_occlusion_values[i] = psSoundOcclusionScale;
+            }
+        }
+    }
+    if (nullptr != geom_SOM)
+    {
+        geom_DB.ray_options(CDB::OPT_CULL);
+        geom_DB.ray_query(geom_SOM, s_occlusion_rays.data(), count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const CDB::RESULT* _B = geom_DB.r_ray_begin(i);
+            for (size_t k = 0; k < geom_DB.r_ray_count(i); ++k)
+                s_occlusion_values[i] *= *(float*)&_B[k].dummy;
+        }
+    }
+#endif
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        CSoundRender_Emitter* E = s_occlusion_queue[i];
+#ifndef _EDITOR
+        E->occlusion = s_occlusion_values[i];
+#endif
+        E->occlusion_time = fTimer_Value;
+        E->occlusion_pos = E->p_source.position;
+        E->occlusion_cell = cell;
+        E->occlusion_queued = false;
+    }
+    s_occlusion_queue.erase(s_occlusion_queue.begin(), s_occlusion_queue.begin() + count);
+    Stats.OcclusionRays += u32(count);
+}
@@ -21,11 +21,14 @@ bool CSoundRender_Core::i_create_source(CSoundRender_Source*& result, pcstr name
     xr_strlwr(id);
     if (strext(id))
         * strext(id) = 0;
-    const auto it = s_sources.find(id);
-    if (it != s_sources.end())
     {
-        result = it->second;
-        return true;
+        ScopeLock lock(&s_sources_lock);
+        const auto it = s_sources.find(id);
+        if (it != s_sources.end())
+        {
+            result = it->second;
+            return true;
+        }
     }
 
     // Load a _new one
@@ -38,7 +41,14 @@ bool CSoundRender_Core::i_create_source(CSoundRender_Source*& result, pcstr name
     }
     else
     {
-        s_sources.insert({ id, S });
+        // Another thread could load it meanwhile
+        ScopeLock lock(&s_sources_lock);
+        const auto inserted = s_sources.insert({ id, S });
+        if (!inserted.second)
+        {
+            xr_delete(S);
+            S = inserted.first->second;
+        }
     }
 
     result = S;
@@ -67,7 +77,6 @@ void CSoundRender_Core::i_create_all_sources()
     FS.file_list(flist, "$game_sounds$", FS_ListFiles, "*.ogg");
     const size_t sizeBefore = s_sources.size();
 
-    DECLARE_MT_LOCK(lock);
     const auto processFile = [&](const FS_File& file)
     {
         string256 id;
@@ -78,7 +87,7 @@ void CSoundRender_Core::i_create_all_sources()
             *strext(id) = 0;
 
         {
-            DECLARE_MT_SCOPE_LOCK(lock);
+            ScopeLock lock(&s_sources_lock);
             const auto it = s_sources.find(id);
             if (it != s_sources.end())
                 return;
@@ -87,9 +96,9 @@ void CSoundRender_Core::i_create_all_sources()
         CSoundRender_Source* S = new CSoundRender_Source();
         S->load(id);
 
-        DO_MT_LOCK(lock);
-        s_sources.insert({ id, S });
-        DO_MT_UNLOCK(lock);
+        ScopeLock lock(&s_sources_lock);
+        if (!s_sources.insert({ id, S }).second)
+            xr_delete(S);
     };
 
     DO_MT_PROCESS_RANGE(flist, processFile);
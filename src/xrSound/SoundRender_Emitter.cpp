@@ -11,11 +11,53 @@ extern float psSoundVEffects;
 void CSoundRender_Emitter::set_position(const Fvector& pos)
 {
     if (source()->channels_num() == 1)
-        p_source.position = pos;
+        p_owner.position = pos;
     else
-        p_source.position.set(0, 0, 0);
+        p_owner.position.set(0, 0, 0);
 
-    bMoved = true;
+    SoundCommand C(SoundCommand::Position, this);
+    C.vec[0] = p_owner.position;
+    SoundRender->i_command(C);
+}
+
+void CSoundRender_Emitter::set_frequency(float scale)
+{
+    VERIFY(_valid(scale));
+    p_owner.freq = scale;
+
+    SoundCommand C(SoundCommand::Frequency, this);
+    C.value[0] = scale;
+    SoundRender->i_command(C);
+}
+
+void CSoundRender_Emitter::set_range(float min, float max)
+{
+    VERIFY(_valid(min) && _valid(max));
+    p_owner.min_distance = min;
+    p_owner.max_distance = max;
+
+    SoundCommand C(SoundCommand::Range, this);
+    C.value[0] = min;
+    C.value[1] = max;
+    SoundRender->i_command(C);
+}
+
+void CSoundRender_Emitter::set_volume(float vol)
+{
+    if (!_valid(vol))
+        vol = 0.0f;
+    p_owner.volume = vol;
+
+    SoundCommand C(SoundCommand::Volume, this);
+    C.value[0] = vol;
+    SoundRender->i_command(C);
+}
+
+void CSoundRender_Emitter::set_priority(float p)
+{
+    SoundCommand C(SoundCommand::Priority, this);
+    C.value[0] = p;
+    SoundRender->i_command(C);
 }
 
 CSoundRender_Emitter::CSoundRender_Emitter()
@@ -25,7 +67,7 @@ CSoundRender_Emitter::CSoundRender_Emitter()
     dbg_ID = ++incrementalID;
 #endif
     target = nullptr;
-    //source = nullptr;
+    m_source = nullptr;
     owner_data = nullptr;
     smooth_volume = 1.f;
     occluder_volume = 1.f;
@@ -33,12 +75,24 @@ CSoundRender_Emitter::CSoundRender_Emitter()
     occluder[0].set(0, 0, 0);
     occluder[1].set(0, 0, 0);
     occluder[2].set(0, 0, 0);
+    occlusion = 1.f;
+    occlusion_time = -1.f;
+    occlusion_pos.set(0, 0, 0);
+    occlusion_cell.set(0, 0, 0);
+    occlusion_queued = false;
     m_current_state = stStopped;
     set_cursor(0);
     bMoved = true;
     b2D = false;
     bStopping = false;
     bRewind = false;
+    bLooped = false;
+    bFinished = false;
+    m_rewinds = 0;
+    b2D_owner = false;
+    bReleased = false;
+    m_rewinds_owner = 0;
+    m_play_time = 0;
     iPaused = 0;
     fTimeStarted = 0.0f;
     fTimeToStop = 0.0f;
@@ -53,6 +107,8 @@ CSoundRender_Emitter::~CSoundRender_Emitter()
 {
     // try to release dependencies, events, for example
     Event_ReleaseOwner();
+    if (owner_data && owner_data->feedback == this)
+        owner_data->feedback = nullptr;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -78,10 +134,6 @@ void CSoundRender_Emitter::Event_Propagade()
         return;
     if (0 == owner_data->g_type)
         return;
-    if (0 == owner_data->g_object)
-        return;
-    if (0 == SoundRender->Handler)
-        return;
 
     VERIFY(_valid(p_source.volume));
     // Calculate range
@@ -90,41 +142,47 @@ void CSoundRender_Emitter::Event_Propagade()
     if (range < 0.1f)
         return;
 
-    // Inform objects
-    SoundRender->s_events.push_back(std::make_pair(owner_data, range));
+    // Inform objects, game object and handler are checked on the game side
+    SoundRender->i_notify(SoundNotify(SoundNotify::Event, this, range));
 }
 
 void CSoundRender_Emitter::switch_to_2D()
 {
-    b2D = true;
+    b2D_owner = true;
+    SoundCommand C(SoundCommand::Mode2D, this);
+    C.flag = true;
+    SoundRender->i_command(C);
     set_priority(100.f);
 }
 
-void CSoundRender_Emitter::switch_to_3D() { b2D = false; }
-u32 CSoundRender_Emitter::play_time()
+void CSoundRender_Emitter::switch_to_3D()
 {
-    if (m_current_state == stPlaying || m_current_state == stPlayingLooped || m_current_state == stSimulating ||
-        m_current_state == stSimulatingLooped)
-        return iFloor((SoundRender->fTimer_Value - fTimeStarted) * 1000.0f);
-    return 0;
+    b2D_owner = false;
+    SoundRender->i_command(SoundCommand(SoundCommand::Mode2D, this));
 }
 
+u32 CSoundRender_Emitter::play_time() { return m_play_time.load(std::memory_order_relaxed); }
+
 #include "SoundRender_Source.h"
 void CSoundRender_Emitter::set_cursor(u32 p)
 {
     m_stream_cursor = p;
 
+    // The tails are attached under the mixer lock
     if (owner_data._get() && owner_data->fn_attached[0].size())
     {
-        u32 bt = ((CSoundRender_Source*)owner_data->handle)->dwBytesTotal;
+        u32 bt = m_source->dwBytesTotal;
         if (m_stream_cursor >= m_cur_handle_cursor + bt)
         {
-            SoundRender->i_destroy_source((CSoundRender_Source*)owner_data->handle);
-            owner_data->handle = SoundRender->i_create_source(owner_data->fn_attached[0].c_str());
+            m_source = SoundRender->i_create_source(owner_data->fn_attached[0].c_str());
             owner_data->fn_attached[0] = owner_data->fn_attached[1];
             owner_data->fn_attached[1] = "";
             m_cur_handle_cursor = get_cursor(true);
 
+            SoundNotify N(SoundNotify::SourceChanged, this);
+            N.source = m_source;
+            SoundRender->i_notify(N);
+
             if (target)
                 ((CSoundRender_TargetA*)target)->source_changed();
         }
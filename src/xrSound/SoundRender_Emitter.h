@@ -4,6 +4,8 @@
 #include "SoundRender_Environment.h"
 #include "xrCore/_std_extensions.h"
 
+#include <atomic>
+
 class CSoundRender_Emitter : public CSound_emitter
 {
     float starting_delay;
@@ -34,7 +36,9 @@ public:
 #endif
 
     CSoundRender_Target* target;
-    CSoundRender_Source* source() { return (CSoundRender_Source*)owner_data->handle; };
+    // The mixer switches to the attached tails on its own, the owner handle follows on the game side
+    CSoundRender_Source* m_source;
+    CSoundRender_Source* source() { return m_source; };
     ref_sound_data_ptr owner_data;
 
     u32 get_bytes_total() const;
@@ -45,6 +49,11 @@ public:
     float occluder_volume; // USER
     float fade_volume;
     Fvector occluder[3];
+    float occlusion; // the last traced, see CSoundRender_Core::get_occlusion_cached()
+    float occlusion_time; // when it was traced, < 0 - stale
+    Fvector occlusion_pos; // emitter position it was traced from
+    Ivector occlusion_cell; // listener cell it was traced to
+    bool occlusion_queued;
 
     State m_current_state;
     u32 m_stream_cursor;
@@ -58,10 +67,20 @@ public:
     bool b2D;
     bool bStopping;
     bool bRewind;
+    bool bLooped;
+    bool bFinished; // the game side is notified
+    u32 m_rewinds; // Rewind commands applied
     float fTimeStarted; // time of "Start"
     float fTimeToStop; // time to "Stop"
     float fTimeToPropagade;
 
+    // Game side copies, the mixer gets the changes by commands
+    CSound_params p_owner;
+    bool b2D_owner;
+    bool bReleased; // Stop command is sent
+    u32 m_rewinds_owner; // Rewind commands sent
+    std::atomic<u32> m_play_time; // published by the mixer
+
     u32 marker;
     void i_stop();
 
@@ -73,33 +92,18 @@ public:
     void Event_Propagade();
     void Event_ReleaseOwner();
     bool isPlaying() { return m_current_state != stStopped; }
-    bool is_2D() override { return b2D; }
+
+    // Game side, see SoundRender_Mixer.h
+    bool is_2D() override { return b2D_owner; }
     void switch_to_2D() override;
     void switch_to_3D() override;
     void set_position(const Fvector& pos) override;
-
-    void set_frequency(float scale) override
-    {
-        VERIFY(_valid(scale));
-        p_source.freq = scale;
-    }
-
-    void set_range(float min, float max) override
-    {
-        VERIFY(_valid(min) && _valid(max));
-        p_source.min_distance = min;
-        p_source.max_distance = max;
-    }
-
-    void set_volume(float vol) override
-    {
-        if (!_valid(vol))
-            vol = 0.0f;
-        p_source.volume = vol;
-    }
-
-    void set_priority(float p) override { priority_scale = p; }
-    const CSound_params* get_params() override { return &p_source; }
+    void set_frequency(float scale) override;
+    void set_range(float min, float max) override;
+    void set_volume(float vol) override;
+    void set_priority(float p) override;
+    const CSound_params* get_params() override { return &p_owner; }
+    void replay(); // from the start, even if the mixer has just finished
     void fill_block(void* ptr, u32 size);
     void fill_data(u8* ptr, u32 offset, u32 size);
 
@@ -110,6 +114,7 @@ public:
     bool update_culling(float dt);
     void update_environment(float dt);
     void rewind();
+    void restart(); // finished one
     void stop(bool isDeffered) override;
     void pause(bool bVal, int id);
 
@@ -25,8 +25,7 @@ void CSoundRender_Emitter::update(float dt)
     float fTime = SoundRender->fTimer_Value;
     float fDeltaTime = SoundRender->fTimer_Delta;
 
-    VERIFY2(!!(owner_data) || (!(owner_data) && (m_current_state == stStopped)), "owner");
-    VERIFY2(owner_data ? *(int*)(&owner_data->feedback) : 1, "owner");
+    VERIFY2(owner_data, "owner");
 
     if (bRewind)
     {
@@ -52,7 +51,7 @@ void CSoundRender_Emitter::update(float dt)
         fTimeToStop = fTime + get_length_sec();
         fTimeToPropagade = fTime;
         fade_volume = 1.f;
-        occluder_volume = SoundRender->get_occlusion(p_source.position, .2f, occluder);
+        occluder_volume = SoundRender->get_occlusion_cached(this, true);
         smooth_volume = p_source.base_volume * p_source.volume *
             (owner_data->s_type == st_Effect ? psSoundVEffects * psSoundVFactor : psSoundVMusic) *
             (b2D ? 1.f : occluder_volume);
@@ -80,7 +79,7 @@ void CSoundRender_Emitter::update(float dt)
         fTimeToStop = 0xffffffff;
         fTimeToPropagade = fTime;
         fade_volume = 1.f;
-        occluder_volume = SoundRender->get_occlusion(p_source.position, .2f, occluder);
+        occluder_volume = SoundRender->get_occlusion_cached(this, true);
         smooth_volume = p_source.base_volume * p_source.volume *
             (owner_data->s_type == st_Effect ? psSoundVEffects * psSoundVFactor : psSoundVMusic) *
             (b2D ? 1.f : occluder_volume);
@@ -208,9 +207,6 @@ void CSoundRender_Emitter::update(float dt)
     if (bStopping && fis_zero(fade_volume))
         i_stop();
 
-    VERIFY2(!!(owner_data) || (!(owner_data) && (m_current_state == stStopped)), "owner");
-    VERIFY2(owner_data ? *(int*)(owner_data->feedback) : 1, "owner");
-
     // footer
     bMoved = FALSE;
     if (m_current_state != stStopped)
@@ -218,12 +214,13 @@ void CSoundRender_Emitter::update(float dt)
         if (fTime >= fTimeToPropagade)
             Event_Propagade();
     }
-    else if (owner_data)
-    {
-        VERIFY(this == owner_data->feedback);
-        owner_data->feedback = 0;
-        owner_data = 0;
-    }
+
+    // Published for play_time(), which is called from the game side
+    u32 play_time = 0;
+    if (m_current_state == stPlaying || m_current_state == stPlayingLooped || m_current_state == stSimulating ||
+        m_current_state == stSimulatingLooped)
+        play_time = iFloor((SoundRender->fTimer_Value - fTimeStarted) * 1000.0f);
+    m_play_time.store(play_time, std::memory_order_relaxed);
 }
 
 IC void volume_lerp(float& c, float t, float s, float dt)
@@ -271,7 +268,7 @@ bool CSoundRender_Emitter::update_culling(float dt)
         // Update occlusion
         float occ = (owner_data->g_type == SOUND_TYPE_WORLD_AMBIENT) ?
             1.0f :
-            SoundRender->get_occlusion(p_source.position, .2f, occluder);
+            SoundRender->get_occlusion_cached(this, false);
         volume_lerp(occluder_volume, occ, 1.f, dt);
         clamp(occluder_volume, 0.f, 1.f);
     }
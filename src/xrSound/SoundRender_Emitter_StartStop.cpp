@@ -12,7 +12,7 @@ void CSoundRender_Emitter::start(ref_sound* _owner, bool _loop, float delay)
     VERIFY(_owner);
     owner_data = _owner->_p;
     VERIFY(owner_data);
-    //	source					= (CSoundRender_Source*)owner_data->handle;
+    m_source = (CSoundRender_Source*)owner_data->handle;
     p_source.position.set(0, 0, 0);
     p_source.min_distance = source()->m_fMinDist; // DS3D_DEFAULTMINDISTANCE;
     p_source.max_distance = source()->m_fMaxDist; // 300.f;
@@ -20,6 +20,8 @@ void CSoundRender_Emitter::start(ref_sound* _owner, bool _loop, float delay)
     p_source.volume = 1.f; // 1.f
     p_source.freq = 1.f;
     p_source.max_ai_distance = source()->m_fMaxAIDist; // 300.f;
+    p_owner = p_source;
+    bLooped = _loop;
 
     if (fis_zero(delay, EPS_L))
     {
@@ -34,27 +36,38 @@ void CSoundRender_Emitter::start(ref_sound* _owner, bool _loop, float delay)
     bRewind = FALSE;
 }
 
+// The owner is released on the game side, see CSoundRender_Core::update_feedback()
 void CSoundRender_Emitter::i_stop()
 {
     bRewind = FALSE;
     if (target)
         SoundRender->i_stop(this);
-    if (owner_data)
-    {
-        Event_ReleaseOwner();
-        VERIFY(this == owner_data->feedback);
-        owner_data->feedback = NULL;
-        owner_data = NULL;
-    }
     m_current_state = stStopped;
 }
 
 void CSoundRender_Emitter::stop(bool isDeffered)
 {
+    if (bReleased)
+        return;
     if (isDeffered)
-        bStopping = TRUE;
-    else
-        i_stop();
+    {
+        SoundRender->i_command(SoundCommand(SoundCommand::StopDeferred, this));
+        return;
+    }
+
+    // The next play() of the owner starts a new emitter
+    VERIFY(this == owner_data->feedback);
+    owner_data->feedback = nullptr;
+    bReleased = true;
+    SoundRender->i_command(SoundCommand(SoundCommand::Stop, this));
+}
+
+void CSoundRender_Emitter::replay()
+{
+    VERIFY(!bReleased);
+    m_rewinds_owner++;
+    m_play_time.store(0, std::memory_order_relaxed);
+    SoundRender->i_command(SoundCommand(SoundCommand::Rewind, this));
 }
 
 void CSoundRender_Emitter::rewind()
@@ -71,6 +84,15 @@ void CSoundRender_Emitter::rewind()
     bRewind = TRUE;
 }
 
+void CSoundRender_Emitter::restart()
+{
+    VERIFY(m_current_state == stStopped);
+    m_current_state = bLooped ? stStartingLooped : stStarting;
+    bStopping = FALSE;
+    bRewind = FALSE;
+    bFinished = false;
+}
+
 void CSoundRender_Emitter::pause(bool bVal, int id)
 {
     if (bVal)
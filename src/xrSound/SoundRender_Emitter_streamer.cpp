@@ -54,7 +54,11 @@ void CSoundRender_Emitter::fill_data(u8* _dest, u32 offset, u32 size)
         // cache access
         if (SoundRender->cache.request(source()->CAT, line))
         {
-            source()->decompress(line, target->get_data());
+            void* cached = SoundRender->cache.get_dataptr(source()->CAT, line);
+            const bool decoded = target->take_decoded(source(), line, cached);
+            if (!decoded)
+                source()->decompress(line, target->get_data());
+            SoundRender->decode_taken(decoded);
         }
 
         // fill block
@@ -121,7 +125,7 @@ void CSoundRender_Emitter::fill_block(void* ptr, u32 size)
     }
     else
     {
-        u32 bt_handle = ((CSoundRender_Source*)owner_data->handle)->dwBytesTotal;
+        u32 bt_handle = source()->dwBytesTotal;
         if (get_cursor(true) + size > m_cur_handle_cursor + bt_handle)
         {
             R_ASSERT(owner_data->fn_attached[0].size());
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "SoundRender.h"
+
+#include <atomic>
+
+const u32 sdef_mixer_period = 10; // ms, the mixer thread updates at least that often
+const u32 sdef_mixer_queue = 4096; // commands or notifications in flight
+
+/*
+ * Bounded lock-free queue (D. Vyukov's algorithm), any number of producers and consumers.
+ * The game thread passes commands to the mixer thread with it and gets the notifications back,
+ * a push fails when the queue is full.
+ */
+template <typename T, u32 Capacity>
+class CSoundRender_Queue : Noncopyable
+{
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be power of two");
+
+    struct Cell
+    {
+        std::atomic<u32> sequence;
+        T data;
+    };
+
+    Cell cells[Capacity];
+    alignas(64) std::atomic<u32> head; // next push
+    alignas(64) std::atomic<u32> tail; // next pop
+
+public:
+    CSoundRender_Queue() : head(0), tail(0)
+    {
+        for (u32 i = 0; i < Capacity; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(const T& value)
+    {
+        u32 pos = head.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& cell = cells[pos & (Capacity - 1)];
+            const s32 diff = s32(cell.sequence.load(std::memory_order_acquire) - pos);
+            if (diff < 0)
+                return false;
+            if (diff == 0 && head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                cell.data = value;
+                cell.sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+            if (diff > 0)
+                pos = head.load(std::memory_order_relaxed);
+        }
+    }
+
+    bool pop(T& value)
+    {
+        u32 pos = tail.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Cell& cell = cells[pos & (Capacity - 1)];
+            const s32 diff = s32(cell.sequence.load(std::memory_order_acquire) - (pos + 1));
+            if (diff < 0)
+                return false;
+            if (diff == 0 && tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                value = cell.data;
+                cell.sequence.store(pos + Capacity, std::memory_order_release);
+                return true;
+            }
+            if (diff > 0)
+                pos = tail.load(std::memory_order_relaxed);
+        }
+    }
+};
+
+// Game side -> mixer
+struct SoundCommand
+{
+    enum Type : u32
+    {
+        Play, // emitter is started by the game, it's updated from now on
+        Stop, // stop and release, the game won't touch the emitter anymore
+        StopDeferred, // fade out, then finish
+        Rewind, // play from the start, restarts finished emitter
+        Position,
+        Frequency,
+        Range,
+        Volume,
+        Priority,
+        Mode2D,
+        TimeToStop, // tail attached, value is its length
+        Pause, // all emitters
+        Listener, // position, direction, top
+    };
+
+    Type type;
+    CSoundRender_Emitter* emitter;
+    Fvector vec[3];
+    float value[2];
+    int id;
+    bool flag;
+
+    SoundCommand(Type type, CSoundRender_Emitter* emitter = nullptr)
+        : type(type), emitter(emitter), id(0), flag(false) {}
+    SoundCommand() = default;
+};
+
+// Mixer -> game side
+struct SoundNotify
+{
+    enum Type : u32
+    {
+        Event, // AI sound event, value is the range
+        Finished, // stopped by itself, rewinds tells how many Rewind commands were applied
+        Released, // reply to Stop, the emitter can be deleted
+        SourceChanged, // the attached tail is reached, source is the owner handle from now on
+    };
+
+    Type type;
+    CSoundRender_Emitter* emitter;
+    float value;
+    u32 rewinds;
+    CSoundRender_Source* source;
+
+    SoundNotify(Type type, CSoundRender_Emitter* emitter, float value = 0.f, u32 rewinds = 0)
+        : type(type), emitter(emitter), value(value), rewinds(rewinds), source(nullptr) {}
+    SoundNotify() = default;
+};
@@ -48,7 +48,7 @@ bool ov_error(int res)
     return false;
 }
 
-void CSoundRender_Source::i_decompress_fr(OggVorbis_File* ovf, char* _dest, u32 left)
+void CSoundRender_Source::i_decompress_fr(OggVorbis_File* ovf, char* _dest, u32 left) const
 {
     // vars
     //	char		eof = 0;
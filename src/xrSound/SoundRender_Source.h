@@ -24,7 +24,7 @@ public:
     u32 m_uGameType;
 
 private:
-    void i_decompress_fr(OggVorbis_File* ovf, char* dest, u32 size);
+    void i_decompress_fr(OggVorbis_File* ovf, char* dest, u32 size) const;
     void LoadWave(pcstr name);
 
 public:
@@ -34,6 +34,8 @@ public:
     bool load(pcstr name, bool warnOnNotFound = true);
     void unload();
     void decompress(u32 line, OggVorbis_File* ovf);
+    // Doesn't touch the cache, so can be called from any thread with its own ovf
+    void decompress(u32 line, OggVorbis_File* ovf, void* dest) const;
 
     float length_sec() const override { return fTimeTotal; }
     u32 game_type() const override { return m_uGameType; }
@@ -29,11 +29,15 @@ size_t ov_read_func(void* ptr, size_t size, size_t nmemb, void* datasource)
 int ov_close_func(void* datasource) { return 0; }
 long ov_tell_func(void* datasource) { return ((IReader*)datasource)->tell(); }
 void CSoundRender_Source::decompress(u32 line, OggVorbis_File* ovf)
+{
+    decompress(line, ovf, SoundRender->cache.get_dataptr(CAT, line));
+}
+
+void CSoundRender_Source::decompress(u32 line, OggVorbis_File* ovf, void* dest) const
 {
     VERIFY(ovf);
     // decompression of one cache-line
     u32 line_size = SoundRender->cache.get_linesize();
-    auto dest = (pstr)SoundRender->cache.get_dataptr(CAT, line);
     u32 buf_offs = (line * line_size) / 2 / m_wformat.nChannels;
     u32 left_file = dwBytesTotal - buf_offs;
     u32 left = (u32)std::min(left_file, line_size);
@@ -44,7 +48,7 @@ void CSoundRender_Source::decompress(u32 line, OggVorbis_File* ovf)
         ov_pcm_seek(ovf, buf_offs);
 
     // decompress
-    i_decompress_fr(ovf, dest, left);
+    i_decompress_fr(ovf, (pstr)dest, left);
 }
 
 void CSoundRender_Source::LoadWave(pcstr pName)
@@ -4,15 +4,24 @@
 #include "SoundRender_Core.h"
 #include "SoundRender_Emitter.h"
 #include "SoundRender_Source.h"
+#include "xrCore/Threading/TaskManager.hpp"
+
+#include <thread>
 
 CSoundRender_Target::CSoundRender_Target()
 {
     m_pEmitter = nullptr;
     rendering = false;
     wave = nullptr;
+    decode_back = 0;
+    decode_busy = false;
 }
 
-CSoundRender_Target::~CSoundRender_Target() { VERIFY(wave == 0); }
+CSoundRender_Target::~CSoundRender_Target()
+{
+    VERIFY(wave == 0);
+    VERIFY(!decode_busy);
+}
 
 bool CSoundRender_Target::_initialize()
 {
@@ -86,9 +95,101 @@ void CSoundRender_Target::attach()
 
 void CSoundRender_Target::detach()
 {
+    decode_wait();
+    for (DecodeSlot& slot : decode_slots)
+        slot.source = nullptr;
     if (wave)
     {
         ov_clear(&ovf);
         FS.r_close(wave);
     }
 }
+
+void CSoundRender_Target::decode_ahead(u32 ahead)
+{
+    if (0 == ahead || decode_busy || !m_pEmitter || !TaskScheduler || !TaskScheduler->GetWorkersCount())
+        return;
+
+    CSoundRender_Source* S = m_pEmitter->source();
+    CSoundRender_Cache& cache = SoundRender->cache;
+    const u32 line_size = cache.get_linesize();
+    const u32 cursor = m_pEmitter->get_cursor(false) / line_size;
+    const u32 last = std::min(S->CAT.size, cursor + ahead * S->m_wformat.nAvgBytesPerSec / 1000 / line_size + 1);
+
+    u32 first = cursor;
+    while (first < last && (cache.cached(S->CAT, first) || decode_slots[0].contains(S, first) ||
+        decode_slots[1].contains(S, first)))
+    {
+        ++first;
+    }
+    if (first == last)
+        return;
+
+    // The job writes over the older slot, unless its lines are still to be taken
+    const auto pending = [S, cursor](const DecodeSlot& slot)
+    {
+        return slot.source == S && slot.first_line + slot.lines > cursor;
+    };
+    u32 index = decode_back ^ 1;
+    if (pending(decode_slots[index]))
+        index ^= 1;
+    if (pending(decode_slots[index]))
+        return;
+
+    // The lines are decoded in one go to read the stream without seeking
+    get_data(); // attach on this thread, the job has only to decode
+    decode_back = index;
+    DecodeSlot& back = decode_slots[decode_back];
+    back.source = S;
+    back.first_line = first;
+    back.lines = last - first;
+    back.data.resize(back.lines * line_size);
+    back.scheduled.Start();
+    decode_busy = true;
+    TaskScheduler->AddTask(
+        "CSoundRender_Target::decode", Task::Type::Sound, { this, &CSoundRender_Target::decode_job });
+}
+
+void CSoundRender_Target::decode_job()
+{
+    DecodeSlot& slot = decode_slots[decode_back];
+    const u32 line_size = SoundRender->cache.get_linesize();
+    for (u32 i = 0; i < slot.lines; ++i)
+        slot.source->decompress(slot.first_line + i, &ovf, slot.data.data() + i * line_size);
+    SoundRender->decode_done(slot.lines, slot.scheduled.GetElapsed_sec());
+    decode_busy.store(false, std::memory_order_release);
+}
+
+void CSoundRender_Target::decode_wait()
+{
+    if (!decode_busy.load(std::memory_order_acquire))
+        return;
+
+    CTimer T;
+    T.Start();
+    while (decode_busy.load(std::memory_order_acquire))
+    {
+        if (!TaskScheduler->ExecuteOneTask())
+            std::this_thread::yield();
+    }
+    SoundRender->decode_waited(T.GetElapsed_sec());
+}
+
+bool CSoundRender_Target::take_decoded(const CSoundRender_Source* S, u32 line, void* dest)
+{
+    if (decode_busy && decode_slots[decode_back].contains(S, line))
+        decode_wait();
+
+    for (const DecodeSlot& slot : decode_slots)
+    {
+        if (&slot == &decode_slots[decode_back] && decode_busy)
+            continue;
+        if (slot.contains(S, line))
+        {
+            const u32 line_size = SoundRender->cache.get_linesize();
+            CopyMemory(dest, slot.data.data() + (line - slot.first_line) * line_size, line_size);
+            return true;
+        }
+    }
+    return false;
+}
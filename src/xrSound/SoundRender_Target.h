@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "SoundRender.h"
 
 class CSoundRender_Target
@@ -17,14 +19,43 @@ protected:
     void attach();
     void detach();
 
+    // Lines ahead of the emitter cursor decoded in background.
+    // The job owns ovf and the back slot while it runs,
+    // the other slot keeps the previous lines until they are taken.
+    struct DecodeSlot
+    {
+        xr_vector<u8> data;
+        CSoundRender_Source* source = nullptr;
+        u32 first_line = 0;
+        u32 lines = 0;
+        CTimer scheduled; // for the latency stats
+
+        bool contains(const CSoundRender_Source* S, u32 line) const
+        {
+            return source == S && line >= first_line && line < first_line + lines;
+        }
+    };
+    DecodeSlot decode_slots[2];
+    u32 decode_back;
+    std::atomic_bool decode_busy;
+
+    void decode_job();
+    void decode_wait();
+
 public:
     OggVorbis_File* get_data()
     {
+        decode_wait();
         if (!wave)
             attach();
         return &ovf;
     }
 
+    // Schedules decoding of the lines the emitter is going to need, ahead - ms of sound
+    void decode_ahead(u32 ahead);
+    // Copies the line decoded in background, false if there is no such line
+    bool take_decoded(const CSoundRender_Source* S, u32 line, void* dest);
+
     CSoundRender_Target();
     virtual ~CSoundRender_Target();
 